@@ -30,6 +30,8 @@
 #include <string>
 #include <unordered_map>
 
+class XmlDocument;
+
 struct Character
 {
   std::string name;
@@ -66,6 +68,8 @@ class AccountReader
   const Account* getAccount(const std::string& characterName) const;
 
  private:
+  bool loadDocument(const XmlDocument& accountsXml);
+
   std::unordered_map<int, Account> accounts_;
   std::unordered_map<int, std::string> passwords_;
   std::unordered_map<std::string, int> characterToAccountNumber_;
@@ -24,13 +24,11 @@
 
 #include "account.h"
 
-#include <cstring>
-#include <fstream>
 #include <sstream>
 #include <utility>
 
 #include "logger.h"
-#include "rapidxml.hpp"
+#include "xml_document.h"
 
 namespace
 {
@@ -65,39 +63,23 @@ std::uint32_t ipAddressToUint32(const std::string& ipAddress)
 
 bool AccountReader::loadFile(const std::string& accountsFilename)
 {
-  // Open XML and read into string
-  std::ifstream xmlFileStream(accountsFilename);
-  if (!xmlFileStream.is_open())
-  {
-    LOG_ERROR("%s: Could not open file %s", __func__, accountsFilename.c_str());
-    return false;
-  }
-
-  return loadFile(&xmlFileStream);
+  XmlDocument accountsXml;
+  return accountsXml.loadFile(accountsFilename) && loadDocument(accountsXml);
 }
 
 bool AccountReader::loadFile(std::istream* accountsFileStream)
 {
-  std::string tempString;
-  std::ostringstream xmlStringStream;
-  while (std::getline(*accountsFileStream, tempString))
-  {
-    xmlStringStream << tempString << "\n";
-  }
-
-  // Convert the std::string to a char*
-  char* xmlString = strdup(xmlStringStream.str().c_str());
-
-  // Parse the XML string with Rapidxml
-  rapidxml::xml_document<> accountsXml;
-  accountsXml.parse<0>(xmlString);
+  XmlDocument accountsXml;
+  return accountsXml.loadStream(accountsFileStream) && loadDocument(accountsXml);
+}
 
+bool AccountReader::loadDocument(const XmlDocument& accountsXml)
+{
   // Get top node (<accounts>)
-  rapidxml::xml_node<>* accountsNode = accountsXml.first_node("accounts");
+  const auto* accountsNode = accountsXml.getFirstNode("accounts");
   if (accountsNode == nullptr)
   {
     LOG_ERROR("%s: Invalid file: Could not find node <accounts>", __func__);
-    free(xmlString);
     return false;
   }
 
@@ -107,34 +89,29 @@ bool AccountReader::loadFile(std::istream* accountsFileStream)
        accountNode = accountNode->next_sibling())
   {
     // Get account number
-    auto* numberAttr = accountNode->first_attribute("number");
-    if (numberAttr == nullptr)
+    int number;
+    if (!XmlDocument::getInteger(accountNode, "number", &number))
     {
-      LOG_ERROR("%s: Invalid file: <account> has no attribute \"number\"", __func__);
-      free(xmlString);
+      LOG_ERROR("%s: Invalid file: <account> has no integer attribute \"number\"", __func__);
       return false;
     }
-    auto number = std::stoi(numberAttr->value());
 
     // Get account password
     auto* passwordAttr = accountNode->first_attribute("password");
     if (passwordAttr == nullptr)
     {
       LOG_ERROR("%s: Invalid file: <account> has no attribute \"password\"", __func__);
-      free(xmlString);
       return false;
     }
     auto password = passwordAttr->value();
 
     // Get account paid days
-    auto* paidDaysAttr = accountNode->first_attribute("paid_days");
-    if (paidDaysAttr == nullptr)
+    int paidDays;
+    if (!XmlDocument::getInteger(accountNode, "paid_days", &paidDays))
     {
-      LOG_ERROR("%s: Invalid file: <account> has no attribute \"paid_days\"", __func__);
-      free(xmlString);
+      LOG_ERROR("%s: Invalid file: <account> has no integer attribute \"paid_days\"", __func__);
       return false;
     }
-    auto paidDays = std::stoi(paidDaysAttr->value());
 
     // Create Account object
     Account account(paidDays, {});
@@ -151,7 +128,6 @@ bool AccountReader::loadFile(std::istream* accountsFileStream)
       if (charNameAttr == nullptr)
       {
         LOG_ERROR("%s: Invalid file: <character> has no attribute \"name\"", __func__);
-        free(xmlString);
         return false;
       }
       character.name = charNameAttr->value();
@@ -161,7 +137,6 @@ bool AccountReader::loadFile(std::istream* accountsFileStream)
       if (worldNameAttr == nullptr)
       {
         LOG_ERROR("%s: Invalid file: <character> has no attribute \"world_name\"", __func__);
-        free(xmlString);
         return false;
       }
       character.worldName = worldNameAttr->value();
@@ -171,20 +146,16 @@ bool AccountReader::loadFile(std::istream* accountsFileStream)
       if (worldIpAttr == nullptr)
       {
         LOG_ERROR("%s: Invalid file: <character> has no attribute \"world_ip\"", __func__);
-        free(xmlString);
         return false;
       }
       character.worldIp = ipAddressToUint32(worldIpAttr->value());
 
       // Get port
-      auto* worldPortAttr = characterNode->first_attribute("world_port");
-      if (worldPortAttr == nullptr)
+      if (!XmlDocument::getInteger(characterNode, "world_port", &character.worldPort))
       {
-        LOG_ERROR("%s: Invalid file: <character> has no attribute \"world_port\"", __func__);
-        free(xmlString);
+        LOG_ERROR("%s: Invalid file: <character> has no integer attribute \"world_port\"", __func__);
         return false;
       }
-      character.worldPort = std::stoi(worldPortAttr->value());
 
       // Insert character
       account.characters.push_back(character);
@@ -200,7 +171,6 @@ bool AccountReader::loadFile(std::istream* accountsFileStream)
   LOG_INFO("%s: Successfully loaded %zu accounts with a total of %zu characters",
            __func__, accounts_.size(), characterToAccountNumber_.size());
 
-  free(xmlString);
   return true;
 }
 
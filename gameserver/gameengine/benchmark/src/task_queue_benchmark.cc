@@ -0,0 +1,157 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares TaskQueue with the previous GameEngineQueue implementation (a vector sorted on expire)
+// with 1k, 10k and 100k pending tasks, two tasks per tag (player) with expire within two seconds:
+//  * add: add a task, like GameEngineQueue::addTask for each incoming packet
+//  * pop: remove the first task, like GameEngineQueue::onTimeout
+//  * cancel: cancel all tasks of a tag, like GameEngineQueue::cancelAllTasks
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "task_queue.h"
+
+namespace
+{
+
+using Task = std::function<void()>;
+
+constexpr int number_of_operations = 2000;
+constexpr int max_expire = 2000000;  // 2 seconds in microseconds
+
+// The previous GameEngineQueue, without the timer
+class LegacyTaskQueue
+{
+ public:
+  void push(int tag, std::int64_t expire, Task&& task)
+  {
+    auto it = std::find_if(queue_.cbegin(), queue_.cend(), [expire](const TaskWrapper& tw)
+    {
+      return tw.expire >= expire;
+    });
+    queue_.emplace(it, std::move(task), tag, expire);
+  }
+
+  void cancel(int tag)
+  {
+    auto pred = [tag](const TaskWrapper& tw) { return tw.tag == tag; };
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(), pred), queue_.end());
+  }
+
+  Task pop()
+  {
+    auto tw = queue_.front();
+    queue_.erase(queue_.begin());
+    return tw.task;
+  }
+
+ private:
+  struct TaskWrapper
+  {
+    TaskWrapper(Task&& task, int tag, std::int64_t expire)
+      : task(std::move(task)),
+        tag(tag),
+        expire(expire)
+    {
+    }
+
+    Task task;
+    int tag;
+    std::int64_t expire;
+  };
+
+  std::vector<TaskWrapper> queue_;
+};
+
+template<typename Queue>
+void run(const char* name, int numberOfPendingTasks)
+{
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<int> randomExpire(0, max_expire);
+  const auto numberOfTags = numberOfPendingTasks / 2;
+  std::uniform_int_distribution<int> randomTag(0, numberOfTags - 1);
+
+  auto counter = 0;
+  const auto task = [&counter]() { counter++; };
+
+  Queue queue;
+  for (auto i = 0; i < numberOfPendingTasks; i++)
+  {
+    queue.push(i % numberOfTags, randomExpire(random), Task(task));
+  }
+
+  const auto measure = [](const std::function<void()>& operation)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    for (auto i = 0; i < number_of_operations; i++)
+    {
+      operation();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+           static_cast<double>(number_of_operations);
+  };
+
+  // New tasks expire after the pending tasks, like tasks added during a tick
+  auto expire = static_cast<std::int64_t>(max_expire);
+  const auto add = measure([&]()
+  {
+    expire += randomExpire(random) / 100;
+    queue.push(randomTag(random), expire, Task(task));
+  });
+  const auto pop = measure([&]()
+  {
+    queue.pop()();
+  });
+  const auto cancel = measure([&]()
+  {
+    queue.cancel(randomTag(random));
+  });
+
+  printf("%-8s pending tasks: %6d  add: %9.1f ns  pop: %9.1f ns  cancel: %9.1f ns\n",
+         name,
+         numberOfPendingTasks,
+         add,
+         pop,
+         cancel);
+}
+
+}  // namespace
+
+int main()
+{
+  for (const auto numberOfPendingTasks : { 1000, 10000, 100000 })
+  {
+    run<LegacyTaskQueue>("legacy", numberOfPendingTasks);
+    run<TaskQueue<Task>>("heap", numberOfPendingTasks);
+  }
+
+  return 0;
+}
@@ -0,0 +1,81 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAMEENGINE_EXPORT_COALESCED_TASK_H_
+#define GAMEENGINE_EXPORT_COALESCED_TASK_H_
+
+#include <functional>
+
+#include "game_engine_queue.h"
+
+class GameEngine;
+
+// Queues input where only the latest value matters (e.g. the direction of a turn) to the GameEngineQueue
+// as at most one task at a time: while the task is queued a new value only replaces the queued one,
+// and the task is then run once, with the latest value.
+template<typename T>
+class CoalescedTask
+{
+ public:
+  using Callback = std::function<void(GameEngine*, const T&)>;
+
+  explicit CoalescedTask(const Callback& callback)
+    : callback_(callback),
+      value_(),
+      queued_(false)
+  {
+  }
+
+  // Delete copy constructors, the queued task refers to this
+  CoalescedTask(const CoalescedTask&) = delete;
+  CoalescedTask& operator=(const CoalescedTask&) = delete;
+
+  void queue(GameEngineQueue* gameEngineQueue, int tag, const T& value)
+  {
+    value_ = value;
+    if (queued_)
+    {
+      return;
+    }
+
+    queued_ = true;
+    gameEngineQueue->addTask(tag, [this](GameEngine* gameEngine)
+    {
+      queued_ = false;
+      callback_(gameEngine, value_);
+    });
+  }
+
+  // Must be called if the queued task is canceled (see GameEngineQueue::cancelAllTasks)
+  void reset() { queued_ = false; }
+
+  bool isQueued() const { return queued_; }
+
+ private:
+  Callback callback_;
+  T value_;
+  bool queued_;
+};
+
+#endif  // GAMEENGINE_EXPORT_COALESCED_TASK_H_
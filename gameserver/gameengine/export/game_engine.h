@@ -26,19 +26,25 @@
 #define GAMEENGINE_EXPORT_GAME_ENGINE_H_
 
 #include <array>
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "byte_buffer.h"
 #include "world.h"
 #include "item_manager.h"
 #include "player.h"
 #include "position.h"
 #include "container_manager.h"
 #include "game_position.h"
+#include "sector_file_store.h"
+#include "world_image.h"
+#include "pathfinding_service.h"
 
 class GameEngineQueue;
 class OutgoingPacket;
@@ -47,8 +53,15 @@ class PlayerCtrl;
 class GameEngine
 {
  public:
+  // Pathfinding expands at most this many nodes per tick, see PathfindingService
+  static constexpr int pathfinding_tick_ms = 50;
+  static constexpr int pathfinding_nodes_per_tick = 4096;
+
   GameEngine()
-    : gameEngineQueue_(nullptr)
+    : pathfindingScheduled_(false),
+      pathfindingTick_(0),
+      pathfindingBudget_(0),
+      gameEngineQueue_(nullptr)
   {
   }
 
@@ -60,7 +73,12 @@ class GameEngine
             const std::string& loginMessage,
             const std::string& dataFilename,
             const std::string& itemsFilename,
-            const std::string& worldFilename);
+            const std::string& itemsCacheFilename,
+            const std::string& worldFilename,
+            bool lazySectors,
+            int loaderThreads,
+            const std::string& pageDirectory,
+            int pageOutIntervalMs);
 
   bool spawn(const std::string& name, PlayerCtrl* player_ctrl);
   void despawn(CreatureId creatureId);
@@ -83,25 +101,69 @@ class GameEngine
   void closeContainer(CreatureId creatureId, int clientContainerId);
   void openParentContainer(CreatureId creatureId, int clientContainerId);
 
+  // Called by GameEngineQueue after each batch of tasks, delivers what happened in the World
+  // during the tick to the players, see World::flushEvents
+  void endTick();
+
+  // Saves the players and the tiles that have changed since the World was loaded, so that another
+  // process that has loaded the same World can take over the game (see loadSnapshot). The
+  // GameEngineQueue must be stopped first, as queued tasks are not part of the snapshot.
+  void saveSnapshot(std::vector<std::uint8_t>* data);
+
+  // Restores a snapshot from saveSnapshot, must be called before any player has spawned. The players
+  // are restored with the PlayerCtrl that getPlayerCtrl returns for their CreatureId, players
+  // without a PlayerCtrl (nullptr) are skipped. The clients of the players are told to close their
+  // containers and to stop walking, since open containers and queued moves are not restored.
+  bool loadSnapshot(const std::vector<std::uint8_t>& data,
+                    const std::function<PlayerCtrl*(CreatureId)>& getPlayerCtrl);
+
  private:
   Item* getItem(CreatureId creatureId, const ItemPosition& position);
   bool canAddItem(CreatureId creatureId, const GamePosition& position, const Item& item, int count) const;
   void removeItem(CreatureId creatureId, const ItemPosition& position, int count);
   void addItem(CreatureId creatureId, const GamePosition& position, Item* item, int count);
 
+  // Walks the given path, one step at a time when the player is allowed to move
+  void startQueuedMoves(CreatureId creatureId, std::deque<Direction>&& path);
+  void queuedMove(CreatureId creatureId);
+
+  // Performs the delayed move (from move) when the player is allowed to move again
+  void delayedMove(CreatureId creatureId);
+
+  // Pages out the sectors that no player is near every pageOutIntervalMs, see World::pageOutSectors
+  void schedulePageOut(int pageOutIntervalMs);
+
+  // Runs the PathfindingService within the budget of the current tick, and schedules
+  // itself for the next tick if there are requests left
+  void processPathfinding();
+
+  // Helper functions for saveSnapshot and loadSnapshot, an Item is saved with the Items in
+  // its Container (if it has been opened)
+  void saveItem(const Item& item, ByteWriter* writer) const;
+  Item* loadItem(int parentContainerId, const ItemPosition& rootItemPosition, bool mapItem, ByteReader* reader);
+
   // This structure holds all player data that shouldn't go into Player
   struct PlayerData
   {
     PlayerData(Player&& player, PlayerCtrl* player_ctrl)
       : player(std::move(player)),
         player_ctrl(player_ctrl),
-        queued_moves()
+        queued_moves(),
+        delayed_move(Direction::NORTH),
+        has_delayed_move(false),
+        delayed_move_scheduled(false)
     {
     }
 
     Player player;
     PlayerCtrl* player_ctrl;
     std::deque<Direction> queued_moves;
+
+    // A single move that is waiting for the next walk tick, a new move while waiting replaces
+    // it (last one wins) instead of queueing another task
+    Direction delayed_move;
+    bool has_delayed_move;
+    bool delayed_move_scheduled;
   };
 
   // Use these instead of the unordered_map directly
@@ -113,6 +175,18 @@ class GameEngine
   // TODO(simon): refactor away unique_ptr
   std::unique_ptr<World> world_;
 
+  // Where the World pages out sectors that no player is near, nullptr if paging is disabled
+  std::unique_ptr<SectorFileStore> sectorStore_;
+
+  // The world image that sectors are loaded from when first accessed, nullptr unless lazySectors is
+  // set and the world file is a world image. Sectors are then paged out through it to sectorStore_.
+  std::unique_ptr<WorldImage> worldImage_;
+
+  std::unique_ptr<PathfindingService> pathfindingService_;
+  bool pathfindingScheduled_;
+  std::int64_t pathfindingTick_;
+  int pathfindingBudget_;
+
   GameEngineQueue* gameEngineQueue_;
   std::string loginMessage_;
   ItemManager itemManager_;
@@ -25,55 +25,133 @@
 #ifndef GAMEENGINE_EXPORT_GAME_ENGINE_QUEUE_H_
 #define GAMEENGINE_EXPORT_GAME_ENGINE_QUEUE_H_
 
+#include <array>
+#include <cstdint>
 #include <functional>
-#include <vector>
 
 #include <boost/asio.hpp>  //NOLINT
-#include <boost/date_time/posix_time/posix_time.hpp>  //NOLINT
+
+#include "task_queue.h"
+#include "unique_function.h"
 
 class GameEngine;
 
+// Runs the tasks of the GameEngine when they expire, in one of two modes:
+//  * tickMs == 0: the timer is set to the first task's expire, and is restarted whenever a task
+//                 that expires earlier is added
+//  * tickMs > 0:  fixed-rate tick mode, the timer expires every tickMs and runs all tasks that have
+//                 expired since the previous tick in one pass, e.g. all input received during the tick
+//
+// After each batch of tasks GameEngine::endTick is called, and then the onTickEnd callback
+//
+// Each task has a Priority, and the expired tasks are run in priority order. A batch may use
+// at most the time budget (see setTimeBudget), the tasks that are left are deferred to the next
+// batch, except LOGIN tasks which are always run. LOW tasks that have been deferred for more
+// than shed_lag_ms are dropped.
 class GameEngineQueue
 {
  public:
-  using Task = std::function<void(GameEngine*)>;
+  // Move-only, typical tasks (e.g. from player input) are stored without any heap allocation
+  using Task = UniqueFunction<void(GameEngine*)>;
+
+  // Returns the current time in microseconds, from a monotonic clock
+  using Clock = std::function<std::int64_t(void)>;
+
+  enum class Priority
+  {
+    LOGIN,   // Spawn and despawn
+    ACTION,  // Movement and item actions
+    CHAT,
+    LOW      // E.g. look, may be dropped under load (see shed_lag_ms)
+  };
+  static constexpr int number_of_priorities = 4;
+
+  // LOW tasks that are this late are dropped
+  static constexpr std::int64_t shed_lag_ms = 1000;
 
-  GameEngineQueue(GameEngine* gameEngine, boost::asio::io_service* io_service);
+  // How often the metrics are logged, if any task was deferred or dropped since the last time
+  static constexpr std::int64_t metrics_report_interval_ms = 10000;
+
+  // All counters are since start, lag is how late a task was run compared to its expire
+  struct Metrics
+  {
+    std::int64_t tasksRun;
+    std::int64_t tasksShed;
+    std::int64_t tasksDeferred;  // Tasks that were run (or shed) in a later batch since the budget ran out
+    std::int64_t batchesOverBudget;
+    std::int64_t maxLagUs;
+    std::int64_t lastLagUs;      // Max lag in the last batch
+  };
+
+  // The clock defaults to std::chrono::steady_clock, the timer always uses real time
+  GameEngineQueue(GameEngine* gameEngine,
+                  boost::asio::io_service* io_service,
+                  int tickMs = 0,
+                  const Clock& clock = Clock());
 
   // Delete copy constructors
   GameEngineQueue(const GameEngineQueue&) = delete;
   GameEngineQueue& operator=(const GameEngineQueue&) = delete;
 
-  void addTask(int tag, const Task& task);
-  void addTask(int tag, std::int64_t expire_ms, const Task& task);
+  // Priority::ACTION
+  void addTask(int tag, Task&& task);
+  void addTask(int tag, std::int64_t expire_ms, Task&& task);
+
+  void addTask(Priority priority, int tag, Task&& task);
+  void addTask(Priority priority, int tag, std::int64_t expire_ms, Task&& task);
   void cancelAllTasks(int tag);
 
+  // 0 means no budget, i.e. all expired tasks are run in the same batch
+  void setTimeBudget(int budgetMs) { budgetMs_ = budgetMs; }
+
+  const Metrics& getMetrics() const { return metrics_; }
+
+  // E.g. to flush the connections once per tick
+  void setOnTickEnd(const std::function<void(void)>& onTickEnd) { onTickEnd_ = onTickEnd; }
+
+  bool isFixedRate() const { return tickMs_ > 0; }
+
+  // Stops running tasks, e.g. while the state of the GameEngine is handed over to another
+  // process. Queued tasks, and tasks that are added while stopped, are kept until resume.
+  void stop();
+  void resume();
+
  private:
-  struct TaskWrapper
-  {
-    TaskWrapper(const Task& task, int tag, const boost::posix_time::ptime& expire)
-      : task(task),
-        tag(tag),
-        expire(expire)
-    {
-    }
-
-    Task task;
-    int tag;
-    boost::posix_time::ptime expire;
-  };
+  static std::int64_t steadyClockNow();
+  std::int64_t now() const { return clock_(); }
+
+  bool empty() const;
+  std::int64_t getFirstExpire() const;
 
   void startTimer();
   void onTimeout(const boost::system::error_code& ec);
 
+  // Runs the expired tasks, in priority order, returns false if the budget ran out
+  bool runTasks(std::int64_t current);
+  void reportMetrics(std::int64_t current);
+
   GameEngine* gameEngine_;
+  Clock clock_;
 
-  // The vector should be sorted on TaskWrapper.expire
-  // This is handled by addTask()
-  std::vector<TaskWrapper> queue_;
+  // One queue per Priority, ordered on expire (in microseconds, see now()), see TaskQueue
+  std::array<TaskQueue<Task>, number_of_priorities> queues_;
 
   boost::asio::deadline_timer timer_;
   bool timer_started_;
+  bool stopped_;
+
+  // Fixed-rate tick mode if tickMs_ > 0, nextTick_ is in microseconds (see now())
+  int tickMs_;
+  std::int64_t nextTick_;
+
+  std::function<void(void)> onTickEnd_;
+
+  int budgetMs_;
+  Metrics metrics_;
+  Metrics reportedMetrics_;
+  std::int64_t reportLagUs_;  // Max lag since the last report
+  std::int64_t overBudgetBatch_;  // current of the last batch that ran out of budget, see runTasks
+  std::int64_t nextReport_;
 };
 
 #endif  // GAMEENGINE_EXPORT_GAME_ENGINE_QUEUE_H_
@@ -357,6 +357,49 @@ void ContainerManager::addItem(const PlayerCtrl* playerCtrl, int containerId, in
   }
 }
 
+const Container* ContainerManager::getContainerOfItem(ItemUniqueId itemUniqueId) const
+{
+  const auto it = containerIds_.find(itemUniqueId);
+  return it != containerIds_.cend() ? &containers_.at(it->second) : nullptr;
+}
+
+std::vector<int> ContainerManager::getClientContainerIds(CreatureId playerId) const
+{
+  std::vector<int> result;
+  const auto it = clientContainerIds_.find(playerId);
+  if (it == clientContainerIds_.cend())
+  {
+    return result;
+  }
+
+  for (auto i = 0u; i < it->second.size(); i++)
+  {
+    if (it->second[i] != Container::INVALID_ID)
+    {
+      result.push_back(i);
+    }
+  }
+  return result;
+}
+
+int ContainerManager::restoreContainer(const Item* item, int parentContainerId, const ItemPosition& rootItemPosition)
+{
+  const auto containerId = nextContainerId_;
+  nextContainerId_ += 1;
+
+  auto& container = containers_[containerId];
+  container.id = containerId;
+  container.weight = 0;
+  container.item = item;
+  container.parentContainerId = parentContainerId;
+  container.rootItemPosition = rootItemPosition;
+  container.items = {};
+  container.relatedPlayers = {};
+
+  containerIds_[item->getItemUniqueId()] = containerId;
+  return containerId;
+}
+
 void ContainerManager::createContainer(PlayerCtrl* playerCtrl, const Item* item, const ItemPosition& itemPosition)
 {
   const auto containerId = nextContainerId_;
@@ -27,6 +27,7 @@
 
 #include <array>
 #include <unordered_map>
+#include <vector>
 
 #include "container.h"
 #include "item.h"
@@ -67,6 +68,14 @@ class ContainerManager
   void removeItem(const PlayerCtrl* playerCtrl, int containerId, int containerSlot);
   void addItem(const PlayerCtrl* playerCtrl, int containerId, int containerSlot, Item* item);
 
+  // Used to save and restore containers, see GameEngine::saveSnapshot and loadSnapshot
+  // Returns nullptr if the Item has no Container (i.e. it has never been opened)
+  const Container* getContainerOfItem(ItemUniqueId itemUniqueId) const;
+  // Returns the clientContainerIds of the player's open containers
+  std::vector<int> getClientContainerIds(CreatureId playerId) const;
+  // Creates an empty Container for the Item, returns its id
+  int restoreContainer(const Item* item, int parentContainerId, const ItemPosition& rootItemPosition);
+
  private:
   void createContainer(PlayerCtrl* playerCtrl, const Item* item, const ItemPosition& itemPosition);
 
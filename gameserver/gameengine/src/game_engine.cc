@@ -24,6 +24,7 @@
 
 #include "game_engine.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <memory>
@@ -44,20 +45,16 @@
 namespace
 {
 
-struct RecursiveTask
-{
-  explicit RecursiveTask(const std::function<void(const RecursiveTask&, GameEngine* gameEngine)>& func)
-    : func_(func)
-  {
-  }
+// Snapshot format, see saveSnapshot:
+//   u32 magic
+//   for each modified tile: u8 1, u16 x, u16 y, u8 z, u16 number of items, the items (see saveItem)
+//   u8 0
+//   u32 number of players, the players (see saveSnapshot)
+constexpr std::uint32_t snapshot_magic = 0x50414E53;  // "SNAP"
 
-  void operator()(GameEngine* gameEngine) const
-  {
-    func_(*this, gameEngine);
-  }
-
-  std::function<void(const RecursiveTask&, GameEngine* gameEngine)> func_;
-};
+// Inventory slots are 1..10, see Equipment
+constexpr int first_inventory_slot = 1;
+constexpr int last_inventory_slot = 10;
 
 }  // namespace
 
@@ -65,26 +62,81 @@ bool GameEngine::init(GameEngineQueue* gameEngineQueue,
                       const std::string& loginMessage,
                       const std::string& dataFilename,
                       const std::string& itemsFilename,
-                      const std::string& worldFilename)
+                      const std::string& itemsCacheFilename,
+                      const std::string& worldFilename,
+                      bool lazySectors,
+                      int loaderThreads,
+                      const std::string& pageDirectory,
+                      int pageOutIntervalMs)
 {
   gameEngineQueue_ = gameEngineQueue;
   loginMessage_ = loginMessage;
 
-  // Load ItemManager
-  if (!itemManager_.loadItemTypes(dataFilename, itemsFilename))
+  // Load ItemManager, from the cache if it's up to date (see itemcompiler)
+  auto start = Tick::now();
+  if (!itemManager_.loadItemTypes(dataFilename, itemsFilename, itemsCacheFilename))
   {
     LOG_ERROR("%s: could not load ItemManager", __func__);
     return false;
   }
+  LOG_INFO("%s: item types loaded in %d ms", __func__, static_cast<int>(Tick::now() - start));
+
+  if (!pageDirectory.empty())
+  {
+    sectorStore_ = std::make_unique<SectorFileStore>(pageDirectory, &itemManager_);
+  }
+
+  // Load World, either from a world image (see worldcompiler) or from world.xml
+  start = Tick::now();
+  if (WorldImage::isWorldImage(worldFilename))
+  {
+    worldImage_ = std::make_unique<WorldImage>(&itemManager_, sectorStore_.get());
+    world_ = std::make_unique<World>();
+    if (!worldImage_->open(worldFilename) || !worldImage_->loadWorld(world_.get(), lazySectors, loaderThreads))
+    {
+      world_.reset();
+    }
+    else if (!lazySectors)
+    {
+      worldImage_.reset();
+    }
+  }
+  else
+  {
+    if (lazySectors)
+    {
+      LOG_INFO("%s: sectors can only be loaded lazily from a world image, loading all of %s",
+               __func__,
+               worldFilename.c_str());
+    }
+    world_ = WorldFactory::createWorld(worldFilename, &itemManager_);
+  }
 
-  // Load World
-  world_ = WorldFactory::createWorld(worldFilename, &itemManager_);
   if (!world_)
   {
     LOG_ERROR("%s: could not load World", __func__);
     return false;
   }
+  LOG_INFO("%s: world loaded in %d ms", __func__, static_cast<int>(Tick::now() - start));
+
+  pathfindingService_ = std::make_unique<PathfindingService>(&world_->getWalkabilityMap());
+
+  // Sectors are paged in from the world image when first accessed, and then paged out to the page
+  // directory like any other sector
+  if (worldImage_)
+  {
+    world_->setSectorStore(worldImage_.get());
+  }
+  else if (sectorStore_)
+  {
+    world_->setSectorStore(sectorStore_.get());
+  }
 
+  // Periodically page out the parts of the World that no player is near
+  if (sectorStore_)
+  {
+    schedulePageOut(pageOutIntervalMs);
+  }
 
   return true;
 }
@@ -133,8 +185,9 @@ void GameEngine::despawn(CreatureId creatureId)
   // Inform ContainerManager
   containerManager_.playerDespawn(getPlayerData(creatureId).player_ctrl);
 
-  // Remove any queued tasks for this player
+  // Remove any queued tasks and path requests for this player
   gameEngineQueue_->cancelAllTasks(creatureId);
+  pathfindingService_->cancel(creatureId);
 
   // Finally despawn the player from the World
   // Note: this will free the PlayerCtrl, but requires Player to still be allocated
@@ -148,70 +201,152 @@ void GameEngine::move(CreatureId creatureId, Direction direction)
 {
   LOG_DEBUG("%s: creature id: %d", __func__, creatureId);
 
-  auto* player_ctrl = getPlayerData(creatureId).player_ctrl;
+  auto& playerData = getPlayerData(creatureId);
+
+  if (playerData.delayed_move_scheduled)
+  {
+    // Already waiting for the next walk tick, replace the move instead of queueing
+    // another one so that a client spamming moves can't queue up more than one step
+    LOG_DEBUG("%s: player move coalesced, creature id: %d", __func__, creatureId);
+    playerData.delayed_move = direction;
+    playerData.has_delayed_move = true;
+    return;
+  }
 
   auto rc = world_->creatureMove(creatureId, direction);
   if (rc == World::ReturnCode::MAY_NOT_MOVE_YET)
   {
     LOG_DEBUG("%s: player move delayed, creature id: %d", __func__, creatureId);
-    const auto& creature = world_->getCreature(creatureId);
+    playerData.delayed_move = direction;
+    playerData.has_delayed_move = true;
+    playerData.delayed_move_scheduled = true;
     gameEngineQueue_->addTask(creatureId,
-                              creature.getNextWalkTick() - Tick::now(),
-                              [this, creatureId, direction](GameEngine* gameEngine)
+                              playerData.player.getNextWalkTick() - Tick::now(),
+                              [this, creatureId](GameEngine* gameEngine)
     {
       (void)gameEngine;
-      move(creatureId, direction);
+      delayedMove(creatureId);
     });
   }
   else if (rc == World::ReturnCode::THERE_IS_NO_ROOM)
   {
-    player_ctrl->sendCancel("There is no room.");
+    playerData.player_ctrl->sendCancel("There is no room.");
+  }
+}
+
+void GameEngine::delayedMove(CreatureId creatureId)
+{
+  auto& playerData = getPlayerData(creatureId);
+  playerData.delayed_move_scheduled = false;
+
+  // Make sure that the move hasn't been canceled
+  if (playerData.has_delayed_move)
+  {
+    playerData.has_delayed_move = false;
+    move(creatureId, playerData.delayed_move);
   }
 }
 
 void GameEngine::movePath(CreatureId creatureId, std::deque<Direction>&& path)
+{
+  // The path from the client is not trusted, it is only used to know where the player
+  // wants to go, and the server finds the path there
+  const auto from = world_->getCreaturePosition(creatureId);
+  auto to = from;
+  for (const auto& direction : path)
+  {
+    to = to.addDirection(direction);
+  }
+
+  // Replace any current path, without telling the client as it has already started the new one
+  getPlayerData(creatureId).queued_moves.clear();
+  if (to == from)
+  {
+    return;
+  }
+
+  pathfindingService_->requestPath(creatureId, from, to, [this, creatureId, from](bool found,
+                                                                                  std::deque<Direction>&& path)
+  {
+    auto* player_ctrl = getPlayerData(creatureId).player_ctrl;
+    if (!found)
+    {
+      player_ctrl->sendCancel("There is no way.");
+      player_ctrl->cancelMove();
+    }
+    else if (world_->getCreaturePosition(creatureId) != from)
+    {
+      // The player moved while the path was searched for
+      player_ctrl->cancelMove();
+    }
+    else
+    {
+      startQueuedMoves(creatureId, std::move(path));
+    }
+  });
+
+  processPathfinding();
+}
+
+void GameEngine::startQueuedMoves(CreatureId creatureId, std::deque<Direction>&& path)
 {
   getPlayerData(creatureId).queued_moves = std::move(path);
+  queuedMove(creatureId);
+}
+
+void GameEngine::queuedMove(CreatureId creatureId)
+{
+  auto& playerData = getPlayerData(creatureId);
 
-  const auto task = RecursiveTask([this, creatureId](const RecursiveTask& task, GameEngine* gameEngine)
+  // Make sure that the queued moves hasn't been canceled
+  if (!playerData.queued_moves.empty())
   {
-    (void)gameEngine;
+    const auto rc = world_->creatureMove(creatureId, playerData.queued_moves.front());
 
-    auto& playerData = getPlayerData(creatureId);
+    if (rc == World::ReturnCode::OK)
+    {
+      // Player moved, pop the move from the queue
+      playerData.queued_moves.pop_front();
+    }
+    else if (rc != World::ReturnCode::MAY_NOT_MOVE_YET)
+    {
+      // If we neither got OK nor MAY_NOT_MOVE_YET: stop here and cancel all queued moves
+      cancelMove(creatureId);
+    }
 
-    // Make sure that the queued moves hasn't been canceled
     if (!playerData.queued_moves.empty())
     {
-      const auto rc = world_->creatureMove(creatureId, playerData.queued_moves.front());
-
-      if (rc == World::ReturnCode::OK)
+      // If there are more queued moves, e.g. we moved but there are more moves or we were not allowed
+      // to move yet, add a new task
+      gameEngineQueue_->addTask(creatureId,
+                                playerData.player.getNextWalkTick() - Tick::now(),
+                                [this, creatureId](GameEngine* gameEngine)
       {
-        // Player moved, pop the move from the queue
-        playerData.queued_moves.pop_front();
-      }
-      else if (rc != World::ReturnCode::MAY_NOT_MOVE_YET)
-      {
-        // If we neither got OK nor MAY_NOT_MOVE_YET: stop here and cancel all queued moves
-        cancelMove(creatureId);
-      }
-
-      if (!playerData.queued_moves.empty())
-      {
-        // If there are more queued moves, e.g. we moved but there are more moves or we were not allowed
-        // to move yet, add a new task
-        gameEngineQueue_->addTask(creatureId, playerData.player.getNextWalkTick() - Tick::now(), task);
-      }
+        (void)gameEngine;
+        queuedMove(creatureId);
+      });
     }
-  });
+  }
+}
 
-  task(this);
+void GameEngine::schedulePageOut(int pageOutIntervalMs)
+{
+  gameEngineQueue_->addTask(Creature::INVALID_ID, pageOutIntervalMs, [this, pageOutIntervalMs](GameEngine* gameEngine)
+  {
+    (void)gameEngine;
+    world_->pageOutSectors();
+    schedulePageOut(pageOutIntervalMs);
+  });
 }
 
 void GameEngine::cancelMove(CreatureId creatureId)
 {
   LOG_DEBUG("%s: creature id: %d", __func__, creatureId);
 
+  pathfindingService_->cancel(creatureId);
+
   auto& playerData = getPlayerData(creatureId);
+  playerData.has_delayed_move = false;
   if (!playerData.queued_moves.empty())
   {
     playerData.queued_moves.clear();
@@ -221,6 +356,29 @@ void GameEngine::cancelMove(CreatureId creatureId)
   // Don't cancel the task, just let it expire and do nothing
 }
 
+void GameEngine::processPathfinding()
+{
+  // Each tick has its own budget, also when processing directly on a new request
+  const auto tick = Tick::now() / pathfinding_tick_ms;
+  if (tick != pathfindingTick_)
+  {
+    pathfindingTick_ = tick;
+    pathfindingBudget_ = pathfinding_nodes_per_tick;
+  }
+  pathfindingBudget_ -= pathfindingService_->process(pathfindingBudget_);
+
+  if (pathfindingService_->hasRequests() && !pathfindingScheduled_)
+  {
+    pathfindingScheduled_ = true;
+    gameEngineQueue_->addTask(Creature::INVALID_ID, pathfinding_tick_ms, [this](GameEngine* gameEngine)
+    {
+      (void)gameEngine;
+      pathfindingScheduled_ = false;
+      processPathfinding();
+    });
+  }
+}
+
 void GameEngine::turn(CreatureId creatureId, Direction direction)
 {
   LOG_DEBUG("%s: Player turn, creature id: %d", __func__, creatureId);
@@ -288,7 +446,7 @@ void GameEngine::say(CreatureId creatureId,
 
       for (const auto* item : tile->getItems())
       {
-        oss << "Item: " << item->getItemTypeId() << " (" << item->getItemType().name << ")\n";
+        oss << "Item: " << item->getItemTypeId() << " (" << item->getItemType().getDetails().name << ")\n";
       }
 
       for (const auto& creatureId : tile->getCreatureIds())
@@ -370,6 +528,13 @@ void GameEngine::moveItem(CreatureId creatureId,
     return;
   }
 
+  // Verify that the player can throw the Item to toPosition
+  if (toPosition.isPosition() && !world_->creatureCanThrowTo(creatureId, toPosition.getPosition()))
+  {
+    playerData.player_ctrl->sendTextMessage(0x13, "You cannot throw there.");
+    return;
+  }
+
   // Verify that the Item can be added to toPosition
   if (!canAddItem(creatureId, toPosition, *item, count))
   {
@@ -378,6 +543,12 @@ void GameEngine::moveItem(CreatureId creatureId,
     return;
   }
 
+  // Shared map Items must stay on their tiles, so move a unique copy instead (copy-on-write)
+  if (itemManager_.isShared(item->getItemUniqueId()))
+  {
+    item = itemManager_.getItem(itemManager_.makeUnique(item->getItemUniqueId()));
+  }
+
   // Remove Item from fromPosition
   removeItem(creatureId, fromPosition, count);
 
@@ -429,18 +600,19 @@ void GameEngine::lookAt(CreatureId creatureId, const ItemPosition& position)
   // TODO(simon): verify that player is close enough, if item is in world
 
   const auto& itemType = item->getItemType();
+  const auto& details = itemType.getDetails();
 
   std::ostringstream ss;
 
-  if (!itemType.name.empty())
+  if (!details.name.empty())
   {
     if (itemType.isStackable && item->getCount() > 1)
     {
-      ss << "You see " << item->getCount() << " " << itemType.name << "s.";
+      ss << "You see " << item->getCount() << " " << details.name << "s.";
     }
     else
     {
-      ss << "You see a " << itemType.name << ".";
+      ss << "You see a " << details.name << ".";
     }
   }
   else
@@ -454,9 +626,9 @@ void GameEngine::lookAt(CreatureId creatureId, const ItemPosition& position)
     ss << "\nIt weights " << itemType.weight << " oz.";
   }
 
-  if (!itemType.descr.empty())
+  if (!details.descr.empty())
   {
-    ss << "\n" << itemType.descr;
+    ss << "\n" << details.descr;
   }
 
   playerData.player_ctrl->sendTextMessage(0x13, ss.str());
@@ -474,6 +646,325 @@ void GameEngine::openParentContainer(CreatureId creatureId, int clientContainerI
   containerManager_.openParentContainer(getPlayerData(creatureId).player_ctrl, clientContainerId);
 }
 
+void GameEngine::endTick()
+{
+  world_->flushEvents();
+}
+
+void GameEngine::saveSnapshot(std::vector<std::uint8_t>* data)
+{
+  // Events that are not yet delivered would be lost
+  world_->flushEvents();
+
+  ByteWriter writer(data);
+  writer.addU32(snapshot_magic);
+
+  // Tiles, without the creatures on them
+  world_->forEachModifiedTile([this, &writer](const Position& position, const Tile& tile)
+  {
+    writer.addU8(1);
+    writer.addU16(position.getX());
+    writer.addU16(position.getY());
+    writer.addU8(position.getZ());
+    writer.addU16(tile.getItems().size());
+    for (const auto* item : tile.getItems())
+    {
+      saveItem(*item, &writer);
+    }
+  });
+  writer.addU8(0);
+
+  // Players, in reverse stack order so that they get the same stack order when restored
+  std::vector<CreatureId> playerIds;
+  for (const auto& playerDataPair : playerData_)
+  {
+    playerIds.push_back(playerDataPair.first);
+  }
+  std::sort(playerIds.begin(), playerIds.end(), [this](CreatureId a, CreatureId b)
+  {
+    return world_->getTile(world_->getCreaturePosition(a))->getCreatureStackPos(a) >
+           world_->getTile(world_->getCreaturePosition(b))->getCreatureStackPos(b);
+  });
+
+  writer.addU32(playerIds.size());
+  for (const auto playerId : playerIds)
+  {
+    const auto& playerData = getPlayerData(playerId);
+    const auto& player = playerData.player;
+    const auto& position = world_->getCreaturePosition(playerId);
+
+    writer.addU32(playerId);
+    writer.addString(player.getName());
+    writer.addU16(position.getX());
+    writer.addU16(position.getY());
+    writer.addU8(position.getZ());
+    writer.addU8(static_cast<std::uint8_t>(player.getDirection()));
+    writer.addU32(player.getMaxHealth());
+    writer.addU32(player.getHealth());
+    const auto& outfit = player.getOutfit();
+    writer.addU16(outfit.type);
+    writer.addU16(outfit.ext);
+    writer.addU16(outfit.head);
+    writer.addU16(outfit.body);
+    writer.addU16(outfit.legs);
+    writer.addU16(outfit.feet);
+    writer.addU8(player.getLightColor());
+    writer.addU8(player.getLightLevel());
+    writer.addU32(player.getMaxMana());
+    writer.addU32(player.getMana());
+    writer.addU32(player.getCapacity());
+    writer.addU32(player.getExperience());
+    writer.addU32(player.getMagicLevel());
+    writer.addU32(player.getPartyShield());
+
+    for (auto inventorySlot = first_inventory_slot; inventorySlot <= last_inventory_slot; inventorySlot++)
+    {
+      const auto* item = player.getEquipment().getItem(inventorySlot);
+      writer.addU8(item ? 1 : 0);
+      if (item)
+      {
+        saveItem(*item, &writer);
+      }
+    }
+
+    // Only what the client needs to be told, see loadSnapshot
+    const auto clientContainerIds = containerManager_.getClientContainerIds(playerId);
+    writer.addU8(clientContainerIds.size());
+    for (const auto clientContainerId : clientContainerIds)
+    {
+      writer.addU8(clientContainerId);
+    }
+    const auto isWalking = !playerData.queued_moves.empty() ||
+                           playerData.has_delayed_move ||
+                           pathfindingService_->hasRequest(playerId);
+    writer.addU8(isWalking ? 1 : 0);
+  }
+}
+
+bool GameEngine::loadSnapshot(const std::vector<std::uint8_t>& data,
+                              const std::function<PlayerCtrl*(CreatureId)>& getPlayerCtrl)
+{
+  if (!playerData_.empty())
+  {
+    LOG_ERROR("%s: there are players in the World already", __func__);
+    return false;
+  }
+
+  ByteReader reader(data.data(), data.size());
+  if (reader.getU32() != snapshot_magic)
+  {
+    LOG_ERROR("%s: invalid snapshot", __func__);
+    return false;
+  }
+
+  // Tiles, the items of the loaded tile are replaced
+  auto numberOfTiles = 0;
+  while (reader.getU8() == 1 && !reader.failed())
+  {
+    const auto x = reader.getU16();
+    const auto y = reader.getU16();
+    const auto z = reader.getU8();
+    const Position position(x, y, z);
+    const auto numberOfItems = reader.getU16();
+
+    std::vector<Item*> items;
+    for (auto i = 0; i < numberOfItems && !reader.failed(); i++)
+    {
+      const ItemPosition rootItemPosition(GamePosition(position), 0, i);
+      items.push_back(loadItem(Container::INVALID_ID, rootItemPosition, true, &reader));
+    }
+    if (reader.failed() || items.empty() || std::find(items.cbegin(), items.cend(), nullptr) != items.cend())
+    {
+      LOG_ERROR("%s: invalid tile at position: %s", __func__, position.toString().c_str());
+      return false;
+    }
+
+    const auto* oldTile = world_->getTile(position);
+    if (oldTile)
+    {
+      for (const auto* item : oldTile->getItems())
+      {
+        itemManager_.destroyItem(item->getItemUniqueId());
+      }
+    }
+
+    // Tile::addItem puts each item first among the top or bottom items, so add them in reverse order
+    Tile tile(items.front());
+    for (auto it = items.crbegin(); it != items.crend() - 1; ++it)
+    {
+      tile.addItem(*it);
+    }
+    world_->restoreTile(position, std::move(tile));
+    numberOfTiles++;
+  }
+
+  // Players
+  const auto numberOfPlayers = reader.getU32();
+  auto numberOfRestoredPlayers = 0;
+  for (auto i = 0u; i < numberOfPlayers && !reader.failed(); i++)
+  {
+    const CreatureId playerId = reader.getU32();
+    Player player(playerId, reader.getString());
+    const auto x = reader.getU16();
+    const auto y = reader.getU16();
+    const auto z = reader.getU8();
+    const Position position(x, y, z);
+    player.setDirection(static_cast<Direction>(reader.getU8() & 0x03));
+    player.setMaxHealth(reader.getU32());
+    player.setHealth(reader.getU32());
+    Outfit outfit;
+    outfit.type = reader.getU16();
+    outfit.ext = reader.getU16();
+    outfit.head = reader.getU16();
+    outfit.body = reader.getU16();
+    outfit.legs = reader.getU16();
+    outfit.feet = reader.getU16();
+    player.setOutfit(outfit);
+    player.setLightColor(reader.getU8());
+    player.setLightLevel(reader.getU8());
+    player.setMaxMana(reader.getU32());
+    player.setMana(reader.getU32());
+    player.setCapacity(reader.getU32());
+    player.setExperience(reader.getU32());
+    player.setMagicLevel(reader.getU32());
+    player.setPartyShield(reader.getU32());
+
+    for (auto inventorySlot = first_inventory_slot; inventorySlot <= last_inventory_slot; inventorySlot++)
+    {
+      if (reader.getU8() == 1)
+      {
+        const ItemPosition rootItemPosition(GamePosition(inventorySlot), 0, 0);
+        auto* item = loadItem(Container::INVALID_ID, rootItemPosition, false, &reader);
+        if (item && !player.getEquipment().addItem(item, inventorySlot))
+        {
+          itemManager_.destroyItem(item->getItemUniqueId());
+        }
+      }
+    }
+
+    std::vector<int> clientContainerIds(reader.getU8());
+    for (auto& clientContainerId : clientContainerIds)
+    {
+      clientContainerId = reader.getU8();
+    }
+    const auto isWalking = reader.getU8() == 1;
+
+    auto* player_ctrl = getPlayerCtrl(playerId);
+    if (reader.failed() || !player_ctrl)
+    {
+      // Its items are left in the ItemManager, as for a player that despawns
+      LOG_DEBUG("%s: skipping player: %s (%d)", __func__, player.getName().c_str(), playerId);
+      continue;
+    }
+
+    playerData_.emplace(std::piecewise_construct,
+                        std::forward_as_tuple(playerId),
+                        std::forward_as_tuple(std::move(player), player_ctrl));
+    auto& playerData = getPlayerData(playerId);
+    player_ctrl->setPlayerId(playerId);
+    containerManager_.playerSpawn(player_ctrl);
+
+    if (world_->restoreCreature(&playerData.player, player_ctrl, position) != World::ReturnCode::OK)
+    {
+      LOG_ERROR("%s: could not restore player: %s (%d)", __func__, playerData.player.getName().c_str(), playerId);
+      containerManager_.playerDespawn(player_ctrl);
+      player_ctrl->setPlayerId(Creature::INVALID_ID);
+      playerData_.erase(playerId);
+      continue;
+    }
+
+    for (const auto clientContainerId : clientContainerIds)
+    {
+      player_ctrl->onCloseContainer(clientContainerId);
+    }
+    if (isWalking)
+    {
+      player_ctrl->cancelMove();
+    }
+    numberOfRestoredPlayers++;
+  }
+
+  if (reader.failed())
+  {
+    LOG_ERROR("%s: snapshot is truncated", __func__);
+    return false;
+  }
+
+  LOG_INFO("%s: restored %d tiles and %d of %d players",
+           __func__,
+           numberOfTiles,
+           numberOfRestoredPlayers,
+           static_cast<int>(numberOfPlayers));
+  return true;
+}
+
+void GameEngine::saveItem(const Item& item, ByteWriter* writer) const
+{
+  writer->addU16(item.getItemTypeId());
+  writer->addU16(item.getCount());
+
+  const auto* container = containerManager_.getContainerOfItem(item.getItemUniqueId());
+  writer->addU8(container ? 1 : 0);
+  if (container)
+  {
+    writer->addU16(container->items.size());
+    for (const auto* containerItem : container->items)
+    {
+      saveItem(*containerItem, writer);
+    }
+  }
+}
+
+Item* GameEngine::loadItem(int parentContainerId,
+                           const ItemPosition& rootItemPosition,
+                           bool mapItem,
+                           ByteReader* reader)
+{
+  const auto itemTypeId = reader->getU16();
+  const auto count = reader->getU16();
+  const auto hasContainer = reader->getU8() == 1;
+  if (reader->failed())
+  {
+    return nullptr;
+  }
+
+  const auto itemUniqueId = mapItem ? itemManager_.createMapItem(itemTypeId) : itemManager_.createItem(itemTypeId);
+  auto* item = itemManager_.getItem(itemUniqueId);
+  if (!item)
+  {
+    LOG_ERROR("%s: could not create item with itemTypeId: %d", __func__, itemTypeId);
+    return nullptr;
+  }
+  if (!itemManager_.isShared(itemUniqueId))
+  {
+    item->setCount(count);
+  }
+
+  if (hasContainer)
+  {
+    // The ItemTypeId of the root item is only known here, rootItemPosition is given without it
+    auto containerRootItemPosition = rootItemPosition;
+    if (parentContainerId == Container::INVALID_ID)
+    {
+      containerRootItemPosition = ItemPosition(rootItemPosition.getGamePosition(),
+                                               itemTypeId,
+                                               rootItemPosition.getStackPosition());
+    }
+    const auto containerId = containerManager_.restoreContainer(item, parentContainerId, containerRootItemPosition);
+    const auto numberOfItems = reader->getU16();
+    for (auto i = 0; i < numberOfItems && !reader->failed(); i++)
+    {
+      auto* containerItem = loadItem(containerId, containerRootItemPosition, false, reader);
+      if (containerItem)
+      {
+        containerManager_.getContainer(containerId)->items.push_back(containerItem);
+      }
+    }
+  }
+
+  return item;
+}
+
 Item* GameEngine::getItem(CreatureId creatureId, const ItemPosition& position)
 {
   // TODO(simon): verify ItemId
@@ -24,38 +24,78 @@
 
 #include "game_engine_queue.h"
 
-GameEngineQueue::GameEngineQueue(GameEngine* gameEngine, boost::asio::io_service* io_service)
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <utility>
+
+#include <boost/date_time/posix_time/posix_time.hpp>  //NOLINT
+
+#include "game_engine.h"
+#include "logger.h"
+
+GameEngineQueue::GameEngineQueue(GameEngine* gameEngine,
+                                 boost::asio::io_service* io_service,
+                                 int tickMs,
+                                 const Clock& clock)
   : gameEngine_(gameEngine),
+    clock_(clock ? clock : Clock(&GameEngineQueue::steadyClockNow)),
+    queues_(),
     timer_(*io_service),
-    timer_started_(false)
+    timer_started_(false),
+    stopped_(false),
+    tickMs_(tickMs),
+    nextTick_(0),
+    onTickEnd_(),
+    budgetMs_(0),
+    metrics_({ 0, 0, 0, 0, 0, 0 }),
+    reportedMetrics_({ 0, 0, 0, 0, 0, 0 }),
+    reportLagUs_(0),
+    overBudgetBatch_(-1),
+    nextReport_(now() + metrics_report_interval_ms * 1000)
+{
+  if (isFixedRate())
+  {
+    // The timer is always running in fixed-rate tick mode
+    nextTick_ = now();
+    startTimer();
+  }
+}
+
+void GameEngineQueue::addTask(int tag, Task&& task)
 {
+  addTask(Priority::ACTION, tag, 0, std::move(task));
 }
 
-void GameEngineQueue::addTask(int tag, const Task& task)
+void GameEngineQueue::addTask(int tag, std::int64_t expire_ms, Task&& task)
 {
-  addTask(tag, 0, task);
+  addTask(Priority::ACTION, tag, expire_ms, std::move(task));
 }
 
-void GameEngineQueue::addTask(int tag, std::int64_t expire_ms, const Task& task)
+void GameEngineQueue::addTask(Priority priority, int tag, Task&& task)
 {
-  auto expire = boost::posix_time::ptime(boost::posix_time::microsec_clock::universal_time()) +
-                boost::posix_time::millisec(expire_ms);
+  addTask(priority, tag, 0, std::move(task));
+}
 
-  // Locate a task with greater, or equal, expire than the given expire
-  auto it = std::find_if(queue_.cbegin(), queue_.cend(), [expire](const TaskWrapper& tw)
-  {
-    return tw.expire >= expire;
-  });
+void GameEngineQueue::addTask(Priority priority, int tag, std::int64_t expire_ms, Task&& task)
+{
+  const auto expire = now() + expire_ms * 1000;
 
-  // Add the new task before the task we found
-  queue_.emplace(it, task, tag, expire);
+  // Tasks with the same expire and priority are called in the order they were added
+  const auto isFirst = empty() || expire < getFirstExpire();
+  queues_[static_cast<int>(priority)].push(tag, expire, std::move(task));
 
-  if (!timer_started_)
+  if (isFixedRate() || stopped_)
+  {
+    // Run on the next tick, or when resumed
+    return;
+  }
+  else if (!timer_started_)
   {
     // If the timer isn't started, start it!
     startTimer();
   }
-  else if (it == queue_.cbegin())
+  else if (isFirst)
   {
     // If the timer is started but we added a task with lower expire than the
     // previously lowest expire, then cancel the timer and let it restart
@@ -65,33 +105,86 @@ void GameEngineQueue::addTask(int tag, std::int64_t expire_ms, const Task& task)
 
 void GameEngineQueue::cancelAllTasks(int tag)
 {
-  if (!queue_.empty())
+  // If the first task had this tag the timer expires too early, but then it is just restarted
+  for (auto& queue : queues_)
   {
-    // If the first task in the queue has this tag we need to restart the timer after removing them
-    bool restart_timer = false;
-    if (queue_.front().tag == tag)
-    {
-      restart_timer = true;
-    }
+    queue.cancel(tag);
+  }
+}
 
-    // Erase all tasks with given tag
-    auto pred = [tag](const TaskWrapper& tw) { return tw.tag == tag; };
-    queue_.erase(std::remove_if(queue_.begin(), queue_.end(), pred), queue_.end());
+void GameEngineQueue::stop()
+{
+  // The timer is left running, see onTimeout
+  stopped_ = true;
+}
 
-    // Restart the timer if restart_timer is true AND if the queue is not empty
-    if (restart_timer && !queue_.empty())
+void GameEngineQueue::resume()
+{
+  if (!stopped_)
+  {
+    return;
+  }
+  stopped_ = false;
+
+  if (timer_started_ && !isFixedRate())
+  {
+    // Tasks may have been added while stopped, let the timer restart with the first expire
+    timer_.cancel();
+  }
+  else if (!timer_started_ && isFixedRate())
+  {
+    // The ticks are kept at the fixed rate from now, see startTimer
+    nextTick_ = now() - tickMs_ * 1000;
+    startTimer();
+  }
+  else if (!timer_started_ && !empty())
+  {
+    startTimer();
+  }
+}
+
+bool GameEngineQueue::empty() const
+{
+  return std::all_of(queues_.cbegin(), queues_.cend(), [](const TaskQueue<Task>& queue)
+  {
+    return queue.empty();
+  });
+}
+
+std::int64_t GameEngineQueue::getFirstExpire() const
+{
+  auto firstExpire = std::numeric_limits<std::int64_t>::max();
+  for (const auto& queue : queues_)
+  {
+    if (!queue.empty())
     {
-      timer_.cancel();
+      firstExpire = std::min(firstExpire, queue.getFirstExpire());
     }
   }
+  return firstExpire;
+}
+
+std::int64_t GameEngineQueue::steadyClockNow()
+{
+  const auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::microseconds>(now).count();
 }
 
 void GameEngineQueue::startTimer()
 {
   // Start timer
-  boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
-  boost::posix_time::ptime taskExpire(queue_.front().expire);
-  timer_.expires_from_now(taskExpire - now);
+  if (isFixedRate())
+  {
+    // If the previous tick took too long, the next tick starts directly and the following
+    // ticks are kept at the fixed rate from there, instead of running the missed ticks back to back
+    const auto current = now();
+    nextTick_ = std::max(nextTick_ + tickMs_ * 1000, current);
+    timer_.expires_from_now(boost::posix_time::microseconds(nextTick_ - current));
+  }
+  else
+  {
+    timer_.expires_from_now(boost::posix_time::microseconds(getFirstExpire() - now()));
+  }
 
   timer_.async_wait([this](const boost::system::error_code& ec)
   {
@@ -103,10 +196,29 @@ void GameEngineQueue::startTimer()
 
 void GameEngineQueue::onTimeout(const boost::system::error_code& ec)
 {
-  if (ec == boost::asio::error::operation_aborted)
+  if (stopped_)
+  {
+    // Restarted by resume
+    timer_started_ = false;
+    return;
+  }
+  else if (ec == boost::asio::error::operation_aborted && isFixedRate())
+  {
+    // Only when the GameEngineQueue is destroyed
+    return;
+  }
+  else if (ec == boost::asio::error::operation_aborted)
   {
     // Canceled by addTask, so just restart the timer
-    startTimer();
+    // (unless all tasks have been canceled since then)
+    if (!empty())
+    {
+      startTimer();
+    }
+    else
+    {
+      timer_started_ = false;
+    }
     return;
   }
   else if (ec)
@@ -115,24 +227,27 @@ void GameEngineQueue::onTimeout(const boost::system::error_code& ec)
     abort();
   }
 
-  // Call all tasks that have expired
-  boost::posix_time::ptime now(boost::posix_time::microsec_clock::universal_time());
-  while (!queue_.empty())
+  const auto current = now();
+  if (runTasks(current))
   {
-    if (queue_.front().expire > now)
-    {
-      break;
-    }
-
-    // More tasks can be added to the queue when calling task()
-    // So copy the task and remove it from the queue before calling task(), to avoid problems
-    auto tw = queue_.front();
-    queue_.erase(queue_.begin());
-    tw.task(gameEngine_);
+    overBudgetBatch_ = -1;
+  }
+  else
+  {
+    metrics_.batchesOverBudget += 1;
+    overBudgetBatch_ = current;
   }
+  gameEngine_->endTick();
+  if (onTickEnd_)
+  {
+    onTickEnd_();
+  }
+  reportMetrics(current);
 
-  // Start the timer again if there are more tasks in the queue
-  if (!queue_.empty())
+  // Start the timer again if there are more tasks in the queue (always in fixed-rate tick mode)
+  // If the budget ran out the first expire has already passed, so the timer expires directly
+  // and lets the io_service handle other events (e.g. network) in between
+  if (isFixedRate() || !empty())
   {
     startTimer();
   }
@@ -141,3 +256,71 @@ void GameEngineQueue::onTimeout(const boost::system::error_code& ec)
     timer_started_ = false;
   }
 }
+
+bool GameEngineQueue::runTasks(std::int64_t current)
+{
+  const auto deadline = current + budgetMs_ * 1000;
+  metrics_.lastLagUs = 0;
+
+  // Call all tasks that have expired, with the highest priority first
+  // More tasks can be added to the queue when calling task(), so the task is removed from the queue first
+  for (auto priority = 0; priority < number_of_priorities; priority++)
+  {
+    auto& queue = queues_[priority];
+    while (!queue.empty() && queue.getFirstExpire() <= current)
+    {
+      // LOGIN tasks are always run, so that players can log in and out also under load
+      if (budgetMs_ > 0 && priority != static_cast<int>(Priority::LOGIN) && now() >= deadline)
+      {
+        return false;
+      }
+
+      // Tasks that expired before the previous batch ran out of budget were deferred by it
+      const auto expire = queue.getFirstExpire();
+      if (expire <= overBudgetBatch_)
+      {
+        metrics_.tasksDeferred += 1;
+      }
+
+      const auto lag = current - expire;
+      auto task = queue.pop();
+      if (priority == static_cast<int>(Priority::LOW) && lag > shed_lag_ms * 1000)
+      {
+        metrics_.tasksShed += 1;
+        continue;
+      }
+
+      metrics_.maxLagUs = std::max(metrics_.maxLagUs, lag);
+      metrics_.lastLagUs = std::max(metrics_.lastLagUs, lag);
+      reportLagUs_ = std::max(reportLagUs_, lag);
+      metrics_.tasksRun += 1;
+      task(gameEngine_);
+    }
+  }
+  return true;
+}
+
+void GameEngineQueue::reportMetrics(std::int64_t current)
+{
+  if (current < nextReport_)
+  {
+    return;
+  }
+
+  if (metrics_.batchesOverBudget != reportedMetrics_.batchesOverBudget ||
+      metrics_.tasksShed != reportedMetrics_.tasksShed)
+  {
+    LOG_INFO("%s: engine overloaded, tasks run: %d, batches over budget: %d, tasks deferred: %d, tasks shed: %d, "
+             "max lag: %d ms",
+             __func__,
+             static_cast<int>(metrics_.tasksRun - reportedMetrics_.tasksRun),
+             static_cast<int>(metrics_.batchesOverBudget - reportedMetrics_.batchesOverBudget),
+             static_cast<int>(metrics_.tasksDeferred - reportedMetrics_.tasksDeferred),
+             static_cast<int>(metrics_.tasksShed - reportedMetrics_.tasksShed),
+             static_cast<int>(reportLagUs_ / 1000));
+  }
+
+  reportedMetrics_ = metrics_;
+  reportLagUs_ = 0;
+  nextReport_ = current + metrics_report_interval_ms * 1000;
+}
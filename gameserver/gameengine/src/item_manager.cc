@@ -26,14 +26,125 @@
 
 #include <cstdio>
 #include <cstring>
-#include <fstream>
-#include <sstream>
+#include <type_traits>
+#include <vector>
 
-#include "rapidxml.hpp"
+#include "checksum.h"
 #include "logger.h"
+#include "mapped_file.h"
+#include "xml_document.h"
 
-bool ItemManager::loadItemTypes(const std::string& dataFilename, const std::string& itemsFilename)
+namespace
 {
+
+ItemCategory getItemCategory(const std::string& type)
+{
+  if (type.empty())             return ItemCategory::NONE;
+  else if (type == "armor")     return ItemCategory::ARMOR;
+  else if (type == "container") return ItemCategory::CONTAINER;
+  else if (type == "ammo")      return ItemCategory::AMMO;
+  else                          return ItemCategory::OTHER;
+}
+
+ItemSlot getItemSlot(const std::string& position)
+{
+  if (position.empty())            return ItemSlot::NONE;
+  else if (position == "helmet")   return ItemSlot::HELMET;
+  else if (position == "amulet")   return ItemSlot::AMULET;
+  else if (position == "body")     return ItemSlot::BODY;
+  else if (position == "legs")     return ItemSlot::LEGS;
+  else if (position == "boots")    return ItemSlot::BOOTS;
+  else if (position == "ring")     return ItemSlot::RING;
+  else                             return ItemSlot::OTHER;
+}
+
+// Item types cache file format (native byte order, the cache is made on the machine that uses it):
+//   CacheHeader
+//   CachedItemType for each ItemTypeId from first to last
+//   strings, each terminated by '\0', referenced by offset from CachedItemType
+constexpr char cache_magic[4] = { 'I', 'T', 'C', 'H' };
+constexpr std::uint32_t cache_version = 1;
+
+struct CacheHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t sourcesChecksum;
+  std::uint32_t first;
+  std::uint32_t last;
+  std::uint32_t stringsSize;
+  std::uint32_t padding;
+};
+
+struct CachedItemType
+{
+  std::uint16_t flags;
+  std::uint16_t speed;
+  std::uint16_t maxitems;
+  std::uint8_t handed;
+  std::uint8_t category;
+  std::uint8_t slot;
+  std::uint8_t padding[3];
+  std::int32_t weight;
+  std::int32_t decayto;
+  std::int32_t decaytime;
+  std::int32_t damage;
+  std::int32_t attack;
+  std::int32_t defence;
+  std::int32_t arm;
+  std::int32_t shottype;
+
+  // name, type, position, skill, descr and amutype
+  std::uint32_t strings[6];
+};
+
+static_assert(std::is_trivially_copyable<CacheHeader>::value && sizeof(CacheHeader) == 32,
+              "CacheHeader must have a fixed layout");
+static_assert(std::is_trivially_copyable<CachedItemType>::value && sizeof(CachedItemType) == 68,
+              "CachedItemType must have a fixed layout");
+
+std::uint16_t packFlags(const ItemType& itemType)
+{
+  return (itemType.ground                << 0) |
+         (itemType.isBlocking            << 1) |
+         (itemType.isBlockingProjectiles << 2) |
+         (itemType.alwaysOnTop           << 3) |
+         (itemType.isContainer           << 4) |
+         (itemType.isStackable           << 5) |
+         (itemType.isUsable              << 6) |
+         (itemType.isMultitype           << 7) |
+         (itemType.isNotMovable          << 8) |
+         (itemType.isEquipable           << 9);
+}
+
+void unpackFlags(std::uint16_t flags, ItemType* itemType)
+{
+  itemType->ground                = flags & (1 << 0);
+  itemType->isBlocking            = flags & (1 << 1);
+  itemType->isBlockingProjectiles = flags & (1 << 2);
+  itemType->alwaysOnTop           = flags & (1 << 3);
+  itemType->isContainer           = flags & (1 << 4);
+  itemType->isStackable           = flags & (1 << 5);
+  itemType->isUsable              = flags & (1 << 6);
+  itemType->isMultitype           = flags & (1 << 7);
+  itemType->isNotMovable          = flags & (1 << 8);
+  itemType->isEquipable           = flags & (1 << 9);
+}
+
+}  // namespace
+
+bool ItemManager::loadItemTypes(const std::string& dataFilename,
+                                const std::string& itemsFilename,
+                                const std::string& cacheFilename)
+{
+  std::uint64_t sourcesChecksum;
+  if (!cacheFilename.empty() &&
+      getSourcesChecksum(dataFilename, itemsFilename, &sourcesChecksum) &&
+      loadItemTypesCache(cacheFilename, sourcesChecksum))
+  {
+    return true;
+  }
+
   if (!loadItemTypesDataFile(dataFilename))
   {
     LOG_ERROR("%s: could not load datafile: %s", __func__, dataFilename.c_str());
@@ -51,16 +162,35 @@ bool ItemManager::loadItemTypes(const std::string& dataFilename, const std::stri
 
 ItemUniqueId ItemManager::createItem(ItemTypeId itemTypeId)
 {
-  if (itemTypeId < itemTypesIdFirst_ || itemTypeId > itemTypesIdLast_)
+  if (!isValidItemTypeId(itemTypeId))
   {
     LOG_ERROR("%s: itemTypeId: %d out of range", __func__, itemTypeId);
     return 0;  // TODO(simon): invalid ItemId (see header and game_position.h)
   }
 
-  const auto itemUniqueId = nextItemUniqueId_;
-  ++nextItemUniqueId_;
+  // Reuse the last freed slot, or take a new slot (and a new chunk if needed)
+  std::uint32_t index;
+  if (freeSlot_ != invalid_slot)
+  {
+    index = freeSlot_;
+    freeSlot_ = slotAt(index).nextFreeSlot;
+  }
+  else
+  {
+    if (numberOfSlots_ % items_per_chunk == 0)
+    {
+      chunks_.emplace_back(new Slot[items_per_chunk]);
+    }
+    index = numberOfSlots_;
+    ++numberOfSlots_;
+  }
+
+  auto& slot = slotAt(index);
+  const auto itemUniqueId = (static_cast<ItemUniqueId>(slot.generation) << 32) | (index + 1);
+  slot.item = Item(itemUniqueId, &itemTypes_[itemTypeId]);
+  slot.nextFreeSlot = invalid_slot;
+  ++numberOfItems_;
 
-  items_.emplace(itemUniqueId, ItemImpl(itemUniqueId, &itemTypes_[itemTypeId]));
   LOG_DEBUG("%s: created Item with itemUniqueId: %lu, itemTypeId: %d", __func__, itemUniqueId, itemTypeId);
 
   return itemUniqueId;
@@ -68,24 +198,305 @@ ItemUniqueId ItemManager::createItem(ItemTypeId itemTypeId)
 
 void ItemManager::destroyItem(ItemUniqueId itemUniqueId)
 {
-  if (items_.count(itemUniqueId) == 0)
+  auto* slot = getSlot(itemUniqueId);
+  if (!slot)
   {
     LOG_ERROR("%s: could not find Item with itemUniqueId: %lu", __func__, itemUniqueId);
     return;
   }
 
+  if (isShared(itemUniqueId))
+  {
+    // Shared Items live as long as the ItemManager
+    return;
+  }
+
   LOG_DEBUG("%s: destroying Item with itemUniqueId: %lu", __func__, itemUniqueId);
-  items_.erase(itemUniqueId);
+
+  // Any handle to the destroyed item is now invalid, also after the slot has been reused
+  slot->item = Item(0, nullptr);
+  ++slot->generation;
+  slot->nextFreeSlot = freeSlot_;
+  freeSlot_ = static_cast<std::uint32_t>((itemUniqueId & 0xFFFFFFFF) - 1);
+  --numberOfItems_;
+}
+
+ItemUniqueId ItemManager::createMapItem(ItemTypeId itemTypeId)
+{
+  if (!isValidItemTypeId(itemTypeId))
+  {
+    LOG_ERROR("%s: itemTypeId: %d out of range", __func__, itemTypeId);
+    return 0;  // TODO(simon): invalid ItemId (see header and game_position.h)
+  }
+
+  if (!isShareable(itemTypeId))
+  {
+    return createItem(itemTypeId);
+  }
+
+  if (sharedItems_[itemTypeId] == 0)
+  {
+    sharedItems_[itemTypeId] = createItem(itemTypeId);
+  }
+  return sharedItems_[itemTypeId];
+}
+
+void ItemManager::createSharedMapItems()
+{
+  for (auto itemTypeId = itemTypesIdFirst_; itemTypeId <= itemTypesIdLast_; itemTypeId++)
+  {
+    if (isShareable(itemTypeId) && sharedItems_[itemTypeId] == 0)
+    {
+      sharedItems_[itemTypeId] = createItem(itemTypeId);
+    }
+  }
+}
+
+Item* ItemManager::getSharedMapItem(ItemTypeId itemTypeId)
+{
+  if (!isValidItemTypeId(itemTypeId) || sharedItems_[itemTypeId] == 0)
+  {
+    return nullptr;
+  }
+  return getItem(sharedItems_[itemTypeId]);
+}
+
+ItemUniqueId ItemManager::makeUnique(ItemUniqueId itemUniqueId)
+{
+  if (!isShared(itemUniqueId))
+  {
+    return itemUniqueId;
+  }
+
+  LOG_DEBUG("%s: copying shared Item with itemUniqueId: %lu", __func__, itemUniqueId);
+  return createItem(getSlot(itemUniqueId)->item.getItemTypeId());
+}
+
+bool ItemManager::isShared(ItemUniqueId itemUniqueId) const
+{
+  const auto* slot = getSlot(itemUniqueId);
+  return slot && sharedItems_[slot->item.getItemTypeId()] == itemUniqueId;
 }
 
 Item* ItemManager::getItem(ItemUniqueId itemUniqueId)
 {
-  if (items_.count(itemUniqueId) == 0)
+  auto* slot = getSlot(itemUniqueId);
+  return slot ? &slot->item : nullptr;
+}
+
+ItemManager::Slot* ItemManager::getSlot(ItemUniqueId itemUniqueId)
+{
+  return const_cast<Slot*>(static_cast<const ItemManager*>(this)->getSlot(itemUniqueId));
+}
+
+const ItemManager::Slot* ItemManager::getSlot(ItemUniqueId itemUniqueId) const
+{
+  const auto index = itemUniqueId & 0xFFFFFFFF;
+  if (index == 0 || index > numberOfSlots_)
   {
     return nullptr;
   }
 
-  return &items_.at(itemUniqueId);
+  const auto& slot = slotAt(static_cast<std::uint32_t>(index - 1));
+  if (slot.item.getItemUniqueId() != itemUniqueId)
+  {
+    // Destroyed, or a handle from an older generation
+    return nullptr;
+  }
+
+  return &slot;
+}
+
+bool ItemManager::saveItemTypesCache(const std::string& dataFilename,
+                                     const std::string& itemsFilename,
+                                     const std::string& cacheFilename) const
+{
+  CacheHeader header;
+  std::memcpy(header.magic, cache_magic, sizeof(header.magic));
+  header.version = cache_version;
+  if (!getSourcesChecksum(dataFilename, itemsFilename, &header.sourcesChecksum))
+  {
+    return false;
+  }
+  header.first = itemTypesIdFirst_;
+  header.last = itemTypesIdLast_;
+  header.padding = 0;
+
+  std::vector<CachedItemType> cachedItemTypes;
+  std::vector<char> strings;
+  for (auto id = itemTypesIdFirst_; id <= itemTypesIdLast_; id++)
+  {
+    const auto& itemType = itemTypes_[id];
+    const auto& details = itemTypesDetails_[id];
+
+    CachedItemType cached = {};
+    cached.flags = packFlags(itemType);
+    cached.speed = itemType.speed;
+    cached.maxitems = itemType.maxitems;
+    cached.handed = itemType.handed;
+    cached.category = static_cast<std::uint8_t>(itemType.category);
+    cached.slot = static_cast<std::uint8_t>(itemType.slot);
+    cached.weight = itemType.weight;
+    cached.decayto = itemType.decayto;
+    cached.decaytime = itemType.decaytime;
+    cached.damage = details.damage;
+    cached.attack = details.attack;
+    cached.defence = details.defence;
+    cached.arm = details.arm;
+    cached.shottype = details.shottype;
+
+    const std::string* detailsStrings[] =
+    {
+      &details.name, &details.type, &details.position, &details.skill, &details.descr, &details.amutype
+    };
+    for (auto i = 0; i < 6; i++)
+    {
+      cached.strings[i] = strings.size();
+      strings.insert(strings.end(), detailsStrings[i]->cbegin(), detailsStrings[i]->cend());
+      strings.push_back('\0');
+    }
+
+    cachedItemTypes.push_back(cached);
+  }
+  header.stringsSize = strings.size();
+
+  auto* file = fopen(cacheFilename.c_str(), "wb");
+  if (file == nullptr)
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, cacheFilename.c_str());
+    return false;
+  }
+
+  auto ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(cachedItemTypes.data(), sizeof(CachedItemType), cachedItemTypes.size(), file) ==
+             cachedItemTypes.size();
+  ok = ok && fwrite(strings.data(), 1, strings.size(), file) == strings.size();
+  ok = (fclose(file) == 0) && ok;
+  if (!ok)
+  {
+    LOG_ERROR("%s: could not write file: %s", __func__, cacheFilename.c_str());
+    std::remove(cacheFilename.c_str());
+    return false;
+  }
+
+  LOG_INFO("%s: saved %d item types to: %s",
+           __func__,
+           static_cast<int>(cachedItemTypes.size()),
+           cacheFilename.c_str());
+  return true;
+}
+
+bool ItemManager::getSourcesChecksum(const std::string& dataFilename,
+                                     const std::string& itemsFilename,
+                                     std::uint64_t* checksum)
+{
+  MappedFile dataFile;
+  MappedFile itemsFile;
+  if (!dataFile.open(dataFilename) || !itemsFile.open(itemsFilename))
+  {
+    LOG_ERROR("%s: could not open %s or %s", __func__, dataFilename.c_str(), itemsFilename.c_str());
+    return false;
+  }
+
+  *checksum = Checksum::fnv1a(dataFile.getData(), dataFile.getSize());
+  *checksum = Checksum::fnv1a(itemsFile.getData(), itemsFile.getSize(), *checksum);
+  return true;
+}
+
+bool ItemManager::loadItemTypesCache(const std::string& cacheFilename, std::uint64_t sourcesChecksum)
+{
+  MappedFile file;
+  if (!file.open(cacheFilename))
+  {
+    LOG_INFO("%s: no item types cache: %s, loading source files", __func__, cacheFilename.c_str());
+    return false;
+  }
+
+  // The cache is mapped, so the records are copied out of it directly instead of being parsed
+  CacheHeader header;
+  if (file.getSize() < sizeof(header))
+  {
+    LOG_ERROR("%s: invalid item types cache: %s", __func__, cacheFilename.c_str());
+    return false;
+  }
+  std::memcpy(&header, file.getData(), sizeof(header));
+
+  if (std::memcmp(header.magic, cache_magic, sizeof(header.magic)) != 0 ||
+      header.version != cache_version ||
+      header.first > header.last ||
+      header.last >= itemTypes_.size() ||
+      header.stringsSize == 0 ||
+      file.getSize() != sizeof(header) + ((header.last - header.first + 1) * sizeof(CachedItemType)) +
+                        header.stringsSize)
+  {
+    LOG_ERROR("%s: invalid item types cache: %s", __func__, cacheFilename.c_str());
+    return false;
+  }
+
+  if (header.sourcesChecksum != sourcesChecksum)
+  {
+    LOG_INFO("%s: item types cache: %s is out of date, loading source files", __func__, cacheFilename.c_str());
+    return false;
+  }
+
+  const auto* records = file.getData() + sizeof(header);
+  const auto* strings = reinterpret_cast<const char*>(records + ((header.last - header.first + 1) *
+                                                                 sizeof(CachedItemType)));
+  if (strings[header.stringsSize - 1] != '\0')
+  {
+    LOG_ERROR("%s: invalid item types cache: %s", __func__, cacheFilename.c_str());
+    return false;
+  }
+
+  for (auto id = header.first; id <= header.last; id++)
+  {
+    CachedItemType cached;
+    std::memcpy(&cached, records + ((id - header.first) * sizeof(CachedItemType)), sizeof(cached));
+    for (const auto offset : cached.strings)
+    {
+      if (offset >= header.stringsSize)
+      {
+        LOG_ERROR("%s: invalid item types cache: %s", __func__, cacheFilename.c_str());
+        return false;
+      }
+    }
+
+    auto& itemType = itemTypes_[id];
+    itemType = ItemType();
+    itemType.id = id;
+    unpackFlags(cached.flags, &itemType);
+    itemType.speed = cached.speed;
+    itemType.maxitems = cached.maxitems;
+    itemType.handed = cached.handed;
+    itemType.category = static_cast<ItemCategory>(cached.category);
+    itemType.slot = static_cast<ItemSlot>(cached.slot);
+    itemType.weight = cached.weight;
+    itemType.decayto = cached.decayto;
+    itemType.decaytime = cached.decaytime;
+    itemType.details = &itemTypesDetails_[id];
+
+    auto& details = itemTypesDetails_[id];
+    details.damage = cached.damage;
+    details.attack = cached.attack;
+    details.defence = cached.defence;
+    details.arm = cached.arm;
+    details.shottype = cached.shottype;
+    details.name = strings + cached.strings[0];
+    details.type = strings + cached.strings[1];
+    details.position = strings + cached.strings[2];
+    details.skill = strings + cached.strings[3];
+    details.descr = strings + cached.strings[4];
+    details.amutype = strings + cached.strings[5];
+  }
+
+  itemTypesIdFirst_ = header.first;
+  itemTypesIdLast_ = header.last;
+
+  LOG_INFO("%s: Successfully loaded %d items from cache: %s",
+           __func__,
+           itemTypesIdLast_ - itemTypesIdFirst_ + 1,
+           cacheFilename.c_str());
+  return true;
 }
 
 bool ItemManager::loadItemTypesDataFile(const std::string& dataFilename)
@@ -111,6 +522,7 @@ bool ItemManager::loadItemTypesDataFile(const std::string& dataFilename)
   {
     ItemType itemType;
     itemType.id = nextItemTypeId;
+    itemType.details = &itemTypesDetails_[nextItemTypeId];
 
     int optByte = fgetc(f);
     while (optByte  >= 0 && optByte != 0xFF)
@@ -180,6 +592,13 @@ bool ItemManager::loadItemTypesDataFile(const std::string& dataFilename)
           break;
         }
 
+        case 0x0D:
+        {
+          // Blocks projectiles
+          itemType.isBlockingProjectiles = true;
+          break;
+        }
+
         case 0x0F:
         {
           // Equipable
@@ -196,7 +615,6 @@ bool ItemManager::loadItemTypesDataFile(const std::string& dataFilename)
 
         case 0x06:
         case 0x09:
-        case 0x0D:
         case 0x0E:
         case 0x11:
         case 0x12:
@@ -261,33 +679,18 @@ bool ItemManager::loadItemTypesDataFile(const std::string& dataFilename)
 
 bool ItemManager::loadItemTypesItemsFile(const std::string& itemsFilename)
 {
-  std::ifstream xmlFile(itemsFilename);
-  if (!xmlFile.is_open())
+  XmlDocument itemXml;
+  if (!itemXml.loadFile(itemsFilename))
   {
-    LOG_ERROR("%s: Could not open file: %s", __func__, itemsFilename.c_str());
+    LOG_ERROR("%s: Could not load file: %s", __func__, itemsFilename.c_str());
     return false;
   }
 
-  std::string tempString;
-  std::ostringstream xmlStringStream;
-  while (std::getline(xmlFile, tempString))
-  {
-    xmlStringStream << tempString << "\n";
-  }
-
-  // Convert the std::string to a char*
-  char* xmlString = strdup(xmlStringStream.str().c_str());
-
-  // Parse the XML string with Rapidxml
-  rapidxml::xml_document<> itemXml;
-  itemXml.parse<0>(xmlString);
-
   // Get top node (<items>)
-  auto* itemsNode = itemXml.first_node("items");
+  const auto* itemsNode = itemXml.getFirstNode("items");
   if (itemsNode == nullptr)
   {
     LOG_ERROR("%s: Invalid file: Could not find node <items>", __func__);
-    free(xmlString);
     return false;
   }
 
@@ -298,14 +701,12 @@ bool ItemManager::loadItemTypesItemsFile(const std::string& itemsFilename)
     numberOfItems++;
 
     // Get id
-    auto* xmlAttrId = itemNode->first_attribute("id");
-    if (xmlAttrId == nullptr)
+    int itemId;
+    if (!XmlDocument::getInteger(itemNode, "id", &itemId))
     {
-      LOG_ERROR("%s: Invalid file: <item> has no attribute \"id\"", __func__);
-      free(xmlString);
+      LOG_ERROR("%s: Invalid file: <item> has no integer attribute \"id\"", __func__);
       return false;
     }
-    auto itemId = std::stoi(xmlAttrId->value());
 
     // Verify that this item has been loaded
     if (itemId < itemTypesIdFirst_ || itemId > itemTypesIdLast_)
@@ -314,102 +715,114 @@ bool ItemManager::loadItemTypesItemsFile(const std::string& itemsFilename)
     }
 
     auto& itemType = itemTypes_[itemId];
+    auto& details = itemTypesDetails_[itemId];
 
     // Get name
     auto* xmlAttrName = itemNode->first_attribute("name");
     if (xmlAttrName == nullptr)
     {
       LOG_ERROR("%s: <item>-node has no attribute \"name\"", __func__);
-      free(xmlString);
       return false;
     }
-    itemType.name = xmlAttrName->value();
+    details.name = xmlAttrName->value();
 
     // Iterate over all rest of attributes
     for (auto* xmlAttrOther = itemNode->first_attribute();
          xmlAttrOther != nullptr;
          xmlAttrOther = xmlAttrOther->next_attribute())
     {
-      std::string attrName(xmlAttrOther->name());
-      if (attrName == "id" || attrName == "name")
+      const auto* attrName = xmlAttrOther->name();
+      if (std::strcmp(attrName, "id") == 0 || std::strcmp(attrName, "name") == 0)
       {
         // We have already these attributes
         continue;
       }
 
-      std::string attrValue(xmlAttrOther->value());
+      const auto* attrValue = xmlAttrOther->value();
 
       // Handle attributes here
-      if (attrName == "weight")
+      auto ok = true;
+      int value = 0;
+      if (std::strcmp(attrName, "weight") == 0)
       {
-        itemType.weight = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &itemType.weight);
       }
-      else if (attrName == "decayto")
+      else if (std::strcmp(attrName, "decayto") == 0)
       {
-        itemType.decayto = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &itemType.decayto);
       }
-      else if (attrName == "decaytime")
+      else if (std::strcmp(attrName, "decaytime") == 0)
       {
-        itemType.decaytime = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &itemType.decaytime);
       }
-      else if (attrName == "damage")
+      else if (std::strcmp(attrName, "damage") == 0)
       {
-        itemType.damage = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &details.damage);
       }
-      else if (attrName == "maxitems")
+      else if (std::strcmp(attrName, "maxitems") == 0)
       {
-        itemType.maxitems = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &value);
+        itemType.maxitems = value;
       }
-      else if (attrName == "type")
+      else if (std::strcmp(attrName, "type") == 0)
       {
-        itemType.type = attrValue;
+        details.type = attrValue;
       }
-      else if (attrName == "position")
+      else if (std::strcmp(attrName, "position") == 0)
       {
-        itemType.position = attrValue;
+        details.position = attrValue;
       }
-      else if (attrName == "attack")
+      else if (std::strcmp(attrName, "attack") == 0)
       {
-        itemType.attack = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &details.attack);
       }
-      else if (attrName == "defence")
+      else if (std::strcmp(attrName, "defence") == 0)
       {
-        itemType.defence = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &details.defence);
       }
-      else if (attrName == "arm")
+      else if (std::strcmp(attrName, "arm") == 0)
       {
-        itemType.arm = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &details.arm);
       }
-      else if (attrName == "skill")
+      else if (std::strcmp(attrName, "skill") == 0)
       {
-        itemType.skill = attrValue;
+        details.skill = attrValue;
       }
-      else if (attrName == "descr")
+      else if (std::strcmp(attrName, "descr") == 0)
       {
-        itemType.descr = attrValue;
+        details.descr = attrValue;
       }
-      else if (attrName == "handed")
+      else if (std::strcmp(attrName, "handed") == 0)
       {
-        itemType.handed = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &value);
+        itemType.handed = value;
       }
-      else if (attrName == "shottype")
+      else if (std::strcmp(attrName, "shottype") == 0)
       {
-        itemType.shottype = std::stoi(attrValue.c_str());
+        ok = XmlDocument::parseInteger(attrValue, &details.shottype);
       }
-      else if (attrName == "amutype")
+      else if (std::strcmp(attrName, "amutype") == 0)
       {
-        itemType.amutype = attrValue;
+        details.amutype = attrValue;
       }
       else
       {
-        LOG_ERROR("%s: unhandled attribute name: %s", __func__, attrName.c_str());
-        free(xmlString);
+        LOG_ERROR("%s: unhandled attribute name: %s", __func__, attrName);
+        return false;
+      }
+
+      if (!ok)
+      {
+        LOG_ERROR("%s: attribute %s of item %d is not an integer: %s", __func__, attrName, itemId, attrValue);
         return false;
       }
     }
+
+    // Resolve the strings that Equipment needs, so that it doesn't need to compare strings
+    itemType.category = getItemCategory(details.type);
+    itemType.slot = getItemSlot(details.position);
   }
 
   LOG_INFO("%s: Successfully loaded %d items", __func__, numberOfItems);
-  free(xmlString);
   return true;
 }
@@ -27,62 +27,132 @@
 
 #include <cstdint>
 #include <array>
+#include <memory>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "item.h"
 
+// Items are stored in chunks of slots, so that pointers to them stay valid until the item is
+// destroyed, and destroyed slots are reused (last destroyed first) through a free list.
+//
+// An ItemUniqueId is a handle to a slot: the low 32 bits are the slot index + 1 (so that 0 is
+// never a valid ItemUniqueId) and the high 32 bits are the generation of the slot, which is
+// increased each time an item in the slot is destroyed. This makes createItem, destroyItem and
+// getItem O(1) without any hashing, and getItem returns nullptr for handles to destroyed items.
+//
+// Static map items (see createMapItem) are shared: there is one Item per ItemType, which is
+// never destroyed, and which must not be mutated. Use makeUnique to get an Item that can be.
 class ItemManager
 {
  public:
+  static constexpr std::uint32_t items_per_chunk = 1024;
+
   ItemManager()
-    : items_(),
-      nextItemUniqueId_(1),  // TODO(simon): 0 is used as invalid itemId in game_position.h
+    : chunks_(),
+      numberOfSlots_(0),
+      freeSlot_(invalid_slot),
+      numberOfItems_(0),
+      sharedItems_(),
       itemTypes_(),
+      itemTypesDetails_(),
       itemTypesIdFirst_(0),
       itemTypesIdLast_(0)
   {
   }
 
-  bool loadItemTypes(const std::string& dataFilename, const std::string& itemsFilename);
+  // Delete copy constructors
+  ItemManager(const ItemManager&) = delete;
+  ItemManager& operator=(const ItemManager&) = delete;
+
+  // If cacheFilename is given, and the cache was made from the same data and items files (see
+  // saveItemTypesCache), the item types are loaded from the cache instead of the source files
+  bool loadItemTypes(const std::string& dataFilename,
+                     const std::string& itemsFilename,
+                     const std::string& cacheFilename = "");
+
+  // Writes the loaded item types to a binary file, together with a checksum of the source files
+  bool saveItemTypesCache(const std::string& dataFilename,
+                          const std::string& itemsFilename,
+                          const std::string& cacheFilename) const;
 
   ItemUniqueId createItem(ItemTypeId itemTypeId);
   void destroyItem(ItemUniqueId itemUniqueId);
 
+  // Returns the shared Item for ground and non-movable items, unless they are stackable or
+  // containers (which have state of their own), otherwise a new Item as createItem
+  ItemUniqueId createMapItem(ItemTypeId itemTypeId);
+
+  // Creates the shared Item of every ItemType that can be shared up front, see getSharedMapItem
+  void createSharedMapItems();
+
+  // Returns the shared Item of the ItemType if it has been created, otherwise nullptr (also if
+  // the ItemType can't be shared). Doesn't modify anything, so it can be called from several
+  // threads at the same time, as long as no Items are created or destroyed meanwhile.
+  Item* getSharedMapItem(ItemTypeId itemTypeId);
+
+  // Copy-on-write: returns a new Item of the same ItemType if itemUniqueId is shared, otherwise
+  // itemUniqueId itself. The caller must replace the shared Item (e.g. on its Tile) with the new one.
+  ItemUniqueId makeUnique(ItemUniqueId itemUniqueId);
+  bool isShared(ItemUniqueId itemUniqueId) const;
+
   Item* getItem(ItemUniqueId itemUniqueId);
 
+  std::size_t getNumberOfItems() const { return numberOfItems_; }
+
  private:
+  static constexpr std::uint32_t invalid_slot = 0xFFFFFFFF;
+
+  bool isValidItemTypeId(ItemTypeId itemTypeId) const
+  {
+    return itemTypeId >= itemTypesIdFirst_ && itemTypeId <= itemTypesIdLast_;
+  }
+
+  bool isShareable(ItemTypeId itemTypeId) const
+  {
+    const auto& itemType = itemTypes_[itemTypeId];
+    return (itemType.ground || itemType.isNotMovable) && !itemType.isStackable && !itemType.isContainer;
+  }
+
   bool loadItemTypesDataFile(const std::string& dataFilename);
   bool loadItemTypesItemsFile(const std::string& itemsFilename);
+  bool loadItemTypesCache(const std::string& cacheFilename, std::uint64_t sourcesChecksum);
+  static bool getSourcesChecksum(const std::string& dataFilename,
+                                 const std::string& itemsFilename,
+                                 std::uint64_t* checksum);
 
-  class ItemImpl : public Item
+  struct Slot
   {
-   public:
-    ItemImpl(ItemUniqueId itemUniqueId, const ItemType* itemType)
-      : itemUniqueId_(itemUniqueId),
-        itemType_(itemType),
-        count_(1)
+    Slot()
+      : item(0, nullptr),
+        generation(0),
+        nextFreeSlot(invalid_slot)
     {
     }
 
-    ItemUniqueId getItemUniqueId() const override { return itemUniqueId_; }
-    ItemTypeId getItemTypeId() const override { return itemType_->id; }
-
-    const ItemType& getItemType() const override { return *itemType_; }
+    // item has ItemUniqueId 0 when the slot is free
+    Item item;
+    std::uint32_t generation;
+    std::uint32_t nextFreeSlot;
+  };
 
-    int getCount() const override { return count_; }
-    void setCount(int count) override { count_ = count; }
+  // Returns nullptr if itemUniqueId isn't a handle to an existing item
+  Slot* getSlot(ItemUniqueId itemUniqueId);
+  const Slot* getSlot(ItemUniqueId itemUniqueId) const;
+  Slot& slotAt(std::uint32_t index) { return chunks_[index / items_per_chunk][index % items_per_chunk]; }
+  const Slot& slotAt(std::uint32_t index) const { return chunks_[index / items_per_chunk][index % items_per_chunk]; }
 
-   private:
-    ItemUniqueId itemUniqueId_;
-    const ItemType* itemType_;
-    int count_;
-  };
+  std::vector<std::unique_ptr<Slot[]>> chunks_;
+  std::uint32_t numberOfSlots_;
+  std::uint32_t freeSlot_;
+  std::size_t numberOfItems_;
 
-  std::unordered_map<ItemUniqueId, ItemImpl> items_;
-  ItemUniqueId nextItemUniqueId_;
+  // The shared Item of each ItemType, 0 if there is none (yet)
+  std::array<ItemUniqueId, 4096> sharedItems_;
 
+  // ItemType points to its ItemTypeDetails, which are kept in a table of their own
   std::array<ItemType, 4096> itemTypes_;
+  std::array<ItemTypeDetails, 4096> itemTypesDetails_;
   ItemTypeId itemTypesIdFirst_;
   ItemTypeId itemTypesIdLast_;
 };
@@ -55,52 +55,40 @@ bool Equipment::canAddItem(const Item& item, int inventorySlot) const
 
   // TODO(simon): Check capacity
 
-  // Get Item attributes
-  std::string itemType;
-  std::string itemPosition;
+  const auto& itemType = item.getItemType();
 
-  if (!item.getItemType().type.empty())
-  {
-    itemType = item.getItemType().type;
-  }
-
-  if (!item.getItemType().position.empty())
-  {
-    itemPosition = item.getItemType().position;
-  }
-
-  LOG_DEBUG("canAddItem(): ItemTypeId: %d Type: %s Positon: %s",
+  LOG_DEBUG("canAddItem(): ItemTypeId: %d Category: %d Slot: %d",
             item.getItemTypeId(),
-            itemType.c_str(),
-            itemPosition.c_str());
+            static_cast<int>(itemType.category),
+            static_cast<int>(itemType.slot));
 
   switch (inventorySlot)
   {
     case HELMET:
     {
-      return itemType == "armor" && itemPosition == "helmet";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::HELMET;
     }
 
     case AMULET:
     {
-      return itemType == "armor" && itemPosition == "amulet";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::AMULET;
     }
 
     case BACKPACK:
     {
-      return itemType == "container";
+      return itemType.category == ItemCategory::CONTAINER;
     }
 
     case ARMOR:
     {
-      return itemType == "armor" && itemPosition == "body";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::BODY;
     }
 
     case RIGHT_HAND:
     case LEFT_HAND:
     {
       // Just check that we don't equip an 2-hander if other hand is not empty
-      if (item.getItemType().handed == 2)
+      if (itemType.handed == 2)
       {
         if (inventorySlot == RIGHT_HAND)
         {
@@ -116,23 +104,23 @@ bool Equipment::canAddItem(const Item& item, int inventorySlot) const
 
     case LEGS:
     {
-      return itemType == "armor" && itemPosition == "legs";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::LEGS;
     }
 
     case FEET:
     {
-      return itemType == "armor" && itemPosition == "boots";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::BOOTS;
     }
 
     case RING:
     {
-      return itemType == "armor" && itemPosition == "ring";
+      return itemType.category == ItemCategory::ARMOR && itemType.slot == ItemSlot::RING;
     }
 
     case AMMO:
     {
       // TODO(simon): Not yet in items.xml
-      return itemType == "ammo";
+      return itemType.category == ItemCategory::AMMO;
     }
   }
 
@@ -184,6 +172,17 @@ Player::Player(const std::string& name)
 {
 }
 
+Player::Player(CreatureId creatureId, const std::string& name)
+  : Creature(creatureId, name),
+    maxMana_(100),
+    mana_(100),
+    capacity_(300),
+    experience_(4200),
+    magicLevel_(1),
+    partyShield_(0)
+{
+}
+
 int Player::getSpeed() const
 {
   return 220 + (2 * (getLevel() - 1));
@@ -71,6 +71,9 @@ class Player : public Creature
  public:
   explicit Player(const std::string& name);
 
+  // See Creature(CreatureId, const std::string&)
+  Player(CreatureId creatureId, const std::string& name);
+
   // From Creature
   int getSpeed() const override;
 
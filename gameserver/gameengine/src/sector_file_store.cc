@@ -0,0 +1,177 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sector_file_store.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+#include "item_manager.h"
+#include "tile.h"
+#include "logger.h"
+
+namespace
+{
+
+// File format, for each tile:
+//   u8 number of items (0 if there is no tile)
+//   for each item (in the same order as Tile::getItems): u16 ItemTypeId, u16 count
+
+bool writeU16(std::uint16_t value, FILE* file)
+{
+  return fputc(value & 0xFF, file) != EOF && fputc((value >> 8) & 0xFF, file) != EOF;
+}
+
+bool readU16(std::uint16_t* value, FILE* file)
+{
+  const auto low = fgetc(file);
+  const auto high = fgetc(file);
+  if (low == EOF || high == EOF)
+  {
+    return false;
+  }
+  *value = static_cast<std::uint16_t>(low | (high << 8));
+  return true;
+}
+
+}  // namespace
+
+bool SectorFileStore::storeSector(const Position& position, const std::vector<Tile>& tiles)
+{
+  // Containers can be referenced by ItemUniqueId (e.g. by ContainerManager), keep them in memory
+  for (const auto& tile : tiles)
+  {
+    for (const auto* item : tile.getItems())
+    {
+      if (item->getItemType().isContainer)
+      {
+        return false;
+      }
+    }
+  }
+
+  const auto filename = getFilename(position);
+  auto* file = fopen(filename.c_str(), "wb");
+  if (file == nullptr)
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  auto ok = true;
+  for (const auto& tile : tiles)
+  {
+    const auto& items = tile.getItems();
+    ok = ok && fputc(static_cast<int>(items.size()), file) != EOF;
+    for (const auto* item : items)
+    {
+      ok = ok && writeU16(item->getItemTypeId(), file) && writeU16(item->getCount(), file);
+    }
+  }
+  ok = (fclose(file) == 0) && ok;
+
+  if (!ok)
+  {
+    LOG_ERROR("%s: could not write file: %s", __func__, filename.c_str());
+    std::remove(filename.c_str());
+    return false;
+  }
+
+  // Everything is written, now the Items can be destroyed
+  for (const auto& tile : tiles)
+  {
+    for (const auto* item : tile.getItems())
+    {
+      itemManager_->destroyItem(item->getItemUniqueId());
+    }
+  }
+
+  return true;
+}
+
+bool SectorFileStore::loadSector(const Position& position, std::vector<Tile>* tiles)
+{
+  const auto filename = getFilename(position);
+  auto* file = fopen(filename.c_str(), "rb");
+  if (file == nullptr)
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  for (auto& tile : *tiles)
+  {
+    const auto numberOfItems = fgetc(file);
+    if (numberOfItems == EOF)
+    {
+      LOG_ERROR("%s: unexpected end of file: %s", __func__, filename.c_str());
+      fclose(file);
+      return false;
+    }
+
+    std::vector<Item*> items;
+    for (auto i = 0; i < numberOfItems; i++)
+    {
+      std::uint16_t itemTypeId;
+      std::uint16_t count;
+      if (!readU16(&itemTypeId, file) || !readU16(&count, file))
+      {
+        LOG_ERROR("%s: unexpected end of file: %s", __func__, filename.c_str());
+        fclose(file);
+        return false;
+      }
+
+      auto itemUniqueId = itemManager_->createMapItem(itemTypeId);
+      if (count != 1)
+      {
+        itemUniqueId = itemManager_->makeUnique(itemUniqueId);
+        itemManager_->getItem(itemUniqueId)->setCount(count);
+      }
+      items.push_back(itemManager_->getItem(itemUniqueId));
+    }
+
+    if (items.empty())
+    {
+      continue;
+    }
+
+    // Tile::addItem puts new items first among top / bottom items, so add them backwards
+    tile = Tile(items.front());
+    for (auto it = items.rbegin(); it != items.rend() - 1; ++it)
+    {
+      tile.addItem(*it);
+    }
+  }
+
+  fclose(file);
+  std::remove(filename.c_str());
+  return true;
+}
+
+std::string SectorFileStore::getFilename(const Position& position) const
+{
+  return directory_ + "/sector_" + std::to_string(position.getX()) + "_" + std::to_string(position.getY()) +
+         "_" + std::to_string(position.getZ()) + ".bin";
+}
@@ -0,0 +1,64 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAMEENGINE_SRC_SECTOR_FILE_STORE_H_
+#define GAMEENGINE_SRC_SECTOR_FILE_STORE_H_
+
+#include <string>
+#include <vector>
+
+#include "sector_store.h"
+
+class ItemManager;
+
+// SectorStore that writes each paged out sector to its own file in the given directory
+//
+// Only the ItemTypeId and count of each Item is stored, so the Items are destroyed when
+// paged out and created again (with new ItemUniqueIds) when paged in, except the shared
+// map Items which are kept by ItemManager (see ItemManager::createMapItem). Sectors with
+// containers are never paged out, since they can be referenced by ItemUniqueId.
+class SectorFileStore : public SectorStore
+{
+ public:
+  SectorFileStore(const std::string& directory, ItemManager* itemManager)
+    : directory_(directory),
+      itemManager_(itemManager)
+  {
+  }
+
+  // Delete copy constructors
+  SectorFileStore(const SectorFileStore&) = delete;
+  SectorFileStore& operator=(const SectorFileStore&) = delete;
+
+  bool storeSector(const Position& position, const std::vector<Tile>& tiles) override;
+  bool loadSector(const Position& position, std::vector<Tile>* tiles) override;
+
+ private:
+  std::string getFilename(const Position& position) const;
+
+  std::string directory_;
+  ItemManager* itemManager_;
+};
+
+#endif  // GAMEENGINE_SRC_SECTOR_FILE_STORE_H_
@@ -0,0 +1,307 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAMEENGINE_SRC_TASK_QUEUE_H_
+#define GAMEENGINE_SRC_TASK_QUEUE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Tasks ordered on expire time, tasks with the same expire time are kept in the order they were added.
+//
+// The order is kept in a 4-ary heap of (expire, sequence, slot), where the tasks themselves are
+// stored in slots that are reused. The slots with the same tag are linked together, so that
+// cancel only visits the tasks with that tag: the slots are freed directly and the heap entries
+// are left behind, and skipped when they reach the top of the heap (or removed all at once when
+// they are more than the tasks in the queue).
+//
+// push is O(1) on average (O(log n) worst case), pop is O(log n) and cancel is O(tasks with the tag).
+// Slots, heap entries and tags are reused, so once the queue has grown to its working size,
+// push and pop do no heap allocations (other than what moving a Task may do).
+template<typename Task>
+class TaskQueue
+{
+ public:
+  TaskQueue()
+    : heap_(),
+      slots_(),
+      freeSlots_(),
+      tags_(),
+      nextSequence_(1),
+      size_(0)
+  {
+  }
+
+  // Delete copy constructors
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+
+  void push(int tag, std::int64_t expire, Task&& task)
+  {
+    auto slotIndex = 0;
+    if (freeSlots_.empty())
+    {
+      slotIndex = static_cast<int>(slots_.size());
+      slots_.emplace_back();
+    }
+    else
+    {
+      slotIndex = freeSlots_.back();
+      freeSlots_.pop_back();
+    }
+
+    // Link the slot first in the list of its tag
+    auto& slot = slots_[slotIndex];
+    slot.task = std::move(task);
+    slot.tag = tag;
+    slot.sequence = nextSequence_++;
+    slot.prev = -1;
+    auto it = tags_.find(tag);
+    if (it == tags_.end())
+    {
+      slot.next = -1;
+      tags_.emplace(tag, slotIndex);
+    }
+    else
+    {
+      slot.next = it->second;
+      if (it->second != -1)
+      {
+        slots_[it->second].prev = slotIndex;
+      }
+      it->second = slotIndex;
+    }
+
+    heap_.push_back(Entry{expire, slot.sequence, slotIndex});
+    siftUp(heap_.size() - 1);
+    size_++;
+  }
+
+  // Removes all tasks with the given tag, the tasks are destroyed directly
+  void cancel(int tag)
+  {
+    auto it = tags_.find(tag);
+    if (it == tags_.end())
+    {
+      return;
+    }
+
+    auto slotIndex = it->second;
+    while (slotIndex != -1)
+    {
+      auto& slot = slots_[slotIndex];
+      const auto next = slot.next;
+      freeSlot(slotIndex);
+      slotIndex = next;
+    }
+    tags_.erase(it);
+
+    if (heap_.size() - size_ > size_)
+    {
+      removeCanceledEntries();
+    }
+    else
+    {
+      skipCanceledEntries();
+    }
+  }
+
+  bool empty() const { return size_ == 0; }
+  std::size_t size() const { return size_; }
+
+  // The queue must not be empty
+  std::int64_t getFirstExpire() const { return heap_.front().expire; }
+  int getFirstTag() const { return slots_[heap_.front().slot].tag; }
+
+  // Removes and returns the first task, the queue must not be empty
+  Task pop()
+  {
+    const auto slotIndex = heap_.front().slot;
+    auto& slot = slots_[slotIndex];
+
+    // Unlink the slot from the list of its tag
+    // The tag is kept when its last task is popped, to not free and allocate it again for its next task
+    if (slot.prev != -1)
+    {
+      slots_[slot.prev].next = slot.next;
+    }
+    else
+    {
+      tags_[slot.tag] = slot.next;
+    }
+    if (slot.next != -1)
+    {
+      slots_[slot.next].prev = slot.prev;
+    }
+
+    auto task = std::move(slot.task);
+    freeSlot(slotIndex);
+    popHeap();
+    skipCanceledEntries();
+    return task;
+  }
+
+ private:
+  static constexpr std::size_t arity = 4;
+
+  struct Entry
+  {
+    std::int64_t expire;
+    std::uint64_t sequence;
+    int slot;
+
+    bool operator<(const Entry& other) const
+    {
+      return expire < other.expire || (expire == other.expire && sequence < other.sequence);
+    }
+  };
+
+  struct Slot
+  {
+    Task task;
+    int tag;
+
+    // Sequence of the task in this slot, 0 if the slot is free
+    std::uint64_t sequence;
+
+    // The other slots with the same tag, -1 if none
+    int prev;
+    int next;
+  };
+
+  void freeSlot(int slotIndex)
+  {
+    auto& slot = slots_[slotIndex];
+    slot.task = Task();
+    slot.sequence = 0;
+    freeSlots_.push_back(slotIndex);
+    size_--;
+  }
+
+  bool isCanceled(const Entry& entry) const { return slots_[entry.slot].sequence != entry.sequence; }
+
+  // Keeps a valid entry at the top of the heap, so that getFirstExpire and pop can use it directly
+  void skipCanceledEntries()
+  {
+    while (!heap_.empty() && isCanceled(heap_.front()))
+    {
+      popHeap();
+    }
+  }
+
+  void removeCanceledEntries()
+  {
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < heap_.size(); i++)
+    {
+      if (!isCanceled(heap_[i]))
+      {
+        heap_[j++] = heap_[i];
+      }
+    }
+    heap_.resize(j);
+
+    // Heapify, starting from the last entry that has children
+    if (heap_.size() > 1)
+    {
+      for (auto i = (heap_.size() - 2) / arity + 1; i > 0; i--)
+      {
+        siftDown(i - 1);
+      }
+    }
+  }
+
+  void popHeap()
+  {
+    heap_.front() = heap_.back();
+    heap_.pop_back();
+    if (!heap_.empty())
+    {
+      siftDown(0);
+    }
+  }
+
+  void siftUp(std::size_t index)
+  {
+    const auto entry = heap_[index];
+    while (index > 0)
+    {
+      const auto parent = (index - 1) / arity;
+      if (!(entry < heap_[parent]))
+      {
+        break;
+      }
+      heap_[index] = heap_[parent];
+      index = parent;
+    }
+    heap_[index] = entry;
+  }
+
+  void siftDown(std::size_t index)
+  {
+    const auto entry = heap_[index];
+    while (true)
+    {
+      const auto firstChild = index * arity + 1;
+      if (firstChild >= heap_.size())
+      {
+        break;
+      }
+
+      auto smallest = firstChild;
+      const auto lastChild = std::min(firstChild + arity, heap_.size());
+      for (auto child = firstChild + 1; child < lastChild; child++)
+      {
+        if (heap_[child] < heap_[smallest])
+        {
+          smallest = child;
+        }
+      }
+
+      if (!(heap_[smallest] < entry))
+      {
+        break;
+      }
+      heap_[index] = heap_[smallest];
+      index = smallest;
+    }
+    heap_[index] = entry;
+  }
+
+  std::vector<Entry> heap_;
+  std::vector<Slot> slots_;
+  std::vector<int> freeSlots_;
+
+  // The first slot of each tag, -1 if the tag has no tasks
+  // A tag is removed when its tasks are canceled
+  std::unordered_map<int, int> tags_;
+
+  std::uint64_t nextSequence_;
+  std::size_t size_;
+};
+
+#endif  // GAMEENGINE_SRC_TASK_QUEUE_H_
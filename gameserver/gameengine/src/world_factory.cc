@@ -25,8 +25,6 @@
 #include "world_factory.h"
 
 #include <cstring>
-#include <fstream>
-#include <sstream>
 #include <utility>
 #include <vector>
 
@@ -35,125 +33,189 @@
 #include "position.h"
 #include "tile.h"
 #include "world.h"
+#include "viewport.h"
 #include "logger.h"
+#include "xml_document.h"
 
-#include "rapidxml.hpp"
+namespace
+{
 
-std::unique_ptr<World> WorldFactory::createWorld(const std::string& worldFilename,
-                                                 ItemManager* itemManager)
+// Reads a <tile>-node into the given Tile, returns false if the node is invalid
+bool loadTile(const XmlDocument::Node* tileNode, ItemManager* itemManager, Tile* tile)
 {
-  // Open world.xml and read it into a string
-  LOG_INFO("Loading world file: \"%s\"", worldFilename.c_str());
-  std::ifstream xmlFile(worldFilename);
-  if (!xmlFile.is_open())
+  // Read the first <item> (there must be at least one, the ground item)
+  // TODO(simon): Must there be one? What about "void", or is it also an Item?
+  const auto* groundItemNode = tileNode->first_node();
+  if (groundItemNode == nullptr)
   {
-    LOG_ERROR("%s: Could not open file: \"%s\"", __func__, worldFilename.c_str());
-    return std::unique_ptr<World>();
+    LOG_ERROR("%s: Invalid file, <tile>-node is missing <item>-node", __func__);
+    return false;
+  }
+  int groundItemTypeId;
+  if (!XmlDocument::getInteger(groundItemNode, "id", &groundItemTypeId))
+  {
+    LOG_ERROR("%s: Invalid file, missing attribute id in <item>-node", __func__);
+    return false;
   }
 
-  std::string tempString;
-  std::ostringstream xmlStringStream;
-  while (std::getline(xmlFile, tempString))
+  const auto groundItemId = itemManager->createMapItem(groundItemTypeId);
+  if (groundItemId == 0)  // TODO(simon): invalid ItemId
   {
-    xmlStringStream << tempString << "\n";
+    LOG_ERROR("%s: groundItemTypeId: %d is invalid", __func__, groundItemTypeId);
+    return false;
   }
 
-  // Convert the std::string to a char*
-  char* xmlString = strdup(xmlStringStream.str().c_str());
+  *tile = Tile(itemManager->getItem(groundItemId));
 
-  // Parse the XML string with Rapidxml
-  rapidxml::xml_document<> worldXml;
-  worldXml.parse<0>(xmlString);
+  // Read more items to put in this tile
+  // But due to the way otserv-3.0 made world.xml, do it backwards
+  for (auto* itemNode = tileNode->last_node(); itemNode != groundItemNode; itemNode = itemNode->previous_sibling())
+  {
+    int itemTypeId;
+    if (!XmlDocument::getInteger(itemNode, "id", &itemTypeId))
+    {
+      LOG_DEBUG("%s: Missing attribute id in <item>-node, skipping Item", __func__);
+      continue;
+    }
 
-  // Get top node (<map>)
-  const auto* mapNode = worldXml.first_node();
+    const auto itemId = itemManager->createMapItem(itemTypeId);
+    if (itemId == 0)  // TODO(simon): invalid ItemId
+    {
+      LOG_ERROR("%s: itemTypeId: %d is invalid", __func__, itemTypeId);
+      return false;
+    }
+
+    tile->addItem(itemManager->getItem(itemId));
+  }
+
+  return true;
+}
+
+// Reads a <floor>-node, where each <tile>-node has the attributes x and y
+// Positions without a <tile>-node will not have any tile
+bool loadFloor(const XmlDocument::Node* floorNode,
+               int z,
+               ItemManager* itemManager,
+               const WorldFactory::SetTile& setTile)
+{
+  for (const auto* tileNode = floorNode->first_node(); tileNode != nullptr; tileNode = tileNode->next_sibling())
+  {
+    int x;
+    int y;
+    if (!XmlDocument::getInteger(tileNode, "x", &x) || !XmlDocument::getInteger(tileNode, "y", &y))
+    {
+      LOG_ERROR("%s: Invalid file, missing attributes x or y in <tile>-node", __func__);
+      return false;
+    }
+
+    Tile tile;
+    if (!loadTile(tileNode, itemManager, &tile))
+    {
+      return false;
+    }
+    setTile(Position(x, y, z), std::move(tile));
+  }
+
+  return true;
+}
 
-  // Read width and height
-  const auto* widthAttr = mapNode->first_attribute("width");
-  const auto* heightAttr = mapNode->first_attribute("height");
-  if (widthAttr == nullptr || heightAttr == nullptr)
+}  // namespace
+
+std::unique_ptr<World> WorldFactory::createWorld(const std::string& worldFilename,
+                                                 ItemManager* itemManager)
+{
+  auto world = std::make_unique<World>();
+  const auto loaded = loadTiles(worldFilename, itemManager, [&world](const Position& position, Tile&& tile)
+  {
+    world->setTile(position, std::move(tile));
+  });
+  if (!loaded)
   {
-    LOG_ERROR("%s: Invalid file, missing attributes width or height in <map>-node", __func__);
-    free(xmlString);
     return std::unique_ptr<World>();
   }
 
-  const auto worldSizeX = std::stoi(widthAttr->value());
-  const auto worldSizeY = std::stoi(heightAttr->value());
+  LOG_INFO("World loaded");
+  return world;
+}
+
+bool WorldFactory::loadTiles(const std::string& worldFilename, ItemManager* itemManager, const SetTile& setTile)
+{
+  LOG_INFO("Loading world file: \"%s\"", worldFilename.c_str());
+  XmlDocument worldXml;
+  if (!worldXml.loadFile(worldFilename))
+  {
+    LOG_ERROR("%s: Could not load file: \"%s\"", __func__, worldFilename.c_str());
+    return false;
+  }
 
-  // Read tiles
-  std::vector<Tile> tiles;
-  tiles.reserve(worldSizeX * worldSizeY);
-  const auto* tileNode = mapNode->first_node();
-  for (int y = World::position_offset; y < World::position_offset + worldSizeY; y++)
+  // Get top node (<map>)
+  const auto* mapNode = worldXml.getFirstNode();
+  if (mapNode == nullptr)
   {
-    for (int x = World::position_offset; x < World::position_offset + worldSizeX; x++)
+    LOG_ERROR("%s: Invalid file, missing <map>-node", __func__);
+    return false;
+  }
+
+  const auto* firstNode = mapNode->first_node();
+  if (firstNode != nullptr && std::strcmp(firstNode->name(), "floor") == 0)
+  {
+    // Each <floor z="..."> contains the tiles on that floor, floors without tiles can be left out
+    for (const auto* floorNode = firstNode; floorNode != nullptr; floorNode = floorNode->next_sibling())
     {
-      if (tileNode == nullptr)
+      int z;
+      if (!XmlDocument::getInteger(floorNode, "z", &z))
       {
-        LOG_ERROR("%s: Invalid file, missing <tile>-node", __func__);
-        free(xmlString);
-        return std::unique_ptr<World>();
+        LOG_ERROR("%s: Invalid file, missing attribute z in <floor>-node", __func__);
+        return false;
       }
 
-      // Read the first <item> (there must be at least one, the ground item)
-      // TODO(simon): Must there be one? What about "void", or is it also an Item?
-      const auto* groundItemNode = tileNode->first_node();
-      if (groundItemNode == nullptr)
-      {
-        LOG_ERROR("%s: Invalid file, <tile>-node is missing <item>-node", __func__);
-        free(xmlString);
-        return std::unique_ptr<World>();
-      }
-      const auto* groundItemAttr = groundItemNode->first_attribute("id");
-      if (groundItemAttr == nullptr)
+      if (z < 0 || z >= World::number_of_floors)
       {
-        LOG_ERROR("%s: Invalid file, missing attribute id in <item>-node", __func__);
-        free(xmlString);
-        return std::unique_ptr<World>();
+        LOG_ERROR("%s: Invalid file, invalid z: %d in <floor>-node", __func__, z);
+        return false;
       }
 
-      const auto groundItemTypeId = std::stoi(groundItemAttr->value());
-      const auto groundItemId = itemManager->createItem(groundItemTypeId);
-      if (groundItemId == 0)  // TODO(simon): invalid ItemId
+      if (!loadFloor(floorNode, z, itemManager, setTile))
       {
-        LOG_ERROR("%s: groundItemTypeId: %d is invalid", __func__, groundItemTypeId);
-        free(xmlString);
-        return std::unique_ptr<World>();
+        return false;
       }
+    }
+  }
+  else
+  {
+    // Old format: width * height <tile>-nodes on the ground floor, starting at (position_offset, position_offset)
+    int worldSizeX;
+    int worldSizeY;
+    if (!XmlDocument::getInteger(mapNode, "width", &worldSizeX) ||
+        !XmlDocument::getInteger(mapNode, "height", &worldSizeY))
+    {
+      LOG_ERROR("%s: Invalid file, missing attributes width or height in <map>-node", __func__);
+      return false;
+    }
 
-      tiles.emplace_back(itemManager->getItem(groundItemId));
-
-      // Read more items to put in this tile
-      // But due to the way otserv-3.0 made world.xml, do it backwards
-      for (auto* itemNode = tileNode->last_node(); itemNode != groundItemNode; itemNode = itemNode->previous_sibling())
+    const auto* tileNode = firstNode;
+    for (int x = World::position_offset; x < World::position_offset + worldSizeX; x++)
+    {
+      for (int y = World::position_offset; y < World::position_offset + worldSizeY; y++)
       {
-        const auto* itemIdAttr = itemNode->first_attribute("id");
-        if (itemIdAttr == nullptr)
+        if (tileNode == nullptr)
         {
-          LOG_DEBUG("%s: Missing attribute id in <item>-node, skipping Item", __func__);
-          continue;
+          LOG_ERROR("%s: Invalid file, missing <tile>-node", __func__);
+          return false;
         }
 
-        const auto itemTypeId = std::stoi(itemIdAttr->value());
-        const auto itemId = itemManager->createItem(itemTypeId);
-        if (itemId == 0)  // TODO(simon): invalid ItemId
+        Tile tile;
+        if (!loadTile(tileNode, itemManager, &tile))
         {
-          LOG_ERROR("%s: itemTypeId: %d is invalid", __func__, itemTypeId);
-          free(xmlString);
-          return std::unique_ptr<World>();
+          return false;
         }
+        setTile(Position(x, y, Viewport::ground_floor), std::move(tile));
 
-        tiles.back().addItem(itemManager->getItem(itemId));
+        // Go to next <tile> in XML
+        tileNode = tileNode->next_sibling();
       }
-
-      // Go to next <tile> in XML
-      tileNode = tileNode->next_sibling();
     }
   }
 
-  LOG_INFO("World loaded, size: %d x %d", worldSizeX, worldSizeY);
-  free(xmlString);
-
-  return std::make_unique<World>(worldSizeX, worldSizeY, std::move(tiles));
+  return true;
 }
@@ -25,17 +25,25 @@
 #ifndef GAMEENGINE_SRC_WORLD_FACTORY_H_
 #define GAMEENGINE_SRC_WORLD_FACTORY_H_
 
+#include <functional>
 #include <memory>
 #include <string>
 
 class World;
 class ItemManager;
+class Position;
+class Tile;
 
 class WorldFactory
 {
  public:
+  using SetTile = std::function<void(const Position& position, Tile&& tile)>;
+
   static std::unique_ptr<World> createWorld(const std::string& worldFilename,
                                             ItemManager* itemManager);
+
+  // Reads world.xml and calls setTile with each tile in it, returns false if the file is invalid
+  static bool loadTiles(const std::string& worldFilename, ItemManager* itemManager, const SetTile& setTile);
 };
 
 #endif  // GAMEENGINE_SRC_WORLD_FACTORY_H_
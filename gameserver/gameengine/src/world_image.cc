@@ -0,0 +1,551 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "world_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "item_manager.h"
+#include "tile.h"
+#include "world.h"
+#include "logger.h"
+
+namespace
+{
+
+// World image file format (native byte order):
+//   ImageHeader
+//   SectorEntry for each sector
+//   sector data, for each tile in the sector (in TileStore::getTileIndex order):
+//     varint number of items
+//     for each item (in the same order as Tile::getItems): varint ItemTypeId
+//
+// Varints are 7 bits per byte, least significant first, with the high bit set on all but the last byte
+constexpr char image_magic[4] = { 'W', 'R', 'L', 'D' };
+constexpr std::uint32_t image_version = 1;
+constexpr int tiles_per_sector = TileStore::sector_size * TileStore::sector_size;
+constexpr int bytes_per_sector_bits = tiles_per_sector / 8;
+
+struct ImageHeader
+{
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t numberOfSectors;
+  std::uint32_t padding;
+};
+
+struct SectorEntry
+{
+  std::uint16_t sectorX;
+  std::uint16_t sectorY;
+  std::uint8_t z;
+  std::uint8_t padding[3];
+  std::uint32_t offset;
+  std::uint32_t size;
+
+  // Walkability and line of sight of each tile, so that a sector doesn't need to be loaded for them
+  std::uint8_t walkable[bytes_per_sector_bits];
+  std::uint8_t passable[bytes_per_sector_bits];
+};
+
+static_assert(std::is_trivially_copyable<ImageHeader>::value && sizeof(ImageHeader) == 16,
+              "ImageHeader must have a fixed layout");
+static_assert(std::is_trivially_copyable<SectorEntry>::value && sizeof(SectorEntry) == 80,
+              "SectorEntry must have a fixed layout");
+
+std::uint64_t getSectorKey(int sectorX, int sectorY, int z)
+{
+  return (static_cast<std::uint64_t>(sectorX) << 32) |
+         (static_cast<std::uint64_t>(sectorY) << 16) |
+          static_cast<std::uint64_t>(z);
+}
+
+std::uint64_t getSectorKey(const Position& position)
+{
+  return getSectorKey(position.getX() >> TileStore::sector_bits,
+                      position.getY() >> TileStore::sector_bits,
+                      position.getZ());
+}
+
+Position getSectorPosition(const SectorEntry& entry)
+{
+  return Position(entry.sectorX << TileStore::sector_bits, entry.sectorY << TileStore::sector_bits, entry.z);
+}
+
+void writeVarint(std::uint32_t value, std::vector<std::uint8_t>* data)
+{
+  while (value >= 0x80)
+  {
+    data->push_back(static_cast<std::uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  data->push_back(static_cast<std::uint8_t>(value));
+}
+
+// Returns false if the varint doesn't end before end or doesn't fit in 32 bits
+bool readVarint(const std::uint8_t** it, const std::uint8_t* end, std::uint32_t* value)
+{
+  *value = 0;
+  for (auto shift = 0; shift < 35; shift += 7)
+  {
+    if (*it == end)
+    {
+      return false;
+    }
+    const auto byte = *((*it)++);
+    *value |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+SectorEntry readSectorEntry(const MappedFile& file, std::uint32_t sectorNumber)
+{
+  SectorEntry entry;
+  std::memcpy(&entry, file.getData() + sizeof(ImageHeader) + (sectorNumber * sizeof(SectorEntry)), sizeof(entry));
+  return entry;
+}
+
+// Calls f(tileIndex, itemTypeIds) for each tile with items in the sector, stops if f returns false
+// Returns false if the sector data is invalid or if f returned false
+template<typename F>
+bool decodeSector(const MappedFile& file, const SectorEntry& entry, const F& f)
+{
+  const auto* it = file.getData() + entry.offset;
+  const auto* end = it + entry.size;
+  std::vector<ItemTypeId> itemTypeIds;
+  for (auto index = 0; index < tiles_per_sector; index++)
+  {
+    std::uint32_t numberOfItems;
+    if (!readVarint(&it, end, &numberOfItems))
+    {
+      return false;
+    }
+
+    itemTypeIds.clear();
+    for (std::uint32_t i = 0; i < numberOfItems; i++)
+    {
+      std::uint32_t itemTypeId;
+      if (!readVarint(&it, end, &itemTypeId) || itemTypeId > 0xFFFF)
+      {
+        return false;
+      }
+      itemTypeIds.push_back(itemTypeId);
+    }
+
+    if (!itemTypeIds.empty() && !f(index, itemTypeIds))
+    {
+      return false;
+    }
+  }
+
+  return it == end;
+}
+
+Tile createTile(const std::vector<Item*>& items)
+{
+  // Tile::addItem puts new items first among top / bottom items, so add them backwards
+  Tile tile(items.front());
+  for (auto it = items.rbegin(); it != items.rend() - 1; ++it)
+  {
+    tile.addItem(*it);
+  }
+  return tile;
+}
+
+void toBytes(const TileStore::SectorBits& bits, std::uint8_t* bytes)
+{
+  for (auto i = 0; i < bytes_per_sector_bits; i++)
+  {
+    bytes[i] = 0;
+    for (auto bit = 0; bit < 8; bit++)
+    {
+      bytes[i] |= bits[(i * 8) + bit] << bit;
+    }
+  }
+}
+
+TileStore::SectorBits fromBytes(const std::uint8_t* bytes)
+{
+  TileStore::SectorBits bits;
+  for (auto i = 0; i < tiles_per_sector; i++)
+  {
+    bits[i] = (bytes[i / 8] >> (i % 8)) & 1;
+  }
+  return bits;
+}
+
+}  // namespace
+
+bool WorldImage::isWorldImage(const std::string& filename)
+{
+  auto* file = fopen(filename.c_str(), "rb");
+  if (file == nullptr)
+  {
+    return false;
+  }
+
+  char magic[sizeof(image_magic)];
+  const auto isImage = fread(magic, sizeof(magic), 1, file) == 1 && std::memcmp(magic, image_magic, sizeof(magic)) == 0;
+  fclose(file);
+  return isImage;
+}
+
+bool WorldImage::open(const std::string& filename)
+{
+  LOG_INFO("Loading world image: \"%s\"", filename.c_str());
+  if (!file_.open(filename))
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  ImageHeader header;
+  if (file_.getSize() < sizeof(header))
+  {
+    LOG_ERROR("%s: invalid world image: %s", __func__, filename.c_str());
+    file_.close();
+    return false;
+  }
+  std::memcpy(&header, file_.getData(), sizeof(header));
+
+  const auto indexEnd = sizeof(header) + (static_cast<std::uint64_t>(header.numberOfSectors) * sizeof(SectorEntry));
+  if (std::memcmp(header.magic, image_magic, sizeof(header.magic)) != 0 ||
+      header.version != image_version ||
+      file_.getSize() < indexEnd)
+  {
+    LOG_ERROR("%s: invalid world image: %s", __func__, filename.c_str());
+    file_.close();
+    return false;
+  }
+
+  sectorIndex_.clear();
+  pagedOutSectors_.clear();
+  for (std::uint32_t sectorNumber = 0; sectorNumber < header.numberOfSectors; sectorNumber++)
+  {
+    const auto entry = readSectorEntry(file_, sectorNumber);
+    const auto key = getSectorKey(entry.sectorX, entry.sectorY, entry.z);
+    if (entry.offset < indexEnd ||
+        static_cast<std::uint64_t>(entry.offset) + entry.size > file_.getSize() ||
+        !sectorIndex_.emplace(key, sectorNumber).second)
+    {
+      LOG_ERROR("%s: invalid sector entry %u in world image: %s", __func__, sectorNumber, filename.c_str());
+      file_.close();
+      sectorIndex_.clear();
+      return false;
+    }
+  }
+
+  filename_ = filename;
+  numberOfSectors_ = header.numberOfSectors;
+  return true;
+}
+
+bool WorldImage::loadWorld(World* world, bool lazy, int numberOfThreads)
+{
+  if (!file_.isOpen())
+  {
+    LOG_ERROR("%s: no world image is open", __func__);
+    return false;
+  }
+
+  if (lazy)
+  {
+    for (std::uint32_t sectorNumber = 0; sectorNumber < numberOfSectors_; sectorNumber++)
+    {
+      const auto entry = readSectorEntry(file_, sectorNumber);
+      world->addPagedOutSector(getSectorPosition(entry), fromBytes(entry.walkable), fromBytes(entry.passable));
+    }
+
+    LOG_INFO("World loaded, %u sectors (loaded when first accessed)", numberOfSectors_);
+    return true;
+  }
+
+  // Tiles with only shared Items are created by all threads, as getSharedMapItem doesn't modify
+  // the ItemManager. Tiles with other Items are rare (e.g. stackable items on the map) and are
+  // created afterwards on this thread, together with adding all tiles to the World.
+  itemManager_->createSharedMapItems();
+
+  struct DecodedSector
+  {
+    std::vector<Tile> tiles;
+    std::vector<std::pair<int, std::vector<ItemTypeId>>> deferredTiles;
+  };
+  std::vector<DecodedSector> sectors(numberOfSectors_);
+  std::atomic<std::uint32_t> nextSectorNumber(0);
+  std::atomic<bool> decodedOk(true);
+
+  const auto decodeSectors = [this, &sectors, &nextSectorNumber, &decodedOk]()
+  {
+    std::vector<Item*> items;
+    for (auto sectorNumber = nextSectorNumber++;
+         sectorNumber < numberOfSectors_ && decodedOk;
+         sectorNumber = nextSectorNumber++)
+    {
+      auto& sector = sectors[sectorNumber];
+      sector.tiles.resize(tiles_per_sector);
+      const auto decoded = decodeSector(file_,
+                                        readSectorEntry(file_, sectorNumber),
+                                        [this, &sector, &items](int index, const std::vector<ItemTypeId>& itemTypeIds)
+      {
+        items.clear();
+        for (const auto itemTypeId : itemTypeIds)
+        {
+          auto* item = itemManager_->getSharedMapItem(itemTypeId);
+          if (item == nullptr)
+          {
+            sector.deferredTiles.emplace_back(index, itemTypeIds);
+            return true;
+          }
+          items.push_back(item);
+        }
+        sector.tiles[index] = createTile(items);
+        return true;
+      });
+
+      if (!decoded)
+      {
+        LOG_ERROR("%s: invalid sector %u in world image: %s", __func__, sectorNumber, filename_.c_str());
+        decodedOk = false;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (auto i = 1; i < numberOfThreads; i++)
+  {
+    threads.emplace_back(decodeSectors);
+  }
+  decodeSectors();
+  for (auto& thread : threads)
+  {
+    thread.join();
+  }
+
+  if (!decodedOk)
+  {
+    return false;
+  }
+
+  std::vector<Item*> items;
+  for (std::uint32_t sectorNumber = 0; sectorNumber < numberOfSectors_; sectorNumber++)
+  {
+    auto& sector = sectors[sectorNumber];
+    for (const auto& deferredTile : sector.deferredTiles)
+    {
+      items.clear();
+      for (const auto itemTypeId : deferredTile.second)
+      {
+        const auto itemUniqueId = itemManager_->createMapItem(itemTypeId);
+        if (itemUniqueId == 0)  // TODO(simon): invalid ItemId
+        {
+          LOG_ERROR("%s: itemTypeId: %d is invalid", __func__, itemTypeId);
+          return false;
+        }
+        items.push_back(itemManager_->getItem(itemUniqueId));
+      }
+      sector.tiles[deferredTile.first] = createTile(items);
+    }
+
+    const auto sectorPosition = getSectorPosition(readSectorEntry(file_, sectorNumber));
+    for (auto x = sectorPosition.getX(); x < sectorPosition.getX() + TileStore::sector_size; x++)
+    {
+      for (auto y = sectorPosition.getY(); y < sectorPosition.getY() + TileStore::sector_size; y++)
+      {
+        const Position position(x, y, sectorPosition.getZ());
+        auto& tile = sector.tiles[TileStore::getTileIndex(position)];
+        if (!tile.getItems().empty())
+        {
+          world->setTile(position, std::move(tile));
+        }
+      }
+    }
+
+    // The tiles are moved into the World, release what is left of them
+    std::vector<Tile>().swap(sector.tiles);
+  }
+
+  LOG_INFO("World loaded, %u sectors using %d threads", numberOfSectors_, std::max(numberOfThreads, 1));
+
+  // Everything is in the World already, the image is not needed anymore
+  file_.close();
+  sectorIndex_.clear();
+  return true;
+}
+
+bool WorldImage::storeSector(const Position& position, const std::vector<Tile>& tiles)
+{
+  // The image is read-only, and the tiles may have changed since they were loaded from it
+  if (!pageStore_ || !pageStore_->storeSector(position, tiles))
+  {
+    return false;
+  }
+
+  pagedOutSectors_.insert(getSectorKey(position));
+  return true;
+}
+
+bool WorldImage::loadSector(const Position& position, std::vector<Tile>* tiles)
+{
+  const auto key = getSectorKey(position);
+  auto pagedOutIt = pagedOutSectors_.find(key);
+  if (pagedOutIt != pagedOutSectors_.end())
+  {
+    if (!pageStore_->loadSector(position, tiles))
+    {
+      return false;
+    }
+    pagedOutSectors_.erase(pagedOutIt);
+    return true;
+  }
+
+  const auto sectorIt = sectorIndex_.find(key);
+  if (sectorIt == sectorIndex_.end())
+  {
+    LOG_ERROR("%s: no sector at position: %s in world image", __func__, position.toString().c_str());
+    return false;
+  }
+  return loadSectorFromImage(sectorIt->second, tiles);
+}
+
+bool WorldImage::loadSectorFromImage(std::uint32_t sectorNumber, std::vector<Tile>* tiles)
+{
+  std::vector<Item*> items;
+  const auto loaded = decodeSector(file_,
+                                   readSectorEntry(file_, sectorNumber),
+                                   [this, tiles, &items](int index, const std::vector<ItemTypeId>& itemTypeIds)
+  {
+    items.clear();
+    for (const auto itemTypeId : itemTypeIds)
+    {
+      const auto itemUniqueId = itemManager_->createMapItem(itemTypeId);
+      if (itemUniqueId == 0)  // TODO(simon): invalid ItemId
+      {
+        LOG_ERROR("%s: itemTypeId: %d is invalid", __func__, itemTypeId);
+        return false;
+      }
+      items.push_back(itemManager_->getItem(itemUniqueId));
+    }
+    (*tiles)[index] = createTile(items);
+    return true;
+  });
+
+  if (!loaded)
+  {
+    LOG_ERROR("%s: could not load sector %u from world image: %s", __func__, sectorNumber, filename_.c_str());
+    return false;
+  }
+  return true;
+}
+
+void WorldImageWriter::addTile(const Position& position, const Tile& tile)
+{
+  if (position.getX() < 0 || position.getX() > 0xFFFF ||
+      position.getY() < 0 || position.getY() > 0xFFFF ||
+      position.getZ() < 0 || position.getZ() >= World::number_of_floors)
+  {
+    LOG_ERROR("%s: invalid position: %s", __func__, position.toString().c_str());
+    return;
+  }
+
+  auto& sector = sectors_[getSectorKey(position)];
+  const auto index = TileStore::getTileIndex(position);
+
+  auto& itemTypeIds = sector.itemTypeIds[index];
+  itemTypeIds.clear();
+  for (const auto* item : tile.getItems())
+  {
+    itemTypeIds.push_back(item->getItemTypeId());
+  }
+  sector.walkable[index] = tile.isWalkable();
+  sector.passable[index] = !tile.isBlockingProjectiles();
+}
+
+bool WorldImageWriter::save(const std::string& filename) const
+{
+  ImageHeader header;
+  std::memcpy(header.magic, image_magic, sizeof(header.magic));
+  header.version = image_version;
+  header.numberOfSectors = sectors_.size();
+  header.padding = 0;
+
+  std::vector<SectorEntry> entries;
+  std::vector<std::uint8_t> data;
+  const auto dataOffset = sizeof(header) + (sectors_.size() * sizeof(SectorEntry));
+  for (const auto& sectorPair : sectors_)
+  {
+    const auto key = sectorPair.first;
+    const auto& sector = sectorPair.second;
+
+    SectorEntry entry;
+    std::memset(&entry, 0, sizeof(entry));
+    entry.sectorX = static_cast<std::uint16_t>(key >> 32);
+    entry.sectorY = static_cast<std::uint16_t>(key >> 16);
+    entry.z = static_cast<std::uint8_t>(key);
+    entry.offset = dataOffset + data.size();
+    toBytes(sector.walkable, entry.walkable);
+    toBytes(sector.passable, entry.passable);
+
+    for (const auto& itemTypeIds : sector.itemTypeIds)
+    {
+      writeVarint(itemTypeIds.size(), &data);
+      for (const auto itemTypeId : itemTypeIds)
+      {
+        writeVarint(itemTypeId, &data);
+      }
+    }
+    entry.size = (dataOffset + data.size()) - entry.offset;
+    entries.push_back(entry);
+  }
+
+  auto* file = fopen(filename.c_str(), "wb");
+  if (file == nullptr)
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  auto ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(entries.data(), sizeof(SectorEntry), entries.size(), file) == entries.size();
+  ok = ok && fwrite(data.data(), 1, data.size(), file) == data.size();
+  ok = (fclose(file) == 0) && ok;
+  if (!ok)
+  {
+    LOG_ERROR("%s: could not write file: %s", __func__, filename.c_str());
+    std::remove(filename.c_str());
+    return false;
+  }
+
+  LOG_INFO("%s: saved %d sectors to: %s", __func__, static_cast<int>(entries.size()), filename.c_str());
+  return true;
+}
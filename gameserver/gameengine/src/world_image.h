@@ -0,0 +1,140 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAMEENGINE_SRC_WORLD_IMAGE_H_
+#define GAMEENGINE_SRC_WORLD_IMAGE_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "item.h"
+#include "mapped_file.h"
+#include "position.h"
+#include "sector_store.h"
+#include "tile_store.h"
+
+class ItemManager;
+class Tile;
+class World;
+
+// Binary world format, made from world.xml by worldcompiler (see WorldImageWriter)
+//
+// The file is memory mapped and indexed by sector, so the tiles are created straight from it
+// without any parsing. Either all sectors are loaded at once, or each sector is added to the
+// World as paged out and loaded from the image the first time it is accessed.
+//
+// Since the image is read-only, sectors that are paged out again are stored in pageStore,
+// or kept in memory if pageStore is nullptr.
+class WorldImage : public SectorStore
+{
+ public:
+  WorldImage(ItemManager* itemManager, SectorStore* pageStore)
+    : itemManager_(itemManager),
+      pageStore_(pageStore),
+      filename_(),
+      file_(),
+      numberOfSectors_(0),
+      sectorIndex_(),
+      pagedOutSectors_()
+  {
+  }
+
+  // Delete copy constructors
+  WorldImage(const WorldImage&) = delete;
+  WorldImage& operator=(const WorldImage&) = delete;
+
+  // Returns true if the file starts like a world image, otherwise it is assumed to be world.xml
+  static bool isWorldImage(const std::string& filename);
+
+  bool open(const std::string& filename);
+
+  // Adds all sectors in the image to the World, if lazy they are added as paged out and
+  // this WorldImage must be set as the World's SectorStore. Otherwise the tiles are created
+  // by numberOfThreads threads (including the calling thread), split by sector.
+  bool loadWorld(World* world, bool lazy, int numberOfThreads = 1);
+
+  // SectorStore
+  bool storeSector(const Position& position, const std::vector<Tile>& tiles) override;
+  bool loadSector(const Position& position, std::vector<Tile>* tiles) override;
+
+ private:
+  bool loadSectorFromImage(std::uint32_t sectorNumber, std::vector<Tile>* tiles);
+
+  ItemManager* itemManager_;
+  SectorStore* pageStore_;
+
+  std::string filename_;
+  MappedFile file_;
+  std::uint32_t numberOfSectors_;
+
+  // Sector key (see getSectorKey in world_image.cc) to its number in the image
+  std::unordered_map<std::uint64_t, std::uint32_t> sectorIndex_;
+
+  // Sectors that have been paged out to pageStore, and must be loaded from there instead of the image
+  std::unordered_set<std::uint64_t> pagedOutSectors_;
+};
+
+// Collects tiles and writes them as a world image
+class WorldImageWriter
+{
+ public:
+  WorldImageWriter()
+    : sectors_()
+  {
+  }
+
+  // Delete copy constructors
+  WorldImageWriter(const WorldImageWriter&) = delete;
+  WorldImageWriter& operator=(const WorldImageWriter&) = delete;
+
+  // Only the ItemTypeIds of the tile's items are stored
+  void addTile(const Position& position, const Tile& tile);
+
+  bool save(const std::string& filename) const;
+
+ private:
+  struct Sector
+  {
+    Sector()
+      : itemTypeIds(TileStore::sector_size * TileStore::sector_size),
+        walkable(),
+        passable()
+    {
+    }
+
+    // Per tile, in the same order as Tile::getItems
+    std::vector<std::vector<ItemTypeId>> itemTypeIds;
+    TileStore::SectorBits walkable;
+    TileStore::SectorBits passable;
+  };
+
+  // Ordered by sector key, so that the image is the same for the same tiles
+  std::map<std::uint64_t, Sector> sectors_;
+};
+
+#endif  // GAMEENGINE_SRC_WORLD_IMAGE_H_
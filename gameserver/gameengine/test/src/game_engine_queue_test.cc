@@ -0,0 +1,330 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "game_engine_queue.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>  //NOLINT
+
+#include "gtest/gtest.h"
+
+#include "game_engine.h"
+#include "item_manager.h"
+#include "tile.h"
+#include "world_image.h"
+
+#include "item_types_files.h"
+
+namespace
+{
+
+const std::string image_filename = "game_engine_queue_test.bin";
+
+// Runs the GameEngineQueue on a fake clock (time_, in microseconds) that only moves when the test
+// (or a task) moves it. The timer still uses real time, but only for the fixed-rate tick interval.
+class GameEngineQueueTest : public ::testing::Test
+{
+ protected:
+  GameEngineQueueTest()
+    : io_service_(),
+      gameEngine_(),
+      time_(0),
+      clock_([this]() { return time_; }),
+      tickEnds_(0),
+      order_()
+  {
+  }
+
+  void SetUp() override
+  {
+    // GameEngine::endTick is called after each batch, so the GameEngine needs a World
+    ItemManager itemManager;
+    ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\"/>", &itemManager));
+    Tile grass(itemManager.getItem(itemManager.createMapItem(100)));
+    WorldImageWriter writer;
+    writer.addTile(Position(200, 200, 7), grass);
+    ASSERT_TRUE(writer.save(image_filename));
+    ASSERT_TRUE(writeSourceFiles("<item id=\"100\" name=\"grass\"/>"));
+  }
+
+  void TearDown() override
+  {
+    std::remove(image_filename.c_str());
+    std::remove(data_filename.c_str());
+    std::remove(items_filename.c_str());
+  }
+
+  bool init(GameEngineQueue* gameEngineQueue)
+  {
+    gameEngineQueue->setOnTickEnd([this]() { tickEnds_ += 1; });
+    return gameEngine_.init(gameEngineQueue, "", data_filename, items_filename, "", image_filename, false, 1, "", 0);
+  }
+
+  // Runs one batch of tasks, i.e. one timeout of the GameEngineQueue
+  void runBatch()
+  {
+    io_service_.reset();
+    io_service_.run_one();
+  }
+
+  // A task that records its name, and then takes durationMs on the fake clock
+  GameEngineQueue::Task task(const std::string& name, int durationMs = 0)
+  {
+    return [this, name, durationMs](GameEngine* gameEngine)
+    {
+      (void)gameEngine;
+      order_.push_back(name);
+      time_ += durationMs * 1000;
+    };
+  }
+
+  boost::asio::io_service io_service_;
+  GameEngine gameEngine_;
+  std::int64_t time_;
+  GameEngineQueue::Clock clock_;
+  int tickEnds_;
+  std::vector<std::string> order_;
+};
+
+}  // namespace
+
+TEST_F(GameEngineQueueTest, PriorityOrder)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 0, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOW, 1, task("low"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::CHAT, 1, task("chat"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::ACTION, 1, task("action 1"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOGIN, 1, task("login"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::ACTION, 1, task("action 2"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOGIN, 1, 100, task("later"));
+
+  // All expired tasks in one batch, highest priority first and in the order they were added
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login", "action 1", "action 2", "chat", "low" }), order_);
+  EXPECT_EQ(1, tickEnds_);
+
+  const auto& metrics = gameEngineQueue.getMetrics();
+  EXPECT_EQ(5, metrics.tasksRun);
+  EXPECT_EQ(0, metrics.tasksShed);
+  EXPECT_EQ(0, metrics.tasksDeferred);
+  EXPECT_EQ(0, metrics.batchesOverBudget);
+
+  // Tasks that have not expired are left
+  time_ += 100 * 1000;
+  runBatch();
+  EXPECT_EQ("later", order_.back());
+  EXPECT_EQ(6, metrics.tasksRun);
+}
+
+TEST_F(GameEngineQueueTest, TimeBudget)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 0, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+  gameEngineQueue.setTimeBudget(10);
+
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOW, 1, task("low", 6));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::CHAT, 1, task("chat", 6));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::ACTION, 1, task("action 1", 6));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::ACTION, 1, task("action 2", 6));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOGIN, 1, task("login 1", 6));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOGIN, 1, task("login 2", 6));
+
+  // LOGIN tasks are run even though they use up the budget, the rest is deferred
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login 1", "login 2" }), order_);
+  EXPECT_EQ(1, gameEngineQueue.getMetrics().batchesOverBudget);
+  EXPECT_EQ(1, tickEnds_);
+
+  // One task fits in the budget, the next task is started before the budget runs out
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login 1", "login 2", "action 1", "action 2" }), order_);
+  EXPECT_EQ(2, gameEngineQueue.getMetrics().batchesOverBudget);
+
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login 1", "login 2", "action 1", "action 2", "chat", "low" }), order_);
+  EXPECT_EQ(2, gameEngineQueue.getMetrics().batchesOverBudget);
+  EXPECT_EQ(3, tickEnds_);
+
+  // Everything but the LOGIN tasks was deferred, and then run 12 and 24 ms late
+  const auto& metrics = gameEngineQueue.getMetrics();
+  EXPECT_EQ(6, metrics.tasksRun);
+  EXPECT_EQ(4, metrics.tasksDeferred);
+  EXPECT_EQ(0, metrics.tasksShed);
+  EXPECT_EQ(24 * 1000, metrics.maxLagUs);
+  EXPECT_EQ(24 * 1000, metrics.lastLagUs);
+}
+
+TEST_F(GameEngineQueueTest, ShedLowTasks)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 0, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+  gameEngineQueue.setTimeBudget(10);
+
+  // The LOGIN task takes longer than shed_lag_ms, so the other tasks are that late when they are run
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOGIN, 1, task("login", GameEngineQueue::shed_lag_ms + 1));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::CHAT, 1, task("chat"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOW, 1, task("low 1"));
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOW, 1, task("low 2"));
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login" }), order_);
+
+  // A LOW task that is added now is not late
+  gameEngineQueue.addTask(GameEngineQueue::Priority::LOW, 1, task("low 3"));
+
+  // Only LOW tasks are dropped
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "login", "chat", "low 3" }), order_);
+
+  const auto& metrics = gameEngineQueue.getMetrics();
+  EXPECT_EQ(3, metrics.tasksRun);
+  EXPECT_EQ(2, metrics.tasksShed);
+  EXPECT_EQ(3, metrics.tasksDeferred);
+  EXPECT_EQ((GameEngineQueue::shed_lag_ms + 1) * 1000, metrics.maxLagUs);
+}
+
+TEST_F(GameEngineQueueTest, FixedRateTickBatchesInput)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 50, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  // Input received during the tick, and a task that expires in the next tick
+  gameEngineQueue.addTask(1, task("input 1"));
+  time_ += 20 * 1000;
+  gameEngineQueue.addTask(1, task("input 2"));
+  gameEngineQueue.addTask(1, 40, task("next tick"));
+  time_ += 20 * 1000;
+  gameEngineQueue.addTask(2, task("input 3"));
+
+  // Nothing is run until the tick, and then all input in one batch
+  EXPECT_EQ(0u, order_.size());
+  time_ = 50 * 1000;
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "input 1", "input 2", "input 3" }), order_);
+  EXPECT_EQ(1, tickEnds_);
+
+  time_ = 100 * 1000;
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "input 1", "input 2", "input 3", "next tick" }), order_);
+  EXPECT_EQ(2, tickEnds_);
+}
+
+TEST_F(GameEngineQueueTest, FixedRateTickEndOncePerTick)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 50, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  // The tick ends also when there were no tasks to run
+  for (auto tick = 1; tick <= 3; tick++)
+  {
+    time_ = tick * 50 * 1000;
+    runBatch();
+    EXPECT_EQ(tick, tickEnds_);
+  }
+
+  // And only once, no matter how many tasks were run
+  for (auto i = 0; i < 10; i++)
+  {
+    gameEngineQueue.addTask(i, task("input"));
+  }
+  time_ = 4 * 50 * 1000;
+  runBatch();
+  EXPECT_EQ(10u, order_.size());
+  EXPECT_EQ(4, tickEnds_);
+}
+
+TEST_F(GameEngineQueueTest, FixedRateTickOverrun)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 50, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  // The first tick takes 3.5 ticks
+  gameEngineQueue.addTask(1, task("slow", 175));
+  time_ = 50 * 1000;
+  runBatch();
+  EXPECT_EQ(1, tickEnds_);
+  EXPECT_EQ(225 * 1000, time_);
+
+  // The next tick starts directly, but the missed ticks are not run back to back
+  gameEngineQueue.addTask(1, task("input 1"));
+  runBatch();
+  EXPECT_EQ(2, tickEnds_);
+  EXPECT_EQ("input 1", order_.back());
+
+  gameEngineQueue.addTask(1, task("input 2"));
+  io_service_.reset();
+  io_service_.poll();
+  EXPECT_EQ(2, tickEnds_);
+  EXPECT_EQ("input 1", order_.back());
+
+  // The ticks are kept at the fixed rate from the tick that started late
+  time_ = 275 * 1000;
+  runBatch();
+  EXPECT_EQ(3, tickEnds_);
+  EXPECT_EQ("input 2", order_.back());
+}
+
+TEST_F(GameEngineQueueTest, StopResume)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 0, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  // Nothing is run while stopped, but the tasks are kept
+  gameEngineQueue.addTask(1, task("before stop"));
+  gameEngineQueue.stop();
+  gameEngineQueue.addTask(1, task("while stopped"));
+  runBatch();
+  EXPECT_EQ(0u, order_.size());
+  EXPECT_EQ(0, tickEnds_);
+
+  // And run when resumed
+  gameEngineQueue.resume();
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "before stop", "while stopped" }), order_);
+  EXPECT_EQ(1, tickEnds_);
+}
+
+TEST_F(GameEngineQueueTest, FixedRateStopResume)
+{
+  GameEngineQueue gameEngineQueue(&gameEngine_, &io_service_, 50, clock_);
+  ASSERT_TRUE(init(&gameEngineQueue));
+
+  gameEngineQueue.stop();
+  gameEngineQueue.addTask(1, task("while stopped"));
+  time_ = 50 * 1000;
+  runBatch();
+  EXPECT_EQ(0u, order_.size());
+  EXPECT_EQ(0, tickEnds_);
+
+  // The next tick is directly when resumed
+  gameEngineQueue.resume();
+  runBatch();
+  EXPECT_EQ(std::vector<std::string>({ "while stopped" }), order_);
+  EXPECT_EQ(1, tickEnds_);
+}
@@ -0,0 +1,229 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "game_engine.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>  //NOLINT
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+#include "coalesced_task.h"
+#include "game_engine_queue.h"
+#include "item_manager.h"
+#include "tile.h"
+#include "world_image.h"
+
+#include "item_types_files.h"
+#include "player_ctrl_mock.h"
+
+using ::testing::_;
+using ::testing::HasSubstr;
+using ::testing::InSequence;
+using ::testing::Invoke;
+using ::testing::NiceMock;
+using ::testing::ReturnPointee;
+using ::testing::SaveArg;
+
+namespace
+{
+
+const std::string image_filename = "game_engine_test.bin";
+
+class GameEngineTest : public ::testing::Test
+{
+ protected:
+  GameEngineTest()
+    : io_service_()
+  {
+  }
+
+  void SetUp() override
+  {
+    // Grass from (200, 200, 7) to (215, 215, 7), players spawn at (208, 208, 7)
+    ItemManager itemManager;
+    ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\"/>", &itemManager));
+    Tile grass(itemManager.getItem(itemManager.createMapItem(100)));
+    WorldImageWriter writer;
+    for (auto x = 200; x < 216; x++)
+    {
+      for (auto y = 200; y < 216; y++)
+      {
+        writer.addTile(Position(x, y, 7), grass);
+      }
+    }
+    ASSERT_TRUE(writer.save(image_filename));
+    ASSERT_TRUE(writeSourceFiles("<item id=\"100\" name=\"grass\"/>"));
+  }
+
+  void TearDown() override
+  {
+    std::remove(image_filename.c_str());
+    std::remove(data_filename.c_str());
+    std::remove(items_filename.c_str());
+  }
+
+  bool init(GameEngine* gameEngine, GameEngineQueue* gameEngineQueue)
+  {
+    return gameEngine->init(gameEngineQueue, "", data_filename, items_filename, "", image_filename, false, 1, "", 0);
+  }
+
+  boost::asio::io_service io_service_;
+};
+
+}  // namespace
+
+TEST_F(GameEngineTest, SaveLoadSnapshot)
+{
+  std::vector<std::uint8_t> snapshot;
+  CreatureId playerId = Creature::INVALID_ID;
+
+  // Spawn a player and put an item in front of it (south)
+  {
+    GameEngine gameEngine;
+    GameEngineQueue gameEngineQueue(&gameEngine, &io_service_);
+    ASSERT_TRUE(init(&gameEngine, &gameEngineQueue));
+
+    NiceMock<PlayerCtrlMock> playerCtrl;
+    EXPECT_CALL(playerCtrl, setPlayerId(_)).WillOnce(SaveArg<0>(&playerId));
+    ON_CALL(playerCtrl, getPlayerId()).WillByDefault(ReturnPointee(&playerId));
+    ASSERT_TRUE(gameEngine.spawn("Alice", &playerCtrl));
+    gameEngine.say(playerId, 0, "/put 101", "", 0);
+
+    gameEngineQueue.stop();
+    gameEngine.saveSnapshot(&snapshot);
+  }
+
+  // Restore it in another GameEngine, the player keeps its id
+  GameEngine gameEngine;
+  GameEngineQueue gameEngineQueue(&gameEngine, &io_service_);
+  ASSERT_TRUE(init(&gameEngine, &gameEngineQueue));
+
+  NiceMock<PlayerCtrlMock> playerCtrl;
+  EXPECT_CALL(playerCtrl, setPlayerId(playerId));
+  ON_CALL(playerCtrl, getPlayerId()).WillByDefault(ReturnPointee(&playerId));
+  ASSERT_TRUE(gameEngine.loadSnapshot(snapshot, [&playerCtrl, playerId](CreatureId creatureId) -> PlayerCtrl*
+  {
+    return creatureId == playerId ? &playerCtrl : nullptr;
+  }));
+
+  // The player and the item are where they were
+  EXPECT_CALL(playerCtrl, sendTextMessage(0x13, HasSubstr("Creature: " + std::to_string(playerId))));
+  gameEngine.say(playerId, 0, "/debug", "", 0);
+  EXPECT_CALL(playerCtrl, sendTextMessage(0x13, HasSubstr("Item: 101")));
+  gameEngine.say(playerId, 0, "/debugf", "", 0);
+
+  // Only before any player has spawned
+  EXPECT_FALSE(gameEngine.loadSnapshot(snapshot, [](CreatureId) { return nullptr; }));
+
+  gameEngine.despawn(playerId);
+}
+
+TEST_F(GameEngineTest, CoalescedTurn)
+{
+  GameEngine gameEngine;
+  GameEngineQueue gameEngineQueue(&gameEngine, &io_service_);
+  ASSERT_TRUE(init(&gameEngine, &gameEngineQueue));
+
+  CreatureId playerId = Creature::INVALID_ID;
+  NiceMock<PlayerCtrlMock> playerCtrl;
+  EXPECT_CALL(playerCtrl, setPlayerId(_)).WillOnce(SaveArg<0>(&playerId));
+  ON_CALL(playerCtrl, getPlayerId()).WillByDefault(ReturnPointee(&playerId));
+  ASSERT_TRUE(gameEngine.spawn("Alice", &playerCtrl));
+
+  auto tasks = 0;
+  CoalescedTask<Direction> queuedTurn([&tasks, &playerId](GameEngine* gameEngine, const Direction& direction)
+  {
+    tasks += 1;
+    gameEngine->turn(playerId, direction);
+  });
+
+  // Turn packets received before the task is run only replace the direction
+  queuedTurn.queue(&gameEngineQueue, playerId, Direction::NORTH);
+  queuedTurn.queue(&gameEngineQueue, playerId, Direction::EAST);
+  queuedTurn.queue(&gameEngineQueue, playerId, Direction::SOUTH);
+  queuedTurn.queue(&gameEngineQueue, playerId, Direction::WEST);
+  EXPECT_TRUE(queuedTurn.isQueued());
+
+  // One task, that turns the player to the last direction
+  auto direction = Direction::NORTH;
+  EXPECT_CALL(playerCtrl, onCreatureTurn(_, _, _, _)).WillOnce(Invoke([&direction](const WorldInterface&,
+                                                                                   const Creature& creature,
+                                                                                   const Position&,
+                                                                                   int)
+  {
+    direction = creature.getDirection();
+  }));
+  io_service_.run();
+  EXPECT_EQ(1, tasks);
+  EXPECT_EQ(1, gameEngineQueue.getMetrics().tasksRun);
+  EXPECT_EQ(Direction::WEST, direction);
+  EXPECT_FALSE(queuedTurn.isQueued());
+
+  // And then a new task for the next turn
+  EXPECT_CALL(playerCtrl, onCreatureTurn(_, _, _, _));
+  queuedTurn.queue(&gameEngineQueue, playerId, Direction::NORTH);
+  io_service_.reset();
+  io_service_.run();
+  EXPECT_EQ(2, tasks);
+
+  gameEngine.despawn(playerId);
+}
+
+TEST_F(GameEngineTest, DelayedMoveCoalesced)
+{
+  GameEngine gameEngine;
+  GameEngineQueue gameEngineQueue(&gameEngine, &io_service_);
+  ASSERT_TRUE(init(&gameEngine, &gameEngineQueue));
+
+  CreatureId playerId = Creature::INVALID_ID;
+  NiceMock<PlayerCtrlMock> playerCtrl;
+  EXPECT_CALL(playerCtrl, setPlayerId(_)).WillOnce(SaveArg<0>(&playerId));
+  ON_CALL(playerCtrl, getPlayerId()).WillByDefault(ReturnPointee(&playerId));
+  ASSERT_TRUE(gameEngine.spawn("Alice", &playerCtrl));
+
+  {
+    InSequence sequence;
+    EXPECT_CALL(playerCtrl, onCreatureMove(_, _, Position(208, 208, 7), _, Position(209, 208, 7)));
+    EXPECT_CALL(playerCtrl, onCreatureMove(_, _, Position(209, 208, 7), _, Position(209, 209, 7)));
+  }
+
+  // The first move is performed directly, the moves until the next walk tick are coalesced into
+  // one delayed move, in the last direction
+  gameEngine.move(playerId, Direction::EAST);
+  gameEngine.move(playerId, Direction::NORTH);
+  gameEngine.move(playerId, Direction::EAST);
+  gameEngine.move(playerId, Direction::WEST);
+  gameEngine.move(playerId, Direction::SOUTH);
+
+  // Only one more step is taken, by one task
+  io_service_.run();
+  EXPECT_EQ(1, gameEngineQueue.getMetrics().tasksRun);
+
+  gameEngine.despawn(playerId);
+}
@@ -0,0 +1,247 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "item_manager.h"
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "item_types_files.h"
+
+// Unless loadItemTypes is called, only ItemTypeId 0 is valid
+
+namespace
+{
+
+const std::string cache_filename = "item_manager_test.bin";
+
+}  // namespace
+
+TEST(ItemManagerTest, CreateDestroy)
+{
+  ItemManager itemManager;
+
+  const auto itemUniqueId = itemManager.createItem(0);
+  ASSERT_NE(0u, itemUniqueId);
+  ASSERT_EQ(1u, itemManager.getNumberOfItems());
+
+  auto* item = itemManager.getItem(itemUniqueId);
+  ASSERT_NE(nullptr, item);
+  ASSERT_EQ(itemUniqueId, item->getItemUniqueId());
+  ASSERT_EQ(0, item->getItemTypeId());
+  ASSERT_EQ(1, item->getCount());
+
+  itemManager.destroyItem(itemUniqueId);
+  ASSERT_EQ(nullptr, itemManager.getItem(itemUniqueId));
+  ASSERT_EQ(0u, itemManager.getNumberOfItems());
+
+  // Invalid handles
+  ASSERT_EQ(nullptr, itemManager.getItem(0));
+  ASSERT_EQ(nullptr, itemManager.getItem(12345));
+  ASSERT_EQ(0u, itemManager.createItem(1));
+}
+
+TEST(ItemManagerTest, StaleHandle)
+{
+  ItemManager itemManager;
+
+  const auto oldItemUniqueId = itemManager.createItem(0);
+  auto* oldItem = itemManager.getItem(oldItemUniqueId);
+  itemManager.destroyItem(oldItemUniqueId);
+
+  // The slot is reused, but the old handle must not give the new item
+  const auto newItemUniqueId = itemManager.createItem(0);
+  ASSERT_NE(oldItemUniqueId, newItemUniqueId);
+  ASSERT_EQ(oldItem, itemManager.getItem(newItemUniqueId));
+  ASSERT_EQ(nullptr, itemManager.getItem(oldItemUniqueId));
+
+  // Destroying with the old handle does nothing
+  itemManager.destroyItem(oldItemUniqueId);
+  ASSERT_NE(nullptr, itemManager.getItem(newItemUniqueId));
+}
+
+TEST(ItemManagerTest, StablePointers)
+{
+  ItemManager itemManager;
+
+  // More than one chunk, the items must not move when new chunks are allocated
+  std::vector<ItemUniqueId> itemUniqueIds;
+  std::vector<Item*> items;
+  for (auto i = 0u; i < ItemManager::items_per_chunk * 3; i++)
+  {
+    itemUniqueIds.push_back(itemManager.createItem(0));
+    items.push_back(itemManager.getItem(itemUniqueIds.back()));
+  }
+
+  for (auto i = 0u; i < itemUniqueIds.size(); i++)
+  {
+    ASSERT_EQ(items[i], itemManager.getItem(itemUniqueIds[i]));
+  }
+
+  // Destroy every other item, and create them again
+  for (auto i = 0u; i < itemUniqueIds.size(); i += 2)
+  {
+    itemManager.destroyItem(itemUniqueIds[i]);
+  }
+  ASSERT_EQ(itemUniqueIds.size() / 2, itemManager.getNumberOfItems());
+  for (auto i = 0u; i < itemUniqueIds.size(); i += 2)
+  {
+    itemUniqueIds[i] = itemManager.createItem(0);
+  }
+
+  // All slots were reused (in any order), no new slots were needed
+  ASSERT_EQ(itemUniqueIds.size(), itemManager.getNumberOfItems());
+  const std::set<Item*> oldItems(items.cbegin(), items.cend());
+  std::set<Item*> newItems;
+  for (const auto itemUniqueId : itemUniqueIds)
+  {
+    newItems.insert(itemManager.getItem(itemUniqueId));
+  }
+  ASSERT_EQ(oldItems, newItems);
+}
+
+TEST(ItemManagerTest, SharedMapItems)
+{
+  ItemManager itemManager;
+  ASSERT_TRUE(loadItemTypes("", &itemManager));
+
+  // Ground and non-movable items are shared
+  const auto groundItemUniqueId = itemManager.createMapItem(100);
+  ASSERT_EQ(groundItemUniqueId, itemManager.createMapItem(100));
+  ASSERT_TRUE(itemManager.isShared(groundItemUniqueId));
+  ASSERT_EQ(itemManager.createMapItem(101), itemManager.createMapItem(101));
+  ASSERT_NE(groundItemUniqueId, itemManager.createMapItem(101));
+  ASSERT_EQ(2u, itemManager.getNumberOfItems());
+
+  // Stackables and containers are not
+  ASSERT_NE(itemManager.createMapItem(102), itemManager.createMapItem(102));
+  ASSERT_NE(itemManager.createMapItem(103), itemManager.createMapItem(103));
+  ASSERT_FALSE(itemManager.isShared(itemManager.createMapItem(103)));
+
+  // Shared items are never destroyed
+  itemManager.destroyItem(groundItemUniqueId);
+  ASSERT_NE(nullptr, itemManager.getItem(groundItemUniqueId));
+
+  // Copy-on-write
+  const auto uniqueItemUniqueId = itemManager.makeUnique(groundItemUniqueId);
+  ASSERT_NE(groundItemUniqueId, uniqueItemUniqueId);
+  ASSERT_FALSE(itemManager.isShared(uniqueItemUniqueId));
+  ASSERT_EQ(100, itemManager.getItem(uniqueItemUniqueId)->getItemTypeId());
+  ASSERT_EQ(uniqueItemUniqueId, itemManager.makeUnique(uniqueItemUniqueId));
+}
+
+TEST(ItemManagerTest, CreateSharedMapItems)
+{
+  ItemManager itemManager;
+  ASSERT_TRUE(loadItemTypes("", &itemManager));
+
+  // Nothing is shared until created
+  ASSERT_EQ(nullptr, itemManager.getSharedMapItem(100));
+
+  // createSharedMapItems creates the same shared items as createMapItem
+  const auto groundItemUniqueId = itemManager.createMapItem(100);
+  itemManager.createSharedMapItems();
+  ASSERT_EQ(itemManager.getItem(groundItemUniqueId), itemManager.getSharedMapItem(100));
+  ASSERT_EQ(itemManager.getItem(itemManager.createMapItem(101)), itemManager.getSharedMapItem(101));
+  ASSERT_EQ(itemManager.getItem(itemManager.createMapItem(104)), itemManager.getSharedMapItem(104));
+  ASSERT_EQ(3u, itemManager.getNumberOfItems());
+
+  // Stackables, containers and invalid ItemTypes are not shared
+  ASSERT_EQ(nullptr, itemManager.getSharedMapItem(102));
+  ASSERT_EQ(nullptr, itemManager.getSharedMapItem(103));
+  ASSERT_EQ(nullptr, itemManager.getSharedMapItem(105));
+}
+
+TEST(ItemManagerTest, ItemTypes)
+{
+  ItemManager itemManager;
+  ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\" weight=\"10\"/>"
+                            "<item id=\"101\" name=\"helmet\" type=\"armor\" position=\"helmet\" arm=\"2\"/>",
+                            &itemManager));
+
+  const auto& grass = itemManager.getItem(itemManager.createItem(100))->getItemType();
+  ASSERT_TRUE(grass.ground);
+  ASSERT_EQ(100, grass.speed);
+  ASSERT_EQ(10, grass.weight);
+  ASSERT_EQ("grass", grass.getDetails().name);
+  ASSERT_EQ(ItemCategory::NONE, grass.category);
+
+  const auto& helmet = itemManager.getItem(itemManager.createItem(101))->getItemType();
+  ASSERT_TRUE(helmet.isNotMovable);
+  ASSERT_FALSE(helmet.ground);
+  ASSERT_EQ(ItemCategory::ARMOR, helmet.category);
+  ASSERT_EQ(ItemSlot::HELMET, helmet.slot);
+  ASSERT_EQ(2, helmet.getDetails().arm);
+}
+
+TEST(ItemManagerTest, Cache)
+{
+  const std::string helmetNode = "<item id=\"101\" name=\"helmet\" type=\"armor\" position=\"helmet\" arm=\"2\"/>";
+  ASSERT_TRUE(writeSourceFiles(helmetNode));
+
+  ItemManager sourceItemManager;
+  ASSERT_TRUE(sourceItemManager.loadItemTypes(data_filename, items_filename));
+  ASSERT_TRUE(sourceItemManager.saveItemTypesCache(data_filename, items_filename, cache_filename));
+
+  // Same source files, loaded from the cache
+  ItemManager cacheItemManager;
+  ASSERT_TRUE(cacheItemManager.loadItemTypes(data_filename, items_filename, cache_filename));
+  const auto& ground = cacheItemManager.getItem(cacheItemManager.createItem(100))->getItemType();
+  ASSERT_TRUE(ground.ground);
+  ASSERT_FALSE(ground.isNotMovable);
+  ASSERT_EQ(100, ground.speed);
+  const auto& helmet = cacheItemManager.getItem(cacheItemManager.createItem(101))->getItemType();
+  ASSERT_TRUE(helmet.isNotMovable);
+  ASSERT_EQ(ItemSlot::HELMET, helmet.slot);
+  ASSERT_EQ("helmet", helmet.getDetails().name);
+  ASSERT_EQ("armor", helmet.getDetails().type);
+  ASSERT_EQ(2, helmet.getDetails().arm);
+  ASSERT_TRUE(cacheItemManager.getItem(cacheItemManager.createItem(103))->getItemType().isContainer);
+  ASSERT_EQ(0u, cacheItemManager.createItem(105));
+
+  // Changed source files, the cache is out of date and not used
+  ASSERT_TRUE(writeSourceFiles("<item id=\"101\" name=\"hat\"/>"));
+  ItemManager changedItemManager;
+  ASSERT_TRUE(changedItemManager.loadItemTypes(data_filename, items_filename, cache_filename));
+  ASSERT_EQ("hat", changedItemManager.getItem(changedItemManager.createItem(101))->getItemType().getDetails().name);
+
+  // Truncated cache, not used
+  ASSERT_TRUE(writeSourceFiles(helmetNode));
+  auto* cacheFile = fopen(cache_filename.c_str(), "wb");
+  ASSERT_NE(nullptr, cacheFile);
+  fputs("ITCH", cacheFile);
+  fclose(cacheFile);
+  ItemManager truncatedItemManager;
+  ASSERT_TRUE(truncatedItemManager.loadItemTypes(data_filename, items_filename, cache_filename));
+  const auto* truncatedHelmet = truncatedItemManager.getItem(truncatedItemManager.createItem(101));
+  ASSERT_EQ("helmet", truncatedHelmet->getItemType().getDetails().name);
+
+  std::remove(data_filename.c_str());
+  std::remove(items_filename.c_str());
+  std::remove(cache_filename.c_str());
+}
@@ -0,0 +1,85 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef GAMEENGINE_TEST_ITEM_TYPES_FILES_H_
+#define GAMEENGINE_TEST_ITEM_TYPES_FILES_H_
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "item_manager.h"
+
+const std::string data_filename = "item_types_test.dat";
+const std::string items_filename = "item_types_test.xml";
+
+// Writes a data file with five item types (starting at 100), each with one 1x1 sprite:
+// 100: ground, 101: not movable, 102: not movable and stackable, 103: not movable container,
+// 104: not movable, blocking and blocking projectiles
+// and an items file with the given <item>-nodes
+inline bool writeSourceFiles(const std::string& itemNodes)
+{
+  const std::vector<std::vector<int>> flags =
+  {
+    { 0x00, 100, 0x00 }, { 0x0C }, { 0x0C, 0x04 }, { 0x0C, 0x03 }, { 0x0C, 0x0B, 0x0D }
+  };
+
+  auto* dataFile = fopen(data_filename.c_str(), "wb");
+  auto* itemsFile = fopen(items_filename.c_str(), "w");
+  if (dataFile == nullptr || itemsFile == nullptr)
+  {
+    return false;
+  }
+
+  for (auto i = 0; i < 0x0C; i++)
+  {
+    fputc(0, dataFile);
+  }
+  for (const auto& itemFlags : flags)
+  {
+    for (const auto flag : itemFlags)
+    {
+      fputc(flag, dataFile);
+    }
+    for (const auto byte : { 0xFF, 1, 1, 1, 1, 1, 1, 0, 0 })
+    {
+      fputc(byte, dataFile);
+    }
+  }
+  fclose(dataFile);
+
+  fputs(("<items>\n" + itemNodes + "</items>\n").c_str(), itemsFile);
+  fclose(itemsFile);
+  return true;
+}
+
+inline bool loadItemTypes(const std::string& itemNodes, ItemManager* itemManager)
+{
+  const auto result = writeSourceFiles(itemNodes) && itemManager->loadItemTypes(data_filename, items_filename);
+  std::remove(data_filename.c_str());
+  std::remove(items_filename.c_str());
+  return result;
+}
+
+#endif  // GAMEENGINE_TEST_ITEM_TYPES_FILES_H_
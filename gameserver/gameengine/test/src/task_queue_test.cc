@@ -0,0 +1,262 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "task_queue.h"
+#include "game_engine_queue.h"
+#include "game_position.h"
+
+namespace
+{
+
+// Counts all heap allocations done via operator new
+std::size_t number_of_allocations = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+  number_of_allocations++;
+  auto* ptr = std::malloc(size);
+  if (ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+TEST(TaskQueueTest, Order)
+{
+  TaskQueue<int> queue;
+  EXPECT_TRUE(queue.empty());
+
+  queue.push(1, 300, 1);
+  queue.push(2, 100, 2);
+  queue.push(1, 200, 3);
+  queue.push(3, 100, 4);  // Same expire as task 2, so after task 2
+  queue.push(2, 0, 5);
+  EXPECT_EQ(5u, queue.size());
+
+  std::vector<int> tasks;
+  while (!queue.empty())
+  {
+    tasks.push_back(queue.pop());
+  }
+  EXPECT_EQ(std::vector<int>({ 5, 2, 4, 3, 1 }), tasks);
+}
+
+TEST(TaskQueueTest, Cancel)
+{
+  TaskQueue<int> queue;
+  queue.push(1, 100, 1);
+  queue.push(2, 200, 2);
+  queue.push(1, 300, 3);
+  queue.push(3, 400, 4);
+  queue.push(1, 500, 5);
+
+  // The first task is canceled
+  queue.cancel(1);
+  EXPECT_EQ(2u, queue.size());
+  EXPECT_EQ(200, queue.getFirstExpire());
+  EXPECT_EQ(2, queue.getFirstTag());
+
+  // Nothing to cancel
+  queue.cancel(1);
+  queue.cancel(4);
+  EXPECT_EQ(2u, queue.size());
+
+  // New tasks with a canceled tag, reusing the freed slots
+  queue.push(1, 50, 6);
+  queue.push(1, 450, 7);
+  EXPECT_EQ(6, queue.pop());
+  EXPECT_EQ(2, queue.pop());
+
+  queue.cancel(3);
+  EXPECT_EQ(7, queue.pop());
+  EXPECT_TRUE(queue.empty());
+}
+
+TEST(TaskQueueTest, CancelDestroysTask)
+{
+  auto counter = std::make_shared<int>(0);
+
+  TaskQueue<std::shared_ptr<int>> queue;
+  queue.push(1, 100, std::shared_ptr<int>(counter));
+  queue.push(2, 200, std::shared_ptr<int>(counter));
+  EXPECT_EQ(3, counter.use_count());
+
+  queue.cancel(2);
+  EXPECT_EQ(2, counter.use_count());
+
+  auto task = queue.pop();
+  EXPECT_EQ(2, counter.use_count());
+  task.reset();
+  EXPECT_EQ(1, counter.use_count());
+}
+
+TEST(TaskQueueTest, Random)
+{
+  // Compare with a simple sorted vector, with many cancels so that canceled entries are removed
+  struct Task
+  {
+    int tag;
+    std::int64_t expire;
+    int id;
+  };
+  std::vector<Task> expected;
+  TaskQueue<int> queue;
+
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<int> randomTag(0, 19);
+  std::uniform_int_distribution<int> randomExpire(0, 1000);
+  std::uniform_int_distribution<int> randomOperation(0, 9);
+  auto nextId = 0;
+  for (auto i = 0; i < 10000; i++)
+  {
+    const auto operation = randomOperation(random);
+    if (operation < 6)
+    {
+      const auto tag = randomTag(random);
+      const auto expire = randomExpire(random);
+      const auto it = std::find_if(expected.begin(), expected.end(), [expire](const Task& task)
+      {
+        return task.expire > expire;
+      });
+      expected.insert(it, Task{tag, expire, nextId});
+      queue.push(tag, expire, nextId++);
+    }
+    else if (operation < 8)
+    {
+      const auto tag = randomTag(random);
+      expected.erase(std::remove_if(expected.begin(), expected.end(), [tag](const Task& task)
+      {
+        return task.tag == tag;
+      }), expected.end());
+      queue.cancel(tag);
+    }
+    else if (!expected.empty())
+    {
+      ASSERT_FALSE(queue.empty());
+      EXPECT_EQ(expected.front().expire, queue.getFirstExpire());
+      EXPECT_EQ(expected.front().tag, queue.getFirstTag());
+      EXPECT_EQ(expected.front().id, queue.pop());
+      expected.erase(expected.begin());
+    }
+    ASSERT_EQ(expected.size(), queue.size());
+  }
+}
+
+TEST(TaskQueueTest, NoAllocations)
+{
+  // Players sending input, like the tasks that Protocol71 adds to GameEngineQueue
+  // The strings are read from the packets before the tasks are created
+  constexpr auto number_of_players = 100;
+  constexpr auto number_of_ticks = 10;
+  std::vector<std::string> messages;
+  for (auto i = 0; i < number_of_players * (number_of_ticks + 1); i++)
+  {
+    messages.emplace_back("A message that does not fit in the std::string itself");
+  }
+
+  TaskQueue<GameEngineQueue::Task> queue;
+  auto numberOfCalls = 0;
+  auto* numberOfCallsPtr = &numberOfCalls;
+  const auto tick = [&](int tick)
+  {
+    for (auto playerId = 0; playerId < number_of_players; playerId++)
+    {
+      const auto packetId = 0x65;
+      queue.push(playerId, tick, [numberOfCallsPtr, playerId, packetId](GameEngine* gameEngine)
+      {
+        (void)gameEngine;
+        *numberOfCallsPtr += playerId + packetId > 0 ? 1 : 0;
+      });
+
+      const auto fromItemPosition = ItemPosition(GamePosition(Position(200, 200, 7)), 1, 0);
+      const auto toGamePosition = GamePosition(Position(201, 200, 7));
+      const auto count = 1;
+      queue.push(playerId, tick, [numberOfCallsPtr, fromItemPosition, toGamePosition, count](GameEngine* gameEngine)
+      {
+        (void)gameEngine;
+        *numberOfCallsPtr += fromItemPosition.getItemTypeId() + count > 0 && toGamePosition.isPosition() ? 1 : 0;
+      });
+
+      auto& message = messages[tick * number_of_players + playerId];
+      auto receiver = std::string();
+      queue.push(playerId, tick, [numberOfCallsPtr,
+                                  message = std::move(message),
+                                  receiver = std::move(receiver)](GameEngine* gameEngine)
+      {
+        (void)gameEngine;
+        *numberOfCallsPtr += !message.empty() && receiver.empty() ? 1 : 0;
+      });
+
+      // A task that does not fit inline
+      std::array<char, GameEngineQueue::Task::inline_size> large = {{ 1 }};
+      queue.push(playerId, tick, [numberOfCallsPtr, large](GameEngine* gameEngine)
+      {
+        (void)gameEngine;
+        *numberOfCallsPtr += large[0];
+      });
+    }
+
+    while (!queue.empty())
+    {
+      auto task = queue.pop();
+      task(nullptr);
+    }
+  };
+
+  // The first tick grows the queue and the pool
+  tick(0);
+
+  const auto numberOfAllocations = number_of_allocations;
+  for (auto i = 1; i <= number_of_ticks; i++)
+  {
+    tick(i);
+  }
+  EXPECT_EQ(numberOfAllocations, number_of_allocations);
+  EXPECT_EQ(number_of_players * 4 * (number_of_ticks + 1), numberOfCalls);
+}
@@ -0,0 +1,186 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "world_image.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "item_manager.h"
+#include "tile.h"
+#include "world.h"
+
+#include "item_types_files.h"
+
+namespace
+{
+
+const std::string image_filename = "world_image_test.bin";
+
+std::vector<ItemTypeId> getItemTypeIds(const Tile* tile)
+{
+  std::vector<ItemTypeId> itemTypeIds;
+  for (const auto* item : tile->getItems())
+  {
+    itemTypeIds.push_back(item->getItemTypeId());
+  }
+  return itemTypeIds;
+}
+
+}  // namespace
+
+TEST(WorldImageTest, SaveLoad)
+{
+  ItemManager itemManager;
+  ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\"/>", &itemManager));
+
+  // Grass, grass with a wall, and grass on another floor and sector
+  auto createTile = [&itemManager](const std::vector<ItemTypeId>& itemTypeIds)
+  {
+    Tile tile(itemManager.getItem(itemManager.createMapItem(itemTypeIds.front())));
+    for (auto it = itemTypeIds.cbegin() + 1; it != itemTypeIds.cend(); ++it)
+    {
+      tile.addItem(itemManager.getItem(itemManager.createMapItem(*it)));
+    }
+    return tile;
+  };
+  const auto grass = createTile({ 100 });
+  const auto wall = createTile({ 100, 104 });
+
+  WorldImageWriter writer;
+  writer.addTile(Position(100, 100, 7), grass);
+  writer.addTile(Position(101, 100, 7), wall);
+  writer.addTile(Position(300, 50, 6), grass);
+  ASSERT_TRUE(writer.save(image_filename));
+  ASSERT_TRUE(WorldImage::isWorldImage(image_filename));
+
+  // Load all sectors
+  {
+    World world;
+    WorldImage worldImage(&itemManager, nullptr);
+    ASSERT_TRUE(worldImage.open(image_filename));
+    ASSERT_TRUE(worldImage.loadWorld(&world, false));
+
+    ASSERT_NE(nullptr, world.getTile(Position(100, 100, 7)));
+    EXPECT_EQ(getItemTypeIds(&grass), getItemTypeIds(world.getTile(Position(100, 100, 7))));
+    ASSERT_NE(nullptr, world.getTile(Position(101, 100, 7)));
+    EXPECT_EQ(getItemTypeIds(&wall), getItemTypeIds(world.getTile(Position(101, 100, 7))));
+    EXPECT_NE(nullptr, world.getTile(Position(300, 50, 6)));
+    EXPECT_EQ(nullptr, world.getTile(Position(102, 100, 7)));
+    EXPECT_EQ(nullptr, world.getTile(Position(100, 100, 6)));
+  }
+
+  // Load each sector when first accessed, walkability and line of sight are known before that
+  {
+    World world;
+    WorldImage worldImage(&itemManager, nullptr);
+    ASSERT_TRUE(worldImage.open(image_filename));
+    ASSERT_TRUE(worldImage.loadWorld(&world, true));
+    world.setSectorStore(&worldImage);
+
+    EXPECT_TRUE(world.getWalkabilityMap().isWalkable(Position(100, 100, 7)));
+    EXPECT_FALSE(world.getWalkabilityMap().isWalkable(Position(101, 100, 7)));
+    EXPECT_FALSE(world.getWalkabilityMap().isWalkable(Position(102, 100, 7)));
+    EXPECT_TRUE(world.getLineOfSight().isPassable(Position(100, 100, 7)));
+    EXPECT_FALSE(world.getLineOfSight().isPassable(Position(101, 100, 7)));
+
+    ASSERT_NE(nullptr, world.getTile(Position(101, 100, 7)));
+    EXPECT_EQ(getItemTypeIds(&wall), getItemTypeIds(world.getTile(Position(101, 100, 7))));
+    EXPECT_NE(nullptr, world.getTile(Position(300, 50, 6)));
+    EXPECT_EQ(nullptr, world.getTile(Position(102, 100, 7)));
+  }
+
+  std::remove(image_filename.c_str());
+}
+
+TEST(WorldImageTest, LoadWithThreads)
+{
+  ItemManager itemManager;
+  ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\"/>", &itemManager));
+
+  // Grass in many sectors, and a stackable item (not shared) on every tenth tile
+  auto grass = Tile(itemManager.getItem(itemManager.createMapItem(100)));
+  auto stackable = Tile(itemManager.getItem(itemManager.createMapItem(100)));
+  stackable.addItem(itemManager.getItem(itemManager.createMapItem(102)));
+
+  WorldImageWriter writer;
+  for (auto x = 0; x < 128; x++)
+  {
+    for (auto y = 0; y < 128; y++)
+    {
+      writer.addTile(Position(x, y, 7), (x + y) % 10 == 0 ? stackable : grass);
+    }
+  }
+  ASSERT_TRUE(writer.save(image_filename));
+
+  World world;
+  WorldImage worldImage(&itemManager, nullptr);
+  ASSERT_TRUE(worldImage.open(image_filename));
+  ASSERT_TRUE(worldImage.loadWorld(&world, false, 4));
+
+  for (auto x = 0; x < 128; x++)
+  {
+    for (auto y = 0; y < 128; y++)
+    {
+      const auto* tile = world.getTile(Position(x, y, 7));
+      ASSERT_NE(nullptr, tile);
+      if ((x + y) % 10 == 0)
+      {
+        ASSERT_EQ(getItemTypeIds(&stackable), getItemTypeIds(tile));
+        for (const auto* item : tile->getItems())
+        {
+          ASSERT_EQ(item->getItemTypeId() == 100, itemManager.isShared(item->getItemUniqueId()));
+        }
+      }
+      else
+      {
+        ASSERT_EQ(getItemTypeIds(&grass), getItemTypeIds(tile));
+      }
+      ASSERT_EQ(itemManager.getSharedMapItem(100), tile->getItems().front());
+    }
+  }
+
+  std::remove(image_filename.c_str());
+}
+
+TEST(WorldImageTest, InvalidImage)
+{
+  ItemManager itemManager;
+  WorldImage worldImage(&itemManager, nullptr);
+  EXPECT_FALSE(WorldImage::isWorldImage(image_filename));
+  EXPECT_FALSE(worldImage.open(image_filename));
+
+  // Right magic, but truncated
+  auto* file = fopen(image_filename.c_str(), "wb");
+  ASSERT_NE(nullptr, file);
+  fputs("WRLD", file);
+  fclose(file);
+  EXPECT_TRUE(WorldImage::isWorldImage(image_filename));
+  EXPECT_FALSE(worldImage.open(image_filename));
+
+  std::remove(image_filename.c_str());
+}
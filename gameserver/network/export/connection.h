@@ -25,6 +25,10 @@
 #ifndef NETWORK_EXPORT_CONNECTION_H_
 #define NETWORK_EXPORT_CONNECTION_H_
 
+#include <cstdint>
+#include <functional>
+#include <vector>
+
 #include "incoming_packet.h"
 #include "outgoing_packet.h"
 
@@ -37,11 +41,39 @@ class Connection
     std::function<void(void)> onDisconnected;
   };
 
+  // What is needed to resume a detached Connection, e.g. in another process (see detach)
+  struct Detached
+  {
+    int socket;
+
+    // Part of a packet that was received but not yet handled, and the rest of the packets that
+    // were not sent (with their headers)
+    std::vector<std::uint8_t> receivedData;
+    std::vector<std::uint8_t> unsentData;
+  };
+
   virtual ~Connection() = default;
 
   virtual void init(const Callbacks& callbacks) = 0;
   virtual void close(bool force) = 0;
   virtual void sendPacket(OutgoingPacket&& packet) = 0;
+
+  // While corked, sent packets are only queued, and all queued packets are written together
+  // (in a single write) on flush. A graceful close also writes the queued packets.
+  virtual void setCorked(bool corked) = 0;
+  virtual void flush() = 0;
+
+  // Stops receiving and sending without closing the socket, so that the connection can be handed
+  // over to another process (see Handoff and ServerFactory::createConnection). onDetached is called
+  // when there is no receive or send in progress anymore, either in the same context or in a later
+  // context, and no callbacks are called after that. The socket is still owned by this instance.
+  // Returns false if the connection is closing, then onDetached is never called.
+  virtual bool detach(const std::function<void(Detached&&)>& onDetached) = 0;
+
+  // Resumes a detached Connection in this process, e.g. when the other process could not take
+  // over. detached is what was given to onDetached, the unsent data is sent and the received data
+  // is parsed first, as in a Connection created with it. The callbacks given to init are kept.
+  virtual void reattach(Detached&& detached) = 0;
 };
 
 #endif  // NETWORK_EXPORT_CONNECTION_H_
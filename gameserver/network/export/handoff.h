@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NETWORK_EXPORT_HANDOFF_H_
+#define NETWORK_EXPORT_HANDOFF_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Hands over sockets and a snapshot of the state from a running server process to a new process
+// that replaces it, so that the server can be restarted without closing any connection. The
+// sockets are passed over a unix domain socket with SCM_RIGHTS (Linux only).
+//
+// The running process listens on a unix domain socket, see listen. When the new process is
+// ready to take over it connects to that socket, see connect. The running process then sends
+// its sockets and snapshot, see send, and the new process receives them, see receive.
+//
+// The new process sends an ack when it has loaded the snapshot, and the running process replies
+// with an ack before it stops, see sendAck. Until then both processes have the sockets open, and
+// if either ack is missing the running process keeps them and continues.
+//
+// send, receive and receiveAck block until done, they are only called once per restart.
+class Handoff
+{
+ public:
+  // At most this many sockets are passed per message
+  static constexpr int max_sockets_per_message = 64;
+
+  // Returns the listening socket, or -1 on error. A socket file that already exists at path
+  // is removed first, as it belongs to the process that is being replaced, or to a process
+  // that is not running anymore.
+  static int listen(const std::string& path);
+
+  // Returns the connected socket, or -1 if no process is listening at path
+  static int connect(const std::string& path);
+
+  static bool send(int socket, const std::vector<int>& sockets, const std::vector<std::uint8_t>& data);
+  static bool receive(int socket, std::vector<int>* sockets, std::vector<std::uint8_t>* data);
+
+  static bool sendAck(int socket);
+
+  // Returns false if there is no ack within timeoutMs, e.g. if the other process has failed
+  static bool receiveAck(int socket, int timeoutMs);
+};
+
+#endif  // NETWORK_EXPORT_HANDOFF_H_
@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NETWORK_EXPORT_NETWORK_THREADS_H_
+#define NETWORK_EXPORT_NETWORK_THREADS_H_
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/asio.hpp>  //NOLINT
+
+class Mailbox;
+
+// A pool of threads that run the Connections, so that socket I/O is not done on the thread that
+// owns the Connections (e.g. the game engine thread), see ServerFactory.
+//
+// Each Connection runs on its own strand of the pool's io_service. The owner uses it through a
+// ConnectionProxy, which passes the calls to the Connection's strand and the callbacks back to
+// ownerService, both over lock-free queues (see Mailbox). The callbacks of all Connections share
+// one queue, so the owner's thread is only woken up once for everything that is received at the
+// same time.
+class NetworkThreads
+{
+ public:
+  // cpus are the CPUs that each thread is pinned to, empty for no pinning (see ThreadAffinity)
+  NetworkThreads(boost::asio::io_service* ownerService, int numberOfThreads, const std::vector<int>& cpus);
+
+  // Stops the threads, if they are running
+  ~NetworkThreads();
+
+  // Delete copy constructors
+  NetworkThreads(const NetworkThreads&) = delete;
+  NetworkThreads& operator=(const NetworkThreads&) = delete;
+
+  void start();
+
+  // Stops the io_service and waits for the threads to exit. Handlers that have not been run are
+  // never run, so after this the Connections can be deleted on the owner's thread.
+  void stop();
+
+  // start and stop are only called on the owner's thread, and so is this
+  bool isRunning() const { return !threads_.empty(); }
+
+  boost::asio::io_service* getService() { return &io_service_; }
+  const std::shared_ptr<Mailbox>& getOwnerMailbox() const { return ownerMailbox_; }
+
+ private:
+  boost::asio::io_service io_service_;
+  std::unique_ptr<boost::asio::io_service::work> work_;
+  std::shared_ptr<Mailbox> ownerMailbox_;
+
+  int numberOfThreads_;
+  std::vector<int> cpus_;
+  std::vector<std::thread> threads_;
+};
+
+#endif  // NETWORK_EXPORT_NETWORK_THREADS_H_
@@ -30,7 +30,12 @@ class Server
  public:
   virtual ~Server() = default;
 
-  // TODO(simon): start / stop?
+  // Stops accepting connections and returns the listening socket, which is still owned by this
+  // instance, so that it can be handed over to another process (see Handoff)
+  virtual int detach() = 0;
+
+  // Accepts connections again after detach, e.g. when the other process could not take over
+  virtual void reattach() = 0;
 };
 
 #endif  // NETWORK_EXPORT_SERVER_H_
@@ -28,8 +28,10 @@
 #include <functional>
 #include <memory>
 
+#include "connection.h"
+
+class NetworkThreads;
 class Server;
-class Connection;
 
 namespace boost
 {
@@ -39,13 +41,29 @@ class io_service;
 }
 }
 
+// If networkThreads is given, the Connections run on the network threads, while the Server,
+// onClientConnected and the Connections' callbacks run on io_service (see NetworkThreads).
+// Otherwise everything runs on io_service.
 class ServerFactory
 {
  public:
   using OnClientConnectedCallback = std::function<void(std::unique_ptr<Connection>&&)>;
   static std::unique_ptr<Server> createServer(boost::asio::io_service* io_service,
                                               int port,
-                                              const OnClientConnectedCallback& onClientConnected);
+                                              const OnClientConnectedCallback& onClientConnected,
+                                              NetworkThreads* networkThreads = nullptr);
+
+  // Same as createServer, but with a socket that is already listening, e.g. one that was handed
+  // over from another process (see Server::detach and Handoff)
+  static std::unique_ptr<Server> adoptServer(boost::asio::io_service* io_service,
+                                             int listeningSocket,
+                                             const OnClientConnectedCallback& onClientConnected,
+                                             NetworkThreads* networkThreads = nullptr);
+
+  // Resumes a Connection that was detached, e.g. in another process (see Connection::detach)
+  static std::unique_ptr<Connection> adoptConnection(boost::asio::io_service* io_service,
+                                                     Connection::Detached&& detached,
+                                                     NetworkThreads* networkThreads = nullptr);
 };
 
 #endif  // NETWORK_EXPORT_SERVER_FACTORY_H_
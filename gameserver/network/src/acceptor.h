@@ -35,11 +35,27 @@ template <typename Backend>
 class Acceptor
 {
  public:
+  // The accepted sockets belong to socketService if given, e.g. to run the connections on
+  // other threads than the acceptor (see NetworkThreads), otherwise to io_service
   Acceptor(typename Backend::Service* io_service,
            int port,
-           const std::function<void(typename Backend::Socket&&)>& onAccept)
+           const std::function<void(typename Backend::Socket&&)>& onAccept,
+           typename Backend::Service* socketService = nullptr)
     : acceptor_(*io_service, port),
-      socket_(*io_service),
+      socket_(socketService ? *socketService : *io_service),
+      onAccept_(onAccept)
+  {
+    accept();
+  }
+
+  // Accepts connections on a socket that is already listening, e.g. one that was handed over
+  // from another process
+  Acceptor(typename Backend::Service* io_service,
+           typename Backend::NativeHandle nativeHandle,
+           const std::function<void(typename Backend::Socket&&)>& onAccept,
+           typename Backend::Service* socketService = nullptr)
+    : acceptor_(*io_service, nativeHandle),
+      socket_(socketService ? *socketService : *io_service),
       onAccept_(onAccept)
   {
     accept();
@@ -54,6 +70,19 @@ class Acceptor
   Acceptor(const Acceptor&) = delete;
   Acceptor& operator=(const Acceptor&) = delete;
 
+  // Stops accepting connections, the socket is kept open, see Server::detach
+  int detach()
+  {
+    acceptor_.cancel();
+    return acceptor_.native_handle();
+  }
+
+  // Accepts connections again after detach
+  void reattach()
+  {
+    accept();
+  }
+
  private:
   void accept()
   {
@@ -27,6 +27,7 @@
 
 #include "connection.h"
 
+#include <algorithm>
 #include <deque>
 #include <memory>
 #include <vector>
@@ -73,6 +74,15 @@
  *      The onDisconnected callback is called as soon as there is no send and
  *      no receive call in progress.
  *
+ * Corked connections (see Connection::setCorked) queue the packets to send until flush()
+ * is called, and then send all queued packets with a single write. This is used when the
+ * packets of a game tick should be sent together.
+ *
+ * A connection can also be detached (see Connection::detach), which cancels the receive and
+ * send in progress and collects what was partially received and what was not sent. A
+ * connection created with that data (e.g. in another process) sends the unsent data first and
+ * parses the received data before anything that is read from the socket.
+ *
  * Connection handles its receive loop itself, which is started in its constructor:
  *   1. receivePacket()
  *   2. receivePacket lambda
@@ -86,10 +96,26 @@ class ConnectionImpl : public Connection
 {
  public:
   explicit ConnectionImpl(typename Backend::Socket&& socket)
+    : ConnectionImpl(std::move(socket), {}, {})
+  {
+  }
+
+  // Resumes a connection that was detached, see Connection::Detached
+  ConnectionImpl(typename Backend::Socket&& socket,
+                 std::vector<std::uint8_t>&& receivedData,
+                 std::vector<std::uint8_t>&& unsentData)
     : socket_(std::move(socket)),
       closing_(false),
       receiveInProgress_(false),
-      sendInProgress_(false)
+      sendInProgress_(false),
+      receivedData_(std::move(receivedData)),
+      corked_(false),
+      flushPending_(false),
+      outgoingBuffer_(std::move(unsentData)),
+      numberOfPacketsInBuffer_(0),
+      detaching_(false),
+      onDetached_(),
+      detached_()
   {
   }
 
@@ -112,6 +138,13 @@ class ConnectionImpl : public Connection
   void init(const Callbacks& callbacks) override
   {
     callbacks_ = callbacks;
+
+    // Data that was not sent before the connection was detached, see Connection::Detached
+    if (!outgoingBuffer_.empty())
+    {
+      sendOutgoingBuffer();
+    }
+
     receivePacket();
   }
 
@@ -133,7 +166,12 @@ class ConnectionImpl : public Connection
 
     // We can close the socket now if either we should force close,
     // or if there are no send in progress (i.e. no queued packets)
-    if (force || !sendInProgress_)
+    if (!force && !sendInProgress_ && !outgoingPackets_.empty())
+    {
+      // Corked, send the queued packets before closing the connection
+      sendCorkedPackets();
+    }
+    else if (force || !sendInProgress_)
     {
       closeSocket();  // Note that this instance might be deleted during this call
     }
@@ -153,12 +191,98 @@ class ConnectionImpl : public Connection
     outgoingPackets_.push_back(std::move(packet));
 
     // Start to send packet if this is the only packet in the queue
-    if (!sendInProgress_)
+    if (!sendInProgress_ && !corked_)
     {
       sendPacketInternal();
     }
   }
 
+  void setCorked(bool corked) override
+  {
+    corked_ = corked;
+    if (!corked_ && !sendInProgress_ && !outgoingPackets_.empty() && !closing_)
+    {
+      sendPacketInternal();
+    }
+  }
+
+  void flush() override
+  {
+    if (!corked_ || closing_ || outgoingPackets_.empty())
+    {
+      return;
+    }
+
+    if (sendInProgress_)
+    {
+      // Send the packets when the current write is done
+      flushPending_ = true;
+      return;
+    }
+
+    sendCorkedPackets();
+  }
+
+  bool detach(const std::function<void(Detached&&)>& onDetached) override
+  {
+    if (closing_)
+    {
+      LOG_ERROR("%s: called with closing_: true", __func__);
+      return false;
+    }
+
+    LOG_DEBUG("%s: receiveInProgress_: %s, sendInProgress_: %s",
+              __func__,
+              (receiveInProgress_ ? "true" : "false"),
+              (sendInProgress_    ? "true" : "false"));
+
+    closing_ = true;
+    detaching_ = true;
+    onDetached_ = onDetached;
+
+    // The handlers of the receive and send in progress collect what is left, see closeSocket
+    if (!sendInProgress_)
+    {
+      appendQueuedPackets(0);
+    }
+
+    typename Backend::ErrorCode error;
+    socket_.cancel(error);
+    if (error)
+    {
+      LOG_ERROR("%s: could not cancel socket operations: %s", __func__, error.message().c_str());
+    }
+
+    closeSocket();  // Note that this instance might be deleted during this call
+    return true;
+  }
+
+  void reattach(Detached&& detached) override
+  {
+    if (!detaching_ || receiveInProgress_ || sendInProgress_)
+    {
+      LOG_ERROR("%s: called with detaching_: %s, receiveInProgress_: %s, sendInProgress_: %s",
+                __func__,
+                (detaching_         ? "true" : "false"),
+                (receiveInProgress_ ? "true" : "false"),
+                (sendInProgress_    ? "true" : "false"));
+      return;
+    }
+
+    // The queued packets are in the unsent data, see appendQueuedPackets
+    closing_ = false;
+    detaching_ = false;
+    onDetached_ = nullptr;
+    detached_ = Detached{ -1, {}, {} };
+    receivedData_ = std::move(detached.receivedData);
+    outgoingPackets_.clear();
+    flushPending_ = false;
+    outgoingBuffer_ = std::move(detached.unsentData);
+    numberOfPacketsInBuffer_ = 0;
+
+    init(callbacks_);
+  }
+
  private:
   void sendPacketInternal()
   {
@@ -183,6 +307,21 @@ class ConnectionImpl : public Connection
                          2,
                          [this](const typename Backend::ErrorCode& errorCode, std::size_t len)
                          {
+                           if (detaching_)
+                           {
+                             // The rest of the header, the packet data and the rest of the queue
+                             const auto& packet = outgoingPackets_.front();
+                             detached_.unsentData.assign(outgoingHeaderBuffer_.data() + len,
+                                                         outgoingHeaderBuffer_.data() + 2);
+                             detached_.unsentData.insert(detached_.unsentData.end(),
+                                                         packet.getBuffer(),
+                                                         packet.getBuffer() + packet.getLength());
+                             appendQueuedPackets(1);
+                             sendInProgress_ = false;
+                             closeSocket();  // Note that this instance might be deleted during this call
+                             return;
+                           }
+
                            if (errorCode || len != 2u)
                            {
                              LOG_DEBUG("%s: errorCode: %s, len: %d (expected: 2)",
@@ -209,6 +348,18 @@ class ConnectionImpl : public Connection
                          packet.getLength(),
                          [this, packet_length](const typename Backend::ErrorCode& errorCode, std::size_t len)
                          {
+                           if (detaching_)
+                           {
+                             // The rest of the packet data and the rest of the queue
+                             const auto& packet = outgoingPackets_.front();
+                             detached_.unsentData.assign(packet.getBuffer() + len,
+                                                         packet.getBuffer() + packet.getLength());
+                             appendQueuedPackets(1);
+                             sendInProgress_ = false;
+                             closeSocket();  // Note that this instance might be deleted during this call
+                             return;
+                           }
+
                            if (errorCode || len != packet_length)
                            {
                              LOG_DEBUG("%s: errorCode: %s, len: %d (expected: %d)",
@@ -248,29 +399,114 @@ class ConnectionImpl : public Connection
     }
   }
 
+  void sendCorkedPackets()
+  {
+    flushPending_ = false;
+
+    // All queued packets, each with its header
+    outgoingBuffer_.clear();
+    for (const auto& packet : outgoingPackets_)
+    {
+      appendPacket(packet, &outgoingBuffer_);
+    }
+    numberOfPacketsInBuffer_ = outgoingPackets_.size();
+
+    LOG_DEBUG("%s: sending %u packets, length: %u", __func__, numberOfPacketsInBuffer_, outgoingBuffer_.size());
+
+    sendOutgoingBuffer();
+  }
+
+  // Writes outgoingBuffer_, which holds the first numberOfPacketsInBuffer_ queued packets
+  void sendOutgoingBuffer()
+  {
+    sendInProgress_ = true;
+
+    const auto buffer_length = outgoingBuffer_.size();
+    Backend::async_write(socket_,
+                         outgoingBuffer_.data(),
+                         buffer_length,
+                         [this, buffer_length](const typename Backend::ErrorCode& errorCode, std::size_t len)
+                         {
+                           if (detaching_)
+                           {
+                             // The rest of the buffer and the packets that were queued after it
+                             detached_.unsentData.assign(outgoingBuffer_.begin() + len, outgoingBuffer_.end());
+                             appendQueuedPackets(numberOfPacketsInBuffer_);
+                             sendInProgress_ = false;
+                             closeSocket();  // Note that this instance might be deleted during this call
+                             return;
+                           }
+
+                           if (errorCode || len != buffer_length)
+                           {
+                             LOG_DEBUG("%s: errorCode: %s, len: %d (expected: %d)",
+                                       __func__,
+                                       errorCode.message().c_str(),
+                                       len,
+                                       buffer_length);
+                             sendInProgress_ = false;
+                             closeSocket();  // Note that this instance might be deleted during this call
+                             return;
+                           }
+
+                           onCorkedPacketsSent();
+                         });
+  }
+
+  void onCorkedPacketsSent()
+  {
+    outgoingPackets_.erase(outgoingPackets_.begin(), outgoingPackets_.begin() + numberOfPacketsInBuffer_);
+    numberOfPacketsInBuffer_ = 0;
+
+    if (!outgoingPackets_.empty() && (flushPending_ || closing_))
+    {
+      // Packets that were flushed during the write
+      sendCorkedPackets();
+    }
+    else if (!outgoingPackets_.empty() && !corked_)
+    {
+      // Uncorked during the write
+      sendPacketInternal();
+    }
+    else
+    {
+      sendInProgress_ = false;
+
+      if (closing_)
+      {
+        closeSocket();  // Note that this instance might be deleted during this call
+      }
+    }
+  }
+
   void receivePacket()
   {
     receiveInProgress_ = true;
 
-    Backend::async_read(socket_,
-                        readBuffer_.data(),
-                        2,
-                        [this](const typename Backend::ErrorCode& errorCode, std::size_t len)
-                        {
-                          if (errorCode || len != 2u || closing_)
-                          {
-                            LOG_DEBUG("%s: errorCode: %s, len: %d (expected: 2), closing_: %s",
-                                      __func__,
-                                      errorCode.message().c_str(),
-                                      len,
-                                      (closing_ ? "true" : "false"));
-                            receiveInProgress_ = false;
-                            closeSocket();  // Note that this instance might be deleted during this call
-                            return;
-                          }
-
-                          onPacketHeaderReceived();
-                        });
+    asyncRead(readBuffer_.data(),
+              2,
+              [this](const typename Backend::ErrorCode& errorCode, std::size_t len)
+              {
+                if (detaching_)
+                {
+                  // Keep what was received of the header
+                  detached_.receivedData.assign(readBuffer_.data(), readBuffer_.data() + len);
+                }
+
+                if (errorCode || len != 2u || closing_)
+                {
+                  LOG_DEBUG("%s: errorCode: %s, len: %d (expected: 2), closing_: %s",
+                            __func__,
+                            errorCode.message().c_str(),
+                            len,
+                            (closing_ ? "true" : "false"));
+                  receiveInProgress_ = false;
+                  closeSocket();  // Note that this instance might be deleted during this call
+                  return;
+                }
+
+                onPacketHeaderReceived();
+              });
   }
 
   void onPacketHeaderReceived()
@@ -288,33 +524,71 @@ class ConnectionImpl : public Connection
       return;
     }
 
+    asyncRead(readBuffer_.data(),
+              packet_length,
+              [this, packet_length](const typename Backend::ErrorCode& errorCode, std::size_t len)
+              {
+                if (detaching_)
+                {
+                  // Keep the header and what was received of the packet data
+                  detached_.receivedData = { static_cast<std::uint8_t>(packet_length & 0xFF),
+                                             static_cast<std::uint8_t>((packet_length >> 8) & 0xFF) };
+                  detached_.receivedData.insert(detached_.receivedData.end(),
+                                                readBuffer_.data(),
+                                                readBuffer_.data() + len);
+                  receiveInProgress_ = false;
+                  closeSocket();  // Note that this instance might be deleted during this call
+                  return;
+                }
+
+                if (errorCode || static_cast<int>(len) != packet_length || closing_)
+                {
+                  LOG_DEBUG("%s: errorCode: %s, len: %d (expected: %d), closing_: %s",
+                            __func__,
+                            errorCode.message().c_str(),
+                            len,
+                            packet_length,
+                            (closing_ ? "true" : "false"));
+                  receiveInProgress_ = false;
+
+                  // Only close the socket on error or if closing_ is true and send not in
+                  // progress (i.e. close(force=false))
+                  if (errorCode ||
+                      static_cast<int>(len) != packet_length ||
+                      (closing_ && !sendInProgress_))
+                  {
+                    closeSocket();  // Note that this instance might be deleted during this call
+                  }
+                  return;
+                }
+
+                onPacketDataReceived(len);
+              });
+  }
+
+  // Same as Backend::async_read, but takes the data that was received before the connection was
+  // detached first, see Connection::Detached
+  void asyncRead(std::uint8_t* buffer,
+                 std::size_t length,
+                 const std::function<void(const typename Backend::ErrorCode&, std::size_t)>& handler)
+  {
+    if (receivedData_.empty())
+    {
+      Backend::async_read(socket_, buffer, length, handler);
+      return;
+    }
+
+    const auto copied = std::min(length, receivedData_.size());
+    std::copy(receivedData_.cbegin(), receivedData_.cbegin() + copied, buffer);
+    receivedData_.erase(receivedData_.cbegin(), receivedData_.cbegin() + copied);
+
+    // Also when nothing is left to read, so that the handler is not called in this context
     Backend::async_read(socket_,
-                        readBuffer_.data(),
-                        packet_length,
-                        [this, packet_length](const typename Backend::ErrorCode& errorCode, std::size_t len)
+                        buffer + copied,
+                        length - copied,
+                        [handler, copied](const typename Backend::ErrorCode& errorCode, std::size_t len)
                         {
-                          if (errorCode || static_cast<int>(len) != packet_length || closing_)
-                          {
-                            LOG_DEBUG("%s: errorCode: %s, len: %d (expected: %d), closing_: %s",
-                                      __func__,
-                                      errorCode.message().c_str(),
-                                      len,
-                                      packet_length,
-                                      (closing_ ? "true" : "false"));
-                            receiveInProgress_ = false;
-
-                            // Only close the socket on error or if closing_ is true and send not in
-                            // progress (i.e. close(force=false))
-                            if (errorCode ||
-                                static_cast<int>(len) != packet_length ||
-                                (closing_ && !sendInProgress_))
-                            {
-                              closeSocket();  // Note that this instance might be deleted during this call
-                            }
-                            return;
-                          }
-
-                          onPacketDataReceived(len);
+                          handler(errorCode, copied + len);
                         });
   }
 
@@ -345,10 +619,38 @@ class ConnectionImpl : public Connection
     receivePacket();
   }
 
+  static void appendPacket(const OutgoingPacket& packet, std::vector<std::uint8_t>* data)
+  {
+    const auto packet_length = packet.getLength();
+    data->push_back(packet_length & 0xFF);
+    data->push_back((packet_length >> 8) & 0xFF);
+    data->insert(data->end(), packet.getBuffer(), packet.getBuffer() + packet_length);
+  }
+
+  // Adds the queued packets, from the given index, to the data that is handed over when detached
+  void appendQueuedPackets(std::size_t first)
+  {
+    for (auto it = outgoingPackets_.cbegin() + first; it < outgoingPackets_.cend(); ++it)
+    {
+      appendPacket(*it, &detached_.unsentData);
+    }
+  }
+
   void closeSocket()
   {
     closing_ = true;
 
+    if (detaching_)
+    {
+      // The socket is kept open, it is handed over together with what was collected in detached_
+      if (!receiveInProgress_ && !sendInProgress_)
+      {
+        detached_.socket = socket_.native_handle();
+        onDetached_(std::move(detached_));  // Note that this instance might be deleted during this call
+      }
+      return;
+    }
+
     if (socket_.is_open())
     {
       typename Backend::ErrorCode error;
@@ -383,8 +685,22 @@ class ConnectionImpl : public Connection
   // I/O Buffers
   std::array<std::uint8_t, 8192> readBuffer_;
 
+  // Received before the connection was detached (see asyncRead), read before the socket
+  std::vector<std::uint8_t> receivedData_;
+
   std::array<std::uint8_t, 2> outgoingHeaderBuffer_;
   std::deque<OutgoingPacket> outgoingPackets_;
+
+  // See setCorked, the queued packets are written from outgoingBuffer_
+  bool corked_;
+  bool flushPending_;
+  std::vector<std::uint8_t> outgoingBuffer_;
+  std::size_t numberOfPacketsInBuffer_;
+
+  // See Connection::detach, detached_ collects what is handed over
+  bool detaching_;
+  std::function<void(Detached&&)> onDetached_;
+  Detached detached_;
 };
 
 #endif  // NETWORK_SRC_CONNECTION_IMPL_H_
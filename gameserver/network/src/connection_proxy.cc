@@ -0,0 +1,207 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "connection_proxy.h"
+
+#include <utility>
+#include <vector>
+
+#include "logger.h"
+#include "mailbox.h"
+#include "network_threads.h"
+
+ConnectionProxy::ConnectionProxy(std::unique_ptr<Connection>&& connection,
+                                 const std::shared_ptr<Mailbox>& networkMailbox,
+                                 const NetworkThreads* networkThreads)
+  : state_(std::make_shared<State>()),
+    networkMailbox_(networkMailbox),
+    ownerMailbox_(networkThreads->getOwnerMailbox()),
+    networkThreads_(networkThreads),
+    closing_(false)
+{
+  state_->connection = std::move(connection);
+  state_->deleted = false;
+}
+
+ConnectionProxy::~ConnectionProxy()
+{
+  // Tasks that are already posted to the owner's thread see this and drop their callbacks
+  state_->deleted = true;
+
+  if (!networkThreads_->isRunning())
+  {
+    state_->connection.reset();
+    return;
+  }
+
+  auto state = state_;
+  networkMailbox_->post([state]()
+  {
+    state->connection.reset();
+  });
+}
+
+void ConnectionProxy::init(const Callbacks& callbacks)
+{
+  state_->callbacks = callbacks;
+
+  // The wrapped Connection owns its callbacks, so they only keep a weak reference to the state
+  // (it is only called back while the state is alive)
+  std::weak_ptr<State> weakState = state_;
+  auto ownerMailbox = ownerMailbox_;
+  Callbacks networkCallbacks;
+  networkCallbacks.onPacketReceived = [weakState, ownerMailbox](IncomingPacket* packet)
+  {
+    auto data = packet->getBytes(packet->getLength());
+    ownerMailbox->post([state = weakState.lock(), data = std::move(data)]()
+    {
+      if (!state->deleted)
+      {
+        IncomingPacket packet(data.data(), data.size());
+        state->callbacks.onPacketReceived(&packet);
+      }
+    });
+  };
+  networkCallbacks.onDisconnected = [weakState, ownerMailbox]()
+  {
+    ownerMailbox->post([state = weakState.lock()]()
+    {
+      if (!state->deleted)
+      {
+        state->callbacks.onDisconnected();  // Note that this instance might be deleted during this call
+      }
+    });
+  };
+
+  auto state = state_;
+  networkMailbox_->post([state, networkCallbacks]()
+  {
+    state->connection->init(networkCallbacks);
+  });
+}
+
+void ConnectionProxy::close(bool force)
+{
+  if (closing_)
+  {
+    LOG_ERROR("%s: called with closing_: true", __func__);
+    return;
+  }
+  closing_ = true;
+
+  auto state = state_;
+  networkMailbox_->post([state, force]()
+  {
+    state->connection->close(force);
+  });
+}
+
+void ConnectionProxy::sendPacket(OutgoingPacket&& packet)
+{
+  if (closing_)
+  {
+    LOG_DEBUG("%s: cannot send packet, closing_: true", __func__);
+    return;
+  }
+
+  auto state = state_;
+  networkMailbox_->post([state, packet = std::move(packet)]() mutable
+  {
+    state->connection->sendPacket(std::move(packet));
+  });
+}
+
+void ConnectionProxy::setCorked(bool corked)
+{
+  auto state = state_;
+  networkMailbox_->post([state, corked]()
+  {
+    state->connection->setCorked(corked);
+  });
+}
+
+void ConnectionProxy::flush()
+{
+  if (closing_)
+  {
+    return;
+  }
+
+  auto state = state_;
+  networkMailbox_->post([state]()
+  {
+    state->connection->flush();
+  });
+}
+
+bool ConnectionProxy::detach(const std::function<void(Detached&&)>& onDetached)
+{
+  if (closing_)
+  {
+    LOG_ERROR("%s: called with closing_: true", __func__);
+    return false;
+  }
+  closing_ = true;
+
+  auto state = state_;
+  auto ownerMailbox = ownerMailbox_;
+  networkMailbox_->post([state, ownerMailbox, onDetached]()
+  {
+    std::weak_ptr<State> weakState = state;
+    const auto detaching = state->connection->detach([weakState, ownerMailbox, onDetached](Detached&& detached)
+    {
+      ownerMailbox->post([state = weakState.lock(), onDetached, detached = std::move(detached)]() mutable
+      {
+        if (!state->deleted)
+        {
+          onDetached(std::move(detached));
+        }
+      });
+    });
+
+    if (!detaching)
+    {
+      // Already closed, see class comment
+      ownerMailbox->post([state, onDetached]()
+      {
+        if (!state->deleted)
+        {
+          onDetached(Detached{ -1, {}, {} });
+        }
+      });
+    }
+  });
+  return true;
+}
+
+void ConnectionProxy::reattach(Detached&& detached)
+{
+  closing_ = false;
+
+  auto state = state_;
+  networkMailbox_->post([state, detached = std::move(detached)]() mutable
+  {
+    state->connection->reattach(std::move(detached));
+  });
+}
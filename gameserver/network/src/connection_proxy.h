@@ -0,0 +1,92 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NETWORK_SRC_CONNECTION_PROXY_H_
+#define NETWORK_SRC_CONNECTION_PROXY_H_
+
+#include "connection.h"
+
+#include <functional>
+#include <memory>
+
+class Mailbox;
+class NetworkThreads;
+
+/**
+ * class ConnectionProxy
+ *
+ * A Connection that is used on the owner's thread, while the Connection it wraps runs on the
+ * network threads (see NetworkThreads).
+ *
+ * All calls are posted, in order, to the wrapped Connection's strand (networkMailbox), and its
+ * callbacks are posted back to the owner's thread (the owner Mailbox of NetworkThreads). Received
+ * packets are copied, as the wrapped Connection reuses its buffer. No callback is called after
+ * this instance has been deleted.
+ *
+ * Since the wrapped Connection may close (e.g. on a socket error) while a call to it is on its
+ * way, detach may return true even though the Connection is already closed. onDetached is then
+ * called with socket -1, after onDisconnected.
+ *
+ * When this instance is deleted the wrapped Connection is deleted on its strand, or directly if
+ * the network threads are stopped. Like any Connection it should not have any receive or send
+ * in progress then, i.e. it should be deleted after onDisconnected or onDetached, or after the
+ * network threads are stopped.
+ */
+class ConnectionProxy : public Connection
+{
+ public:
+  ConnectionProxy(std::unique_ptr<Connection>&& connection,
+                  const std::shared_ptr<Mailbox>& networkMailbox,
+                  const NetworkThreads* networkThreads);
+  ~ConnectionProxy() override;
+
+  // Delete copy constructors
+  ConnectionProxy(const ConnectionProxy&) = delete;
+  ConnectionProxy& operator=(const ConnectionProxy&) = delete;
+
+  void init(const Callbacks& callbacks) override;
+  void close(bool force) override;
+  void sendPacket(OutgoingPacket&& packet) override;
+  void setCorked(bool corked) override;
+  void flush() override;
+  bool detach(const std::function<void(Detached&&)>& onDetached) override;
+  void reattach(Detached&& detached) override;
+
+ private:
+  // Shared with the tasks in both directions, so that it lives until the last task has been run
+  struct State
+  {
+    std::unique_ptr<Connection> connection;  // Only used on the network side
+    Callbacks callbacks;                     // Only used on the owner side
+    bool deleted;                            // Only used on the owner side
+  };
+
+  std::shared_ptr<State> state_;
+  std::shared_ptr<Mailbox> networkMailbox_;
+  std::shared_ptr<Mailbox> ownerMailbox_;
+  const NetworkThreads* networkThreads_;
+  bool closing_;
+};
+
+#endif  // NETWORK_SRC_CONNECTION_PROXY_H_
@@ -0,0 +1,363 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "handoff.h"
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include "logger.h"
+
+constexpr int Handoff::max_sockets_per_message;
+
+namespace
+{
+
+// Message format:
+//   u32 magic, u32 number of sockets, u32 length of data (native byte order, same host)
+//   for each batch of at most max_sockets_per_message sockets: one byte with the sockets attached
+//   the data
+constexpr std::uint32_t handoff_magic = 0x46464F48;  // "HOFF"
+
+// See sendAck
+constexpr std::uint32_t ack_magic = 0x4B4F4648;  // "HFOK"
+
+struct Header
+{
+  std::uint32_t magic;
+  std::uint32_t numberOfSockets;
+  std::uint32_t dataLength;
+};
+
+bool setBlocking(int socket)
+{
+  const auto flags = fcntl(socket, F_GETFL);
+  return flags != -1 && fcntl(socket, F_SETFL, flags & ~O_NONBLOCK) != -1;
+}
+
+bool getAddress(const std::string& path, sockaddr_un* address)
+{
+  if (path.size() >= sizeof(address->sun_path))
+  {
+    LOG_ERROR("%s: path is too long: %s", __func__, path.c_str());
+    return false;
+  }
+
+  std::memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  std::memcpy(address->sun_path, path.c_str(), path.size());
+  return true;
+}
+
+bool writeAll(int socket, const std::uint8_t* data, std::size_t length)
+{
+  while (length > 0)
+  {
+    const auto written = ::send(socket, data, length, MSG_NOSIGNAL);
+    if (written == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (written <= 0)
+    {
+      return false;
+    }
+    data += written;
+    length -= written;
+  }
+  return true;
+}
+
+bool readAll(int socket, std::uint8_t* data, std::size_t length)
+{
+  while (length > 0)
+  {
+    const auto read = ::recv(socket, data, length, 0);
+    if (read == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (read <= 0)
+    {
+      return false;
+    }
+    data += read;
+    length -= read;
+  }
+  return true;
+}
+
+bool sendSockets(int socket, const int* sockets, int numberOfSockets)
+{
+  std::uint8_t byte = 0;
+  iovec iov = { &byte, 1 };
+
+  std::vector<std::uint8_t> control(CMSG_SPACE(sizeof(int) * numberOfSockets));
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+
+  auto* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * numberOfSockets);
+  std::memcpy(CMSG_DATA(cmsg), sockets, sizeof(int) * numberOfSockets);
+
+  while (true)
+  {
+    const auto sent = sendmsg(socket, &message, MSG_NOSIGNAL);
+    if (sent == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    return sent == 1;
+  }
+}
+
+bool receiveSockets(int socket, int numberOfSockets, std::vector<int>* sockets)
+{
+  std::uint8_t byte = 0;
+  iovec iov = { &byte, 1 };
+
+  std::vector<std::uint8_t> control(CMSG_SPACE(sizeof(int) * numberOfSockets));
+  msghdr message;
+  std::memset(&message, 0, sizeof(message));
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+
+  ssize_t received;
+  do
+  {
+    received = recvmsg(socket, &message, MSG_CMSG_CLOEXEC);
+  }
+  while (received == -1 && errno == EINTR);
+
+  if (received != 1 || (message.msg_flags & MSG_CTRUNC) != 0)
+  {
+    return false;
+  }
+
+  auto* cmsg = CMSG_FIRSTHDR(&message);
+  if (cmsg == nullptr ||
+      cmsg->cmsg_level != SOL_SOCKET ||
+      cmsg->cmsg_type != SCM_RIGHTS ||
+      cmsg->cmsg_len != CMSG_LEN(sizeof(int) * numberOfSockets))
+  {
+    return false;
+  }
+
+  const auto offset = sockets->size();
+  sockets->resize(offset + numberOfSockets);
+  std::memcpy(sockets->data() + offset, CMSG_DATA(cmsg), sizeof(int) * numberOfSockets);
+  return true;
+}
+
+}  // namespace
+
+int Handoff::listen(const std::string& path)
+{
+  sockaddr_un address;
+  if (!getAddress(path, &address))
+  {
+    return -1;
+  }
+
+  const auto handoffSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (handoffSocket == -1)
+  {
+    LOG_ERROR("%s: could not create socket: %s", __func__, std::strerror(errno));
+    return -1;
+  }
+
+  unlink(path.c_str());
+  if (bind(handoffSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 ||
+      ::listen(handoffSocket, 1) == -1)
+  {
+    LOG_ERROR("%s: could not listen on: %s: %s", __func__, path.c_str(), std::strerror(errno));
+    close(handoffSocket);
+    return -1;
+  }
+
+  return handoffSocket;
+}
+
+int Handoff::connect(const std::string& path)
+{
+  sockaddr_un address;
+  if (!getAddress(path, &address))
+  {
+    return -1;
+  }
+
+  const auto handoffSocket = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (handoffSocket == -1)
+  {
+    LOG_ERROR("%s: could not create socket: %s", __func__, std::strerror(errno));
+    return -1;
+  }
+
+  if (::connect(handoffSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1)
+  {
+    LOG_DEBUG("%s: no process is listening on: %s: %s", __func__, path.c_str(), std::strerror(errno));
+    close(handoffSocket);
+    return -1;
+  }
+
+  return handoffSocket;
+}
+
+bool Handoff::send(int socket, const std::vector<int>& sockets, const std::vector<std::uint8_t>& data)
+{
+  if (!setBlocking(socket))
+  {
+    LOG_ERROR("%s: could not set blocking mode: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  Header header;
+  header.magic = handoff_magic;
+  header.numberOfSockets = sockets.size();
+  header.dataLength = data.size();
+  if (!writeAll(socket, reinterpret_cast<const std::uint8_t*>(&header), sizeof(header)))
+  {
+    LOG_ERROR("%s: could not send header: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  for (std::size_t i = 0; i < sockets.size(); i += max_sockets_per_message)
+  {
+    const auto numberOfSockets = std::min<std::size_t>(max_sockets_per_message, sockets.size() - i);
+    if (!sendSockets(socket, sockets.data() + i, numberOfSockets))
+    {
+      LOG_ERROR("%s: could not send sockets: %s", __func__, std::strerror(errno));
+      return false;
+    }
+  }
+
+  if (!writeAll(socket, data.data(), data.size()))
+  {
+    LOG_ERROR("%s: could not send data: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+bool Handoff::receive(int socket, std::vector<int>* sockets, std::vector<std::uint8_t>* data)
+{
+  if (!setBlocking(socket))
+  {
+    LOG_ERROR("%s: could not set blocking mode: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  Header header;
+  if (!readAll(socket, reinterpret_cast<std::uint8_t*>(&header), sizeof(header)) || header.magic != handoff_magic)
+  {
+    LOG_ERROR("%s: could not receive header", __func__);
+    return false;
+  }
+
+  sockets->clear();
+  while (sockets->size() < header.numberOfSockets)
+  {
+    const auto numberOfSockets = std::min<std::size_t>(max_sockets_per_message,
+                                                       header.numberOfSockets - sockets->size());
+    if (!receiveSockets(socket, numberOfSockets, sockets))
+    {
+      LOG_ERROR("%s: could not receive sockets", __func__);
+      for (const auto receivedSocket : *sockets)
+      {
+        close(receivedSocket);
+      }
+      sockets->clear();
+      return false;
+    }
+  }
+
+  data->resize(header.dataLength);
+  if (!readAll(socket, data->data(), data->size()))
+  {
+    LOG_ERROR("%s: could not receive data", __func__);
+    for (const auto receivedSocket : *sockets)
+    {
+      close(receivedSocket);
+    }
+    sockets->clear();
+    return false;
+  }
+
+  return true;
+}
+
+bool Handoff::sendAck(int socket)
+{
+  if (!setBlocking(socket))
+  {
+    LOG_ERROR("%s: could not set blocking mode: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  const auto ack = ack_magic;
+  if (!writeAll(socket, reinterpret_cast<const std::uint8_t*>(&ack), sizeof(ack)))
+  {
+    LOG_ERROR("%s: could not send ack: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  return true;
+}
+
+bool Handoff::receiveAck(int socket, int timeoutMs)
+{
+  timeval timeout;
+  timeout.tv_sec = timeoutMs / 1000;
+  timeout.tv_usec = (timeoutMs % 1000) * 1000;
+  if (!setBlocking(socket) || setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) == -1)
+  {
+    LOG_ERROR("%s: could not set blocking mode: %s", __func__, std::strerror(errno));
+    return false;
+  }
+
+  std::uint32_t ack = 0;
+  if (!readAll(socket, reinterpret_cast<std::uint8_t*>(&ack), sizeof(ack)) || ack != ack_magic)
+  {
+    LOG_ERROR("%s: no ack within %d ms", __func__, timeoutMs);
+    return false;
+  }
+
+  return true;
+}
@@ -22,22 +22,40 @@
  * SOFTWARE.
  */
 
-#ifndef WORLD_TEST_SRC_ITEM_MOCK_H_
-#define WORLD_TEST_SRC_ITEM_MOCK_H_
+#include "mailbox.h"
 
-#include "item.h"
-#include "gmock/gmock.h"
+#include <utility>
 
-class ItemMock : public Item
+Mailbox::Mailbox(const Executor& executor)
+  : executor_(executor),
+    tasks_(),
+    scheduled_(false)
 {
- public:
-  MOCK_CONST_METHOD0(getItemUniqueId, ItemUniqueId());
-  MOCK_CONST_METHOD0(getItemTypeId, ItemTypeId());
+}
 
-  MOCK_CONST_METHOD0(getItemType, const ItemType&());
+void Mailbox::post(Task&& task)
+{
+  tasks_.push(std::move(task));
+
+  // If run() has already cleared scheduled_ it sees the task, otherwise it is scheduled again
+  if (!scheduled_.exchange(true, std::memory_order_acq_rel))
+  {
+    auto self = shared_from_this();
+    executor_([self]()
+    {
+      self->run();
+    });
+  }
+}
 
-  MOCK_CONST_METHOD0(getCount, int());
-  MOCK_METHOD1(setCount, void(int count));
-};
+void Mailbox::run()
+{
+  scheduled_.exchange(false, std::memory_order_acq_rel);
 
-#endif  // WORLD_TEST_SRC_ITEM_MOCK_H_
+  Task task;
+  while (tasks_.pop(&task))
+  {
+    task();
+    task = nullptr;
+  }
+}
@@ -0,0 +1,64 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef NETWORK_SRC_MAILBOX_H_
+#define NETWORK_SRC_MAILBOX_H_
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+#include "mpsc_queue.h"
+#include "unique_function.h"
+
+// Tasks that are run by an executor (e.g. a strand or the thread of an io_service), in the order
+// they were posted. Tasks can be posted from any thread, and are passed to the executor's thread
+// over a lock-free queue (see MpscQueue). The executor is only called when the first task is posted
+// to an idle mailbox, and then runs all tasks that have been posted until the mailbox is empty.
+// The executor must not run its functions concurrently, so that there is a single consumer.
+class Mailbox : public std::enable_shared_from_this<Mailbox>
+{
+ public:
+  using Task = UniqueFunction<void(void)>;
+  using Executor = std::function<void(const std::function<void(void)>&)>;
+
+  explicit Mailbox(const Executor& executor);
+
+  // Delete copy constructors
+  Mailbox(const Mailbox&) = delete;
+  Mailbox& operator=(const Mailbox&) = delete;
+
+  void post(Task&& task);
+
+ private:
+  void run();
+
+  Executor executor_;
+  MpscQueue<Task> tasks_;
+
+  // True from when the executor is called until it has started to run the tasks
+  std::atomic<bool> scheduled_;
+};
+
+#endif  // NETWORK_SRC_MAILBOX_H_
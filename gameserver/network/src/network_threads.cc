@@ -0,0 +1,90 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "network_threads.h"
+
+#include "logger.h"
+#include "mailbox.h"
+#include "thread_affinity.h"
+
+NetworkThreads::NetworkThreads(boost::asio::io_service* ownerService,
+                               int numberOfThreads,
+                               const std::vector<int>& cpus)
+  : io_service_(),
+    work_(),
+    ownerMailbox_(std::make_shared<Mailbox>([ownerService](const std::function<void(void)>& task)
+                                            {
+                                              ownerService->post(task);
+                                            })),
+    numberOfThreads_(numberOfThreads),
+    cpus_(cpus),
+    threads_()
+{
+}
+
+NetworkThreads::~NetworkThreads()
+{
+  stop();
+}
+
+void NetworkThreads::start()
+{
+  if (isRunning())
+  {
+    LOG_ERROR("%s: already running", __func__);
+    return;
+  }
+
+  // Keep the threads running also when there is no connection
+  work_ = std::make_unique<boost::asio::io_service::work>(io_service_);
+  for (auto i = 0; i < numberOfThreads_; i++)
+  {
+    threads_.emplace_back([this, i]()
+    {
+      if (!ThreadAffinity::pinCurrentThread(cpus_))
+      {
+        LOG_ERROR("NetworkThreads: could not pin network thread %d", i);
+      }
+      io_service_.run();
+    });
+  }
+
+  LOG_INFO("%s: started %d network threads", __func__, numberOfThreads_);
+}
+
+void NetworkThreads::stop()
+{
+  if (!isRunning())
+  {
+    return;
+  }
+
+  work_.reset();
+  io_service_.stop();
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+  threads_.clear();
+}
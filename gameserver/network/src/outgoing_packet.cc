@@ -25,15 +25,20 @@
 #include "outgoing_packet.h"
 
 #include <algorithm>
+#include <mutex>
 
 #include "logger.h"
 
 // Initialize static packet pool
 std::stack<std::unique_ptr<std::array<std::uint8_t, 8192>>> OutgoingPacket::buffer_pool_;
 
+// Packets may be created on one thread and sent (and deleted) on another, see NetworkThreads
+static std::mutex buffer_pool_mutex;
+
 OutgoingPacket::OutgoingPacket()
   : position_(0)
 {
+  std::lock_guard<std::mutex> lock(buffer_pool_mutex);
   if (buffer_pool_.empty())
   {
     buffer_ = std::make_unique<std::array<std::uint8_t, 8192>>();
@@ -52,6 +57,7 @@ OutgoingPacket::~OutgoingPacket()
 {
   if (buffer_)
   {
+    std::lock_guard<std::mutex> lock(buffer_pool_mutex);
     buffer_pool_.push(std::move(buffer_));
     LOG_DEBUG("Returned buffer to pool, buffers now in pool: %lu",
               buffer_pool_.size());
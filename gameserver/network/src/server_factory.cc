@@ -24,14 +24,26 @@
 
 #include "server_factory.h"
 
+#include <utility>
+#include <vector>
+
 #include <boost/asio.hpp>  //NOLINT
 
+#include "connection_proxy.h"
+#include "mailbox.h"
+#include "network_threads.h"
 #include "server_impl.h"
 
 struct Backend
 {
   using Service = boost::asio::io_service;
 
+  // A socket that is already open, see ServerFactory::adoptServer
+  struct NativeHandle
+  {
+    int handle;
+  };
+
   class Acceptor : public boost::asio::ip::tcp::acceptor
   {
    public:
@@ -39,9 +51,28 @@ struct Backend
       : boost::asio::ip::tcp::acceptor(io_service, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port))
     {
     }
+
+    Acceptor(Service& io_service, NativeHandle nativeHandle)  //NOLINT
+      : boost::asio::ip::tcp::acceptor(io_service, boost::asio::ip::tcp::v4(), nativeHandle.handle)
+    {
+    }
+  };
+
+  // The handlers of a socket with a strand are run on that strand, see createConnectionProxy
+  class Socket : public boost::asio::ip::tcp::socket
+  {
+   public:
+    explicit Socket(Service& io_service)  //NOLINT
+      : boost::asio::ip::tcp::socket(io_service),
+        strand()
+    {
+    }
+
+    Socket(Socket&&) = default;
+
+    std::shared_ptr<Service::strand> strand;
   };
 
-  using Socket = boost::asio::ip::tcp::socket;
   using ErrorCode = boost::system::error_code;
   using Error = boost::asio::error::basic_errors;
   using shutdown_type = boost::asio::ip::tcp::socket::shutdown_type;
@@ -51,7 +82,14 @@ struct Backend
                           std::size_t length,
                           const std::function<void(const Backend::ErrorCode&, std::size_t)>& handler)
   {
-    boost::asio::async_write(socket, boost::asio::buffer(buffer, length), handler);
+    if (socket.strand)
+    {
+      boost::asio::async_write(socket, boost::asio::buffer(buffer, length), socket.strand->wrap(handler));
+    }
+    else
+    {
+      boost::asio::async_write(socket, boost::asio::buffer(buffer, length), handler);
+    }
   }
 
   static void async_read(Socket& socket,  //NOLINT
@@ -59,13 +97,89 @@ struct Backend
                          std::size_t length,
                          const std::function<void(const Backend::ErrorCode&, std::size_t)>& handler)
   {
-    boost::asio::async_read(socket, boost::asio::buffer(buffer, length), handler);
+    if (socket.strand)
+    {
+      boost::asio::async_read(socket, boost::asio::buffer(buffer, length), socket.strand->wrap(handler));
+    }
+    else
+    {
+      boost::asio::async_read(socket, boost::asio::buffer(buffer, length), handler);
+    }
   }
 };
 
+// Runs the Connection on its own strand of the network threads, see NetworkThreads
+static std::unique_ptr<Connection> createConnectionProxy(NetworkThreads* networkThreads,
+                                                         Backend::Socket&& socket,
+                                                         std::vector<std::uint8_t>&& receivedData,
+                                                         std::vector<std::uint8_t>&& unsentData)
+{
+  auto strand = std::make_shared<Backend::Service::strand>(*networkThreads->getService());
+  socket.strand = strand;
+  auto connection = std::make_unique<ConnectionImpl<Backend>>(std::move(socket),
+                                                              std::move(receivedData),
+                                                              std::move(unsentData));
+  auto networkMailbox = std::make_shared<Mailbox>([strand](const std::function<void(void)>& task)
+  {
+    strand->post(task);
+  });
+  return std::make_unique<ConnectionProxy>(std::move(connection), networkMailbox, networkThreads);
+}
+
+static ServerImpl<Backend>::CreateConnection getCreateConnection(NetworkThreads* networkThreads)
+{
+  return [networkThreads](Backend::Socket&& socket)
+  {
+    return createConnectionProxy(networkThreads, std::move(socket), {}, {});
+  };
+}
+
 std::unique_ptr<Server> ServerFactory::createServer(boost::asio::io_service* io_service,
                                                     int port,
-                                                    const OnClientConnectedCallback& onClientConnected)
+                                                    const OnClientConnectedCallback& onClientConnected,
+                                                    NetworkThreads* networkThreads)
 {
+  if (networkThreads)
+  {
+    return std::make_unique<ServerImpl<Backend>>(io_service,
+                                                 port,
+                                                 onClientConnected,
+                                                 networkThreads->getService(),
+                                                 getCreateConnection(networkThreads));
+  }
   return std::make_unique<ServerImpl<Backend>>(io_service, port, onClientConnected);
 }
+
+std::unique_ptr<Server> ServerFactory::adoptServer(boost::asio::io_service* io_service,
+                                                   int listeningSocket,
+                                                   const OnClientConnectedCallback& onClientConnected,
+                                                   NetworkThreads* networkThreads)
+{
+  if (networkThreads)
+  {
+    return std::make_unique<ServerImpl<Backend>>(io_service,
+                                                 Backend::NativeHandle{ listeningSocket },
+                                                 onClientConnected,
+                                                 networkThreads->getService(),
+                                                 getCreateConnection(networkThreads));
+  }
+  return std::make_unique<ServerImpl<Backend>>(io_service, Backend::NativeHandle{ listeningSocket }, onClientConnected);
+}
+
+std::unique_ptr<Connection> ServerFactory::adoptConnection(boost::asio::io_service* io_service,
+                                                           Connection::Detached&& detached,
+                                                           NetworkThreads* networkThreads)
+{
+  Backend::Socket socket(networkThreads ? *networkThreads->getService() : *io_service);
+  socket.assign(boost::asio::ip::tcp::v4(), detached.socket);
+  if (networkThreads)
+  {
+    return createConnectionProxy(networkThreads,
+                                 std::move(socket),
+                                 std::move(detached.receivedData),
+                                 std::move(detached.unsentData));
+  }
+  return std::make_unique<ConnectionImpl<Backend>>(std::move(socket),
+                                                   std::move(detached.receivedData),
+                                                   std::move(detached.unsentData));
+}
@@ -27,6 +27,7 @@
 
 #include "server.h"
 
+#include <functional>
 #include <memory>
 #include <unordered_map>
 #include <utility>
@@ -39,16 +40,39 @@ template <typename Backend>
 class ServerImpl : public Server
 {
  public:
+  // Creates the Connection for an accepted socket, see NetworkThreads
+  using CreateConnection = std::function<std::unique_ptr<Connection>(typename Backend::Socket&&)>;
+
+  // The accepted sockets belong to socketService, if given, see Acceptor
   ServerImpl(typename Backend::Service* io_service,
              int port,
-             const std::function<void(std::unique_ptr<Connection>&&)>& onClientConnected)
+             const std::function<void(std::unique_ptr<Connection>&&)>& onClientConnected,
+             typename Backend::Service* socketService = nullptr,
+             const CreateConnection& createConnection = &createConnectionImpl)
     : acceptor_(io_service,
                 port,
-                [onClientConnected](typename Backend::Socket&& socket)
+                [onClientConnected, createConnection](typename Backend::Socket&& socket)
                 {
                   LOG_DEBUG("onAccept()");
-                  onClientConnected(std::make_unique<ConnectionImpl<Backend>>(std::move(socket)));
-                })
+                  onClientConnected(createConnection(std::move(socket)));
+                },
+                socketService)
+  {
+  }
+
+  ServerImpl(typename Backend::Service* io_service,
+             typename Backend::NativeHandle listeningSocket,
+             const std::function<void(std::unique_ptr<Connection>&&)>& onClientConnected,
+             typename Backend::Service* socketService = nullptr,
+             const CreateConnection& createConnection = &createConnectionImpl)
+    : acceptor_(io_service,
+                listeningSocket,
+                [onClientConnected, createConnection](typename Backend::Socket&& socket)
+                {
+                  LOG_DEBUG("onAccept()");
+                  onClientConnected(createConnection(std::move(socket)));
+                },
+                socketService)
   {
   }
 
@@ -56,7 +80,22 @@ class ServerImpl : public Server
   ServerImpl(const ServerImpl&) = delete;
   ServerImpl& operator=(const ServerImpl&) = delete;
 
+  int detach() override
+  {
+    return acceptor_.detach();
+  }
+
+  void reattach() override
+  {
+    acceptor_.reattach();
+  }
+
  private:
+  static std::unique_ptr<Connection> createConnectionImpl(typename Backend::Socket&& socket)
+  {
+    return std::make_unique<ConnectionImpl<Backend>>(std::move(socket));
+  }
+
   Acceptor<Backend> acceptor_;
 };
 
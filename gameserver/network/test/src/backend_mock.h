@@ -49,16 +49,24 @@ struct Backend
 
   struct Socket;
 
+  struct NativeHandle
+  {
+    int handle;
+  };
+
   struct Service
   {
     // Calls from Acceptor
     MOCK_METHOD0(acceptor_cancel, void());
+    MOCK_METHOD0(acceptor_native_handle, int());
     MOCK_METHOD2(acceptor_async_accept, void(Socket&, const std::function<void(const ErrorCode&)>&));
 
     // Calls from Socket
     MOCK_CONST_METHOD0(socket_is_open, bool());
     MOCK_METHOD2(socket_shutdown, void(shutdown_type, ErrorCode&));
     MOCK_METHOD1(socket_close, void(ErrorCode&));
+    MOCK_METHOD1(socket_cancel, void(ErrorCode&));
+    MOCK_METHOD0(socket_native_handle, int());
 
     // Calls from static functions
     MOCK_METHOD4(async_write, void(Socket&,
@@ -82,6 +90,8 @@ struct Backend
     bool is_open() const { return service_.socket_is_open(); }
     void shutdown(shutdown_type st, ErrorCode& ec) { service_.socket_shutdown(st, ec); }
     void close(ErrorCode& ec) { service_.socket_close(ec); }
+    void cancel(ErrorCode& ec) { service_.socket_cancel(ec); }
+    int native_handle() { return service_.socket_native_handle(); }
 
     Service& service_;
   };
@@ -94,7 +104,14 @@ struct Backend
     {
     }
 
+    Acceptor(Service& service, NativeHandle)
+      : service_(service),
+        port_(0)
+    {
+    }
+
     void cancel() { service_.acceptor_cancel(); }
+    int native_handle() { return service_.acceptor_native_handle(); }
     void async_accept(Socket& s, const std::function<void(const ErrorCode&)>& cb)
     {
       service_.acceptor_async_accept(s, cb);
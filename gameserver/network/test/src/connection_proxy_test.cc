@@ -0,0 +1,226 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "connection_proxy.h"
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "mailbox.h"
+#include "network_threads.h"
+
+namespace
+{
+
+// Records the calls, so that we can check on which side (and in which order) they are made
+class ConnectionFake : public Connection
+{
+ public:
+  explicit ConnectionFake(std::vector<std::string>* calls)
+    : calls_(calls)
+  {
+  }
+
+  void init(const Callbacks& callbacks) override
+  {
+    calls_->push_back("init");
+    callbacks_ = callbacks;
+  }
+
+  void close(bool force) override { calls_->push_back(force ? "close force" : "close"); }
+  void sendPacket(OutgoingPacket&& packet) override { calls_->push_back("send " + std::to_string(packet.getLength())); }
+  void setCorked(bool corked) override { calls_->push_back(corked ? "cork" : "uncork"); }
+  void flush() override { calls_->push_back("flush"); }
+
+  bool detach(const std::function<void(Detached&&)>& onDetached) override
+  {
+    calls_->push_back("detach");
+    if (!detachable)
+    {
+      return false;
+    }
+    onDetached(Detached{ 5, { 0x01 }, { 0x02, 0x03 } });
+    return true;
+  }
+
+  void reattach(Detached&& detached) override
+  {
+    calls_->push_back("reattach " + std::to_string(detached.socket));
+  }
+
+  Callbacks callbacks_;
+  bool detachable = true;
+
+ private:
+  std::vector<std::string>* calls_;
+};
+
+}  // namespace
+
+class ConnectionProxyTest : public ::testing::Test
+{
+ public:
+  ConnectionProxyTest()
+    : ownerService_(),
+      networkThreads_(&ownerService_, 1, {}),
+      calls_(),
+      connectionFake_(nullptr),
+      proxy_()
+  {
+    // The network threads are not started, the test runs both sides by polling
+    auto connection = std::make_unique<ConnectionFake>(&calls_);
+    connectionFake_ = connection.get();
+    auto* networkService = networkThreads_.getService();
+    auto networkMailbox = std::make_shared<Mailbox>([networkService](const std::function<void(void)>& task)
+    {
+      networkService->post(task);
+    });
+    proxy_ = std::make_unique<ConnectionProxy>(std::move(connection), networkMailbox, &networkThreads_);
+  }
+
+ protected:
+  void pollNetwork()
+  {
+    networkThreads_.getService()->poll();
+    networkThreads_.getService()->reset();
+  }
+
+  void pollOwner()
+  {
+    ownerService_.poll();
+    ownerService_.reset();
+  }
+
+  boost::asio::io_service ownerService_;
+  NetworkThreads networkThreads_;
+  std::vector<std::string> calls_;
+  ConnectionFake* connectionFake_;
+  std::unique_ptr<ConnectionProxy> proxy_;
+};
+
+TEST_F(ConnectionProxyTest, Calls)
+{
+  proxy_->init({ [](IncomingPacket*) {}, []() {} });
+  proxy_->setCorked(true);
+  OutgoingPacket packet;
+  packet.addU16(0x1234);
+  proxy_->sendPacket(std::move(packet));
+  proxy_->flush();
+  proxy_->close(false);
+
+  // Nothing is called until the network side runs, and then in order
+  ASSERT_TRUE(calls_.empty());
+  pollNetwork();
+  ASSERT_EQ(std::vector<std::string>({ "init", "cork", "send 2", "flush", "close" }), calls_);
+
+  // No more packets after close
+  proxy_->sendPacket(OutgoingPacket());
+  pollNetwork();
+  ASSERT_EQ(5u, calls_.size());
+}
+
+TEST_F(ConnectionProxyTest, Callbacks)
+{
+  std::vector<std::vector<std::uint8_t>> packets;
+  auto disconnected = false;
+  proxy_->init({ [&packets](IncomingPacket* packet)
+                 {
+                   packets.push_back(packet->getBytes(packet->getLength()));
+                 },
+                 [&disconnected]()
+                 {
+                   disconnected = true;
+                 } });
+  pollNetwork();
+
+  // The packet is copied, as the Connection reuses its buffer
+  std::vector<std::uint8_t> buffer = { 0x01, 0x02, 0x03 };
+  IncomingPacket packet(buffer.data(), buffer.size());
+  connectionFake_->callbacks_.onPacketReceived(&packet);
+  buffer = { 0x04, 0x05, 0x06 };
+  connectionFake_->callbacks_.onDisconnected();
+
+  // Nothing is called until the owner side runs
+  ASSERT_TRUE(packets.empty());
+  ASSERT_FALSE(disconnected);
+  pollOwner();
+  ASSERT_EQ(1u, packets.size());
+  ASSERT_EQ(std::vector<std::uint8_t>({ 0x01, 0x02, 0x03 }), packets[0]);
+  ASSERT_TRUE(disconnected);
+
+  // No callbacks after the proxy is deleted
+  IncomingPacket lastPacket(buffer.data(), buffer.size());
+  connectionFake_->callbacks_.onPacketReceived(&lastPacket);
+  proxy_.reset();
+  pollOwner();
+  ASSERT_EQ(1u, packets.size());
+}
+
+TEST_F(ConnectionProxyTest, Detach)
+{
+  proxy_->init({ [](IncomingPacket*) {}, []() {} });
+
+  std::vector<Connection::Detached> detached;
+  ASSERT_TRUE(proxy_->detach([&detached](Connection::Detached&& value)
+  {
+    detached.push_back(std::move(value));
+  }));
+  ASSERT_FALSE(proxy_->detach([](Connection::Detached&&) {}));
+
+  pollNetwork();
+  ASSERT_TRUE(detached.empty());
+  pollOwner();
+  ASSERT_EQ(1u, detached.size());
+  EXPECT_EQ(5, detached[0].socket);
+  EXPECT_EQ(std::vector<std::uint8_t>({ 0x01 }), detached[0].receivedData);
+  EXPECT_EQ(std::vector<std::uint8_t>({ 0x02, 0x03 }), detached[0].unsentData);
+
+  // Reattached on the network side, and then used as before
+  proxy_->reattach(std::move(detached[0]));
+  proxy_->sendPacket(OutgoingPacket());
+  pollNetwork();
+  ASSERT_EQ(std::vector<std::string>({ "init", "detach", "reattach 5", "send 0" }), calls_);
+}
+
+TEST_F(ConnectionProxyTest, DetachClosed)
+{
+  proxy_->init({ [](IncomingPacket*) {}, []() {} });
+
+  // The Connection was closed while the call to detach was on its way
+  connectionFake_->detachable = false;
+  std::vector<Connection::Detached> detached;
+  ASSERT_TRUE(proxy_->detach([&detached](Connection::Detached&& value)
+  {
+    detached.push_back(std::move(value));
+  }));
+
+  pollNetwork();
+  pollOwner();
+  ASSERT_EQ(1u, detached.size());
+  EXPECT_EQ(-1, detached[0].socket);
+}
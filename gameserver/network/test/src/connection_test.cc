@@ -230,6 +230,68 @@ TEST_F(ConnectionTest, SendPacket)
   connection_.reset();
 }
 
+TEST_F(ConnectionTest, SendPacketCorked)
+{
+  const std::uint8_t* buffer = nullptr;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> writeHandler;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> readHandler;
+
+  // Create and initialize connection
+  connection_ = std::make_unique<ConnectionImpl<Backend>>(Backend::Socket(service_));
+  EXPECT_CALL(service_, async_read(_, _, _, _)).WillOnce(SaveArg<3>(&readHandler));
+  connection_->init(callbacks_);
+  connection_->setCorked(true);
+
+  // Nothing is sent until flush
+  EXPECT_CALL(service_, async_write(_, _, _, _)).Times(0);
+  OutgoingPacket outgoingPacketOne;
+  outgoingPacketOne.addU8(0x12);
+  connection_->sendPacket(std::move(outgoingPacketOne));
+  OutgoingPacket outgoingPacketTwo;
+  outgoingPacketTwo.addU16(0x3456);
+  connection_->sendPacket(std::move(outgoingPacketTwo));
+  ::testing::Mock::VerifyAndClearExpectations(&service_);
+
+  // Both packets are sent with their headers in one write
+  EXPECT_CALL(service_, async_write(_, _, 7, _)).WillOnce(DoAll(SaveArg<1>(&buffer), SaveArg<3>(&writeHandler)));
+  connection_->flush();
+  ASSERT_NE(nullptr, buffer);
+  EXPECT_EQ(0x01, buffer[0]);
+  EXPECT_EQ(0x00, buffer[1]);
+  EXPECT_EQ(0x12, buffer[2]);
+  EXPECT_EQ(0x02, buffer[3]);
+  EXPECT_EQ(0x00, buffer[4]);
+  EXPECT_EQ(0x56, buffer[5]);
+  EXPECT_EQ(0x34, buffer[6]);
+
+  // A packet flushed during the write is sent when the write is done
+  OutgoingPacket outgoingPacketThree;
+  outgoingPacketThree.addU8(0x78);
+  connection_->sendPacket(std::move(outgoingPacketThree));
+  connection_->flush();
+  EXPECT_CALL(service_, async_write(_, _, 3, _)).WillOnce(DoAll(SaveArg<1>(&buffer), SaveArg<3>(&writeHandler)));
+  writeHandler(Backend::Error::no_error, 7);
+  EXPECT_EQ(0x78, buffer[2]);
+  writeHandler(Backend::Error::no_error, 3);
+
+  // A graceful close sends the queued packets first
+  OutgoingPacket outgoingPacketFour;
+  outgoingPacketFour.addU8(0x9A);
+  connection_->sendPacket(std::move(outgoingPacketFour));
+  EXPECT_CALL(service_, async_write(_, _, 3, _)).WillOnce(SaveArg<3>(&writeHandler));
+  connection_->close(false);
+
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(true));
+  EXPECT_CALL(service_, socket_shutdown(Backend::shutdown_both, _));
+  EXPECT_CALL(service_, socket_close(_));
+  writeHandler(Backend::Error::no_error, 3);
+
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(false));
+  EXPECT_CALL(callbacksMock_, onDisconnected());
+  readHandler(Backend::operation_aborted, 0);
+  connection_.reset();
+}
+
 TEST_F(ConnectionTest, DisconnectInHeaderReadCall)
 {
   std::function<void(const Backend::ErrorCode&, std::size_t)> readHandler;
@@ -365,6 +427,188 @@ TEST_F(ConnectionTest, ReadsPacketLengthZero)
   connection_.reset();
 }
 
+TEST_F(ConnectionTest, Detach)
+{
+  std::uint8_t* readBuffer = nullptr;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> readHandler;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> writeHandler;
+
+  // Create and initialize connection
+  connection_ = std::make_unique<ConnectionImpl<Backend>>(Backend::Socket(service_));
+  EXPECT_CALL(service_, async_read(_, _, 2, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  connection_->init(callbacks_);
+
+  // Receive a header, the packet data (4 bytes) is being read
+  readBuffer[0] = 0x04;
+  readBuffer[1] = 0x00;
+  EXPECT_CALL(service_, async_read(_, _, 4, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  readHandler(Backend::no_error, 2);
+
+  // Send two packets, the header of the first is being written
+  OutgoingPacket outgoingPacketOne;
+  outgoingPacketOne.addU8(0x12);
+  EXPECT_CALL(service_, async_write(_, _, 2, _)).WillOnce(SaveArg<3>(&writeHandler));
+  connection_->sendPacket(std::move(outgoingPacketOne));
+  OutgoingPacket outgoingPacketTwo;
+  outgoingPacketTwo.addU16(0x3456);
+  connection_->sendPacket(std::move(outgoingPacketTwo));
+
+  // Detach cancels the read and the write, but doesn't close the socket
+  Connection::Detached detached;
+  auto numberOfDetachedCalls = 0;
+  EXPECT_CALL(service_, socket_cancel(_));
+  EXPECT_CALL(service_, socket_shutdown(_, _)).Times(0);
+  EXPECT_CALL(service_, socket_close(_)).Times(0);
+  ASSERT_TRUE(connection_->detach([&detached, &numberOfDetachedCalls](Connection::Detached&& result)
+  {
+    detached = std::move(result);
+    numberOfDetachedCalls++;
+  }));
+
+  // Nothing can be sent while detaching
+  OutgoingPacket outgoingPacketThree;
+  outgoingPacketThree.addU8(0x78);
+  connection_->sendPacket(std::move(outgoingPacketThree));
+
+  // One byte of the packet data was read before the read was cancelled
+  readBuffer[0] = 0xAB;
+  readHandler(Backend::operation_aborted, 1);
+  EXPECT_EQ(0, numberOfDetachedCalls);
+
+  // One byte of the header was written before the write was cancelled
+  EXPECT_CALL(service_, socket_native_handle()).WillOnce(Return(42));
+  writeHandler(Backend::operation_aborted, 1);
+  ASSERT_EQ(1, numberOfDetachedCalls);
+
+  EXPECT_EQ(42, detached.socket);
+  EXPECT_EQ(std::vector<std::uint8_t>({ 0x04, 0x00, 0xAB }), detached.receivedData);
+  EXPECT_EQ(std::vector<std::uint8_t>({ 0x00, 0x12, 0x02, 0x00, 0x56, 0x34 }), detached.unsentData);
+
+  // A closing connection can't be detached
+  ASSERT_FALSE(connection_->detach([](Connection::Detached&&) {}));
+  connection_.reset();
+}
+
+TEST_F(ConnectionTest, Reattach)
+{
+  std::uint8_t* readBuffer = nullptr;
+  const std::uint8_t* writeBuffer = nullptr;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> readHandler;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> writeHandler;
+
+  // Create and initialize connection
+  connection_ = std::make_unique<ConnectionImpl<Backend>>(Backend::Socket(service_));
+  EXPECT_CALL(service_, async_read(_, _, 2, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  connection_->init(callbacks_);
+
+  // Send a packet, and detach while it is being written and a header is being read
+  OutgoingPacket outgoingPacket;
+  outgoingPacket.addU8(0x12);
+  EXPECT_CALL(service_, async_write(_, _, 2, _)).WillOnce(SaveArg<3>(&writeHandler));
+  connection_->sendPacket(std::move(outgoingPacket));
+
+  Connection::Detached detached;
+  EXPECT_CALL(service_, socket_cancel(_));
+  ASSERT_TRUE(connection_->detach([&detached](Connection::Detached&& result)
+  {
+    detached = std::move(result);
+  }));
+  readBuffer[0] = 0x01;
+  readHandler(Backend::operation_aborted, 1);
+  EXPECT_CALL(service_, socket_native_handle()).WillOnce(Return(42));
+  writeHandler(Backend::operation_aborted, 0);
+  ASSERT_EQ(42, detached.socket);
+
+  // The socket is not closed, and the connection continues where it was detached
+  EXPECT_CALL(service_, socket_close(_)).Times(0);
+  EXPECT_CALL(service_, async_write(_, _, 3, _)).WillOnce(DoAll(SaveArg<1>(&writeBuffer),
+                                                                SaveArg<3>(&writeHandler)));
+  EXPECT_CALL(service_, async_read(_, _, 1, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  connection_->reattach(std::move(detached));
+  ASSERT_NE(nullptr, writeBuffer);
+  EXPECT_EQ(0x01, writeBuffer[0]);
+  EXPECT_EQ(0x00, writeBuffer[1]);
+  EXPECT_EQ(0x12, writeBuffer[2]);
+
+  // The rest of the header is read from the socket, and the packet is received as usual
+  readBuffer[0] = 0x00;
+  EXPECT_CALL(service_, async_read(_, _, 1, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  readHandler(Backend::no_error, 1);
+  readBuffer[0] = 0x34;
+  const std::uint8_t expectedPacketData[] = { 0x34 };
+  IncomingPacket expectedPacket { expectedPacketData, 1u };
+  EXPECT_CALL(callbacksMock_, onPacketReceived(Pointee(expectedPacket)));
+  EXPECT_CALL(service_, async_read(_, _, 2, _)).WillOnce(SaveArg<3>(&readHandler));
+  readHandler(Backend::no_error, 1);
+  writeHandler(Backend::no_error, 3);
+
+  // Close the connection
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(true));
+  EXPECT_CALL(service_, socket_shutdown(Backend::shutdown_both, _));
+  EXPECT_CALL(service_, socket_close(_));
+  connection_->close(false);
+
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(false));
+  EXPECT_CALL(callbacksMock_, onDisconnected());
+  readHandler(Backend::operation_aborted, 0);
+  connection_.reset();
+}
+
+TEST_F(ConnectionTest, ResumeDetached)
+{
+  std::uint8_t* readBuffer = nullptr;
+  const std::uint8_t* writeBuffer = nullptr;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> readHandler;
+  std::function<void(const Backend::ErrorCode&, std::size_t)> writeHandler;
+
+  // The header and one byte of the packet data was received, and the end of a packet was not sent
+  connection_ = std::make_unique<ConnectionImpl<Backend>>(Backend::Socket(service_),
+                                                          std::vector<std::uint8_t>({ 0x04, 0x00, 0x12 }),
+                                                          std::vector<std::uint8_t>({ 0x56, 0x78 }));
+
+  // The unsent data is written first, and the header is already received
+  EXPECT_CALL(service_, async_write(_, _, 2, _)).WillOnce(DoAll(SaveArg<1>(&writeBuffer),
+                                                                SaveArg<3>(&writeHandler)));
+  EXPECT_CALL(service_, async_read(_, _, 0, _)).WillOnce(SaveArg<3>(&readHandler));
+  connection_->init(callbacks_);
+  ASSERT_NE(nullptr, writeBuffer);
+  EXPECT_EQ(0x56, writeBuffer[0]);
+  EXPECT_EQ(0x78, writeBuffer[1]);
+
+  // The rest of the packet data is read from the socket
+  EXPECT_CALL(service_, async_read(_, _, 3, _)).WillOnce(DoAll(SaveArg<1>(&readBuffer), SaveArg<3>(&readHandler)));
+  readHandler(Backend::no_error, 0);
+  readBuffer[0] = 0x34;
+  readBuffer[1] = 0x56;
+  readBuffer[2] = 0x78;
+  const std::uint8_t expectedPacketData[] = { 0x12, 0x34, 0x56, 0x78 };
+  IncomingPacket expectedPacket { expectedPacketData, 4u };
+  EXPECT_CALL(callbacksMock_, onPacketReceived(Pointee(expectedPacket)));
+  EXPECT_CALL(service_, async_read(_, _, 2, _)).WillOnce(SaveArg<3>(&readHandler));
+  readHandler(Backend::no_error, 3);
+
+  // Packets are sent as usual after the unsent data
+  OutgoingPacket outgoingPacket;
+  outgoingPacket.addU8(0x9A);
+  connection_->sendPacket(std::move(outgoingPacket));
+  EXPECT_CALL(service_, async_write(_, _, 2, _)).WillOnce(SaveArg<3>(&writeHandler));
+  writeHandler(Backend::no_error, 2);
+  EXPECT_CALL(service_, async_write(_, _, 1, _)).WillOnce(SaveArg<3>(&writeHandler));
+  writeHandler(Backend::no_error, 2);
+  writeHandler(Backend::no_error, 1);
+
+  // Close the connection
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(true));
+  EXPECT_CALL(service_, socket_shutdown(Backend::shutdown_both, _));
+  EXPECT_CALL(service_, socket_close(_));
+  connection_->close(false);
+
+  EXPECT_CALL(service_, socket_is_open()).WillOnce(Return(false));
+  EXPECT_CALL(callbacksMock_, onDisconnected());
+  readHandler(Backend::operation_aborted, 0);
+  connection_.reset();
+}
+
 // TODO(simon): tests to do:
 //
 // close(true) in receivePacket
@@ -0,0 +1,116 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "handoff.h"
+
+TEST(HandoffTest, SendReceive)
+{
+  const auto path = std::string("/tmp/handoff_test_") + std::to_string(getpid()) + ".sock";
+
+  // Nobody is listening yet
+  ASSERT_EQ(-1, Handoff::connect(path));
+
+  const auto listeningSocket = Handoff::listen(path);
+  ASSERT_NE(-1, listeningSocket);
+  const auto receivingSocket = Handoff::connect(path);
+  ASSERT_NE(-1, receivingSocket);
+  const auto sendingSocket = accept(listeningSocket, nullptr, nullptr);
+  ASSERT_NE(-1, sendingSocket);
+
+  // More sockets than fit in one message
+  std::vector<int> readEnds;
+  std::vector<int> writeEnds;
+  for (auto i = 0; i < Handoff::max_sockets_per_message + 6; i++)
+  {
+    int fds[2];
+    ASSERT_EQ(0, pipe(fds));
+    readEnds.push_back(fds[0]);
+    writeEnds.push_back(fds[1]);
+  }
+  const std::vector<std::uint8_t> data = { 0x01, 0x02, 0x03, 0x04, 0x05 };
+
+  ASSERT_TRUE(Handoff::send(sendingSocket, writeEnds, data));
+
+  std::vector<int> receivedSockets;
+  std::vector<std::uint8_t> receivedData;
+  ASSERT_TRUE(Handoff::receive(receivingSocket, &receivedSockets, &receivedData));
+  EXPECT_EQ(data, receivedData);
+  ASSERT_EQ(writeEnds.size(), receivedSockets.size());
+
+  // The received sockets are the same, in the same order
+  for (auto i = 0u; i < receivedSockets.size(); i++)
+  {
+    const auto value = static_cast<std::uint8_t>(i);
+    ASSERT_EQ(1, write(receivedSockets[i], &value, 1));
+    std::uint8_t readValue = 0;
+    ASSERT_EQ(1, read(readEnds[i], &readValue, 1));
+    EXPECT_EQ(value, readValue);
+  }
+
+  for (const auto fd : readEnds)
+  {
+    close(fd);
+  }
+  for (const auto fd : writeEnds)
+  {
+    close(fd);
+  }
+  for (const auto fd : receivedSockets)
+  {
+    close(fd);
+  }
+  close(sendingSocket);
+  close(receivingSocket);
+  close(listeningSocket);
+  std::remove(path.c_str());
+}
+
+TEST(HandoffTest, Ack)
+{
+  int sockets[2];
+  ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+
+  // Acks in both directions
+  ASSERT_TRUE(Handoff::sendAck(sockets[0]));
+  ASSERT_TRUE(Handoff::receiveAck(sockets[1], 1000));
+  ASSERT_TRUE(Handoff::sendAck(sockets[1]));
+  ASSERT_TRUE(Handoff::receiveAck(sockets[0], 1000));
+
+  // No ack in time
+  ASSERT_FALSE(Handoff::receiveAck(sockets[0], 10));
+
+  // The other process has closed the socket without an ack
+  close(sockets[1]);
+  ASSERT_FALSE(Handoff::receiveAck(sockets[0], 1000));
+  close(sockets[0]);
+}
@@ -32,6 +32,7 @@
 
 using ::testing::_;
 using ::testing::SaveArg;
+using ::testing::Return;
 
 class ServerTest : public ::testing::Test
 {
@@ -80,3 +81,35 @@ TEST_F(ServerTest, AcceptConnection)
   EXPECT_CALL(service_, acceptor_cancel());
   server_.reset();
 }
+
+TEST_F(ServerTest, AdoptAndDetach)
+{
+  std::function<void(const Backend::ErrorCode&)> onAcceptHandler;
+
+  // Create Server with a socket that is already listening, should call async_accept
+  EXPECT_CALL(service_, acceptor_async_accept(_, _)).WillOnce(SaveArg<1>(&onAcceptHandler));
+  server_ = std::make_unique<ServerImpl<Backend>>(&service_,
+                                                  Backend::NativeHandle{ 42 },
+                                                  [this](std::unique_ptr<Connection>&& connection)
+  {
+    callbackMock_.onClientConnected(std::move(connection));
+  });
+
+  // Detach Server, should stop accepting and return the listening socket
+  EXPECT_CALL(service_, acceptor_cancel());
+  EXPECT_CALL(service_, acceptor_native_handle()).WillOnce(Return(42));
+  EXPECT_EQ(42, server_->detach());
+
+  // Aborted accept should not call onClientConnected or async_accept
+  onAcceptHandler(Backend::Error::operation_aborted);
+
+  // Reattach Server, should accept again
+  EXPECT_CALL(service_, acceptor_async_accept(_, _)).WillOnce(SaveArg<1>(&onAcceptHandler));
+  server_->reattach();
+  EXPECT_CALL(callbackMock_, onClientConnected(_));
+  EXPECT_CALL(service_, acceptor_async_accept(_, _)).WillOnce(SaveArg<1>(&onAcceptHandler));
+  onAcceptHandler(Backend::Error::no_error);
+
+  EXPECT_CALL(service_, acceptor_cancel());
+  server_.reset();
+}
@@ -0,0 +1,192 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares XmlDocument with the previous way of loading world.xml, items.xml and accounts.xml
+// (std::getline into a std::ostringstream, copied with strdup, attributes parsed with std::stoi)
+// on a generated world.xml with 512x512 tiles:
+//  * load: read and parse the file and parse all attributes
+//  * peak RSS: the highest resident set size of the process that loaded the file, each loader is
+//    run in its own child process so that they don't affect each other
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+
+#include "rapidxml.hpp"
+#include "xml_document.h"
+
+namespace
+{
+
+const std::string filename = "xml_document_benchmark.xml";
+constexpr int world_size = 512;
+
+bool writeWorldFile()
+{
+  auto* file = fopen(filename.c_str(), "w");
+  if (file == nullptr)
+  {
+    return false;
+  }
+
+  fprintf(file, "<?xml version=\"1.0\"?>\n<map>\n<floor z=\"7\">\n");
+  for (auto x = 0; x < world_size; x++)
+  {
+    for (auto y = 0; y < world_size; y++)
+    {
+      fprintf(file, "<tile x=\"%d\" y=\"%d\"><item id=\"%d\"/>", 192 + x, 192 + y, 100 + ((x * y) % 50));
+      if ((x + y) % 4 == 0)
+      {
+        fprintf(file, "<item id=\"%d\"/>", 1000 + (x % 200));
+      }
+      fprintf(file, "</tile>\n");
+    }
+  }
+  fprintf(file, "</floor>\n</map>\n");
+  return fclose(file) == 0;
+}
+
+// Sums all attributes, so that the parsing can't be optimized away
+long long sumAttributes(const XmlDocument::Node* mapNode, const std::function<int(const char*)>& parse)
+{
+  auto sum = 0LL;
+  for (const auto* floorNode = mapNode->first_node(); floorNode != nullptr; floorNode = floorNode->next_sibling())
+  {
+    for (const auto* tileNode = floorNode->first_node(); tileNode != nullptr; tileNode = tileNode->next_sibling())
+    {
+      sum += parse(tileNode->first_attribute("x")->value()) + parse(tileNode->first_attribute("y")->value());
+      for (const auto* itemNode = tileNode->first_node(); itemNode != nullptr; itemNode = itemNode->next_sibling())
+      {
+        sum += parse(itemNode->first_attribute("id")->value());
+      }
+    }
+  }
+  return sum;
+}
+
+long long loadLegacy()
+{
+  std::ifstream xmlFile(filename);
+  std::string tempString;
+  std::ostringstream xmlStringStream;
+  while (std::getline(xmlFile, tempString))
+  {
+    xmlStringStream << tempString << "\n";
+  }
+  char* xmlString = strdup(xmlStringStream.str().c_str());
+
+  rapidxml::xml_document<> worldXml;
+  worldXml.parse<rapidxml::parse_no_data_nodes>(xmlString);
+  const auto sum = sumAttributes(worldXml.first_node(), [](const char* value)
+  {
+    return std::stoi(value);
+  });
+
+  free(xmlString);
+  return sum;
+}
+
+long long loadXmlDocument()
+{
+  XmlDocument worldXml;
+  if (!worldXml.loadFile(filename))
+  {
+    return 0;
+  }
+  return sumAttributes(worldXml.getFirstNode(), [](const char* value)
+  {
+    int result = 0;
+    XmlDocument::parseInteger(value, &result);
+    return result;
+  });
+}
+
+// Runs load in a child process and prints how long it took and the peak RSS of the child
+void run(const char* name, long long (*load)())
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+  {
+    return;
+  }
+
+  const auto pid = fork();
+  if (pid == 0)
+  {
+    const auto start = std::chrono::steady_clock::now();
+    const auto sum = load ? load() : 0;
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double ms = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0;
+    const auto ok = write(fds[1], &ms, sizeof(ms)) == sizeof(ms) && sum >= 0;
+    _exit(ok ? 0 : 1);
+  }
+
+  close(fds[1]);
+  double ms = 0.0;
+  const auto ok = read(fds[0], &ms, sizeof(ms)) == sizeof(ms);
+  close(fds[0]);
+
+  int status;
+  struct rusage usage;
+  if (!ok || wait4(pid, &status, 0, &usage) != pid || status != 0)
+  {
+    printf("%-12s failed\n", name);
+    return;
+  }
+
+  printf("%-12s load: %8.1f ms  peak RSS: %7.1f MB\n", name, ms, usage.ru_maxrss / 1024.0);
+}
+
+}  // namespace
+
+int main()
+{
+  if (!writeWorldFile())
+  {
+    printf("Could not write %s\n", filename.c_str());
+    return 1;
+  }
+
+  std::ifstream file(filename, std::ifstream::ate);
+  printf("%s: %.1f MB\n", filename.c_str(), file.tellg() / (1024.0 * 1024.0));
+
+  // Peak RSS of a child that doesn't load anything, to compare with
+  run("baseline", nullptr);
+  run("legacy", loadLegacy);
+  run("XmlDocument", loadXmlDocument);
+
+  std::remove(filename.c_str());
+  return 0;
+}
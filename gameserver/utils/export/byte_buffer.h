@@ -0,0 +1,156 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_BYTE_BUFFER_H_
+#define UTILS_EXPORT_BYTE_BUFFER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Little endian serialization of integers, strings and byte arrays, e.g. for snapshots of
+// the game state that are handed over to another process (see GameEngine::saveSnapshot)
+class ByteWriter
+{
+ public:
+  explicit ByteWriter(std::vector<std::uint8_t>* data)
+    : data_(data)
+  {
+  }
+
+  void addU8(std::uint8_t value)
+  {
+    data_->push_back(value);
+  }
+
+  void addU16(std::uint16_t value)
+  {
+    addU8(value & 0xFF);
+    addU8((value >> 8) & 0xFF);
+  }
+
+  void addU32(std::uint32_t value)
+  {
+    addU16(value & 0xFFFF);
+    addU16((value >> 16) & 0xFFFF);
+  }
+
+  void addString(const std::string& string)
+  {
+    addU32(string.size());
+    data_->insert(data_->end(), string.cbegin(), string.cend());
+  }
+
+  void addBytes(const std::vector<std::uint8_t>& bytes)
+  {
+    addU32(bytes.size());
+    data_->insert(data_->end(), bytes.cbegin(), bytes.cend());
+  }
+
+ private:
+  std::vector<std::uint8_t>* data_;
+};
+
+// Reads what ByteWriter wrote. Reading past the end returns zero (or empty) values and makes
+// the reader fail, so a sequence of reads only needs to be checked once (see failed).
+class ByteReader
+{
+ public:
+  ByteReader(const std::uint8_t* data, std::size_t length)
+    : data_(data),
+      length_(length),
+      position_(0),
+      failed_(false)
+  {
+  }
+
+  bool failed() const { return failed_; }
+  bool isEmpty() const { return position_ >= length_; }
+
+  std::uint8_t getU8()
+  {
+    if (!canRead(1))
+    {
+      return 0;
+    }
+    return data_[position_++];
+  }
+
+  std::uint16_t getU16()
+  {
+    const std::uint16_t low = getU8();
+    const std::uint16_t high = getU8();
+    return low | (high << 8);
+  }
+
+  std::uint32_t getU32()
+  {
+    const std::uint32_t low = getU16();
+    const std::uint32_t high = getU16();
+    return low | (high << 16);
+  }
+
+  std::string getString()
+  {
+    const auto length = getU32();
+    if (!canRead(length))
+    {
+      return std::string();
+    }
+    std::string string(reinterpret_cast<const char*>(data_ + position_), length);
+    position_ += length;
+    return string;
+  }
+
+  std::vector<std::uint8_t> getBytes()
+  {
+    const auto length = getU32();
+    if (!canRead(length))
+    {
+      return std::vector<std::uint8_t>();
+    }
+    std::vector<std::uint8_t> bytes(data_ + position_, data_ + position_ + length);
+    position_ += length;
+    return bytes;
+  }
+
+ private:
+  bool canRead(std::size_t length)
+  {
+    if (failed_ || length > length_ - position_)
+    {
+      failed_ = true;
+      return false;
+    }
+    return true;
+  }
+
+  const std::uint8_t* data_;
+  std::size_t length_;
+  std::size_t position_;
+  bool failed_;
+};
+
+#endif  // UTILS_EXPORT_BYTE_BUFFER_H_
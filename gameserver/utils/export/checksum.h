@@ -0,0 +1,50 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_CHECKSUM_H_
+#define UTILS_EXPORT_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit FNV-1a, used to detect that a generated file is out of date compared to its sources
+// Not a cryptographic hash, only use it to detect changes
+class Checksum
+{
+ public:
+  static constexpr std::uint64_t initial_value = 0xcbf29ce484222325ULL;
+
+  // Continue a checksum by passing the previous result as value
+  static std::uint64_t fnv1a(const std::uint8_t* data, std::size_t size, std::uint64_t value = initial_value)
+  {
+    for (std::size_t i = 0; i < size; i++)
+    {
+      value ^= data[i];
+      value *= 0x100000001b3ULL;
+    }
+    return value;
+  }
+};
+
+#endif  // UTILS_EXPORT_CHECKSUM_H_
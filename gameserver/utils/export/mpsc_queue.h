@@ -0,0 +1,109 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_MPSC_QUEUE_H_
+#define UTILS_EXPORT_MPSC_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free queue with any number of producers and a single consumer, e.g. to pass
+// work from the network threads to the game engine thread (see Mailbox)
+//
+// push may be called from any thread, pop only from one thread at a time. Each value is stored
+// in its own node, linked from the oldest (tail_) to the newest (head_), with a stub node first
+// so that the queue is never really empty. A push that is in progress is not seen by pop until
+// it has linked its node, so pop may return false even though a push has started.
+//
+// T needs to be default constructible (the stub node) and move assignable.
+template<typename T>
+class MpscQueue
+{
+ public:
+  MpscQueue()
+    : head_(new Node()),
+      tail_(head_.load(std::memory_order_relaxed))
+  {
+  }
+
+  ~MpscQueue()
+  {
+    while (auto* next = tail_->next.load(std::memory_order_acquire))
+    {
+      delete tail_;
+      tail_ = next;
+    }
+    delete tail_;
+  }
+
+  // Delete copy constructors
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void push(T&& value)
+  {
+    auto* node = new Node();
+    node->value = std::move(value);
+
+    // The node is the newest from here, but it is only reachable from the previous node
+    // after it has been linked
+    auto* previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  // Returns false if there is nothing to pop
+  bool pop(T* value)
+  {
+    auto* next = tail_->next.load(std::memory_order_acquire);
+    if (!next)
+    {
+      return false;
+    }
+
+    // next becomes the new stub node
+    *value = std::move(next->value);
+    next->value = T();
+    delete tail_;
+    tail_ = next;
+    return true;
+  }
+
+ private:
+  struct Node
+  {
+    Node()
+      : next(nullptr),
+        value()
+    {
+    }
+
+    std::atomic<Node*> next;
+    T value;
+  };
+
+  std::atomic<Node*> head_;  // Producers
+  Node* tail_;               // Consumer, the stub node
+};
+
+#endif  // UTILS_EXPORT_MPSC_QUEUE_H_
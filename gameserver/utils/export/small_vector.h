@@ -0,0 +1,231 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_SMALL_VECTOR_H_
+#define UTILS_EXPORT_SMALL_VECTOR_H_
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
+#include <type_traits>
+
+// A vector that stores up to N elements inline, without any heap allocation, and
+// falls back to a heap allocated array when it grows larger than that.
+//
+// Only supports trivially copyable types (e.g. pointers and ids), so that elements can
+// be moved around with memcpy / memmove.
+template<typename T, std::size_t N>
+class SmallVector
+{
+  static_assert(std::is_trivially_copyable<T>::value, "SmallVector only supports trivially copyable types");
+  static_assert(N > 0, "SmallVector must have room for at least one element inline");
+
+ public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using iterator = T*;
+  using const_iterator = const T*;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  SmallVector()
+    : size_(0),
+      capacity_(N)
+  {
+  }
+
+  SmallVector(std::initializer_list<T> values)
+    : SmallVector()
+  {
+    for (const auto& value : values)
+    {
+      push_back(value);
+    }
+  }
+
+  SmallVector(const SmallVector& other)
+    : SmallVector()
+  {
+    reserve(other.size_);
+    std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+    size_ = other.size_;
+  }
+
+  SmallVector& operator=(const SmallVector& other)
+  {
+    if (this != &other)
+    {
+      clear();
+      reserve(other.size_);
+      std::memcpy(data(), other.data(), other.size_ * sizeof(T));
+      size_ = other.size_;
+    }
+    return *this;
+  }
+
+  SmallVector(SmallVector&& other) noexcept
+    : size_(other.size_),
+      capacity_(other.capacity_)
+  {
+    // Either steal the heap array or copy the inline elements
+    std::memcpy(&storage_, &other.storage_, sizeof(storage_));
+    other.size_ = 0;
+    other.capacity_ = N;
+  }
+
+  SmallVector& operator=(SmallVector&& other) noexcept
+  {
+    if (this != &other)
+    {
+      freeHeap();
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      std::memcpy(&storage_, &other.storage_, sizeof(storage_));
+      other.size_ = 0;
+      other.capacity_ = N;
+    }
+    return *this;
+  }
+
+  ~SmallVector()
+  {
+    freeHeap();
+  }
+
+  // Iterators
+  iterator begin() { return data(); }
+  iterator end() { return data() + size_; }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size_; }
+  const_iterator cbegin() const { return data(); }
+  const_iterator cend() const { return data() + size_; }
+  reverse_iterator rbegin() { return reverse_iterator(end()); }
+  reverse_iterator rend() { return reverse_iterator(begin()); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+  const_reverse_iterator crbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator crend() const { return const_reverse_iterator(begin()); }
+
+  // Capacity
+  bool empty() const { return size_ == 0; }
+  size_type size() const { return size_; }
+  size_type capacity() const { return capacity_; }
+  bool isInline() const { return capacity_ == N; }
+
+  void reserve(size_type capacity)
+  {
+    if (capacity <= capacity_)
+    {
+      return;
+    }
+
+    auto* heap = static_cast<T*>(::operator new(capacity * sizeof(T)));
+    std::memcpy(heap, data(), size_ * sizeof(T));
+    freeHeap();
+    storage_.heap = heap;
+    capacity_ = static_cast<std::uint32_t>(capacity);
+  }
+
+  // Element access
+  T& operator[](size_type index) { return data()[index]; }
+  const T& operator[](size_type index) const { return data()[index]; }
+  T& front() { return data()[0]; }
+  const T& front() const { return data()[0]; }
+  T& back() { return data()[size_ - 1]; }
+  const T& back() const { return data()[size_ - 1]; }
+  T* data() { return isInline() ? storage_.inline_elements : storage_.heap; }
+  const T* data() const { return isInline() ? storage_.inline_elements : storage_.heap; }
+
+  // Modifiers
+  void clear()
+  {
+    size_ = 0;
+  }
+
+  void push_back(const T& value)
+  {
+    if (size_ == capacity_)
+    {
+      // Copy value first, it could be an element in this vector
+      const auto copy = value;
+      reserve(capacity_ * 2);
+      data()[size_++] = copy;
+    }
+    else
+    {
+      data()[size_++] = value;
+    }
+  }
+
+  void pop_back()
+  {
+    --size_;
+  }
+
+  iterator insert(const_iterator position, const T& value)
+  {
+    const auto index = position - cbegin();
+    const auto copy = value;
+    if (size_ == capacity_)
+    {
+      reserve(capacity_ * 2);
+    }
+    auto* elements = data();
+    std::memmove(elements + index + 1, elements + index, (size_ - index) * sizeof(T));
+    elements[index] = copy;
+    ++size_;
+    return elements + index;
+  }
+
+  iterator erase(const_iterator position)
+  {
+    const auto index = position - cbegin();
+    auto* elements = data();
+    std::memmove(elements + index, elements + index + 1, (size_ - index - 1) * sizeof(T));
+    --size_;
+    return elements + index;
+  }
+
+ private:
+  void freeHeap()
+  {
+    if (!isInline())
+    {
+      ::operator delete(storage_.heap);
+      capacity_ = N;
+    }
+  }
+
+  std::uint32_t size_;
+  std::uint32_t capacity_;
+  union Storage
+  {
+    T inline_elements[N];
+    T* heap;
+  } storage_;
+};
+
+#endif  // UTILS_EXPORT_SMALL_VECTOR_H_
@@ -0,0 +1,48 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_THREAD_AFFINITY_H_
+#define UTILS_EXPORT_THREAD_AFFINITY_H_
+
+#include <string>
+#include <vector>
+
+// Pinning of threads to CPUs, e.g. to keep the game engine thread and the network threads
+// on different cores. Only supported on Linux.
+class ThreadAffinity
+{
+ public:
+  // Delete constructor (static class only)
+  ThreadAffinity() = delete;
+
+  // Parses a list of CPUs such as "0,2-3" into { 0, 2, 3 }, an empty string is an empty list
+  // Returns false if the list is invalid
+  static bool parseCpuList(const std::string& cpuList, std::vector<int>* cpus);
+
+  // Pins the calling thread to the given CPUs, an empty list leaves the thread as it is
+  // Returns false if the thread could not be pinned
+  static bool pinCurrentThread(const std::vector<int>& cpus);
+};
+
+#endif  // UTILS_EXPORT_THREAD_AFFINITY_H_
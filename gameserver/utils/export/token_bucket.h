@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_TOKEN_BUCKET_H_
+#define UTILS_EXPORT_TOKEN_BUCKET_H_
+
+#include <algorithm>
+#include <cstdint>
+
+// Rate limiter that allows bursts of up to burst events, and refills with
+// ratePerSecond events per second. Time is given by the caller (e.g. Tick::now()),
+// in milliseconds.
+//
+// Tokens are counted in thousandths internally so that the refill is exact with
+// integer math, also for rates below one event per millisecond.
+class TokenBucket
+{
+ public:
+  TokenBucket(int ratePerSecond, int burst)
+    : ratePerSecond_(ratePerSecond),
+      capacity_(static_cast<std::int64_t>(burst) * 1000),
+      tokens_(capacity_),
+      lastMs_(0)
+  {
+  }
+
+  // Returns true and consumes a token if there is one, otherwise the event should be dropped
+  bool consume(std::int64_t nowMs)
+  {
+    if (nowMs > lastMs_)
+    {
+      tokens_ = std::min(capacity_, tokens_ + (nowMs - lastMs_) * ratePerSecond_);
+      lastMs_ = nowMs;
+    }
+
+    if (tokens_ < 1000)
+    {
+      return false;
+    }
+
+    tokens_ -= 1000;
+    return true;
+  }
+
+  void reset()
+  {
+    tokens_ = capacity_;
+  }
+
+ private:
+  std::int64_t ratePerSecond_;
+  std::int64_t capacity_;
+  std::int64_t tokens_;
+  std::int64_t lastMs_;
+};
+
+#endif  // UTILS_EXPORT_TOKEN_BUCKET_H_
@@ -0,0 +1,282 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_UNIQUE_FUNCTION_H_
+#define UTILS_EXPORT_UNIQUE_FUNCTION_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Fixed size blocks for the callables that do not fit inline in a UniqueFunction.
+// Released blocks are kept for reuse instead of being freed. Thread safe.
+class FunctionBlockPool
+{
+ public:
+  static constexpr std::size_t block_size = 256;
+
+  // Delete constructor (static class only)
+  FunctionBlockPool() = delete;
+
+  static void* allocate();
+  static void release(void* block);
+
+  // The number of blocks allocated from the heap so far
+  static std::size_t getNumberOfBlocks();
+};
+
+template<typename Signature>
+class UniqueFunction;
+
+// Like std::function, but move-only: the callable is never copied, so it may capture
+// move-only types, and moving a UniqueFunction never allocates.
+//
+// Callables of at most inline_size bytes are stored inline. Larger callables are stored in a
+// block from FunctionBlockPool, and only callables larger than FunctionBlockPool::block_size are
+// allocated with new. So once the pool has grown to the number of large callables that are alive
+// at the same time, creating a UniqueFunction does no heap allocations.
+template<typename R, typename... Args>
+class UniqueFunction<R(Args...)>
+{
+ public:
+  static constexpr std::size_t inline_size = 96;
+
+  UniqueFunction() noexcept
+    : ops_(nullptr)
+  {
+  }
+
+  UniqueFunction(std::nullptr_t) noexcept  // NOLINT
+    : ops_(nullptr)
+  {
+  }
+
+  template<typename F,
+           typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, UniqueFunction>::value>::type>
+  UniqueFunction(F&& f)  // NOLINT
+    : ops_(nullptr)
+  {
+    using Callable = typename std::decay<F>::type;
+    construct<Callable>(std::forward<F>(f), std::integral_constant<int, getStorageKind<Callable>()>());
+  }
+
+  UniqueFunction(UniqueFunction&& other) noexcept
+    : ops_(other.ops_)
+  {
+    if (ops_)
+    {
+      ops_->move(&storage_, &other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  UniqueFunction& operator=(UniqueFunction&& other) noexcept
+  {
+    if (this != &other)
+    {
+      reset();
+      if (other.ops_)
+      {
+        other.ops_->move(&storage_, &other.storage_);
+        ops_ = other.ops_;
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  UniqueFunction& operator=(std::nullptr_t) noexcept
+  {
+    reset();
+    return *this;
+  }
+
+  ~UniqueFunction()
+  {
+    reset();
+  }
+
+  // Delete copy constructors
+  UniqueFunction(const UniqueFunction&) = delete;
+  UniqueFunction& operator=(const UniqueFunction&) = delete;
+
+  explicit operator bool() const { return ops_ != nullptr; }
+
+  // Like std::function, the callable may modify its own state also when called via a const UniqueFunction
+  R operator()(Args... args) const
+  {
+    return ops_->call(const_cast<Storage*>(&storage_), std::forward<Args>(args)...);
+  }
+
+  // True if the callable type F is stored inline
+  template<typename F>
+  static constexpr bool isInline()
+  {
+    return sizeof(F) <= inline_size &&
+           alignof(F) <= alignof(std::max_align_t) &&
+           std::is_nothrow_move_constructible<F>::value;
+  }
+
+ private:
+  using Storage = typename std::aligned_storage<inline_size, alignof(std::max_align_t)>::type;
+
+  struct Ops
+  {
+    R (*call)(Storage* storage, Args&&... args);
+    void (*move)(Storage* to, Storage* from);
+    void (*destroy)(Storage* storage);
+  };
+
+  void reset()
+  {
+    if (ops_)
+    {
+      ops_->destroy(&storage_);
+      ops_ = nullptr;
+    }
+  }
+
+  // Where a callable is stored, see construct
+  static constexpr int inline_storage = 0;
+  static constexpr int pooled_storage = 1;
+  static constexpr int heap_storage = 2;
+
+  template<typename F>
+  static constexpr int getStorageKind()
+  {
+    return isInline<F>() ? inline_storage :
+           sizeof(F) <= FunctionBlockPool::block_size && alignof(F) <= alignof(std::max_align_t) ? pooled_storage :
+           heap_storage;
+  }
+
+  template<typename Callable, typename F>
+  void construct(F&& f, std::integral_constant<int, inline_storage>)
+  {
+    new (&storage_) Callable(std::forward<F>(f));
+    ops_ = &inlineOps<Callable>;
+  }
+
+  template<typename Callable, typename F>
+  void construct(F&& f, std::integral_constant<int, pooled_storage>)
+  {
+    auto* block = FunctionBlockPool::allocate();
+    try
+    {
+      setPointer(new (block) Callable(std::forward<F>(f)));
+    }
+    catch (...)
+    {
+      FunctionBlockPool::release(block);
+      throw;
+    }
+    ops_ = &pooledOps<Callable>;
+  }
+
+  template<typename Callable, typename F>
+  void construct(F&& f, std::integral_constant<int, heap_storage>)
+  {
+    setPointer(new Callable(std::forward<F>(f)));
+    ops_ = &heapOps<Callable>;
+  }
+
+  template<typename F>
+  void setPointer(F* f) { *reinterpret_cast<F**>(&storage_) = f; }
+
+  template<typename F>
+  static F* getPointer(Storage* storage) { return *reinterpret_cast<F**>(storage); }
+
+  // The callable is stored in storage_
+  template<typename F>
+  static R callInline(Storage* storage, Args&&... args)
+  {
+    return (*reinterpret_cast<F*>(storage))(std::forward<Args>(args)...);
+  }
+
+  template<typename F>
+  static void moveInline(Storage* to, Storage* from)
+  {
+    auto* f = reinterpret_cast<F*>(from);
+    new (to) F(std::move(*f));
+    f->~F();
+  }
+
+  template<typename F>
+  static void destroyInline(Storage* storage)
+  {
+    reinterpret_cast<F*>(storage)->~F();
+  }
+
+  // storage_ holds a pointer to the callable
+  template<typename F>
+  static R callPointer(Storage* storage, Args&&... args)
+  {
+    return (*getPointer<F>(storage))(std::forward<Args>(args)...);
+  }
+
+  static void movePointer(Storage* to, Storage* from)
+  {
+    *reinterpret_cast<void**>(to) = *reinterpret_cast<void**>(from);
+  }
+
+  template<typename F>
+  static void destroyPooled(Storage* storage)
+  {
+    auto* f = getPointer<F>(storage);
+    f->~F();
+    FunctionBlockPool::release(f);
+  }
+
+  template<typename F>
+  static void destroyHeap(Storage* storage)
+  {
+    delete getPointer<F>(storage);
+  }
+
+  template<typename F>
+  static constexpr Ops inlineOps = { &callInline<F>, &moveInline<F>, &destroyInline<F> };
+
+  template<typename F>
+  static constexpr Ops pooledOps = { &callPointer<F>, &movePointer, &destroyPooled<F> };
+
+  template<typename F>
+  static constexpr Ops heapOps = { &callPointer<F>, &movePointer, &destroyHeap<F> };
+
+  const Ops* ops_;
+  Storage storage_;
+};
+
+template<typename R, typename... Args>
+template<typename F>
+constexpr typename UniqueFunction<R(Args...)>::Ops UniqueFunction<R(Args...)>::inlineOps;
+
+template<typename R, typename... Args>
+template<typename F>
+constexpr typename UniqueFunction<R(Args...)>::Ops UniqueFunction<R(Args...)>::pooledOps;
+
+template<typename R, typename... Args>
+template<typename F>
+constexpr typename UniqueFunction<R(Args...)>::Ops UniqueFunction<R(Args...)>::heapOps;
+
+#endif  // UTILS_EXPORT_UNIQUE_FUNCTION_H_
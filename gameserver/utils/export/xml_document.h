@@ -0,0 +1,78 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef UTILS_EXPORT_XML_DOCUMENT_H_
+#define UTILS_EXPORT_XML_DOCUMENT_H_
+
+#include <istream>
+#include <string>
+#include <vector>
+
+#include "rapidxml.hpp"
+
+// An XML file read into a single buffer and parsed in place by rapidxml
+//
+// The file is read with one sized read and parsed without any further copies, the names and
+// values of the nodes and attributes point into the buffer. So they are only valid as long as
+// the XmlDocument, and should be parsed directly (see getInteger) instead of via std::string.
+// Text between elements is not kept as data nodes, so next_sibling() always gives the next element.
+class XmlDocument
+{
+ public:
+  using Node = rapidxml::xml_node<>;
+  using Attribute = rapidxml::xml_attribute<>;
+
+  XmlDocument()
+    : buffer_(),
+      document_()
+  {
+  }
+
+  // Delete copy constructors
+  XmlDocument(const XmlDocument&) = delete;
+  XmlDocument& operator=(const XmlDocument&) = delete;
+
+  // Returns false if the file could not be read or is not valid XML
+  bool loadFile(const std::string& filename);
+  bool loadStream(std::istream* stream);
+
+  // Returns the first top node, with the given name if not nullptr, or nullptr if there is none
+  const Node* getFirstNode(const char* name = nullptr) const { return document_.first_node(name); }
+
+  // Parses a decimal integer like std::stoi (leading whitespace and trailing characters are
+  // ignored) but without exceptions or allocations, returns false if there is no integer
+  static bool parseInteger(const char* string, int* value);
+
+  // Parses the attribute with the given name as an integer, returns false if the node has no
+  // such attribute or if its value is not an integer
+  static bool getInteger(const Node* node, const char* name, int* value);
+
+ private:
+  bool parse(const std::string& source);
+
+  std::vector<char> buffer_;
+  rapidxml::xml_document<> document_;
+};
+
+#endif  // UTILS_EXPORT_XML_DOCUMENT_H_
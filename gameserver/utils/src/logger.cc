@@ -33,13 +33,19 @@ const std::unordered_map<std::string, Logger::Module> Logger::file_to_module_ =
 {
   // utils
   { "config_parser.h",      Module::UTILS       },
+  { "mapped_file.cc",       Module::UTILS       },
+  { "thread_affinity.cc",   Module::UTILS       },
+  { "xml_document.cc",      Module::UTILS       },
 
   // account
   { "account.cc",           Module::ACCOUNT     },
 
   // network
   { "connection_impl.h",    Module::NETWORK     },
+  { "connection_proxy.cc",  Module::NETWORK     },
   { "server_impl.h",        Module::NETWORK     },
+  { "handoff.cc",           Module::NETWORK     },
+  { "network_threads.cc",   Module::NETWORK     },
   { "incoming_packet.cc",   Module::NETWORK     },
   { "outgoing_packet.cc",   Module::NETWORK     },
   { "acceptor.h",           Module::NETWORK     },
@@ -50,6 +56,10 @@ const std::unordered_map<std::string, Logger::Module> Logger::file_to_module_ =
   { "world.cc",             Module::WORLD       },
   { "creature.cc",          Module::WORLD       },
   { "position.cc",          Module::WORLD       },
+  { "sector_grid.cc",       Module::WORLD       },
+  { "tile_store.cc",        Module::WORLD       },
+  { "pathfinder.cc",        Module::WORLD       },
+  { "pathfinding_service.cc", Module::WORLD     },
   { "item_factory.cc",      Module::WORLD       },
   { "world_factory.cc",     Module::WORLD       },
 
@@ -62,6 +72,8 @@ const std::unordered_map<std::string, Logger::Module> Logger::file_to_module_ =
   { "game_engine_queue.cc", Module::GAMEENGINE  },
   { "player.cc",            Module::GAMEENGINE  },
   { "item_manager.cc",      Module::GAMEENGINE  },
+  { "sector_file_store.cc", Module::GAMEENGINE  },
+  { "world_image.cc",       Module::GAMEENGINE  },
 
   // worldserver
   { "protocol_71.cc",       Module::WORLDSERVER },
@@ -0,0 +1,76 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logger.h"
+
+bool MappedFile::open(const std::string& filename)
+{
+  close();
+
+  const auto fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+  {
+    LOG_DEBUG("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  struct stat fileStat;
+  if (fstat(fd, &fileStat) == -1 || fileStat.st_size <= 0)
+  {
+    LOG_ERROR("%s: could not get size of file, or file is empty: %s", __func__, filename.c_str());
+    ::close(fd);
+    return false;
+  }
+
+  // The mapping is kept after the file descriptor is closed
+  const auto size = static_cast<std::size_t>(fileStat.st_size);
+  auto* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED)
+  {
+    LOG_ERROR("%s: could not map file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  data_ = static_cast<const std::uint8_t*>(data);
+  size_ = size;
+  return true;
+}
+
+void MappedFile::close()
+{
+  if (data_)
+  {
+    munmap(const_cast<std::uint8_t*>(data_), size_);
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
@@ -0,0 +1,124 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "thread_affinity.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <cstdlib>
+
+#include "logger.h"
+
+bool ThreadAffinity::parseCpuList(const std::string& cpuList, std::vector<int>* cpus)
+{
+  cpus->clear();
+
+  // Parses a non-negative number at position, and moves position past it
+  const auto parseNumber = [&cpuList](std::size_t* position, int* number)
+  {
+    const auto start = *position;
+    while (*position < cpuList.size() && cpuList[*position] >= '0' && cpuList[*position] <= '9')
+    {
+      *position += 1;
+    }
+    if (*position == start || *position - start > 4)
+    {
+      return false;
+    }
+    *number = std::atoi(cpuList.substr(start, *position - start).c_str());
+    return true;
+  };
+
+  std::size_t position = 0;
+  while (position < cpuList.size())
+  {
+    int first;
+    if (!parseNumber(&position, &first))
+    {
+      return false;
+    }
+
+    auto last = first;
+    if (position < cpuList.size() && cpuList[position] == '-')
+    {
+      position += 1;
+      if (!parseNumber(&position, &last) || last < first)
+      {
+        return false;
+      }
+    }
+
+    for (auto cpu = first; cpu <= last; cpu++)
+    {
+      cpus->push_back(cpu);
+    }
+
+    if (position < cpuList.size())
+    {
+      // Another CPU or range must follow the comma
+      if (cpuList[position] != ',' || position + 1 == cpuList.size())
+      {
+        return false;
+      }
+      position += 1;
+    }
+  }
+  return true;
+}
+
+bool ThreadAffinity::pinCurrentThread(const std::vector<int>& cpus)
+{
+  if (cpus.empty())
+  {
+    return true;
+  }
+
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (const auto cpu : cpus)
+  {
+    if (cpu >= CPU_SETSIZE)
+    {
+      LOG_ERROR("%s: invalid cpu: %d", __func__, cpu);
+      return false;
+    }
+    CPU_SET(cpu, &cpuSet);
+  }
+
+  const auto error = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+  if (error != 0)
+  {
+    LOG_ERROR("%s: could not set affinity, error: %d", __func__, error);
+    return false;
+  }
+  return true;
+#else
+  LOG_ERROR("%s: not supported on this platform", __func__);
+  return false;
+#endif
+}
@@ -0,0 +1,69 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "unique_function.h"
+
+#include <mutex>
+
+namespace
+{
+
+// The released blocks are linked through their first bytes
+struct FreeBlock
+{
+  FreeBlock* next;
+};
+
+std::mutex mutex;
+FreeBlock* free_blocks = nullptr;
+std::size_t number_of_blocks = 0;
+
+}  // namespace
+
+void* FunctionBlockPool::allocate()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (free_blocks)
+    {
+      auto* block = free_blocks;
+      free_blocks = block->next;
+      return block;
+    }
+    number_of_blocks++;
+  }
+  return ::operator new(block_size);
+}
+
+void FunctionBlockPool::release(void* block)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  free_blocks = new (block) FreeBlock{free_blocks};
+}
+
+std::size_t FunctionBlockPool::getNumberOfBlocks()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  return number_of_blocks;
+}
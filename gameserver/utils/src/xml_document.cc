@@ -0,0 +1,141 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "xml_document.h"
+
+#include <cctype>
+#include <cstdio>
+#include <iterator>
+#include <limits>
+
+#include "logger.h"
+
+bool XmlDocument::loadFile(const std::string& filename)
+{
+  auto* file = fopen(filename.c_str(), "rb");
+  if (file == nullptr)
+  {
+    LOG_ERROR("%s: could not open file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  if (fseek(file, 0, SEEK_END) != 0)
+  {
+    LOG_ERROR("%s: could not read file: %s", __func__, filename.c_str());
+    fclose(file);
+    return false;
+  }
+  const auto size = ftell(file);
+  if (size < 0 || fseek(file, 0, SEEK_SET) != 0)
+  {
+    LOG_ERROR("%s: could not read file: %s", __func__, filename.c_str());
+    fclose(file);
+    return false;
+  }
+
+  // rapidxml needs a zero terminated string that it can modify
+  buffer_.assign(size + 1, '\0');
+  const auto ok = fread(buffer_.data(), 1, size, file) == static_cast<std::size_t>(size);
+  fclose(file);
+  if (!ok)
+  {
+    LOG_ERROR("%s: could not read file: %s", __func__, filename.c_str());
+    return false;
+  }
+
+  return parse(filename);
+}
+
+bool XmlDocument::loadStream(std::istream* stream)
+{
+  buffer_.assign(std::istreambuf_iterator<char>(*stream), std::istreambuf_iterator<char>());
+  buffer_.push_back('\0');
+  return parse("stream");
+}
+
+bool XmlDocument::parseInteger(const char* string, int* value)
+{
+  while (std::isspace(static_cast<unsigned char>(*string)))
+  {
+    string++;
+  }
+
+  const auto negative = *string == '-';
+  if (*string == '-' || *string == '+')
+  {
+    string++;
+  }
+
+  if (!std::isdigit(static_cast<unsigned char>(*string)))
+  {
+    return false;
+  }
+
+  // Accumulate as a negative number, so that the lowest int can be parsed as well
+  auto result = 0LL;
+  while (std::isdigit(static_cast<unsigned char>(*string)))
+  {
+    result = (result * 10) - (*string - '0');
+    if (result < std::numeric_limits<int>::min())
+    {
+      return false;
+    }
+    string++;
+  }
+
+  if (!negative)
+  {
+    result = -result;
+    if (result > std::numeric_limits<int>::max())
+    {
+      return false;
+    }
+  }
+
+  *value = static_cast<int>(result);
+  return true;
+}
+
+bool XmlDocument::getInteger(const Node* node, const char* name, int* value)
+{
+  const auto* attribute = node->first_attribute(name);
+  return attribute != nullptr && parseInteger(attribute->value(), value);
+}
+
+bool XmlDocument::parse(const std::string& source)
+{
+  // Only elements and attributes are used, without data nodes the whitespace between elements
+  // doesn't show up as siblings of them
+  document_.clear();
+  try
+  {
+    document_.parse<rapidxml::parse_no_data_nodes>(buffer_.data());
+  }
+  catch (const rapidxml::parse_error& e)
+  {
+    LOG_ERROR("%s: could not parse %s: %s", __func__, source.c_str(), e.what());
+    return false;
+  }
+  return true;
+}
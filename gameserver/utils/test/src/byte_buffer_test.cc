@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "byte_buffer.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ByteBufferTest, WriteRead)
+{
+  std::vector<std::uint8_t> data;
+  ByteWriter writer(&data);
+  writer.addU8(0x12);
+  writer.addU16(0x3456);
+  writer.addU32(0x789ABCDE);
+  writer.addString("hello");
+  writer.addBytes({ 1, 2, 3 });
+  writer.addString("");
+
+  // Little endian
+  ASSERT_EQ(0x56, data[1]);
+  ASSERT_EQ(0x34, data[2]);
+
+  ByteReader reader(data.data(), data.size());
+  EXPECT_EQ(0x12, reader.getU8());
+  EXPECT_EQ(0x3456, reader.getU16());
+  EXPECT_EQ(0x789ABCDEu, reader.getU32());
+  EXPECT_EQ("hello", reader.getString());
+  EXPECT_EQ(std::vector<std::uint8_t>({ 1, 2, 3 }), reader.getBytes());
+  EXPECT_EQ("", reader.getString());
+  EXPECT_TRUE(reader.isEmpty());
+  EXPECT_FALSE(reader.failed());
+}
+
+TEST(ByteBufferTest, ReadPastEnd)
+{
+  std::vector<std::uint8_t> data;
+  ByteWriter writer(&data);
+  writer.addU16(0x1234);
+  writer.addString("hello");
+
+  // The string is truncated
+  ByteReader reader(data.data(), data.size() - 1);
+  EXPECT_EQ(0x1234, reader.getU16());
+  EXPECT_FALSE(reader.failed());
+  EXPECT_EQ("", reader.getString());
+  EXPECT_TRUE(reader.failed());
+
+  // Once failed, all reads fail
+  ByteReader reader2(data.data(), 1);
+  reader2.getU16();
+  EXPECT_TRUE(reader2.failed());
+  EXPECT_EQ(0, reader2.getU8());
+  EXPECT_TRUE(reader2.failed());
+}
@@ -0,0 +1,112 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "mpsc_queue.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(MpscQueueTest, PushPop)
+{
+  MpscQueue<int> queue;
+
+  int value = 0;
+  ASSERT_FALSE(queue.pop(&value));
+
+  queue.push(1);
+  queue.push(2);
+  queue.push(3);
+  ASSERT_TRUE(queue.pop(&value));
+  ASSERT_EQ(1, value);
+  ASSERT_TRUE(queue.pop(&value));
+  ASSERT_EQ(2, value);
+
+  queue.push(4);
+  ASSERT_TRUE(queue.pop(&value));
+  ASSERT_EQ(3, value);
+  ASSERT_TRUE(queue.pop(&value));
+  ASSERT_EQ(4, value);
+  ASSERT_FALSE(queue.pop(&value));
+}
+
+TEST(MpscQueueTest, MoveOnly)
+{
+  // Values that are left in the queue are deleted with it
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.push(std::make_unique<int>(1));
+  queue.push(std::make_unique<int>(2));
+
+  std::unique_ptr<int> value;
+  ASSERT_TRUE(queue.pop(&value));
+  ASSERT_EQ(1, *value);
+}
+
+TEST(MpscQueueTest, MultipleProducers)
+{
+  static constexpr int number_of_producers = 4;
+  static constexpr int values_per_producer = 20000;
+
+  // Each value is producer * values_per_producer + i
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (auto producer = 0; producer < number_of_producers; producer++)
+  {
+    producers.emplace_back([&queue, producer]()
+    {
+      for (auto i = 0; i < values_per_producer; i++)
+      {
+        queue.push(producer * values_per_producer + i);
+      }
+    });
+  }
+
+  // The values of each producer are popped in the order they were pushed
+  std::vector<int> next(number_of_producers, 0);
+  auto popped = 0;
+  while (popped < number_of_producers * values_per_producer)
+  {
+    int value;
+    if (!queue.pop(&value))
+    {
+      std::this_thread::yield();
+      continue;
+    }
+
+    const auto producer = value / values_per_producer;
+    ASSERT_EQ(next[producer], value % values_per_producer);
+    next[producer] += 1;
+    popped += 1;
+  }
+
+  for (auto& producer : producers)
+  {
+    producer.join();
+  }
+
+  int value;
+  ASSERT_FALSE(queue.pop(&value));
+}
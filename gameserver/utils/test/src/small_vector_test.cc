@@ -0,0 +1,93 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "small_vector.h"
+
+#include "gtest/gtest.h"
+
+TEST(SmallVectorTest, InlineAndHeap)
+{
+  SmallVector<int, 2> vector;
+  ASSERT_TRUE(vector.empty());
+  ASSERT_TRUE(vector.isInline());
+
+  vector.push_back(1);
+  vector.push_back(2);
+  ASSERT_EQ(2u, vector.size());
+  ASSERT_TRUE(vector.isInline());
+
+  // Grows onto the heap
+  vector.push_back(3);
+  ASSERT_EQ(3u, vector.size());
+  ASSERT_FALSE(vector.isInline());
+  ASSERT_EQ(1, vector[0]);
+  ASSERT_EQ(2, vector[1]);
+  ASSERT_EQ(3, vector[2]);
+
+  vector.clear();
+  ASSERT_TRUE(vector.empty());
+}
+
+TEST(SmallVectorTest, InsertErase)
+{
+  SmallVector<int, 4> vector = { 1, 3 };
+
+  vector.insert(vector.begin() + 1, 2);
+  vector.insert(vector.begin(), 0);
+  vector.insert(vector.end(), 4);
+  ASSERT_EQ(5u, vector.size());
+  for (auto i = 0; i < 5; i++)
+  {
+    ASSERT_EQ(i, vector[i]);
+  }
+
+  vector.erase(vector.begin());
+  vector.erase(vector.begin() + 1);
+  ASSERT_EQ(3u, vector.size());
+  ASSERT_EQ(1, vector.front());
+  ASSERT_EQ(3, vector[1]);
+  ASSERT_EQ(4, vector.back());
+}
+
+TEST(SmallVectorTest, CopyMove)
+{
+  SmallVector<int, 2> small = { 1 };
+  SmallVector<int, 2> large = { 1, 2, 3 };
+
+  auto smallCopy = small;
+  auto largeCopy = large;
+  ASSERT_EQ(1u, smallCopy.size());
+  ASSERT_EQ(3u, largeCopy.size());
+  ASSERT_EQ(3, largeCopy[2]);
+
+  // Moving from a heap allocated vector steals the allocation
+  const auto* data = large.data();
+  auto largeMoved = std::move(large);
+  ASSERT_EQ(data, largeMoved.data());
+  ASSERT_TRUE(large.empty());
+
+  small = std::move(largeMoved);
+  ASSERT_EQ(3u, small.size());
+  ASSERT_EQ(data, small.data());
+}
@@ -0,0 +1,55 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "thread_affinity.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+TEST(ThreadAffinityTest, ParseCpuList)
+{
+  std::vector<int> cpus = { 1 };
+  ASSERT_TRUE(ThreadAffinity::parseCpuList("", &cpus));
+  ASSERT_TRUE(cpus.empty());
+
+  ASSERT_TRUE(ThreadAffinity::parseCpuList("3", &cpus));
+  ASSERT_EQ(std::vector<int>({ 3 }), cpus);
+
+  ASSERT_TRUE(ThreadAffinity::parseCpuList("0,2-4,7", &cpus));
+  ASSERT_EQ(std::vector<int>({ 0, 2, 3, 4, 7 }), cpus);
+
+  ASSERT_FALSE(ThreadAffinity::parseCpuList("1,", &cpus));
+  ASSERT_FALSE(ThreadAffinity::parseCpuList(",1", &cpus));
+  ASSERT_FALSE(ThreadAffinity::parseCpuList("3-1", &cpus));
+  ASSERT_FALSE(ThreadAffinity::parseCpuList("1-", &cpus));
+  ASSERT_FALSE(ThreadAffinity::parseCpuList("a", &cpus));
+  ASSERT_FALSE(ThreadAffinity::parseCpuList("1 2", &cpus));
+}
+
+TEST(ThreadAffinityTest, PinNothing)
+{
+  // An empty list leaves the thread as it is
+  ASSERT_TRUE(ThreadAffinity::pinCurrentThread({}));
+}
@@ -0,0 +1,62 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "token_bucket.h"
+
+#include "gtest/gtest.h"
+
+TEST(TokenBucketTest, Burst)
+{
+  TokenBucket bucket(10, 3);
+
+  // The bucket starts full
+  ASSERT_TRUE(bucket.consume(0));
+  ASSERT_TRUE(bucket.consume(0));
+  ASSERT_TRUE(bucket.consume(0));
+  ASSERT_FALSE(bucket.consume(0));
+
+  bucket.reset();
+  ASSERT_TRUE(bucket.consume(0));
+}
+
+TEST(TokenBucketTest, Refill)
+{
+  TokenBucket bucket(10, 2);
+  ASSERT_TRUE(bucket.consume(1000));
+  ASSERT_TRUE(bucket.consume(1000));
+  ASSERT_FALSE(bucket.consume(1000));
+
+  // 10 per second is one token per 100 ms
+  ASSERT_FALSE(bucket.consume(1099));
+  ASSERT_TRUE(bucket.consume(1100));
+  ASSERT_FALSE(bucket.consume(1100));
+
+  // Never more than the burst, no matter how long it has been
+  ASSERT_TRUE(bucket.consume(60000));
+  ASSERT_TRUE(bucket.consume(60000));
+  ASSERT_FALSE(bucket.consume(60000));
+
+  // Time going backwards doesn't add any tokens
+  ASSERT_FALSE(bucket.consume(50000));
+}
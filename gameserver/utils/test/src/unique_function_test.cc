@@ -0,0 +1,117 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "unique_function.h"
+
+#include <array>
+#include <memory>
+#include <utility>
+
+#include "gtest/gtest.h"
+
+TEST(UniqueFunctionTest, Call)
+{
+  UniqueFunction<int(int)> empty;
+  ASSERT_FALSE(empty);
+
+  UniqueFunction<int(int)> addOne = [](int value) { return value + 1; };
+  ASSERT_TRUE(addOne);
+  ASSERT_EQ(2, addOne(1));
+
+  // Move-only captures
+  auto value = std::make_unique<int>(10);
+  UniqueFunction<int(int)> addValue = [value = std::move(value)](int x) { return x + *value; };
+  ASSERT_EQ(15, addValue(5));
+
+  // Mutable callables keep their state
+  UniqueFunction<int()> counter = [count = 0]() mutable { return ++count; };
+  ASSERT_EQ(1, counter());
+  ASSERT_EQ(2, counter());
+}
+
+TEST(UniqueFunctionTest, Move)
+{
+  auto value = std::make_shared<int>(1);
+
+  UniqueFunction<int()> function = [value]() { return *value; };
+  ASSERT_EQ(2, value.use_count());
+
+  // The callable is moved, not copied
+  auto moved = std::move(function);
+  ASSERT_FALSE(function);  // NOLINT
+  ASSERT_TRUE(moved);
+  ASSERT_EQ(1, moved());
+  ASSERT_EQ(2, value.use_count());
+
+  UniqueFunction<int()> assigned;
+  assigned = std::move(moved);
+  ASSERT_EQ(1, assigned());
+  ASSERT_EQ(2, value.use_count());
+
+  // The callable is destroyed
+  assigned = nullptr;
+  ASSERT_FALSE(assigned);
+  ASSERT_EQ(1, value.use_count());
+}
+
+TEST(UniqueFunctionTest, Storage)
+{
+  using Function = UniqueFunction<int()>;
+
+  // Small callables are stored inline
+  std::array<char, Function::inline_size - 8> small = {{ 1 }};
+  auto smallFunction = [small]() { return static_cast<int>(small[0]); };
+  ASSERT_TRUE(Function::isInline<decltype(smallFunction)>());
+
+  // Larger callables are stored in pooled blocks, that are reused
+  std::array<char, FunctionBlockPool::block_size - 8> large = {{ 2 }};
+  auto value = std::make_shared<int>(3);
+  auto largeFunction = [large, value]() { return static_cast<int>(large[0]) + *value; };
+  ASSERT_FALSE(Function::isInline<decltype(largeFunction)>());
+
+  {
+    Function function(largeFunction);
+    ASSERT_EQ(5, function());
+    ASSERT_EQ(3, value.use_count());
+  }
+  ASSERT_EQ(2, value.use_count());
+
+  const auto numberOfBlocks = FunctionBlockPool::getNumberOfBlocks();
+  for (auto i = 0; i < 10; i++)
+  {
+    Function function(largeFunction);
+    auto moved = std::move(function);
+    ASSERT_EQ(5, moved());
+  }
+  ASSERT_EQ(numberOfBlocks, FunctionBlockPool::getNumberOfBlocks());
+
+  // Even larger callables are allocated on the heap
+  std::array<char, FunctionBlockPool::block_size * 2> huge = {{ 4 }};
+  Function hugeFunction = [huge]() { return static_cast<int>(huge[0]); };
+  ASSERT_EQ(4, hugeFunction());
+  ASSERT_EQ(numberOfBlocks, FunctionBlockPool::getNumberOfBlocks());
+
+  Function function = smallFunction;
+  ASSERT_EQ(1, function());
+}
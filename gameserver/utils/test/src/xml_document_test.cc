@@ -0,0 +1,113 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "xml_document.h"
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+
+TEST(XmlDocumentTest, ParseInteger)
+{
+  int value = 0;
+  ASSERT_TRUE(XmlDocument::parseInteger("1234", &value));
+  ASSERT_EQ(1234, value);
+  ASSERT_TRUE(XmlDocument::parseInteger("-42", &value));
+  ASSERT_EQ(-42, value);
+  ASSERT_TRUE(XmlDocument::parseInteger("+7", &value));
+  ASSERT_EQ(7, value);
+  ASSERT_TRUE(XmlDocument::parseInteger("2147483647", &value));
+  ASSERT_EQ(2147483647, value);
+  ASSERT_TRUE(XmlDocument::parseInteger("-2147483648", &value));
+  ASSERT_EQ(-2147483647 - 1, value);
+
+  // Like std::stoi, leading whitespace and trailing characters are ignored
+  ASSERT_TRUE(XmlDocument::parseInteger(" 12.50", &value));
+  ASSERT_EQ(12, value);
+
+  // Not integers, value is left untouched
+  value = 5;
+  ASSERT_FALSE(XmlDocument::parseInteger("", &value));
+  ASSERT_FALSE(XmlDocument::parseInteger("-", &value));
+  ASSERT_FALSE(XmlDocument::parseInteger("abc", &value));
+  ASSERT_FALSE(XmlDocument::parseInteger("2147483648", &value));
+  ASSERT_FALSE(XmlDocument::parseInteger("-2147483649", &value));
+  ASSERT_EQ(5, value);
+}
+
+TEST(XmlDocumentTest, LoadStream)
+{
+  std::stringstream xmlStream;
+  xmlStream << "<?xml version=\"1.0\"?>\n"
+               "<map width=\"2\">\n"
+               "  <tile x=\"100\" y=\"abc\"/>\n"
+               "</map>\n";
+
+  XmlDocument document;
+  ASSERT_TRUE(document.loadStream(&xmlStream));
+  ASSERT_EQ(nullptr, document.getFirstNode("accounts"));
+
+  const auto* mapNode = document.getFirstNode();
+  ASSERT_NE(nullptr, mapNode);
+  ASSERT_STREQ("map", mapNode->name());
+
+  int value = 0;
+  ASSERT_TRUE(XmlDocument::getInteger(mapNode, "width", &value));
+  ASSERT_EQ(2, value);
+  ASSERT_FALSE(XmlDocument::getInteger(mapNode, "height", &value));
+
+  const auto* tileNode = mapNode->first_node("tile");
+  ASSERT_NE(nullptr, tileNode);
+  ASSERT_TRUE(XmlDocument::getInteger(tileNode, "x", &value));
+  ASSERT_EQ(100, value);
+  ASSERT_FALSE(XmlDocument::getInteger(tileNode, "y", &value));
+}
+
+TEST(XmlDocumentTest, LoadFile)
+{
+  const std::string filename = "xml_document_test.xml";
+  auto* file = fopen(filename.c_str(), "w");
+  ASSERT_NE(nullptr, file);
+  fputs("<items><item id=\"100\" name=\"grass\"/></items>", file);
+  fclose(file);
+
+  XmlDocument document;
+  ASSERT_TRUE(document.loadFile(filename));
+  const auto* itemsNode = document.getFirstNode("items");
+  ASSERT_NE(nullptr, itemsNode);
+  ASSERT_NE(nullptr, itemsNode->first_node("item"));
+  ASSERT_STREQ("grass", itemsNode->first_node("item")->first_attribute("name")->value());
+
+  // Invalid XML is an error, not an exception
+  file = fopen(filename.c_str(), "w");
+  ASSERT_NE(nullptr, file);
+  fputs("<items><item id=\"100\"></items>", file);
+  fclose(file);
+  ASSERT_FALSE(document.loadFile(filename));
+
+  std::remove(filename.c_str());
+  ASSERT_FALSE(document.loadFile(filename));
+}
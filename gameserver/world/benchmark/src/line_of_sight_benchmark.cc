@@ -0,0 +1,131 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures LineOfSight on a 1024x1024 map where 10% of the tiles block projectiles, with
+// random checks within the client viewport (15x11 tiles):
+//  * uncached: computeLineOfSight, every check steps the rays
+//  * cached: hasLineOfSight where the same (from, to) pairs are checked over and over,
+//            like monsters checking their targets, with a working set that fits the
+//            cache and one that does not
+// and prints how many checks fit in 10% of a 50 ms game tick.
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "line_of_sight.h"
+#include "position.h"
+
+namespace
+{
+
+constexpr int map_size = 1024;
+constexpr int z = 7;
+constexpr int tick_ms = 50;
+constexpr int number_of_checks = 4000000;
+
+struct Check
+{
+  Position from;
+  Position to;
+};
+
+template<typename F>
+void run(const char* name, const std::vector<Check>& checks, F&& hasLineOfSight)
+{
+  auto numberOfClear = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (auto i = 0; i < number_of_checks; i++)
+  {
+    const auto& check = checks[i % checks.size()];
+    if (hasLineOfSight(check.from, check.to))
+    {
+      numberOfClear++;
+    }
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+
+  const auto nsPerCheck = static_cast<double>(ns) / number_of_checks;
+  printf("%-22s checks: %8d  clear: %5.1f%%  avg time: %6.1f ns  checks per tick (10%% of %d ms): %9d\n",
+         name,
+         number_of_checks,
+         100.0 * numberOfClear / number_of_checks,
+         nsPerCheck,
+         tick_ms,
+         static_cast<int>((tick_ms * 1000000.0 / 10.0) / nsPerCheck));
+}
+
+}  // namespace
+
+int main()
+{
+  std::mt19937 random(1234);
+
+  LineOfSight lineOfSight;
+  std::bernoulli_distribution blocked(0.10);
+  for (auto x = 0; x < map_size; x++)
+  {
+    for (auto y = 0; y < map_size; y++)
+    {
+      lineOfSight.setPassable(Position(x, y, z), !blocked(random));
+    }
+  }
+
+  // Random checks within the visible part of the viewport
+  const auto randomChecks = [&random](int numberOfChecks)
+  {
+    std::uniform_int_distribution<int> center(LineOfSight::max_distance, map_size - LineOfSight::max_distance - 1);
+    std::uniform_int_distribution<int> offsetX(-7, 7);
+    std::uniform_int_distribution<int> offsetY(-5, 5);
+    std::vector<Check> checks;
+    for (auto i = 0; i < numberOfChecks; i++)
+    {
+      const Position from(center(random), center(random), z);
+      checks.push_back(Check{from, Position(from.getX() + offsetX(random), from.getY() + offsetY(random), z)});
+    }
+    return checks;
+  };
+
+  const auto uncached = [&lineOfSight](const Position& from, const Position& to)
+  {
+    return lineOfSight.computeLineOfSight(from, to);
+  };
+  const auto cached = [&lineOfSight](const Position& from, const Position& to)
+  {
+    return lineOfSight.hasLineOfSight(from, to);
+  };
+
+  printf("Map: %dx%d tiles, 10%% block projectiles, cache: %d entries\n",
+         map_size,
+         map_size,
+         static_cast<int>(LineOfSight::cache_size));
+  run("uncached", randomChecks(1000000), uncached);
+  run("cached, 64 pairs", randomChecks(64), cached);
+  run("cached, 4096 pairs", randomChecks(4096), cached);
+
+  return 0;
+}
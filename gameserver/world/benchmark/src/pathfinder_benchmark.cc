@@ -0,0 +1,159 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures Pathfinder on a 1024x1024 map where 15% of the tiles are not walkable:
+//  * typical: goal within the client viewport, like a player clicking on the map
+//  * long: goal 64 to 128 tiles away in both directions, like a click on the minimap
+//  * worst case: goal at max_distance that is walled in, so that the whole search window is expanded
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "pathfinder.h"
+#include "walkability_map.h"
+#include "position.h"
+#include "logger.h"
+
+namespace
+{
+
+constexpr int map_size = 1024;
+constexpr int z = 7;
+
+struct Search
+{
+  Position from;
+  Position to;
+};
+
+void run(const char* name, const WalkabilityMap& walkabilityMap, const std::vector<Search>& searches)
+{
+  Pathfinder pathfinder;
+  std::deque<Direction> path;
+  auto numberOfFound = 0;
+  std::size_t numberOfExpandedNodes = 0;
+  std::size_t totalPathLength = 0;
+
+  const auto start = std::chrono::steady_clock::now();
+  for (const auto& search : searches)
+  {
+    if (pathfinder.findPath(walkabilityMap, search.from, search.to, &path) == Pathfinder::Result::FOUND)
+    {
+      numberOfFound++;
+      totalPathLength += path.size();
+    }
+    numberOfExpandedNodes += pathfinder.getNumberOfExpandedNodes();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  const auto us = std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+
+  const auto numberOfSearches = static_cast<double>(searches.size());
+  printf("%-11s searches: %6d  found: %5.1f%%  avg path length: %6.1f  avg expanded nodes: %8.1f  "
+         "avg time: %8.2f us  (%5.1f ns per node)\n",
+         name,
+         static_cast<int>(searches.size()),
+         100.0 * numberOfFound / numberOfSearches,
+         numberOfFound > 0 ? static_cast<double>(totalPathLength) / numberOfFound : 0.0,
+         numberOfExpandedNodes / numberOfSearches,
+         us / numberOfSearches,
+         1000.0 * us / numberOfExpandedNodes);
+}
+
+}  // namespace
+
+int main()
+{
+  // Searches that are refused are logged as debug
+  Logger::setLevel(Logger::Module::WORLD, Logger::Level::INFO);
+
+  std::mt19937 random(1234);
+
+  WalkabilityMap walkabilityMap;
+  std::bernoulli_distribution blocked(0.15);
+  for (auto x = 0; x < map_size; x++)
+  {
+    for (auto y = 0; y < map_size; y++)
+    {
+      walkabilityMap.setWalkable(Position(x, y, z), !blocked(random));
+    }
+  }
+
+  // Returns a random walkable position at most maxOffset away from, but not at, position
+  const auto randomPosition = [&random, &walkabilityMap](const Position& position, int minOffset, int maxOffset)
+  {
+    std::uniform_int_distribution<int> offset(minOffset, maxOffset);
+    std::bernoulli_distribution negative(0.5);
+    while (true)
+    {
+      const auto x = position.getX() + (negative(random) ? -offset(random) : offset(random));
+      const auto y = position.getY() + (negative(random) ? -offset(random) : offset(random));
+      const Position result(x, y, z);
+      if (result != position && walkabilityMap.isWalkable(result))
+      {
+        return result;
+      }
+    }
+  };
+
+  std::uniform_int_distribution<int> center(Pathfinder::max_distance, map_size - Pathfinder::max_distance - 1);
+
+  std::vector<Search> typical;
+  for (auto i = 0; i < 100000; i++)
+  {
+    const Position from(center(random), center(random), z);
+    typical.push_back(Search{from, randomPosition(from, 0, 7)});
+  }
+
+  std::vector<Search> long_searches;
+  for (auto i = 0; i < 2000; i++)
+  {
+    const Position from(center(random), center(random), z);
+    long_searches.push_back(Search{from, randomPosition(from, 64, Pathfinder::max_distance)});
+  }
+
+  printf("Map: %dx%d tiles, 15%% not walkable\n", map_size, map_size);
+  run("typical", walkabilityMap, typical);
+  run("long", walkabilityMap, long_searches);
+
+  // Wall in the goals, this modifies the map so do these last
+  std::vector<Search> worst_case;
+  for (auto i = 0; i < 200; i++)
+  {
+    const Position from(center(random), center(random), z);
+    const Position to(from.getX() + Pathfinder::max_distance, from.getY() + Pathfinder::max_distance, z);
+    walkabilityMap.setWalkable(to, true);
+    walkabilityMap.setWalkable(Position(to.getX() - 1, to.getY(), z), false);
+    walkabilityMap.setWalkable(Position(to.getX() + 1, to.getY(), z), false);
+    walkabilityMap.setWalkable(Position(to.getX(), to.getY() - 1, z), false);
+    walkabilityMap.setWalkable(Position(to.getX(), to.getY() + 1, z), false);
+    worst_case.push_back(Search{from, to});
+  }
+
+  run("worst case", walkabilityMap, worst_case);
+
+  return 0;
+}
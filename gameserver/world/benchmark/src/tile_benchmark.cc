@@ -0,0 +1,188 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Measures the memory used per Tile, compared to the previous Tile layout
+// (two std::vectors), for a map where most tiles only have a ground item.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "tile.h"
+#include "item.h"
+
+namespace
+{
+
+// Counts all heap allocations done via operator new
+std::size_t number_of_allocations = 0;
+std::size_t allocated_bytes = 0;
+
+}  // namespace
+
+void* operator new(std::size_t size)
+{
+  number_of_allocations++;
+  allocated_bytes += size;
+  auto* ptr = std::malloc(size);
+  if (ptr == nullptr)
+  {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+  std::free(ptr);
+}
+
+namespace
+{
+
+// The previous Tile layout
+class LegacyTile
+{
+ public:
+  explicit LegacyTile(Item* groundItem)
+    : numberOfTopItems(0),
+      items_({groundItem})
+  {
+  }
+
+  void addCreature(CreatureId creatureId)
+  {
+    creatureIds_.insert(creatureIds_.begin(), creatureId);
+  }
+
+  void addItem(Item* item)
+  {
+    auto itemIt = items_.cbegin();
+    if (item->getItemType().alwaysOnTop)
+    {
+      std::advance(itemIt, 1);
+      numberOfTopItems++;
+    }
+    else
+    {
+      std::advance(itemIt, 1 + numberOfTopItems);
+    }
+    items_.insert(itemIt, item);
+  }
+
+  std::size_t getNumberOfThings() const
+  {
+    return items_.size() + creatureIds_.size();
+  }
+
+ private:
+  int numberOfTopItems;
+  std::vector<Item*> items_;
+  std::vector<CreatureId> creatureIds_;
+};
+
+// 90% of the tiles only have a ground item, 8% have one more item
+// and 2% have three more items and a creature
+template<typename T>
+void run(const char* name, int numberOfTiles, Item* groundItem, Item* topItem, Item* bottomItem)
+{
+  const auto allocationsBefore = number_of_allocations;
+  const auto bytesBefore = allocated_bytes;
+  const auto start = std::chrono::steady_clock::now();
+
+  std::vector<T> tiles;
+  tiles.reserve(numberOfTiles);
+  for (auto i = 0; i < numberOfTiles; i++)
+  {
+    tiles.emplace_back(groundItem);
+    if (i % 100 >= 90)
+    {
+      tiles.back().addItem(bottomItem);
+    }
+    if (i % 100 >= 98)
+    {
+      tiles.back().addItem(topItem);
+      tiles.back().addItem(bottomItem);
+      tiles.back().addCreature(i);
+    }
+  }
+
+  const auto built = std::chrono::steady_clock::now();
+
+  std::size_t numberOfThings = 0;
+  for (const auto& tile : tiles)
+  {
+    numberOfThings += tile.getNumberOfThings();
+  }
+
+  const auto end = std::chrono::steady_clock::now();
+
+  // Don't count the array of tiles itself
+  const auto allocationsPerTile = static_cast<double>(number_of_allocations - allocationsBefore - 1) / numberOfTiles;
+  const auto heapBytesPerTile = static_cast<double>(allocated_bytes - bytesBefore - (sizeof(T) * numberOfTiles)) /
+                                numberOfTiles;
+
+  // glibc malloc uses at least 32 bytes per allocation (16 bytes for small allocations + header)
+  const auto totalBytesPerTile = sizeof(T) + (allocationsPerTile * 32);
+
+  printf("%-12s sizeof: %3d  heap allocations: %4.2f  requested heap bytes: %5.2f  total (approx.): %6.2f  "
+         "build: %4d ms  scan: %3d ms  (%d things)\n",
+         name,
+         static_cast<int>(sizeof(T)),
+         allocationsPerTile,
+         heapBytesPerTile,
+         totalBytesPerTile,
+         static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(built - start).count()),
+         static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(end - built).count()),
+         static_cast<int>(numberOfThings));
+}
+
+}  // namespace
+
+int main()
+{
+  ItemType groundItemType;
+  groundItemType.ground = true;
+  ItemType topItemType;
+  topItemType.alwaysOnTop = true;
+  ItemType bottomItemType;
+
+  Item groundItem(0, &groundItemType);
+  Item topItem(0, &topItemType);
+  Item bottomItem(0, &bottomItemType);
+
+  const auto numberOfTiles = 2048 * 2048;
+  printf("Tiles: %d, all values are per tile\n", numberOfTiles);
+  run<LegacyTile>("LegacyTile", numberOfTiles, &groundItem, &topItem, &bottomItem);
+  run<Tile>("Tile", numberOfTiles, &groundItem, &topItem, &bottomItem);
+
+  return 0;
+}
@@ -0,0 +1,282 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+// Compares tile layouts on a 2048x2048 map: the flat column-major array that World used
+// to have, 16x16 blocks in column-major order, 16x16 blocks in Z-order (Morton order) and
+// the TileStore itself (16x16 sectors in column-major order, looked up via a sector cache
+// and a hash map).
+//
+// Two workloads are measured, both at random positions on the map:
+//  * rectangle scan: all tiles in a 18x14 rectangle, row by row
+//  * map slice serialization: the full 18x14 map and the 18x1 and 1x14 slices sent when
+//    a player moves, in the same order as Protocol71::addFloorData
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "tile.h"
+#include "tile_store.h"
+#include "item.h"
+#include "position.h"
+
+namespace
+{
+
+constexpr int map_size = 2048;
+constexpr int number_of_iterations = 200000;
+
+struct ColumnMajor
+{
+  static int index(int x, int y)
+  {
+    return (x * map_size) + y;
+  }
+};
+
+struct Blocked
+{
+  static int index(int x, int y)
+  {
+    const auto block = ((x >> 4) * (map_size >> 4)) + (y >> 4);
+    return (block << 8) + ((x & 15) << 4) + (y & 15);
+  }
+};
+
+struct BlockedMorton
+{
+  static int spreadBits(int value)
+  {
+    value = (value | (value << 2)) & 0x33;
+    value = (value | (value << 1)) & 0x55;
+    return value;
+  }
+
+  static int index(int x, int y)
+  {
+    const auto block = ((x >> 4) * (map_size >> 4)) + (y >> 4);
+    return (block << 8) + spreadBits(x & 15) + (spreadBits(y & 15) << 1);
+  }
+};
+
+// Gives each position a deterministic number of extra things, same as tile_benchmark:
+// 90% only ground, 8% one more item and 2% three more items and a creature
+template<typename AddItem, typename AddCreature>
+void populateTile(int x, int y, Item* topItem, Item* bottomItem, AddItem addItem, AddCreature addCreature)
+{
+  const auto n = static_cast<unsigned>(x * 7919 + y * 104729) % 100;
+  if (n >= 90)
+  {
+    addItem(bottomItem);
+  }
+  if (n >= 98)
+  {
+    addItem(topItem);
+    addItem(bottomItem);
+    addCreature(n);
+  }
+}
+
+// Flat array of tiles with the given layout
+template<typename Layout>
+class FlatMap
+{
+ public:
+  FlatMap(Item* groundItem, Item* topItem, Item* bottomItem)
+    : tiles_(map_size * map_size)
+  {
+    for (auto x = 0; x < map_size; x++)
+    {
+      for (auto y = 0; y < map_size; y++)
+      {
+        auto* tile = &tiles_[Layout::index(x, y)];
+        *tile = Tile(groundItem);
+        populateTile(x, y, topItem, bottomItem,
+                     [tile](Item* item) { tile->addItem(item); },
+                     [tile](CreatureId creatureId) { tile->addCreature(creatureId); });
+      }
+    }
+  }
+
+  const Tile* getTile(int x, int y) const
+  {
+    return &tiles_[Layout::index(x, y)];
+  }
+
+ private:
+  std::vector<Tile> tiles_;
+};
+
+class TileStoreMap
+{
+ public:
+  TileStoreMap(Item* groundItem, Item* topItem, Item* bottomItem)
+    : tileStore_()
+  {
+    for (auto x = 0; x < map_size; x++)
+    {
+      for (auto y = 0; y < map_size; y++)
+      {
+        Tile tile(groundItem);
+        populateTile(x, y, topItem, bottomItem,
+                     [&tile](Item* item) { tile.addItem(item); },
+                     [&tile](CreatureId creatureId) { tile.addCreature(creatureId); });
+        tileStore_.setTile(Position(x, y, 7), std::move(tile));
+      }
+    }
+  }
+
+  const Tile* getTile(int x, int y) const
+  {
+    return tileStore_.getTile(Position(x, y, 7));
+  }
+
+ private:
+  TileStore tileStore_;
+};
+
+template<typename Map>
+std::size_t scanRectangle(const Map& map, int x_min, int y_min, int width, int height)
+{
+  std::size_t numberOfThings = 0;
+  for (auto y = y_min; y < y_min + height; y++)
+  {
+    for (auto x = x_min; x < x_min + width; x++)
+    {
+      numberOfThings += map.getTile(x, y)->getNumberOfThings();
+    }
+  }
+  return numberOfThings;
+}
+
+template<typename Map>
+void serializeSlice(const Map& map, int x_min, int y_min, int width, int height, std::vector<std::uint8_t>* buffer)
+{
+  for (auto x = x_min; x < x_min + width; x++)
+  {
+    for (auto y = y_min; y < y_min + height; y++)
+    {
+      const auto* tile = map.getTile(x, y);
+      for (const auto* item : tile->getItems())
+      {
+        const auto itemTypeId = item->getItemTypeId();
+        buffer->push_back(itemTypeId);
+        buffer->push_back(itemTypeId >> 8);
+      }
+      for (const auto creatureId : tile->getCreatureIds())
+      {
+        buffer->push_back(creatureId);
+      }
+      buffer->push_back(0x00);
+      buffer->push_back(0xFF);
+    }
+  }
+}
+
+double millisecondsSince(const std::chrono::steady_clock::time_point& start)
+{
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0;
+}
+
+template<typename Map>
+void run(const char* name, Item* groundItem, Item* topItem, Item* bottomItem)
+{
+  const auto buildStart = std::chrono::steady_clock::now();
+  const Map map(groundItem, topItem, bottomItem);
+  const auto buildMs = millisecondsSince(buildStart);
+
+  // Same random positions for all layouts
+  std::mt19937 random(1234);
+  std::uniform_int_distribution<int> distribution(0, map_size - 18);
+  std::vector<std::pair<int, int>> positions;
+  positions.reserve(number_of_iterations);
+  for (auto i = 0; i < number_of_iterations; i++)
+  {
+    const auto x = distribution(random);
+    const auto y = distribution(random);
+    positions.emplace_back(x, y);
+  }
+
+  std::size_t numberOfThings = 0;
+  const auto scanStart = std::chrono::steady_clock::now();
+  for (const auto& position : positions)
+  {
+    numberOfThings += scanRectangle(map, position.first, position.second, 18, 14);
+  }
+  const auto scanMs = millisecondsSince(scanStart);
+
+  std::vector<std::uint8_t> buffer;
+  std::size_t numberOfBytes = 0;
+  const auto serializeStart = std::chrono::steady_clock::now();
+  for (const auto& position : positions)
+  {
+    buffer.clear();
+    serializeSlice(map, position.first, position.second, 18, 14, &buffer);  // Full map
+    serializeSlice(map, position.first, position.second, 18, 1, &buffer);   // North / south
+    serializeSlice(map, position.first, position.second, 1, 14, &buffer);   // East / west
+    numberOfBytes += buffer.size();
+  }
+  const auto serializeMs = millisecondsSince(serializeStart);
+
+  const auto tilesPerIteration = (18 * 14) + 18 + 14;
+  printf("%-14s build: %6.0f ms  rectangle scan: %7.1f ms (%6.1f Mtiles/s)  "
+         "serialization: %7.1f ms (%6.1f Mtiles/s)  (%d things, %d bytes)\n",
+         name,
+         buildMs,
+         scanMs,
+         (18.0 * 14.0 * number_of_iterations) / (scanMs * 1000.0),
+         serializeMs,
+         (static_cast<double>(tilesPerIteration) * number_of_iterations) / (serializeMs * 1000.0),
+         static_cast<int>(numberOfThings),
+         static_cast<int>(numberOfBytes));
+}
+
+}  // namespace
+
+int main()
+{
+  ItemType groundItemType;
+  groundItemType.id = 100;
+  groundItemType.ground = true;
+  ItemType topItemType;
+  topItemType.id = 200;
+  topItemType.alwaysOnTop = true;
+  ItemType bottomItemType;
+  bottomItemType.id = 300;
+
+  Item groundItem(0, &groundItemType);
+  Item topItem(0, &topItemType);
+  Item bottomItem(0, &bottomItemType);
+
+  printf("Map: %dx%d tiles, %d iterations at random positions\n", map_size, map_size, number_of_iterations);
+  run<FlatMap<ColumnMajor>>("ColumnMajor", &groundItem, &topItem, &bottomItem);
+  run<FlatMap<Blocked>>("Blocked", &groundItem, &topItem, &bottomItem);
+  run<FlatMap<BlockedMorton>>("BlockedMorton", &groundItem, &topItem, &bottomItem);
+  run<TileStoreMap>("TileStore", &groundItem, &topItem, &bottomItem);
+
+  return 0;
+}
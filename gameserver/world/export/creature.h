@@ -49,6 +49,10 @@ class Creature
 
   Creature();
   explicit Creature(const std::string& name);
+
+  // Recreates a creature with the id it had, e.g. in another process (see GameEngine::loadSnapshot)
+  // New creatures never get an id that is lower than this one
+  Creature(CreatureId creatureId, const std::string& name);
   virtual ~Creature() = default;
 
   bool operator==(const Creature& other) const;
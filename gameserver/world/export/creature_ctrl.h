@@ -26,6 +26,9 @@
 #define WORLD_EXPORT_CREATURE_CTRL_H_
 
 #include <string>
+#include <vector>
+
+#include "world_event.h"
 
 class WorldInterface;
 class Creature;
@@ -38,50 +41,74 @@ class CreatureCtrl
  public:
   virtual ~CreatureCtrl() = default;
 
+  // Called with the events that this creature could see, in the order that they happened
+  //
+  // World buffers the events and delivers them once per tick, see World::flushEvents, except
+  // for the creature's own spawn and moves and for tile updates. These are sent together with
+  // the current tiles, so they are delivered directly, after any buffered events. Despawns are
+  // also delivered directly, in a call of their own.
+  //
+  // The default implementation calls the functions below for each event, so implement either
+  // this function or the functions below. The functions below do nothing by default.
+  virtual void onWorldEvents(const WorldInterface& world_interface, const std::vector<WorldEvent>& events);
+
   // Called when the creature has spawned nearby this creature
   // Can be the creature itself that has spawned
   virtual void onCreatureSpawn(const WorldInterface& world_interface,
                                const Creature& creature,
-                               const Position& position) = 0;
+                               const Position& position);
 
   // Called when a creature has despawned nearby this creature
   virtual void onCreatureDespawn(const WorldInterface& world_interface,
                                  const Creature& creature,
                                  const Position& position,
-                                 int stackPos) = 0;
+                                 int stackPos);
 
-  // Called when a creature has moved
+  // Called when a creature has moved and this creature could see it both before
+  // and after the move
+  // Can be the creature itself that has moved
   virtual void onCreatureMove(const WorldInterface& world_interface,
                               const Creature& creature,
                               const Position& oldPosition,
                               int oldStackPos,
-                              const Position& newPosition) = 0;
+                              const Position& newPosition);
+
+  // Called when a creature has moved into the view of this creature
+  virtual void onCreatureEnterView(const WorldInterface& world_interface,
+                                   const Creature& creature,
+                                   const Position& position);
+
+  // Called when a creature has moved out of the view of this creature
+  virtual void onCreatureLeaveView(const WorldInterface& world_interface,
+                                   const Creature& creature,
+                                   const Position& oldPosition,
+                                   int oldStackPos);
 
   // Called when a creature has turned
   virtual void onCreatureTurn(const WorldInterface& world_interface,
                               const Creature& creature,
                               const Position& position,
-                              int stackPos) = 0;
+                              int stackPos);
 
   // Called when a creature says something
   virtual void onCreatureSay(const WorldInterface& world_interface,
                              const Creature& creature,
                              const Position& position,
-                             const std::string& message) = 0;
+                             const std::string& message);
 
   // Called when an Item was removed from a Tile
   virtual void onItemRemoved(const WorldInterface& world_interface,
                              const Position& position,
-                             int stackPos) = 0;
+                             int stackPos);
 
   // Called when an Item was added to a Tile
   virtual void onItemAdded(const WorldInterface& world_interface,
                            const Item& item,
-                           const Position& position) = 0;
+                           const Position& position);
 
   // Called when a Tile has been updated
   virtual void onTileUpdate(const WorldInterface& world_interface,
-                            const Position& position) = 0;
+                            const Position& position);
 };
 
 #endif  // WORLD_EXPORT_CREATURE_CTRL_H_
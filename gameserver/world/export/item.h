@@ -31,45 +31,34 @@
 using ItemUniqueId = std::uint64_t;
 using ItemTypeId = int;
 
-struct ItemType;
-
-class Item
+// Equipment category and slot of an ItemType, resolved from the type and position
+// attributes in items.xml when the item types are loaded
+enum class ItemCategory : std::uint8_t
 {
- public:
-  virtual ~Item() = default;
-
-  virtual ItemUniqueId getItemUniqueId() const = 0;
-  virtual ItemTypeId getItemTypeId() const = 0;
-
-  virtual const ItemType& getItemType() const = 0;
-
-  virtual int getCount() const = 0;
-  virtual void setCount(int count) = 0;
+  NONE,
+  ARMOR,
+  CONTAINER,
+  AMMO,
+  OTHER
 };
 
-struct ItemType
+enum class ItemSlot : std::uint8_t
 {
-  ItemTypeId id     = 0;
-
-  // Loaded from data file
-  bool ground       = false;
-  int  speed        = 0;
-  bool isBlocking   = false;
-  bool alwaysOnTop  = false;
-  bool isContainer  = false;
-  bool isStackable  = false;
-  bool isUsable     = false;
-  bool isMultitype  = false;
-  bool isNotMovable = false;
-  bool isEquipable  = false;
+  NONE,
+  HELMET,
+  AMULET,
+  BODY,
+  LEGS,
+  BOOTS,
+  RING,
+  OTHER
+};
 
-  // Loaded from xml file
+// Data that is rarely used (e.g. when looking at an item), kept apart from ItemType
+struct ItemTypeDetails
+{
   std::string name     = "";
-  int weight           = 0;
-  int decayto          = 0;
-  int decaytime        = 0;
   int damage           = 0;
-  int maxitems         = 0;
   std::string type     = "";
   std::string position = "";
   int attack           = 0;
@@ -77,9 +66,95 @@ struct ItemType
   int arm              = 0;
   std::string skill    = "";
   std::string descr    = "";
-  int handed           = 0;
   int shottype         = 0;
   std::string amutype  = "";
 };
 
+// The data that is used when items are moved and tiles are walked on, packed so
+// that the ItemTypes used by a tile share as few cache lines as possible
+struct ItemType
+{
+  ItemType()
+    : id(0),
+      ground(false),
+      isBlocking(false),
+      isBlockingProjectiles(false),
+      alwaysOnTop(false),
+      isContainer(false),
+      isStackable(false),
+      isUsable(false),
+      isMultitype(false),
+      isNotMovable(false),
+      isEquipable(false),
+      speed(0),
+      maxitems(0),
+      handed(0),
+      category(ItemCategory::NONE),
+      slot(ItemSlot::NONE),
+      weight(0),
+      decayto(0),
+      decaytime(0),
+      details(nullptr)
+  {
+  }
+
+  const ItemTypeDetails& getDetails() const
+  {
+    static const ItemTypeDetails noDetails;
+    return details ? *details : noDetails;
+  }
+
+  ItemTypeId id;
+
+  // Loaded from data file
+  bool ground                : 1;
+  bool isBlocking            : 1;
+  bool isBlockingProjectiles : 1;
+  bool alwaysOnTop           : 1;
+  bool isContainer           : 1;
+  bool isStackable           : 1;
+  bool isUsable              : 1;
+  bool isMultitype           : 1;
+  bool isNotMovable          : 1;
+  bool isEquipable           : 1;
+  std::uint16_t speed;
+
+  // Loaded from xml file
+  std::uint16_t maxitems;
+  std::uint8_t handed;
+  ItemCategory category;
+  ItemSlot slot;
+  int weight;
+  int decayto;
+  int decaytime;
+
+  // Owned by ItemManager, nullptr if there are no details
+  const ItemTypeDetails* details;
+};
+
+// Items are owned by ItemManager (gameengine), which hands out stable pointers to them
+class Item final
+{
+ public:
+  Item(ItemUniqueId itemUniqueId, const ItemType* itemType)
+    : itemUniqueId_(itemUniqueId),
+      itemType_(itemType),
+      count_(1)
+  {
+  }
+
+  ItemUniqueId getItemUniqueId() const { return itemUniqueId_; }
+  ItemTypeId getItemTypeId() const { return itemType_->id; }
+
+  const ItemType& getItemType() const { return *itemType_; }
+
+  int getCount() const { return count_; }
+  void setCount(int count) { count_ = count; }
+
+ private:
+  ItemUniqueId itemUniqueId_;
+  const ItemType* itemType_;
+  int count_;
+};
+
 #endif  // WORLD_EXPORT_ITEM_H_
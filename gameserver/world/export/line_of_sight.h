@@ -0,0 +1,111 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_LINE_OF_SIGHT_H_
+#define WORLD_EXPORT_LINE_OF_SIGHT_H_
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+#include "position.h"
+
+// Answers "can a projectile fly from this position to that position?", e.g. when a
+// creature throws an item or shoots at another creature.
+//
+// Like WalkabilityMap it keeps one bit per tile, maintained by World whenever a tile
+// changes, telling if projectiles can pass the tile: the tile exists and none of its
+// items block projectiles. Creatures never block projectiles.
+//
+// A ray is stepped from the center of the from tile to the center of the to tile with
+// integer (Bresenham) steps, and there is line of sight if the to tile and all tiles
+// between can be passed. The ray is also tried in the other direction, since the two
+// rays can take different tiles around corners.
+//
+// The same checks are often repeated (e.g. a monster checking its target every step),
+// so recent results are cached. Any change to a bit invalidates the whole cache.
+class LineOfSight
+{
+ public:
+  static constexpr int sector_bits = 4;
+  static constexpr int sector_size = 1 << sector_bits;
+
+  // Positions further away than this, in x or y, are never in line of sight
+  static constexpr int max_distance = 16;
+
+  static constexpr int cache_bits = 8;
+  static constexpr int cache_size = 1 << cache_bits;
+
+  LineOfSight()
+    : sectors_(),
+      version_(1),
+      cache_()
+  {
+  }
+
+  // Delete copy constructors
+  LineOfSight(const LineOfSight&) = delete;
+  LineOfSight& operator=(const LineOfSight&) = delete;
+
+  void setPassable(const Position& position, bool passable);
+  bool isPassable(const Position& position) const;
+
+  // Cached, see computeLineOfSight
+  bool hasLineOfSight(const Position& from, const Position& to) const;
+
+  // Not cached, false if the positions are on different floors or too far away
+  bool computeLineOfSight(const Position& from, const Position& to) const;
+
+ private:
+  // Bit (x & (sector_size - 1)) of row (y & (sector_size - 1))
+  using Sector = std::array<std::uint16_t, sector_size>;
+
+  // Steps the ray from (fromX, fromY) to (toX, toY) on floor z and checks the tiles between
+  bool isRayPassable(int fromX, int fromY, int toX, int toY, int z) const;
+
+  static bool isValid(const Position& position);
+  static std::uint64_t getSectorKey(int sectorX, int sectorY, int z);
+
+  std::unordered_map<std::uint64_t, Sector> sectors_;
+
+  // Incremented whenever a bit changes, cache entries with another version are invalid
+  std::uint32_t version_;
+
+  struct CacheEntry
+  {
+    CacheEntry()
+      : key(0),
+        version(0),
+        result(false)
+    {
+    }
+
+    std::uint64_t key;
+    std::uint32_t version;
+    bool result;
+  };
+  mutable std::array<CacheEntry, cache_size> cache_;
+};
+
+#endif  // WORLD_EXPORT_LINE_OF_SIGHT_H_
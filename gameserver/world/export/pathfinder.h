@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_PATHFINDER_H_
+#define WORLD_EXPORT_PATHFINDER_H_
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "direction.h"
+#include "position.h"
+
+class WalkabilityMap;
+
+// A* search over a WalkabilityMap, moving in the four directions that creatures can walk.
+//
+// The search is limited to a window around the start and goal positions, of which the
+// walkability bits are copied when the search is started. The storage for the window
+// and the search nodes is kept between searches, so a Pathfinder should be reused.
+//
+// A search can be done in several steps, see search, so that a long search can be spread
+// over several ticks.
+class Pathfinder
+{
+ public:
+  // Searches where the goal is further away than this (in either direction) are refused
+  static constexpr int max_distance = 128;
+
+  // How far outside of the rectangle spanned by the start and goal positions the search may go
+  static constexpr int search_margin = 16;
+
+  enum class Result
+  {
+    SEARCHING,
+    FOUND,
+    NOT_FOUND,
+  };
+
+  Pathfinder();
+
+  // Delete copy constructors
+  Pathfinder(const Pathfinder&) = delete;
+  Pathfinder& operator=(const Pathfinder&) = delete;
+
+  // Starts a new search, any previous search is discarded
+  // The goal position must be walkable, but the start position does not need to be
+  void start(const WalkabilityMap& walkabilityMap, const Position& from, const Position& to);
+
+  // Continues the current search and expands at most maxNodes nodes
+  // Returns SEARCHING if the search is not done yet
+  Result search(int maxNodes);
+
+  // Starts a search and runs it to completion
+  Result findPath(const WalkabilityMap& walkabilityMap,
+                  const Position& from,
+                  const Position& to,
+                  std::deque<Direction>* path);
+
+  // Returns the path of the last search, only valid if it returned FOUND
+  void getPath(std::deque<Direction>* path) const;
+
+  // Returns the number of nodes expanded by the current or last search
+  int getNumberOfExpandedNodes() const { return numberOfExpandedNodes_; }
+
+ private:
+  struct Node
+  {
+    // The node is only valid if generation is the same as generation_, so that the nodes
+    // don't need to be cleared for each search
+    std::uint32_t generation;
+    std::uint32_t cost;
+    Direction direction;  // The direction that was walked to reach this node
+    bool closed;
+  };
+
+  struct OpenNode
+  {
+    int x;
+    int y;
+  };
+
+  // x and y are relative to the search window, index is (y * width_) + x
+  int getHeuristic(int x, int y) const;
+  bool isWalkable(int index) const { return (walkable_[index / 64] >> (index % 64)) & 1u; }
+  void addOpenNode(int x, int y, int index, std::uint32_t cost, Direction direction);
+
+  // The search window
+  int x_;
+  int y_;
+  int width_;
+  int height_;
+
+  int startIndex_;
+  int goalX_;
+  int goalY_;
+  int goalIndex_;
+  Result result_;
+  int numberOfExpandedNodes_;
+
+  std::uint32_t generation_;
+  std::vector<std::uint64_t> walkable_;
+  std::vector<Node> nodes_;
+  // The open nodes, in buckets by estimated path length (cost + heuristic), see addOpenNode
+  std::vector<std::vector<OpenNode>> openBuckets_;
+  std::size_t numberOfOpenBuckets_;
+  std::size_t currentOpenBucket_;
+  int startEstimate_;
+};
+
+#endif  // WORLD_EXPORT_PATHFINDER_H_
@@ -0,0 +1,91 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_PATHFINDING_SERVICE_H_
+#define WORLD_EXPORT_PATHFINDING_SERVICE_H_
+
+#include <deque>
+#include <functional>
+
+#include "creature.h"
+#include "direction.h"
+#include "pathfinder.h"
+#include "position.h"
+
+class WalkabilityMap;
+
+// Queue of path requests, e.g. from players clicking on the map or from monsters.
+//
+// Requests are handled in order by a single Pathfinder, and process is called once per
+// tick with a budget of nodes to expand, so that long searches are spread over several
+// ticks instead of stalling the game engine.
+class PathfindingService
+{
+ public:
+  // Called with the path if found, or with an empty path if not found
+  using Callback = std::function<void(bool found, std::deque<Direction>&& path)>;
+
+  explicit PathfindingService(const WalkabilityMap* walkabilityMap)
+    : walkabilityMap_(walkabilityMap),
+      pathfinder_(),
+      requests_(),
+      searching_(false)
+  {
+  }
+
+  // Delete copy constructors
+  PathfindingService(const PathfindingService&) = delete;
+  PathfindingService& operator=(const PathfindingService&) = delete;
+
+  // Replaces any pending request from the same creature
+  void requestPath(CreatureId creatureId, const Position& from, const Position& to, const Callback& callback);
+
+  // The callback of a canceled request is not called
+  void cancel(CreatureId creatureId);
+
+  bool hasRequests() const { return !requests_.empty(); }
+  bool hasRequest(CreatureId creatureId) const;
+
+  // Expands at most maxNodes nodes in total, and calls the callback of each request that finished
+  // Returns the number of expanded nodes
+  int process(int maxNodes);
+
+ private:
+  struct Request
+  {
+    CreatureId creatureId;
+    Position from;
+    Position to;
+    Callback callback;
+  };
+
+  const WalkabilityMap* walkabilityMap_;
+  Pathfinder pathfinder_;
+  std::deque<Request> requests_;
+
+  // True if the first request has been started in pathfinder_
+  bool searching_;
+};
+
+#endif  // WORLD_EXPORT_PATHFINDING_SERVICE_H_
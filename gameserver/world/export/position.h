@@ -33,8 +33,19 @@ class Position
  public:
   static const Position INVALID;
 
-  Position();
-  Position(int x, int y, int z);
+  Position()
+    : x_(0),
+      y_(0),
+      z_(0)
+  {
+  }
+
+  Position(int x, int y, int z)
+    : x_(x),
+      y_(y),
+      z_(z)
+  {
+  }
 
   bool operator==(const Position& other) const;
   bool operator!=(const Position& other) const;
@@ -0,0 +1,93 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_SECTOR_GRID_H_
+#define WORLD_EXPORT_SECTOR_GRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "creature.h"
+#include "position.h"
+
+// Spatial index of Creatures, used to answer "which creatures are near this position?"
+// without probing every Tile in the area.
+//
+// The world is divided into sectors of sector_size x sector_size tiles (per floor), and
+// each sector holds the CreatureIds and Positions of all creatures standing in it.
+// The cost of a query is proportional to the number of sectors touched and the number of
+// creatures in them, not to the area being queried.
+class SectorGrid
+{
+ public:
+  static constexpr int sector_bits = 3;
+  static constexpr int sector_size = 1 << sector_bits;
+
+  SectorGrid()
+    : sectors_()
+  {
+  }
+
+  // Delete copy constructors
+  SectorGrid(const SectorGrid&) = delete;
+  SectorGrid& operator=(const SectorGrid&) = delete;
+
+  void addCreature(CreatureId creatureId, const Position& position);
+  bool removeCreature(CreatureId creatureId, const Position& position);
+  bool moveCreature(CreatureId creatureId, const Position& fromPosition, const Position& toPosition);
+
+  // Returns the CreatureIds of all creatures in the given rectangle (inclusive) on floor z
+  std::vector<CreatureId> getCreatureIds(int x_min, int y_min, int x_max, int y_max, int z) const;
+
+  // Same as above but appends to the given vector, so that callers can reuse it
+  void getCreatureIds(int x_min, int y_min, int x_max, int y_max, int z, std::vector<CreatureId>* creatureIds) const;
+
+  // The number of sectors with at least one creature
+  std::size_t getNumberOfSectors() const { return sectors_.size(); }
+
+ private:
+  struct Entry
+  {
+    Entry(CreatureId creatureId, const Position& position)
+      : creatureId(creatureId),
+        position(position)
+    {
+    }
+
+    CreatureId creatureId;
+    Position position;
+  };
+  using Sector = std::vector<Entry>;
+
+  // Note: positions are never negative, so shifting is the same as dividing by sector_size
+  static int toSectorCoordinate(int coordinate) { return coordinate >> sector_bits; }
+  static std::uint64_t getSectorKey(int sectorX, int sectorY, int z);
+  static std::uint64_t getSectorKey(const Position& position);
+
+  std::unordered_map<std::uint64_t, Sector> sectors_;
+};
+
+#endif  // WORLD_EXPORT_SECTOR_GRID_H_
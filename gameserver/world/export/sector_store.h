@@ -0,0 +1,51 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_SECTOR_STORE_H_
+#define WORLD_EXPORT_SECTOR_STORE_H_
+
+#include <vector>
+
+#include "position.h"
+#include "tile.h"
+
+// Backing store for sectors of tiles that are paged out from TileStore.
+//
+// The tiles are given in the same order as TileStore keeps them, and position is the
+// north-west corner of the sector.
+class SectorStore
+{
+ public:
+  virtual ~SectorStore() = default;
+
+  // Writes the tiles to the store and releases everything they own
+  // Returns false if the sector could not be stored, in which case the tiles are left untouched
+  virtual bool storeSector(const Position& position, const std::vector<Tile>& tiles) = 0;
+
+  // Reads the tiles that was stored for the sector at position, tiles is already sized
+  // Returns false if the sector could not be read
+  virtual bool loadSector(const Position& position, std::vector<Tile>* tiles) = 0;
+};
+
+#endif  // WORLD_EXPORT_SECTOR_STORE_H_
@@ -25,20 +25,41 @@
 #ifndef WORLD_EXPORT_TILE_H_
 #define WORLD_EXPORT_TILE_H_
 
-#include <vector>
+#include <cstdint>
 
 #include "item.h"
 #include "creature.h"
+#include "small_vector.h"
 
+// A Tile is a stack of things, by stack position:
+//   ground item (0), top items, creatures, bottom items
+//
+// The items are stored as [ground, top items..., bottom items...] and the creatures
+// separately, so a stack position maps to an index with simple arithmetic.
+// Both are stored inline for the common case of a few things, so a Tile with
+// only a ground item does not allocate any memory.
+//
+// The attributes that are checked on every step (blocking, creatures, ground speed, ...)
+// are cached in a packed flags word that is updated when things are added or removed.
 class Tile
 {
  public:
-  explicit Tile(Item* groundItem)
-    : numberOfTopItems(0),
-      items_({groundItem})
+  using Items = SmallVector<Item*, 2>;
+  using CreatureIds = SmallVector<CreatureId, 2>;
+
+  // The client can only show this many things (ground + 9 items / creatures) per tile
+  static constexpr int max_visible_things = 10;
+
+  // Creates a tile without any ground, i.e. a position on a floor where there is no tile
+  Tile()
+    : items_(),
+      creatureIds_(),
+      flags_()
   {
   }
 
+  explicit Tile(Item* groundItem);
+
   // Delete copy constructors
   Tile(const Tile&) = delete;
   Tile& operator=(const Tile&) = delete;
@@ -51,7 +72,7 @@ class Tile
   void addCreature(CreatureId creatureId);
   bool removeCreature(CreatureId creatureId);
   CreatureId getCreatureId(int stackPosition) const;
-  const std::vector<CreatureId>& getCreatureIds() const { return creatureIds_; }
+  const CreatureIds& getCreatureIds() const { return creatureIds_; }
   int getCreatureStackPos(CreatureId creatureId) const;
 
   // Items
@@ -59,16 +80,50 @@ class Tile
   bool removeItem(ItemTypeId itemTypeId, int stackPosition);
   const Item* getItem(int stackPosition) const;
   Item* getItem(int stackPosition);
-  const std::vector<Item*>& getItems() const { return items_; }
+  const Items& getItems() const { return items_; }
 
   // Other
   std::size_t getNumberOfThings() const;
-  int getGroundSpeed() const;
+  int getGroundSpeed() const { return flags_.groundSpeed; }
+
+  // Cached attributes
+  bool isBlocking() const { return flags_.numberOfBlockingItems > 0; }
+  bool hasCreatures() const { return flags_.hasCreatures; }
+  bool isWalkable() const { return !isBlocking() && !hasCreatures(); }
+  bool isBlockingProjectiles() const { return flags_.numberOfProjectileBlockingItems > 0; }
+
+  // True if the tile has more things than the client can show, i.e. the client does not know
+  // about all things and needs the whole tile when something is removed from it
+  bool needsFullUpdate() const { return flags_.needsFullUpdate; }
 
  private:
-  int numberOfTopItems;
-  std::vector<Item*> items_;
-  std::vector<CreatureId> creatureIds_;
+  // Returns the index in items_ of the Item at stackPosition, or -1 if there is no Item there
+  int getItemIndex(int stackPosition) const;
+
+  void updateThingFlags();
+
+  Items items_;
+  CreatureIds creatureIds_;
+
+  struct Flags
+  {
+    Flags()
+      : groundSpeed(0),
+        numberOfTopItems(0),
+        numberOfBlockingItems(0),
+        numberOfProjectileBlockingItems(0),
+        hasCreatures(0),
+        needsFullUpdate(0)
+    {
+    }
+
+    std::uint32_t groundSpeed                     : 12;
+    std::uint32_t numberOfTopItems                : 8;
+    std::uint32_t numberOfBlockingItems           : 8;
+    std::uint32_t numberOfProjectileBlockingItems : 8;
+    std::uint32_t hasCreatures                    : 1;
+    std::uint32_t needsFullUpdate                 : 1;
+  } flags_;
 };
 
 #endif  // WORLD_EXPORT_TILE_H_
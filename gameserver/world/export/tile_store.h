@@ -0,0 +1,232 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_TILE_STORE_H_
+#define WORLD_EXPORT_TILE_STORE_H_
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "position.h"
+#include "tile.h"
+
+class SectorStore;
+
+// Storage of all Tiles in the World.
+//
+// The world is divided into sectors of sector_size x sector_size tiles (per floor), and a
+// sector is only allocated when a tile in it is set, so memory usage follows the
+// actual map instead of the bounding rectangle of it. As tiles are stored per sector, a
+// rectangle of tiles is kept in a few blocks of memory instead of one block per column.
+//
+// If a SectorStore is set, sectors that are not marked as in use can be paged out to it.
+// A paged out sector is paged in again as soon as any of its tiles are accessed,
+// so paging is transparent to users of the TileStore.
+class TileStore
+{
+ public:
+  static constexpr int sector_bits = 4;
+  static constexpr int sector_size = 1 << sector_bits;
+
+  // One bit per tile in a sector, indexed by getTileIndex
+  using SectorBits = std::bitset<sector_size * sector_size>;
+
+  TileStore()
+    : sectors_(),
+      sectorStore_(nullptr),
+      sectorCache_()
+  {
+  }
+
+  // Delete copy constructors
+  TileStore(const TileStore&) = delete;
+  TileStore& operator=(const TileStore&) = delete;
+
+  void setSectorStore(SectorStore* sectorStore) { sectorStore_ = sectorStore; }
+
+  void setTile(const Position& position, Tile&& tile);
+
+  // Adds a sector that is only in the SectorStore, so that it is paged in the first time
+  // any of its tiles are accessed. Position is the north-west corner of the sector.
+  void addPagedOutSector(const Position& position);
+
+  // Returns nullptr if there is no tile at the given position
+  // Defined here so that it can be inlined, it is called for every tile in every map description
+  Tile* getTile(const Position& position)
+  {
+    // Reuse the const version, the tile itself is not const
+    return const_cast<Tile*>(static_cast<const TileStore*>(this)->getTile(position));
+  }
+
+  const Tile* getTile(const Position& position) const
+  {
+    if (!isValid(position))
+    {
+      return nullptr;
+    }
+
+    const auto* tiles = getSectorTiles(toSectorCoordinate(position.getX()),
+                                       toSectorCoordinate(position.getY()),
+                                       position.getZ());
+    if (!tiles)
+    {
+      return nullptr;
+    }
+
+    const auto& tile = tiles[getTileIndex(position)];
+    if (tile.getItems().empty())
+    {
+      // No ground, so no tile here
+      return nullptr;
+    }
+    return &tile;
+  }
+
+  // Pages in all sectors overlapping the given rectangle (inclusive) on floor z
+  void pageIn(int x_min, int y_min, int x_max, int y_max, int z);
+
+  // Marks all sectors overlapping the given rectangle (inclusive) on floor z as in use
+  void markInUse(int x_min, int y_min, int x_max, int y_max, int z);
+
+  // Pages out all resident sectors that are not marked as in use and clears the marks
+  // Returns the number of sectors that were paged out
+  int pageOut();
+
+  // Marks the sector of the tile at position as modified, see forEachModifiedTile
+  void markModified(const Position& position);
+
+  // Calls f for each tile with a ground in the sectors marked as modified, paging them in as needed
+  void forEachModifiedTile(const std::function<void(const Position&, const Tile&)>& f);
+
+  std::size_t getNumberOfSectors() const { return sectors_.size(); }
+  std::size_t getNumberOfResidentSectors() const;
+
+  // Index of the tile at position within its sector
+  static int getTileIndex(const Position& position)
+  {
+    // Column-major order within the sector, same order as map data is sent to the client
+    // A sector is only 256 tiles so any order keeps a viewport within a few pages,
+    // and Z-order was measured to be slower, see tile_layout_benchmark
+    return ((position.getX() & (sector_size - 1)) << sector_bits) | (position.getY() & (sector_size - 1));
+  }
+
+ private:
+  struct Sector
+  {
+    Sector()
+      : tiles(sector_size * sector_size),
+        paged_out(false),
+        in_use(false),
+        modified(false)
+    {
+    }
+
+    // Empty when paged out
+    std::vector<Tile> tiles;
+    bool paged_out;
+    bool in_use;
+
+    // See markModified, kept when paged out
+    bool modified;
+  };
+
+  // Returns nullptr if the sector does not exist or could not be paged in
+  Tile* getSectorTiles(int sectorX, int sectorY, int z) const
+  {
+    const auto& cachedSector = sectorCache_[getSectorCacheIndex(sectorX, sectorY)];
+    if (cachedSector.key == getSectorKey(sectorX, sectorY, z))
+    {
+      return cachedSector.tiles;
+    }
+
+    auto* sector = getSector(sectorX, sectorY, z);
+    return sector ? sector->tiles.data() : nullptr;
+  }
+
+  Sector* getSector(int sectorX, int sectorY, int z) const;
+  bool pageInSector(int sectorX, int sectorY, int z, Sector* sector) const;
+
+  static bool isValid(const Position& position)
+  {
+    // Same limits as the protocol, 16 bits for x and y, 8 bits for z
+    return position.getX() >= 0 &&
+           position.getX() < (1 << 16) &&
+           position.getY() >= 0 &&
+           position.getY() < (1 << 16) &&
+           position.getZ() >= 0 &&
+           position.getZ() < (1 << 8);
+  }
+
+  static int toSectorCoordinate(int coordinate) { return coordinate >> sector_bits; }
+
+  // Position of the north-west corner of the sector, see getSectorKey
+  static Position getSectorPosition(std::uint64_t key)
+  {
+    return Position(static_cast<std::int32_t>(key >> 32) << sector_bits,
+                    static_cast<std::uint16_t>(key >> 16) << sector_bits,
+                    static_cast<std::uint16_t>(key));
+  }
+
+  static int getSectorCacheIndex(int sectorX, int sectorY)
+  {
+    return (sectorX & sector_cache_mask) | ((sectorY & sector_cache_mask) << sector_cache_bits);
+  }
+
+
+  static std::uint64_t getSectorKey(int sectorX, int sectorY, int z)
+  {
+    return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(sectorX)) << 32) |
+           (static_cast<std::uint64_t>(static_cast<std::uint16_t>(sectorY)) << 16) |
+            static_cast<std::uint64_t>(static_cast<std::uint16_t>(z));
+  }
+
+  // Paging in is done on access, also from const functions
+  mutable std::unordered_map<std::uint64_t, Sector> sectors_;
+  SectorStore* sectorStore_;
+
+  // Direct-mapped cache of the tiles of recently accessed resident sectors, indexed by the
+  // lowest bits of the sector coordinates so that all sectors overlapping a viewport are cached
+  // at the same time. This avoids a hash map lookup and two dependent loads for each tile.
+  // The cache is cleared when sectors are paged out, as that is when the tiles are released.
+  static constexpr int sector_cache_bits = 2;
+  static constexpr int sector_cache_mask = (1 << sector_cache_bits) - 1;
+  struct CachedSector
+  {
+    CachedSector()
+      : key(~static_cast<std::uint64_t>(0)),
+        tiles(nullptr)
+    {
+    }
+
+    std::uint64_t key;
+    Tile* tiles;
+  };
+  mutable std::array<CachedSector, 1 << (sector_cache_bits * 2)> sectorCache_;
+};
+
+#endif  // WORLD_EXPORT_TILE_STORE_H_
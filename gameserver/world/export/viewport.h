@@ -0,0 +1,125 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_VIEWPORT_H_
+#define WORLD_EXPORT_VIEWPORT_H_
+
+#include "position.h"
+
+// The area around a creature that it can see.
+//
+// Note: client displays 15x11 tiles, but it know about 18x14 tiles.
+//
+//       Client know about one extra row north, one extra column west
+//       two extra rows south and two extra rows east.
+//
+//     00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15 16 17 18
+//     ________________________________________________________
+// 00 |   _______________________________________________      |
+// 01 |  |                                               |     |
+// 02 |  |                                               |     |
+// 03 |  |                                               |     |
+// 04 |  |                                               |     |
+// 05 |  |                                               |     |
+// 06 |  |                                               |     |
+// 07 |  |                                               |     |
+// 08 |  |                                               |     |
+// 09 |  |                                               |     |
+// 10 |  |                                               |     |
+// 11 |  |                                               |     |
+// 12 |  |_______________________________________________|     |
+// 13 |                                                        |
+// 14 |________________________________________________________|
+//
+// A creature at (x, y) knows about (x - west, y - north) to (x + east, y + south).
+// The other way around, a position (x, y) is known by all creatures standing
+// at (x - east, y - south) to (x + west, y + north), which is what World uses
+// to find out "who can see this?".
+//
+// Floors: a creature above ground (z <= 7) knows about all floors above ground,
+//         a creature underground knows about the floors two levels above and below it.
+//         Floors are drawn with a diagonal offset, one tile north-west for each
+//         floor above the creature (and one tile south-east for each floor below).
+struct Viewport
+{
+  static constexpr int west  = 8;
+  static constexpr int east  = 9;
+  static constexpr int north = 6;
+  static constexpr int south = 7;
+
+  static constexpr int width  = west + 1 + east;
+  static constexpr int height = north + 1 + south;
+
+  static constexpr int highest_floor = 0;
+  static constexpr int ground_floor = 7;
+  static constexpr int lowest_floor = 15;
+  static constexpr int underground_floor_range = 2;
+
+  // Returns the highest (lowest z) floor that is known by a creature on floor viewerZ
+  static int getHighestVisibleFloor(int viewerZ)
+  {
+    return viewerZ <= ground_floor ? highest_floor : viewerZ - underground_floor_range;
+  }
+
+  // Returns the lowest (highest z) floor that is known by a creature on floor viewerZ
+  static int getLowestVisibleFloor(int viewerZ)
+  {
+    if (viewerZ <= ground_floor)
+    {
+      return ground_floor;
+    }
+    return viewerZ + underground_floor_range < lowest_floor ? viewerZ + underground_floor_range : lowest_floor;
+  }
+
+  // Returns true if floor z is known by a creature on floor viewerZ
+  static bool canSeeFloor(int viewerZ, int z)
+  {
+    return z >= getHighestVisibleFloor(viewerZ) && z <= getLowestVisibleFloor(viewerZ);
+  }
+
+  // Returns the diagonal offset that floor z is drawn with, for a creature on floor viewerZ
+  static int getFloorOffset(int viewerZ, int z)
+  {
+    return viewerZ - z;
+  }
+
+  // Returns true if position is known by a creature standing at viewerPosition
+  static bool canSee(const Position& viewerPosition, const Position& position)
+  {
+    if (!canSeeFloor(viewerPosition.getZ(), position.getZ()))
+    {
+      return false;
+    }
+
+    const auto offset = getFloorOffset(viewerPosition.getZ(), position.getZ());
+    return position.getX() >= viewerPosition.getX() - west  + offset &&
+           position.getX() <= viewerPosition.getX() + east  + offset &&
+           position.getY() >= viewerPosition.getY() - north + offset &&
+           position.getY() <= viewerPosition.getY() + south + offset;
+  }
+};
+
+static_assert(Viewport::width == 18 && Viewport::height == 14, "The client expects a 18x14 map");
+
+#endif  // WORLD_EXPORT_VIEWPORT_H_
@@ -0,0 +1,73 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_WALKABILITY_MAP_H_
+#define WORLD_EXPORT_WALKABILITY_MAP_H_
+
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "position.h"
+
+// One bit per tile telling if a creature can walk onto the tile, maintained by World
+// whenever a tile changes. Used for pathfinding, so that searches don't need to touch
+// the tiles (which may be paged out) or their items.
+//
+// Like TileStore the bits are allocated per sector, 32 bytes per sector per floor.
+// Positions without a tile are not walkable.
+class WalkabilityMap
+{
+ public:
+  static constexpr int sector_bits = 4;
+  static constexpr int sector_size = 1 << sector_bits;
+
+  WalkabilityMap()
+    : sectors_()
+  {
+  }
+
+  // Delete copy constructors
+  WalkabilityMap(const WalkabilityMap&) = delete;
+  WalkabilityMap& operator=(const WalkabilityMap&) = delete;
+
+  void setWalkable(const Position& position, bool walkable);
+  bool isWalkable(const Position& position) const;
+
+  // Copies the bits of the rectangle starting at (x, y) on floor z to bits, row by row,
+  // so that the bit for (x + i, y + j) is bit (j * width + i)
+  void copyRectangle(int x, int y, int z, int width, int height, std::vector<std::uint64_t>* bits) const;
+
+ private:
+  // Bit (x & (sector_size - 1)) of row (y & (sector_size - 1))
+  using Sector = std::array<std::uint16_t, sector_size>;
+
+  static bool isValid(const Position& position);
+  static std::uint64_t getSectorKey(int sectorX, int sectorY, int z);
+
+  std::unordered_map<std::uint64_t, Sector> sectors_;
+};
+
+#endif  // WORLD_EXPORT_WALKABILITY_MAP_H_
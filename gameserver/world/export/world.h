@@ -25,6 +25,9 @@
 #ifndef WORLD_EXPORT_WORLD_H_
 #define WORLD_EXPORT_WORLD_H_
 
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -36,11 +39,17 @@
 #include "item.h"
 #include "tile.h"
 #include "position.h"
+#include "sector_grid.h"
+#include "tile_store.h"
+#include "walkability_map.h"
+#include "line_of_sight.h"
+#include "world_event.h"
 
 class World : public WorldInterface
 {
  public:
   static constexpr int position_offset = 192;
+  static constexpr int number_of_floors = 16;
 
   enum class ReturnCode
   {
@@ -55,6 +64,11 @@ class World : public WorldInterface
     OTHER_ERROR,
   };
 
+  // Creates a world without any tiles, use setTile to add them
+  World();
+
+  // Creates a world with worldSizeX * worldSizeY tiles on the ground floor, starting at
+  // (position_offset, position_offset) and given in column-major order
   World(int worldSizeX,
         int worldSizeY,
         std::vector<Tile>&& tiles);
@@ -63,8 +77,29 @@ class World : public WorldInterface
   World(const World&) = delete;
   World& operator=(const World&) = delete;
 
+  // Tile management
+  void setTile(const Position& position, Tile&& tile);
+
+  // Delivers the buffered events to the creatures that could see them, one call per creature,
+  // see CreatureCtrl::onWorldEvents. Should be called once per tick.
+  void flushEvents();
+
+  // Paging of sectors that no creature is near, see TileStore
+  void setSectorStore(SectorStore* sectorStore) { tile_store_.setSectorStore(sectorStore); }
+  int pageOutSectors();
+
+  // Adds a sector that is only in the SectorStore and is paged in when first accessed, see
+  // TileStore::addPagedOutSector. The walkability and line of sight bits of its tiles are
+  // given up front, so that pathfinding and line of sight work before it is paged in.
+  void addPagedOutSector(const Position& position,
+                         const TileStore::SectorBits& walkable,
+                         const TileStore::SectorBits& passable);
+
   // Creature management
   ReturnCode addCreature(Creature* creature, CreatureCtrl* creatureCtrl, const Position& position);
+  // Adds a creature exactly at the given position without telling any creature about it, for
+  // creatures whose clients already know about them (see GameEngine::loadSnapshot)
+  ReturnCode restoreCreature(Creature* creature, CreatureCtrl* creatureCtrl, const Position& position);
   void removeCreature(CreatureId creatureId);
   bool creatureExists(CreatureId creatureId) const;
   ReturnCode creatureMove(CreatureId creatureId, Direction direction);
@@ -84,6 +119,17 @@ class World : public WorldInterface
                       const Position& toPosition);
   Item* getItem(const Position& position, int stackPosition);
 
+  // Calls f for each tile in the sectors where items have been added, removed or accessed by
+  // getItem (and may have been changed) since the world was loaded, paging them in as needed.
+  // Creatures on the tiles are not part of the state that is saved this way.
+  void forEachModifiedTile(const std::function<void(const Position&, const Tile&)>& f);
+  // Replaces the tile with one that was saved from forEachModifiedTile, its sector stays modified
+  void restoreTile(const Position& position, Tile&& tile);
+
+  // Walkability of all tiles, kept up to date as tiles change, see Pathfinder
+  const WalkabilityMap& getWalkabilityMap() const { return walkability_map_; }
+  const LineOfSight& getLineOfSight() const { return line_of_sight_; }
+
   // Creature checks
   bool creatureCanThrowTo(CreatureId creatureId, const Position& position) const;
   bool creatureCanReach(CreatureId creatureId, const Position& position) const;
@@ -95,21 +141,40 @@ class World : public WorldInterface
 
  private:
   // Helper functions
+  // Returns the creatures that can see the given position
   std::vector<CreatureId> getCreatureIdsThatCanSeePosition(const Position& position) const;
+  // Returns the creatures that a creature standing at the given position can see
+  std::vector<CreatureId> getVisibleCreatureIds(const Position& viewerPosition) const;
+  // Pages in the sectors around a creature at the given position, see pageOutSectors
+  void pageInSectorsAround(const Position& position);
+  // Buffers an event for the given creature, see flushEvents
+  void queueEvent(CreatureId creatureId, const WorldEvent& event);
+  // Delivers the buffered events of a single creature, before an event that must be delivered directly
+  void flushEvents(CreatureId creatureId);
+  // Buffers an event for all creatures that can see the position
+  void queueItemAdded(const Item& item, const Position& position);
+  void queueItemRemoved(const Position& position, int stackPos);
+  // Delivers a tile update to all creatures that can see the position
+  void queueTileUpdate(const Position& position);
+  // Must be called whenever items or creatures are added to or removed from a tile,
+  // updates the walkability and line of sight bits of the tile
+  void updateTileBits(const Position& position, const Tile* tile);
 
   // Functions to use instead of accessing the containers directly
   Tile* internalGetTile(const Position& position);
   Creature& internalGetCreature(CreatureId creatureId);
-  CreatureCtrl& getCreatureCtrl(CreatureId creatureId);
 
-  // World size
-  int worldSizeX_;
-  int worldSizeY_;
+  // All tiles, allocated per sector and paged out when no creature is near
+  TileStore tile_store_;
 
-  // Column-major order, due to how map blocks are sent to client
-  // No z axis yet
-  // index = (((x - position_offset) * worldSizeY_) + (y - position_offset))
-  std::vector<Tile> tiles_;
+  // One bit per tile, true if the tile exists and is walkable
+  WalkabilityMap walkability_map_;
+
+  // One bit per tile, true if the tile exists and projectiles can pass it
+  LineOfSight line_of_sight_;
+
+  // Spatial index of all creatures, used for spectator queries
+  SectorGrid sector_grid_;
 
   struct CreatureData
   {
@@ -118,15 +183,38 @@ class World : public WorldInterface
                  const Position& position)
       : creature(creature),
         creature_ctrl(creature_ctrl),
-        position(position)
+        position(position),
+        visible_creature_ids(),
+        events(),
+        observer_ids(),
+        observer_generation(0)
     {
     }
 
     Creature* creature;
     CreatureCtrl* creature_ctrl;
     Position position;
+
+    // The creatures that this creature can see (not including itself)
+    // Used to know if a moving creature enters, leaves or moves within this creature's view
+    std::vector<CreatureId> visible_creature_ids;
+
+    // The events that this creature has seen since the last flushEvents
+    std::vector<WorldEvent> events;
+
+    // Creatures that have buffered events about this creature
+    // Only valid when observer_generation equals event_generation_
+    std::vector<CreatureId> observer_ids;
+    std::uint64_t observer_generation;
   };
   std::unordered_map<CreatureId, CreatureData> creature_data_;
+
+  // The creatures that have buffered events, and the messages of the buffered CREATURE_SAY events
+  std::vector<CreatureId> creature_ids_with_events_;
+  std::deque<std::string> event_messages_;
+
+  // Incremented by flushEvents, see CreatureData::observer_generation
+  std::uint64_t event_generation_;
 };
 
 #endif  // WORLD_EXPORT_WORLD_H_
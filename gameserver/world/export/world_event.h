@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef WORLD_EXPORT_WORLD_EVENT_H_
+#define WORLD_EXPORT_WORLD_EVENT_H_
+
+#include <cstdint>
+#include <string>
+
+#include "creature.h"
+#include "item.h"
+#include "position.h"
+
+// Something that happened in the World that a creature could see, see CreatureCtrl::onWorldEvents
+//
+// Events only store ids and values, the creatures are looked up when the events are delivered.
+// World makes sure that all events about a creature have been delivered before it is removed,
+// and that all events have been delivered before items are paged out.
+struct WorldEvent
+{
+  enum class Type : std::uint8_t
+  {
+    CREATURE_SPAWN,
+    CREATURE_DESPAWN,
+    CREATURE_MOVE,
+    CREATURE_ENTER_VIEW,
+    CREATURE_LEAVE_VIEW,
+    CREATURE_TURN,
+    CREATURE_SAY,
+    ITEM_REMOVED,
+    ITEM_ADDED,
+    TILE_UPDATE,
+  };
+
+  Type type                  = Type::TILE_UPDATE;
+
+  // The stack position at position before the event, for CREATURE_DESPAWN, CREATURE_MOVE,
+  // CREATURE_LEAVE_VIEW, CREATURE_TURN and ITEM_REMOVED
+  int stackPos               = 0;
+
+  // CREATURE_* events
+  CreatureId creatureId      = Creature::INVALID_ID;
+
+  // The position where it happened, the old position for CREATURE_MOVE and CREATURE_LEAVE_VIEW
+  Position position          = Position();
+
+  // CREATURE_MOVE
+  Position newPosition       = Position();
+
+  // ITEM_ADDED, a copy of the Item (its ItemType and count) as it was when it was added, since
+  // the Item may be removed and destroyed before the event is delivered
+  Item item                  = Item(0, nullptr);
+
+  // CREATURE_SAY, owned by World until all events have been delivered
+  const std::string* message = nullptr;
+};
+
+#endif  // WORLD_EXPORT_WORLD_EVENT_H_
@@ -55,6 +55,16 @@ Creature::Creature(const std::string& name)
 {
 }
 
+Creature::Creature(CreatureId creatureId, const std::string& name)
+  : Creature(name)
+{
+  creatureId_ = creatureId;
+  if (nextCreatureId_ <= creatureId)
+  {
+    nextCreatureId_ = creatureId + 1;
+  }
+}
+
 bool Creature::operator==(const Creature& other) const
 {
   return creatureId_ == other.creatureId_;
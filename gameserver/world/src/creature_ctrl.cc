@@ -0,0 +1,201 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "creature_ctrl.h"
+
+#include "world_interface.h"
+
+void CreatureCtrl::onWorldEvents(const WorldInterface& world_interface, const std::vector<WorldEvent>& events)
+{
+  for (const auto& event : events)
+  {
+    switch (event.type)
+    {
+      case WorldEvent::Type::CREATURE_SPAWN:
+      {
+        onCreatureSpawn(world_interface, world_interface.getCreature(event.creatureId), event.position);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_DESPAWN:
+      {
+        onCreatureDespawn(world_interface,
+                          world_interface.getCreature(event.creatureId),
+                          event.position,
+                          event.stackPos);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_MOVE:
+      {
+        onCreatureMove(world_interface,
+                       world_interface.getCreature(event.creatureId),
+                       event.position,
+                       event.stackPos,
+                       event.newPosition);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_ENTER_VIEW:
+      {
+        onCreatureEnterView(world_interface, world_interface.getCreature(event.creatureId), event.position);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_LEAVE_VIEW:
+      {
+        onCreatureLeaveView(world_interface,
+                            world_interface.getCreature(event.creatureId),
+                            event.position,
+                            event.stackPos);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_TURN:
+      {
+        onCreatureTurn(world_interface, world_interface.getCreature(event.creatureId), event.position, event.stackPos);
+        break;
+      }
+
+      case WorldEvent::Type::CREATURE_SAY:
+      {
+        onCreatureSay(world_interface, world_interface.getCreature(event.creatureId), event.position, *event.message);
+        break;
+      }
+
+      case WorldEvent::Type::ITEM_REMOVED:
+      {
+        onItemRemoved(world_interface, event.position, event.stackPos);
+        break;
+      }
+
+      case WorldEvent::Type::ITEM_ADDED:
+      {
+        onItemAdded(world_interface, event.item, event.position);
+        break;
+      }
+
+      case WorldEvent::Type::TILE_UPDATE:
+      {
+        onTileUpdate(world_interface, event.position);
+        break;
+      }
+    }
+  }
+}
+
+void CreatureCtrl::onCreatureSpawn(const WorldInterface& world_interface,
+                                   const Creature& creature,
+                                   const Position& position)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)position;
+}
+
+void CreatureCtrl::onCreatureDespawn(const WorldInterface& world_interface,
+                                     const Creature& creature,
+                                     const Position& position,
+                                     int stackPos)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)position;
+  (void)stackPos;
+}
+
+void CreatureCtrl::onCreatureMove(const WorldInterface& world_interface,
+                                  const Creature& creature,
+                                  const Position& oldPosition,
+                                  int oldStackPos,
+                                  const Position& newPosition)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)oldPosition;
+  (void)oldStackPos;
+  (void)newPosition;
+}
+
+void CreatureCtrl::onCreatureEnterView(const WorldInterface& world_interface,
+                                       const Creature& creature,
+                                       const Position& position)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)position;
+}
+
+void CreatureCtrl::onCreatureLeaveView(const WorldInterface& world_interface,
+                                       const Creature& creature,
+                                       const Position& oldPosition,
+                                       int oldStackPos)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)oldPosition;
+  (void)oldStackPos;
+}
+
+void CreatureCtrl::onCreatureTurn(const WorldInterface& world_interface,
+                                  const Creature& creature,
+                                  const Position& position,
+                                  int stackPos)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)position;
+  (void)stackPos;
+}
+
+void CreatureCtrl::onCreatureSay(const WorldInterface& world_interface,
+                                 const Creature& creature,
+                                 const Position& position,
+                                 const std::string& message)
+{
+  (void)world_interface;
+  (void)creature;
+  (void)position;
+  (void)message;
+}
+
+void CreatureCtrl::onItemRemoved(const WorldInterface& world_interface, const Position& position, int stackPos)
+{
+  (void)world_interface;
+  (void)position;
+  (void)stackPos;
+}
+
+void CreatureCtrl::onItemAdded(const WorldInterface& world_interface, const Item& item, const Position& position)
+{
+  (void)world_interface;
+  (void)item;
+  (void)position;
+}
+
+void CreatureCtrl::onTileUpdate(const WorldInterface& world_interface, const Position& position)
+{
+  (void)world_interface;
+  (void)position;
+}
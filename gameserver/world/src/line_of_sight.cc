@@ -0,0 +1,199 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "line_of_sight.h"
+
+#include <cstdlib>
+
+void LineOfSight::setPassable(const Position& position, bool passable)
+{
+  if (!isValid(position))
+  {
+    return;
+  }
+
+  const auto key = getSectorKey(position.getX() >> sector_bits, position.getY() >> sector_bits, position.getZ());
+  const auto bit = static_cast<std::uint16_t>(1u << (position.getX() & (sector_size - 1)));
+  const auto row = position.getY() & (sector_size - 1);
+  if (passable)
+  {
+    // Value-initialized, so all other tiles in a new sector are not passable
+    auto& bits = sectors_[key][row];
+    if (bits & bit)
+    {
+      return;
+    }
+    bits |= bit;
+  }
+  else
+  {
+    auto it = sectors_.find(key);
+    if (it == sectors_.end() || (it->second[row] & bit) == 0u)
+    {
+      return;
+    }
+    it->second[row] &= ~bit;
+  }
+
+  // Invalidate the cache, version 0 is used by empty cache entries
+  version_++;
+  if (version_ == 0u)
+  {
+    cache_.fill(CacheEntry());
+    version_ = 1;
+  }
+}
+
+bool LineOfSight::isPassable(const Position& position) const
+{
+  if (!isValid(position))
+  {
+    return false;
+  }
+
+  const auto it = sectors_.find(getSectorKey(position.getX() >> sector_bits,
+                                             position.getY() >> sector_bits,
+                                             position.getZ()));
+  if (it == sectors_.end())
+  {
+    return false;
+  }
+  return (it->second[position.getY() & (sector_size - 1)] >> (position.getX() & (sector_size - 1))) & 1u;
+}
+
+bool LineOfSight::hasLineOfSight(const Position& from, const Position& to) const
+{
+  const auto dx = to.getX() - from.getX();
+  const auto dy = to.getY() - from.getY();
+  if (!isValid(from) ||
+      from.getZ() != to.getZ() ||
+      std::abs(dx) > max_distance ||
+      std::abs(dy) > max_distance)
+  {
+    return false;
+  }
+
+  // from (40 bits) and the offset to to (2 x 6 bits)
+  const auto key = (static_cast<std::uint64_t>(from.getZ()) << 44) |
+                   (static_cast<std::uint64_t>(from.getX()) << 28) |
+                   (static_cast<std::uint64_t>(from.getY()) << 12) |
+                   (static_cast<std::uint64_t>(dx + max_distance) << 6) |
+                    static_cast<std::uint64_t>(dy + max_distance);
+  auto& entry = cache_[(key * 0x9E3779B97F4A7C15u) >> (64 - cache_bits)];
+  if (entry.version != version_ || entry.key != key)
+  {
+    entry.key = key;
+    entry.version = version_;
+    entry.result = computeLineOfSight(from, to);
+  }
+  return entry.result;
+}
+
+bool LineOfSight::computeLineOfSight(const Position& from, const Position& to) const
+{
+  if (!isValid(from) ||
+      !isValid(to) ||
+      from.getZ() != to.getZ() ||
+      std::abs(to.getX() - from.getX()) > max_distance ||
+      std::abs(to.getY() - from.getY()) > max_distance)
+  {
+    return false;
+  }
+
+  if (from == to)
+  {
+    return true;
+  }
+
+  // The from tile is not checked, the creature throwing or shooting is standing there
+  return isPassable(to) &&
+         (isRayPassable(from.getX(), from.getY(), to.getX(), to.getY(), to.getZ()) ||
+          isRayPassable(to.getX(), to.getY(), from.getX(), from.getY(), to.getZ()));
+}
+
+bool LineOfSight::isRayPassable(int fromX, int fromY, int toX, int toY, int z) const
+{
+  // Integer ray stepping, stepping in x and/or y depending on the accumulated error.
+  // Only the tiles between from and to are checked. The ray usually stays within one or
+  // two sectors, so a sector is only looked up when the ray enters it.
+  const auto dx = std::abs(toX - fromX);
+  const auto dy = -std::abs(toY - fromY);
+  const auto stepX = fromX < toX ? 1 : -1;
+  const auto stepY = fromY < toY ? 1 : -1;
+  auto error = dx + dy;
+
+  auto x = fromX;
+  auto y = fromY;
+  auto sectorKey = ~static_cast<std::uint64_t>(0);
+  const Sector* sector = nullptr;
+  while (true)
+  {
+    const auto error2 = 2 * error;
+    if (error2 >= dy)
+    {
+      error += dy;
+      x += stepX;
+    }
+    if (error2 <= dx)
+    {
+      error += dx;
+      y += stepY;
+    }
+
+    if (x == toX && y == toY)
+    {
+      return true;
+    }
+
+    const auto key = getSectorKey(x >> sector_bits, y >> sector_bits, z);
+    if (key != sectorKey)
+    {
+      const auto it = sectors_.find(key);
+      sector = it == sectors_.end() ? nullptr : &it->second;
+      sectorKey = key;
+    }
+    if (!sector || (((*sector)[y & (sector_size - 1)] >> (x & (sector_size - 1))) & 1u) == 0u)
+    {
+      return false;
+    }
+  }
+}
+
+bool LineOfSight::isValid(const Position& position)
+{
+  // Same limits as TileStore
+  return position.getX() >= 0 &&
+         position.getX() < (1 << 16) &&
+         position.getY() >= 0 &&
+         position.getY() < (1 << 16) &&
+         position.getZ() >= 0 &&
+         position.getZ() < (1 << 8);
+}
+
+std::uint64_t LineOfSight::getSectorKey(int sectorX, int sectorY, int z)
+{
+  return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(sectorX)) << 32) |
+         (static_cast<std::uint64_t>(static_cast<std::uint16_t>(sectorY)) << 16) |
+          static_cast<std::uint64_t>(static_cast<std::uint16_t>(z));
+}
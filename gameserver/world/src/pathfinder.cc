@@ -0,0 +1,264 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pathfinder.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+
+#include "walkability_map.h"
+#include "logger.h"
+
+namespace
+{
+
+constexpr std::array<Direction, 4> all_directions =
+{
+  Direction::NORTH,
+  Direction::EAST,
+  Direction::SOUTH,
+  Direction::WEST,
+};
+
+int getDeltaX(Direction direction)
+{
+  return direction == Direction::EAST ? 1 : (direction == Direction::WEST ? -1 : 0);
+}
+
+int getDeltaY(Direction direction)
+{
+  return direction == Direction::SOUTH ? 1 : (direction == Direction::NORTH ? -1 : 0);
+}
+
+}  // namespace
+
+Pathfinder::Pathfinder()
+  : x_(0),
+    y_(0),
+    width_(0),
+    height_(0),
+    startIndex_(0),
+    goalX_(0),
+    goalY_(0),
+    goalIndex_(0),
+    result_(Result::NOT_FOUND),
+    numberOfExpandedNodes_(0),
+    generation_(0),
+    walkable_(),
+    nodes_(),
+    openBuckets_(),
+    numberOfOpenBuckets_(0u),
+    currentOpenBucket_(0u),
+    startEstimate_(0)
+{
+}
+
+void Pathfinder::start(const WalkabilityMap& walkabilityMap, const Position& from, const Position& to)
+{
+  for (auto i = 0u; i < numberOfOpenBuckets_; i++)
+  {
+    openBuckets_[i].clear();
+  }
+  numberOfOpenBuckets_ = 0u;
+  currentOpenBucket_ = 0u;
+  numberOfExpandedNodes_ = 0;
+  result_ = Result::NOT_FOUND;
+
+  if (from.getZ() != to.getZ() ||
+      std::abs(from.getX() - to.getX()) > max_distance ||
+      std::abs(from.getY() - to.getY()) > max_distance)
+  {
+    LOG_DEBUG("%s: goal: %s is too far away from: %s", __func__, to.toString().c_str(), from.toString().c_str());
+    return;
+  }
+
+  if (!walkabilityMap.isWalkable(to))
+  {
+    LOG_DEBUG("%s: goal: %s is not walkable", __func__, to.toString().c_str());
+    return;
+  }
+
+  x_ = std::min(from.getX(), to.getX()) - search_margin;
+  y_ = std::min(from.getY(), to.getY()) - search_margin;
+  width_ = std::abs(from.getX() - to.getX()) + 1 + (2 * search_margin);
+  height_ = std::abs(from.getY() - to.getY()) + 1 + (2 * search_margin);
+  walkabilityMap.copyRectangle(x_, y_, from.getZ(), width_, height_, &walkable_);
+
+  const auto numberOfNodes = static_cast<std::size_t>(width_ * height_);
+  if (nodes_.size() < numberOfNodes)
+  {
+    nodes_.resize(numberOfNodes, Node{0u, 0u, Direction::NORTH, false});
+  }
+
+  generation_++;
+  if (generation_ == 0u)
+  {
+    // Wrapped around, invalidate all nodes
+    for (auto& node : nodes_)
+    {
+      node.generation = 0u;
+    }
+    generation_ = 1u;
+  }
+
+  goalX_ = to.getX() - x_;
+  goalY_ = to.getY() - y_;
+  goalIndex_ = (goalY_ * width_) + goalX_;
+  startIndex_ = ((from.getY() - y_) * width_) + (from.getX() - x_);
+  startEstimate_ = getHeuristic(from.getX() - x_, from.getY() - y_);
+  addOpenNode(from.getX() - x_, from.getY() - y_, startIndex_, 0u, Direction::NORTH);
+  result_ = Result::SEARCHING;
+}
+
+Pathfinder::Result Pathfinder::search(int maxNodes)
+{
+  if (result_ != Result::SEARCHING)
+  {
+    return result_;
+  }
+
+  for (auto i = 0; i < maxNodes; i++)
+  {
+    while (currentOpenBucket_ < numberOfOpenBuckets_ && openBuckets_[currentOpenBucket_].empty())
+    {
+      currentOpenBucket_++;
+    }
+    if (currentOpenBucket_ == numberOfOpenBuckets_)
+    {
+      result_ = Result::NOT_FOUND;
+      return result_;
+    }
+
+    auto& openBucket = openBuckets_[currentOpenBucket_];
+    const auto x = openBucket.back().x;
+    const auto y = openBucket.back().y;
+    openBucket.pop_back();
+
+    const auto index = (y * width_) + x;
+
+    auto& node = nodes_[index];
+    if (node.closed)
+    {
+      // Already expanded via a cheaper path
+      continue;
+    }
+    node.closed = true;
+    numberOfExpandedNodes_++;
+
+    if (index == goalIndex_)
+    {
+      result_ = Result::FOUND;
+      return result_;
+    }
+
+    for (const auto direction : all_directions)
+    {
+      const auto neighbourX = x + getDeltaX(direction);
+      const auto neighbourY = y + getDeltaY(direction);
+      if (neighbourX < 0 || neighbourX >= width_ || neighbourY < 0 || neighbourY >= height_)
+      {
+        continue;
+      }
+
+      const auto neighbourIndex = (neighbourY * width_) + neighbourX;
+      if (isWalkable(neighbourIndex))
+      {
+        addOpenNode(neighbourX, neighbourY, neighbourIndex, node.cost + 1u, direction);
+      }
+    }
+  }
+
+  return result_;
+}
+
+Pathfinder::Result Pathfinder::findPath(const WalkabilityMap& walkabilityMap,
+                                        const Position& from,
+                                        const Position& to,
+                                        std::deque<Direction>* path)
+{
+  start(walkabilityMap, from, to);
+
+  // The search always ends as there is a limited number of nodes in the window
+  while (search(width_ * height_) == Result::SEARCHING)
+  {
+  }
+
+  if (result_ == Result::FOUND)
+  {
+    getPath(path);
+  }
+  return result_;
+}
+
+void Pathfinder::getPath(std::deque<Direction>* path) const
+{
+  path->clear();
+  if (result_ != Result::FOUND)
+  {
+    return;
+  }
+
+  // Walk backwards from the goal to the start
+  auto index = goalIndex_;
+  while (index != startIndex_)
+  {
+    const auto direction = nodes_[index].direction;
+    path->push_front(direction);
+    index -= (getDeltaY(direction) * width_) + getDeltaX(direction);
+  }
+}
+
+int Pathfinder::getHeuristic(int x, int y) const
+{
+  // Manhattan distance, as creatures can only walk in four directions
+  return std::abs(x - goalX_) + std::abs(y - goalY_);
+}
+
+void Pathfinder::addOpenNode(int x, int y, int index, std::uint32_t cost, Direction direction)
+{
+  auto& node = nodes_[index];
+  if (node.generation == generation_ && (node.closed || node.cost <= cost))
+  {
+    return;
+  }
+
+  node.generation = generation_;
+  node.cost = cost;
+  node.direction = direction;
+  node.closed = false;
+
+  // As the heuristic is the Manhattan distance and each step costs 1, the estimate of a neighbour
+  // is either the same as or 2 more than the estimate of the expanded node. So instead of a priority
+  // queue, the open nodes are kept in buckets by estimate, and the buckets are expanded in order.
+  // The last added node in a bucket is expanded first, which is often the one closest to the goal.
+  const auto estimate = static_cast<int>(cost) + getHeuristic(x, y);
+  const auto bucket = static_cast<std::size_t>((estimate - startEstimate_) / 2);
+  if (bucket >= openBuckets_.size())
+  {
+    openBuckets_.resize(bucket + 1);
+  }
+  numberOfOpenBuckets_ = std::max(numberOfOpenBuckets_, bucket + 1);
+  openBuckets_[bucket].push_back(OpenNode{x, y});
+}
@@ -0,0 +1,108 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pathfinding_service.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "walkability_map.h"
+#include "logger.h"
+
+void PathfindingService::requestPath(CreatureId creatureId,
+                                     const Position& from,
+                                     const Position& to,
+                                     const Callback& callback)
+{
+  cancel(creatureId);
+  requests_.push_back(Request{creatureId, from, to, callback});
+}
+
+void PathfindingService::cancel(CreatureId creatureId)
+{
+  auto it = std::find_if(requests_.begin(), requests_.end(), [creatureId](const Request& request)
+  {
+    return request.creatureId == creatureId;
+  });
+  if (it == requests_.end())
+  {
+    return;
+  }
+
+  if (it == requests_.begin())
+  {
+    // The search in pathfinder_ (if any) is discarded when the next one starts
+    searching_ = false;
+  }
+  requests_.erase(it);
+}
+
+bool PathfindingService::hasRequest(CreatureId creatureId) const
+{
+  return std::any_of(requests_.cbegin(), requests_.cend(), [creatureId](const Request& request)
+  {
+    return request.creatureId == creatureId;
+  });
+}
+
+int PathfindingService::process(int maxNodes)
+{
+  auto numberOfExpandedNodes = 0;
+  while (!requests_.empty() && numberOfExpandedNodes < maxNodes)
+  {
+    if (!searching_)
+    {
+      const auto& request = requests_.front();
+      pathfinder_.start(*walkabilityMap_, request.from, request.to);
+      searching_ = true;
+    }
+
+    const auto expandedNodesBefore = pathfinder_.getNumberOfExpandedNodes();
+    const auto result = pathfinder_.search(maxNodes - numberOfExpandedNodes);
+    numberOfExpandedNodes += pathfinder_.getNumberOfExpandedNodes() - expandedNodesBefore;
+    if (result == Pathfinder::Result::SEARCHING)
+    {
+      // Out of budget, continue with this request next time
+      break;
+    }
+
+    LOG_DEBUG("%s: path from: %s to: %s %s, expanded nodes: %d",
+              __func__,
+              requests_.front().from.toString().c_str(),
+              requests_.front().to.toString().c_str(),
+              result == Pathfinder::Result::FOUND ? "found" : "not found",
+              pathfinder_.getNumberOfExpandedNodes());
+
+    // Remove the request before calling the callback, as it may request a new path
+    std::deque<Direction> path;
+    pathfinder_.getPath(&path);
+    const auto callback = std::move(requests_.front().callback);
+    requests_.pop_front();
+    searching_ = false;
+
+    callback(result == Pathfinder::Result::FOUND, std::move(path));
+  }
+
+  return numberOfExpandedNodes;
+}
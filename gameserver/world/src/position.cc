@@ -28,20 +28,6 @@
 
 const Position Position::INVALID = Position();
 
-Position::Position()
-  : x_(0),
-    y_(0),
-    z_(0)
-{
-}
-
-Position::Position(int x, int y, int z)
-  : x_(x),
-    y_(y),
-    z_(z)
-{
-}
-
 bool Position::operator==(const Position& other) const
 {
   return (x_ == other.x_) && (y_ == other.y_) && (z_ == other.z_);
@@ -0,0 +1,168 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sector_grid.h"
+
+#include <algorithm>
+
+#include "logger.h"
+
+void SectorGrid::addCreature(CreatureId creatureId, const Position& position)
+{
+  sectors_[getSectorKey(position)].emplace_back(creatureId, position);
+}
+
+bool SectorGrid::removeCreature(CreatureId creatureId, const Position& position)
+{
+  auto sectorIt = sectors_.find(getSectorKey(position));
+  if (sectorIt == sectors_.end())
+  {
+    LOG_ERROR("%s: no sector found for position: %s", __func__, position.toString().c_str());
+    return false;
+  }
+
+  auto& sector = sectorIt->second;
+  auto it = std::find_if(sector.begin(), sector.end(), [creatureId](const Entry& entry)
+  {
+    return entry.creatureId == creatureId;
+  });
+  if (it == sector.end())
+  {
+    LOG_ERROR("%s: creature: %d not found in sector for position: %s",
+              __func__,
+              creatureId,
+              position.toString().c_str());
+    return false;
+  }
+
+  // Order within a sector does not matter, so swap with last element instead of shifting
+  *it = sector.back();
+  sector.pop_back();
+
+  // Don't keep a sector for every position that a creature has ever visited
+  if (sector.empty())
+  {
+    sectors_.erase(sectorIt);
+  }
+  return true;
+}
+
+bool SectorGrid::moveCreature(CreatureId creatureId, const Position& fromPosition, const Position& toPosition)
+{
+  const auto fromKey = getSectorKey(fromPosition);
+  const auto toKey = getSectorKey(toPosition);
+
+  if (fromKey != toKey)
+  {
+    if (!removeCreature(creatureId, fromPosition))
+    {
+      return false;
+    }
+    sectors_[toKey].emplace_back(creatureId, toPosition);
+    return true;
+  }
+
+  // Same sector, just update the position
+  auto sectorIt = sectors_.find(fromKey);
+  if (sectorIt != sectors_.end())
+  {
+    for (auto& entry : sectorIt->second)
+    {
+      if (entry.creatureId == creatureId)
+      {
+        entry.position = toPosition;
+        return true;
+      }
+    }
+  }
+
+  LOG_ERROR("%s: creature: %d not found in sector for position: %s",
+            __func__,
+            creatureId,
+            fromPosition.toString().c_str());
+  return false;
+}
+
+std::vector<CreatureId> SectorGrid::getCreatureIds(int x_min, int y_min, int x_max, int y_max, int z) const
+{
+  std::vector<CreatureId> creatureIds;
+  getCreatureIds(x_min, y_min, x_max, y_max, z, &creatureIds);
+  return creatureIds;
+}
+
+void SectorGrid::getCreatureIds(int x_min,
+                                int y_min,
+                                int x_max,
+                                int y_max,
+                                int z,
+                                std::vector<CreatureId>* creatureIds) const
+{
+  if (sectors_.empty())
+  {
+    return;
+  }
+
+  const auto sectorXMin = toSectorCoordinate(std::max(x_min, 0));
+  const auto sectorXMax = toSectorCoordinate(std::max(x_max, 0));
+  const auto sectorYMin = toSectorCoordinate(std::max(y_min, 0));
+  const auto sectorYMax = toSectorCoordinate(std::max(y_max, 0));
+
+  for (auto sectorX = sectorXMin; sectorX <= sectorXMax; ++sectorX)
+  {
+    for (auto sectorY = sectorYMin; sectorY <= sectorYMax; ++sectorY)
+    {
+      const auto sectorIt = sectors_.find(getSectorKey(sectorX, sectorY, z));
+      if (sectorIt == sectors_.cend())
+      {
+        continue;
+      }
+
+      for (const auto& entry : sectorIt->second)
+      {
+        // The sector might only partially overlap the rectangle
+        if (entry.position.getX() >= x_min &&
+            entry.position.getX() <= x_max &&
+            entry.position.getY() >= y_min &&
+            entry.position.getY() <= y_max)
+        {
+          creatureIds->push_back(entry.creatureId);
+        }
+      }
+    }
+  }
+}
+
+std::uint64_t SectorGrid::getSectorKey(int sectorX, int sectorY, int z)
+{
+  return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(sectorX)) << 32) |
+         (static_cast<std::uint64_t>(static_cast<std::uint16_t>(sectorY)) << 16) |
+         (static_cast<std::uint64_t>(static_cast<std::uint16_t>(z)));
+}
+
+std::uint64_t SectorGrid::getSectorKey(const Position& position)
+{
+  return getSectorKey(toSectorCoordinate(position.getX()),
+                      toSectorCoordinate(position.getY()),
+                      position.getZ());
+}
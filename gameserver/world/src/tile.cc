@@ -25,13 +25,37 @@
 #include "tile.h"
 
 #include <algorithm>
-#include <iterator>
 
 #include "logger.h"
 
+namespace
+{
+
+// Limits of the fields in Tile::Flags
+constexpr int max_ground_speed = (1 << 12) - 1;
+constexpr int max_number_of_items = (1 << 8) - 1;
+
+}  // namespace
+
+Tile::Tile(Item* groundItem)
+  : items_({groundItem}),
+    creatureIds_(),
+    flags_()
+{
+  const auto& itemType = groundItem->getItemType();
+  if (itemType.speed > max_ground_speed)
+  {
+    LOG_ERROR("%s: ground speed: %d is too large", __func__, itemType.speed);
+  }
+  flags_.groundSpeed = std::min(static_cast<int>(itemType.speed), max_ground_speed);
+  flags_.numberOfBlockingItems = itemType.isBlocking ? 1 : 0;
+  flags_.numberOfProjectileBlockingItems = itemType.isBlockingProjectiles ? 1 : 0;
+}
+
 void Tile::addCreature(CreatureId creatureId)
 {
   creatureIds_.insert(creatureIds_.begin(), creatureId);
+  updateThingFlags();
 }
 
 bool Tile::removeCreature(CreatureId creatureId)
@@ -40,6 +64,7 @@ bool Tile::removeCreature(CreatureId creatureId)
   if (it != creatureIds_.cend())
   {
     creatureIds_.erase(it);
+    updateThingFlags();
     return true;
   }
   else
@@ -51,16 +76,14 @@ bool Tile::removeCreature(CreatureId creatureId)
 CreatureId Tile::getCreatureId(int stackPosition) const
 {
   // Calculate position in creatureIds_
-  int index = stackPosition - 1 - numberOfTopItems;
+  int index = stackPosition - 1 - flags_.numberOfTopItems;
   if (index < 0 || index >= static_cast<int>(creatureIds_.size()))
   {
     LOG_ERROR("%s: No Creature found at stackPosition: %d", __func__, stackPosition);
     return Creature::INVALID_ID;
   }
 
-  auto creatureIt = creatureIds_.cbegin();
-  std::advance(creatureIt, index);
-  return *creatureIt;
+  return creatureIds_[index];
 }
 
 int Tile::getCreatureStackPos(CreatureId creatureId) const
@@ -72,110 +95,88 @@ int Tile::getCreatureStackPos(CreatureId creatureId) const
     LOG_ERROR("getCreatureStackPos(): No creature %d at this Tile", creatureId);
     return 255;  // TODO(simon): Invalid stackPosition constant?
   }
-  return 1 + numberOfTopItems + std::distance(creatureIds_.cbegin(), it);
+  return 1 + flags_.numberOfTopItems + (it - creatureIds_.cbegin());
 }
 
 void Tile::addItem(Item* item)
 {
-  auto itemIt = items_.cbegin();
+  const auto& itemType = item->getItemType();
+  if ((itemType.alwaysOnTop && flags_.numberOfTopItems == max_number_of_items) ||
+      (itemType.isBlocking && flags_.numberOfBlockingItems == max_number_of_items) ||
+      (itemType.isBlockingProjectiles && flags_.numberOfProjectileBlockingItems == max_number_of_items))
+  {
+    LOG_ERROR("%s: too many items on tile", __func__);
+    return;
+  }
 
-  if (item->getItemType().alwaysOnTop)
+  // New items are put first among the top items or first among the bottom items
+  if (itemType.alwaysOnTop)
   {
-    std::advance(itemIt, 1);
-    numberOfTopItems++;
+    items_.insert(items_.cbegin() + 1, item);
+    flags_.numberOfTopItems++;
   }
   else
   {
-    std::advance(itemIt, 1 + numberOfTopItems);
+    items_.insert(items_.cbegin() + 1 + flags_.numberOfTopItems, item);
   }
 
-  items_.insert(itemIt, item);
+  if (itemType.isBlocking)
+  {
+    flags_.numberOfBlockingItems++;
+  }
+  if (itemType.isBlockingProjectiles)
+  {
+    flags_.numberOfProjectileBlockingItems++;
+  }
+  updateThingFlags();
 }
 
 bool Tile::removeItem(ItemTypeId itemTypeId, int stackPosition)
 {
-  if (stackPosition == 0)
+  const auto index = getItemIndex(stackPosition);
+  if (index == -1)
+  {
+    return false;
+  }
+
+  if (index == 0)
   {
-    // Ground Item
     LOG_ERROR("%s: Stackposition is ground Item, cannot remove", __func__);
+    return false;
   }
-  else if (stackPosition < 1 + numberOfTopItems)
+
+  if (items_[index]->getItemTypeId() != itemTypeId)
   {
-    // Top Item
-    auto itemIt = items_.cbegin();
-    std::advance(itemIt, stackPosition);
-    if ((*itemIt)->getItemTypeId() == itemTypeId)
-    {
-      items_.erase(itemIt);
-      return true;
-    }
-    else
-    {
-      LOG_ERROR("%s: Given ItemTypeId does not match Item at given stackpos", __func__);
-    }
+    LOG_ERROR("%s: Given ItemTypeId does not match Item at given stackpos", __func__);
+    return false;
   }
-  else if (stackPosition < 1 + numberOfTopItems + static_cast<int>(creatureIds_.size()))
+
+  if (index <= flags_.numberOfTopItems)
   {
-    // Creature
-    LOG_ERROR("%s: Stackposition is Creature, cannot remove", __func__);
+    flags_.numberOfTopItems--;
   }
-  else if (stackPosition < 1 + static_cast<int>(items_.size() + creatureIds_.size()))
+  const auto& itemType = items_[index]->getItemType();
+  if (itemType.isBlocking)
   {
-    // Bottom Item
-    auto itemIt = items_.cbegin();
-    std::advance(itemIt, stackPosition - creatureIds_.size());
-    if ((*itemIt)->getItemTypeId() == itemTypeId)
-    {
-      items_.erase(itemIt);
-      return true;
-    }
-    else
-    {
-      LOG_ERROR("%s: Given ItemTypeId does not match Item at given stackpos", __func__);
-    }
+    flags_.numberOfBlockingItems--;
   }
-  else
+  if (itemType.isBlockingProjectiles)
   {
-    // Invalid stackpos
-    LOG_ERROR("%s: Stackposition is invalid", __func__);
+    flags_.numberOfProjectileBlockingItems--;
   }
-
-  return false;
+  items_.erase(items_.cbegin() + index);
+  updateThingFlags();
+  return true;
 }
 
 const Item* Tile::getItem(int stackPosition) const
 {
-  if (stackPosition == 0)
-  {
-    // Ground Item
-    return items_.front();
-  }
-  else if (stackPosition < 1 + numberOfTopItems)
-  {
-    // Top Item
-    auto itemIt = items_.cbegin();
-    std::advance(itemIt, stackPosition);
-    return *itemIt;
-  }
-  else if (stackPosition < 1 + numberOfTopItems + static_cast<int>(creatureIds_.size()))
-  {
-    // Creature
-    LOG_ERROR("%s: Stackposition is Creature", __func__);
-    return nullptr;
-  }
-  else if (stackPosition < 1 + static_cast<int>(items_.size() + creatureIds_.size()))
+  const auto index = getItemIndex(stackPosition);
+  if (index == -1)
   {
-    // Bottom Item
-    auto itemIt = items_.cbegin();
-    std::advance(itemIt, stackPosition - creatureIds_.size());
-    return *itemIt;
-  }
-  else
-  {
-    // Invalid stackpos
-    LOG_ERROR("%s: Stackposition is invalid", __func__);
     return nullptr;
   }
+  return items_[index];
 }
 
 Item* Tile::getItem(int stackPosition)
@@ -189,13 +190,38 @@ std::size_t Tile::getNumberOfThings() const
   return items_.size() + creatureIds_.size();
 }
 
-int Tile::getGroundSpeed() const
+
+void Tile::updateThingFlags()
+{
+  flags_.hasCreatures = creatureIds_.empty() ? 0 : 1;
+  flags_.needsFullUpdate = getNumberOfThings() >= max_visible_things ? 1 : 0;
+}
+
+int Tile::getItemIndex(int stackPosition) const
 {
-  if (items_.empty())
+  // items_ is [ground, top items..., bottom items...] and the creatures are between
+  // the top items and the bottom items in the stack
+  const auto numberOfCreatures = static_cast<int>(creatureIds_.size());
+  const auto numberOfThings = static_cast<int>(getNumberOfThings());
+
+  if (stackPosition < 0 || stackPosition >= numberOfThings)
   {
-    LOG_ERROR("%s: Tile does not have any items", __func__);
-    return 0;
+    LOG_ERROR("%s: Stackposition is invalid", __func__);
+    return -1;
+  }
+  else if (stackPosition <= flags_.numberOfTopItems)
+  {
+    // Ground or top Item
+    return stackPosition;
+  }
+  else if (stackPosition <= flags_.numberOfTopItems + numberOfCreatures)
+  {
+    LOG_ERROR("%s: Stackposition is Creature", __func__);
+    return -1;
+  }
+  else
+  {
+    // Bottom Item
+    return stackPosition - numberOfCreatures;
   }
-
-  return items_.front()->getItemType().speed;
 }
@@ -0,0 +1,236 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "tile_store.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "sector_store.h"
+#include "logger.h"
+
+void TileStore::setTile(const Position& position, Tile&& tile)
+{
+  if (!isValid(position))
+  {
+    LOG_ERROR("%s: invalid position: %s", __func__, position.toString().c_str());
+    return;
+  }
+
+  const auto sectorX = toSectorCoordinate(position.getX());
+  const auto sectorY = toSectorCoordinate(position.getY());
+  auto* sector = getSector(sectorX, sectorY, position.getZ());
+  if (!sector)
+  {
+    sector = &sectors_[getSectorKey(sectorX, sectorY, position.getZ())];
+  }
+  sector->tiles[getTileIndex(position)] = std::move(tile);
+}
+
+void TileStore::addPagedOutSector(const Position& position)
+{
+  if (!isValid(position))
+  {
+    LOG_ERROR("%s: invalid position: %s", __func__, position.toString().c_str());
+    return;
+  }
+
+  const auto key = getSectorKey(toSectorCoordinate(position.getX()),
+                                toSectorCoordinate(position.getY()),
+                                position.getZ());
+  if (sectors_.count(key) != 0)
+  {
+    LOG_ERROR("%s: sector at position: %s already exists", __func__, position.toString().c_str());
+    return;
+  }
+
+  auto& sector = sectors_[key];
+  std::vector<Tile>().swap(sector.tiles);
+  sector.paged_out = true;
+}
+
+void TileStore::pageIn(int x_min, int y_min, int x_max, int y_max, int z)
+{
+  if (!sectorStore_)
+  {
+    return;
+  }
+
+  for (auto sectorX = toSectorCoordinate(std::max(x_min, 0)); sectorX <= toSectorCoordinate(x_max); sectorX++)
+  {
+    for (auto sectorY = toSectorCoordinate(std::max(y_min, 0)); sectorY <= toSectorCoordinate(y_max); sectorY++)
+    {
+      // getSector pages in the sector
+      getSector(sectorX, sectorY, z);
+    }
+  }
+}
+
+void TileStore::markInUse(int x_min, int y_min, int x_max, int y_max, int z)
+{
+  for (auto sectorX = toSectorCoordinate(std::max(x_min, 0)); sectorX <= toSectorCoordinate(x_max); sectorX++)
+  {
+    for (auto sectorY = toSectorCoordinate(std::max(y_min, 0)); sectorY <= toSectorCoordinate(y_max); sectorY++)
+    {
+      auto it = sectors_.find(getSectorKey(sectorX, sectorY, z));
+      if (it != sectors_.end())
+      {
+        it->second.in_use = true;
+      }
+    }
+  }
+}
+
+int TileStore::pageOut()
+{
+  sectorCache_.fill(CachedSector());
+
+  auto numberOfPagedOutSectors = 0;
+  for (auto& sectorPair : sectors_)
+  {
+    auto& sector = sectorPair.second;
+    if (sector.in_use || sector.paged_out || !sectorStore_)
+    {
+      sector.in_use = false;
+      continue;
+    }
+
+    // Never page out a sector with creatures in it
+    const auto hasCreatures = std::any_of(sector.tiles.cbegin(), sector.tiles.cend(), [](const Tile& tile)
+    {
+      return tile.hasCreatures();
+    });
+    if (hasCreatures)
+    {
+      continue;
+    }
+
+    const auto position = getSectorPosition(sectorPair.first);
+    if (!sectorStore_->storeSector(position, sector.tiles))
+    {
+      LOG_DEBUG("%s: could not page out sector at position: %s", __func__, position.toString().c_str());
+      continue;
+    }
+
+    // Release the memory, not just the elements
+    std::vector<Tile>().swap(sector.tiles);
+    sector.paged_out = true;
+    numberOfPagedOutSectors++;
+  }
+
+  return numberOfPagedOutSectors;
+}
+
+void TileStore::markModified(const Position& position)
+{
+  if (!isValid(position))
+  {
+    return;
+  }
+
+  auto it = sectors_.find(getSectorKey(toSectorCoordinate(position.getX()),
+                                       toSectorCoordinate(position.getY()),
+                                       position.getZ()));
+  if (it != sectors_.end())
+  {
+    it->second.modified = true;
+  }
+}
+
+void TileStore::forEachModifiedTile(const std::function<void(const Position&, const Tile&)>& f)
+{
+  for (const auto& sectorPair : sectors_)
+  {
+    if (!sectorPair.second.modified)
+    {
+      continue;
+    }
+
+    const auto sectorPosition = getSectorPosition(sectorPair.first);
+    const auto* sector = getSector(toSectorCoordinate(sectorPosition.getX()),
+                                   toSectorCoordinate(sectorPosition.getY()),
+                                   sectorPosition.getZ());
+    if (!sector)
+    {
+      LOG_ERROR("%s: could not page in sector at position: %s", __func__, sectorPosition.toString().c_str());
+      continue;
+    }
+
+    for (auto x = 0; x < sector_size; x++)
+    {
+      for (auto y = 0; y < sector_size; y++)
+      {
+        const Position position(sectorPosition.getX() + x, sectorPosition.getY() + y, sectorPosition.getZ());
+        const auto& tile = sector->tiles[getTileIndex(position)];
+        if (!tile.getItems().empty())
+        {
+          f(position, tile);
+        }
+      }
+    }
+  }
+}
+
+std::size_t TileStore::getNumberOfResidentSectors() const
+{
+  return std::count_if(sectors_.cbegin(), sectors_.cend(), [](const decltype(sectors_)::value_type& sectorPair)
+  {
+    return !sectorPair.second.paged_out;
+  });
+}
+
+TileStore::Sector* TileStore::getSector(int sectorX, int sectorY, int z) const
+{
+  auto it = sectors_.find(getSectorKey(sectorX, sectorY, z));
+  if (it == sectors_.end())
+  {
+    return nullptr;
+  }
+
+  auto* sector = &it->second;
+  if (sector->paged_out && !pageInSector(sectorX, sectorY, z, sector))
+  {
+    return nullptr;
+  }
+
+  auto& cachedSector = sectorCache_[getSectorCacheIndex(sectorX, sectorY)];
+  cachedSector.key = it->first;
+  cachedSector.tiles = sector->tiles.data();
+  return sector;
+}
+
+bool TileStore::pageInSector(int sectorX, int sectorY, int z, Sector* sector) const
+{
+  const Position position(sectorX << sector_bits, sectorY << sector_bits, z);
+  std::vector<Tile> tiles(sector_size * sector_size);
+  if (!sectorStore_ || !sectorStore_->loadSector(position, &tiles))
+  {
+    LOG_ERROR("%s: could not page in sector at position: %s", __func__, position.toString().c_str());
+    return false;
+  }
+
+  sector->tiles = std::move(tiles);
+  sector->paged_out = false;
+  return true;
+}
@@ -0,0 +1,137 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "walkability_map.h"
+
+#include <algorithm>
+
+void WalkabilityMap::setWalkable(const Position& position, bool walkable)
+{
+  if (!isValid(position))
+  {
+    return;
+  }
+
+  const auto key = getSectorKey(position.getX() >> sector_bits, position.getY() >> sector_bits, position.getZ());
+  const auto bit = static_cast<std::uint16_t>(1u << (position.getX() & (sector_size - 1)));
+  if (walkable)
+  {
+    // Value-initialized, so all other tiles in a new sector are not walkable
+    sectors_[key][position.getY() & (sector_size - 1)] |= bit;
+  }
+  else
+  {
+    auto it = sectors_.find(key);
+    if (it != sectors_.end())
+    {
+      it->second[position.getY() & (sector_size - 1)] &= ~bit;
+    }
+  }
+}
+
+bool WalkabilityMap::isWalkable(const Position& position) const
+{
+  if (!isValid(position))
+  {
+    return false;
+  }
+
+  const auto it = sectors_.find(getSectorKey(position.getX() >> sector_bits,
+                                             position.getY() >> sector_bits,
+                                             position.getZ()));
+  if (it == sectors_.end())
+  {
+    return false;
+  }
+  return (it->second[position.getY() & (sector_size - 1)] >> (position.getX() & (sector_size - 1))) & 1u;
+}
+
+void WalkabilityMap::copyRectangle(int x, int y, int z, int width, int height, std::vector<std::uint64_t>* bits) const
+{
+  bits->assign((width * height + 63) / 64, 0u);
+
+  // Positions outside of the valid range are left as not walkable
+  const auto x_min = std::max(x, 0);
+  const auto y_min = std::max(y, 0);
+  const auto x_max = std::min(x + width, 1 << 16) - 1;
+  const auto y_max = std::min(y + height, 1 << 16) - 1;
+  if (z < 0 || z >= (1 << 8) || x_min > x_max || y_min > y_max)
+  {
+    return;
+  }
+
+  // Look up each sector once and copy all of its rows that overlap the rectangle
+  for (auto sectorY = y_min >> sector_bits; sectorY <= y_max >> sector_bits; sectorY++)
+  {
+    for (auto sectorX = x_min >> sector_bits; sectorX <= x_max >> sector_bits; sectorX++)
+    {
+      const auto it = sectors_.find(getSectorKey(sectorX, sectorY, z));
+      if (it == sectors_.end())
+      {
+        continue;
+      }
+
+      const auto sector_x_min = std::max(x_min, sectorX << sector_bits);
+      const auto sector_x_max = std::min(x_max, (sectorX << sector_bits) + sector_size - 1);
+      const auto sector_y_min = std::max(y_min, sectorY << sector_bits);
+      const auto sector_y_max = std::min(y_max, (sectorY << sector_bits) + sector_size - 1);
+      for (auto tileY = sector_y_min; tileY <= sector_y_max; tileY++)
+      {
+        // The bits of the row that are within the rectangle, which may be split over two words
+        const auto numberOfBits = sector_x_max - sector_x_min + 1;
+        const auto row = (static_cast<std::uint64_t>(it->second[tileY & (sector_size - 1)]) >>
+                          (sector_x_min & (sector_size - 1))) & ((static_cast<std::uint64_t>(1) << numberOfBits) - 1);
+        if (row == 0u)
+        {
+          continue;
+        }
+
+        const auto index = ((tileY - y) * width) + (sector_x_min - x);
+        (*bits)[index / 64] |= row << (index % 64);
+        if ((index % 64) + numberOfBits > 64)
+        {
+          (*bits)[(index / 64) + 1] |= row >> (64 - (index % 64));
+        }
+      }
+    }
+  }
+}
+
+bool WalkabilityMap::isValid(const Position& position)
+{
+  // Same limits as TileStore
+  return position.getX() >= 0 &&
+         position.getX() < (1 << 16) &&
+         position.getY() >= 0 &&
+         position.getY() < (1 << 16) &&
+         position.getZ() >= 0 &&
+         position.getZ() < (1 << 8);
+}
+
+std::uint64_t WalkabilityMap::getSectorKey(int sectorX, int sectorY, int z)
+{
+  return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(sectorX)) << 32) |
+         (static_cast<std::uint64_t>(static_cast<std::uint16_t>(sectorY)) << 16) |
+          static_cast<std::uint64_t>(static_cast<std::uint16_t>(z));
+}
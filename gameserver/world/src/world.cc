@@ -33,14 +33,134 @@
 
 #include "logger.h"
 #include "tick.h"
+#include "viewport.h"
+
+namespace
+{
+
+bool containsCreatureId(const std::vector<CreatureId>& creatureIds, CreatureId creatureId)
+{
+  return std::find(creatureIds.cbegin(), creatureIds.cend(), creatureId) != creatureIds.cend();
+}
+
+void eraseCreatureId(std::vector<CreatureId>* creatureIds, CreatureId creatureId)
+{
+  auto it = std::find(creatureIds->begin(), creatureIds->end(), creatureId);
+  if (it != creatureIds->end())
+  {
+    // Order does not matter, so swap with last element instead of shifting
+    *it = creatureIds->back();
+    creatureIds->pop_back();
+  }
+}
+
+// Calls f with each area (x_min, y_min, x_max, y_max, z) that a creature at position can see,
+// with an extra margin of one sector so that sectors are paged in before they come into view
+template<typename F>
+void forEachPagingArea(const Position& position, const F& f)
+{
+  const auto margin = TileStore::sector_size;
+  const auto highestFloor = Viewport::getHighestVisibleFloor(position.getZ());
+  const auto lowestFloor = Viewport::getLowestVisibleFloor(position.getZ());
+  for (auto z = highestFloor; z <= lowestFloor; z++)
+  {
+    const auto offset = Viewport::getFloorOffset(position.getZ(), z);
+    f(position.getX() - Viewport::west - margin + offset,
+      position.getY() - Viewport::north - margin + offset,
+      position.getX() + Viewport::east + margin + offset,
+      position.getY() + Viewport::south + margin + offset,
+      z);
+  }
+}
+
+}  // namespace
+
+World::World()
+  : tile_store_(),
+    walkability_map_(),
+    line_of_sight_(),
+    sector_grid_(),
+    event_generation_(0)
+{
+}
 
 World::World(int worldSizeX,
              int worldSizeY,
              std::vector<Tile>&& tiles)
-  : worldSizeX_(worldSizeX),
-    worldSizeY_(worldSizeY),
-    tiles_(std::move(tiles))
+  : World()
 {
+  if (tiles.size() != static_cast<std::size_t>(worldSizeX * worldSizeY))
+  {
+    LOG_ERROR("%s: got %d tiles, expected %d", __func__, static_cast<int>(tiles.size()), worldSizeX * worldSizeY);
+    return;
+  }
+
+  auto tileIt = tiles.begin();
+  for (auto x = position_offset; x < position_offset + worldSizeX; x++)
+  {
+    for (auto y = position_offset; y < position_offset + worldSizeY; y++)
+    {
+      setTile(Position(x, y, Viewport::ground_floor), std::move(*tileIt));
+      ++tileIt;
+    }
+  }
+}
+
+void World::setTile(const Position& position, Tile&& tile)
+{
+  if (position.getZ() < 0 || position.getZ() >= number_of_floors)
+  {
+    LOG_ERROR("%s: invalid position: %s", __func__, position.toString().c_str());
+    return;
+  }
+  tile_store_.setTile(position, std::move(tile));
+  updateTileBits(position, tile_store_.getTile(position));
+}
+
+void World::addPagedOutSector(const Position& position,
+                              const TileStore::SectorBits& walkable,
+                              const TileStore::SectorBits& passable)
+{
+  if (position.getZ() < 0 || position.getZ() >= number_of_floors)
+  {
+    LOG_ERROR("%s: invalid position: %s", __func__, position.toString().c_str());
+    return;
+  }
+  tile_store_.addPagedOutSector(position);
+
+  for (auto x = position.getX(); x < position.getX() + TileStore::sector_size; x++)
+  {
+    for (auto y = position.getY(); y < position.getY() + TileStore::sector_size; y++)
+    {
+      const Position tilePosition(x, y, position.getZ());
+      const auto index = TileStore::getTileIndex(tilePosition);
+      walkability_map_.setWalkable(tilePosition, walkable[index]);
+      line_of_sight_.setPassable(tilePosition, passable[index]);
+    }
+  }
+}
+
+int World::pageOutSectors()
+{
+  // Buffered events may refer to items that are about to be paged out
+  flushEvents();
+
+  // Sectors around creatures are in use, the rest can be paged out
+  for (const auto& creatureDataPair : creature_data_)
+  {
+    forEachPagingArea(creatureDataPair.second.position, [this](int x_min, int y_min, int x_max, int y_max, int z)
+    {
+      tile_store_.markInUse(x_min, y_min, x_max, y_max, z);
+    });
+  }
+
+  const auto numberOfPagedOutSectors = tile_store_.pageOut();
+  LOG_DEBUG("%s: paged out %d sectors, %d of %d sectors are resident",
+            __func__,
+            numberOfPagedOutSectors,
+            static_cast<int>(tile_store_.getNumberOfResidentSectors()),
+            static_cast<int>(tile_store_.getNumberOfSectors()));
+  return numberOfPagedOutSectors;
 }
 
 World::ReturnCode World::addCreature(Creature* creature, CreatureCtrl* creatureCtrl, const Position& position)
@@ -89,7 +209,7 @@ World::ReturnCode World::addCreature(Creature* creature, CreatureCtrl* creatureC
     }
 
     // TODO(simon): Need to check more stuff (blocking, etc)
-    if (!tile->getCreatureIds().empty())
+    if (tile->hasCreatures())
     {
       tile = nullptr;
       continue;
@@ -102,17 +222,37 @@ World::ReturnCode World::addCreature(Creature* creature, CreatureCtrl* creatureC
   {
     LOG_INFO("%s: spawning creature: %d at position: %s", __func__, creatureId, adjustedPosition.toString().c_str());
     tile->addCreature(creatureId);
+    updateTileBits(adjustedPosition, tile);
+    sector_grid_.addCreature(creatureId, adjustedPosition);
+    pageInSectorsAround(adjustedPosition);
 
     creature_data_.emplace(std::piecewise_construct,
                            std::forward_as_tuple(creatureId),
                            std::forward_as_tuple(creature, creatureCtrl, adjustedPosition));
 
+    // The spawned creature can see all creatures in its viewport
+    auto& visibleCreatureIds = creature_data_.at(creatureId).visible_creature_ids;
+    visibleCreatureIds = getVisibleCreatureIds(adjustedPosition);
+    eraseCreatureId(&visibleCreatureIds, creatureId);
+
     // Tell near creatures that a creature has spawned
-    // Including the spawned creature!
+    // Including the spawned creature, which gets the event directly
+    WorldEvent event;
+    event.type = WorldEvent::Type::CREATURE_SPAWN;
+    event.creatureId = creatureId;
+    event.position = adjustedPosition;
     auto nearCreatureIds = getCreatureIdsThatCanSeePosition(adjustedPosition);
     for (const auto& nearCreatureId : nearCreatureIds)
     {
-      getCreatureCtrl(nearCreatureId).onCreatureSpawn(*this, *creature, adjustedPosition);
+      queueEvent(nearCreatureId, event);
+      if (nearCreatureId != creatureId)
+      {
+        creature_data_.at(nearCreatureId).visible_creature_ids.push_back(creatureId);
+      }
+      else
+      {
+        flushEvents(creatureId);
+      }
     }
 
     return ReturnCode::OK;
@@ -127,6 +267,46 @@ World::ReturnCode World::addCreature(Creature* creature, CreatureCtrl* creatureC
   }
 }
 
+World::ReturnCode World::restoreCreature(Creature* creature, CreatureCtrl* creatureCtrl, const Position& position)
+{
+  const auto creatureId = creature->getCreatureId();
+  if (creatureExists(creatureId))
+  {
+    LOG_ERROR("%s: Creature already exists: %s (%d)", __func__, creature->getName().c_str(), creatureId);
+    return ReturnCode::OTHER_ERROR;
+  }
+
+  auto* tile = internalGetTile(position);
+  if (!tile)
+  {
+    LOG_ERROR("%s: no tile found at position: %s", __func__, position.toString().c_str());
+    return ReturnCode::INVALID_POSITION;
+  }
+
+  tile->addCreature(creatureId);
+  updateTileBits(position, tile);
+  sector_grid_.addCreature(creatureId, position);
+  pageInSectorsAround(position);
+
+  creature_data_.emplace(std::piecewise_construct,
+                         std::forward_as_tuple(creatureId),
+                         std::forward_as_tuple(creature, creatureCtrl, position));
+
+  // Same as addCreature, but the clients already know about the creature so there are no events
+  auto& visibleCreatureIds = creature_data_.at(creatureId).visible_creature_ids;
+  visibleCreatureIds = getVisibleCreatureIds(position);
+  eraseCreatureId(&visibleCreatureIds, creatureId);
+  for (const auto& nearCreatureId : getCreatureIdsThatCanSeePosition(position))
+  {
+    if (nearCreatureId != creatureId)
+    {
+      creature_data_.at(nearCreatureId).visible_creature_ids.push_back(creatureId);
+    }
+  }
+
+  return ReturnCode::OK;
+}
+
 void World::removeCreature(CreatureId creatureId)
 {
   if (!creatureExists(creatureId))
@@ -135,21 +315,40 @@ void World::removeCreature(CreatureId creatureId)
     return;
   }
 
-  const auto& creature = getCreature(creatureId);
   const auto& position = getCreaturePosition(creatureId);
   auto* tile = internalGetTile(position);
   auto stackPos = tile->getCreatureStackPos(creatureId);
 
   // Tell near creatures that a creature has despawned
   // Including the despawning creature!
+  WorldEvent event;
+  event.type = WorldEvent::Type::CREATURE_DESPAWN;
+  event.stackPos = stackPos;
+  event.creatureId = creatureId;
+  event.position = position;
   auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
   for (const auto& nearCreatureId : nearCreatureIds)
   {
-    getCreatureCtrl(nearCreatureId).onCreatureDespawn(*this, creature, position, stackPos);
+    eraseCreatureId(&creature_data_.at(nearCreatureId).visible_creature_ids, creatureId);
+    queueEvent(nearCreatureId, event);
   }
 
-  creature_data_.erase(creatureId);
+  // The events refer to this creature, so deliver them while it can still be looked up
+  // Only the creatures that have buffered events about it get their events before the end of the tick
+  const auto& creatureData = creature_data_.at(creatureId);
+  if (creatureData.observer_generation == event_generation_)
+  {
+    const auto observerIds = creatureData.observer_ids;
+    for (const auto observerId : observerIds)
+    {
+      flushEvents(observerId);
+    }
+  }
+
+  sector_grid_.removeCreature(creatureId, position);
   tile->removeCreature(creatureId);
+  updateTileBits(position, tile);
+  creature_data_.erase(creatureId);  // Note: position is a reference into creature_data_
 }
 
 bool World::creatureExists(CreatureId creatureId) const
@@ -192,19 +391,10 @@ World::ReturnCode World::creatureMove(CreatureId creatureId, const Position& toP
   }
 
   // Check if toTile is blocking or not
-  for (const auto* item : toTile->getItems())
+  if (!toTile->isWalkable())
   {
-    if (item->getItemType().isBlocking)
-    {
-      LOG_DEBUG("%s: Item on toTile is blocking", __func__);
-      return ReturnCode::THERE_IS_NO_ROOM;
-    }
-
-    if (!toTile->getCreatureIds().empty())
-    {
-      LOG_DEBUG("%s: Item on toTile has creatures", __func__);
-      return ReturnCode::THERE_IS_NO_ROOM;
-    }
+    LOG_DEBUG("%s: toTile is blocking or has creatures", __func__);
+    return ReturnCode::THERE_IS_NO_ROOM;
   }
 
   // Move the actual creature
@@ -212,9 +402,20 @@ World::ReturnCode World::creatureMove(CreatureId creatureId, const Position& toP
   auto* fromTile = internalGetTile(fromPosition);
   auto fromStackPos = fromTile->getCreatureStackPos(creatureId);
   fromTile->removeCreature(creatureId);
+  updateTileBits(fromPosition, fromTile);
 
   toTile->addCreature(creatureId);
+  updateTileBits(toPosition, toTile);
   creature_data_.at(creatureId).position = toPosition;
+  sector_grid_.moveCreature(creatureId, fromPosition, toPosition);
+
+  // Page in the sectors that the creature is getting close to, when it enters a new sector
+  if ((fromPosition.getX() >> TileStore::sector_bits) != (toPosition.getX() >> TileStore::sector_bits) ||
+      (fromPosition.getY() >> TileStore::sector_bits) != (toPosition.getY() >> TileStore::sector_bits) ||
+      fromPosition.getZ() != toPosition.getZ())
+  {
+    pageInSectorsAround(toPosition);
+  }
 
   // Set new nextWalkTime for this Creature
   auto groundSpeed = fromTile->getGroundSpeed();
@@ -249,45 +450,69 @@ World::ReturnCode World::creatureMove(CreatureId creatureId, const Position& toP
     creature.setDirection(Direction::EAST);
   }
 
-  // Call onCreatureMove on all creatures that can see the movement
-  // including the moving creature itself
-  // Note that the range of which we iterate over tiles, (-9, -7) to (+8, +6),
-  // are the opposite of Protocol71::canSee (-8, -6) to (+9, +7)
-  // This makes sense, as we here want to know "who can see us move?" while
-  // in Protocol71::canSee we want to know "can we see them move?"
-  // TODO(simon): refactor this and Protocol71::canSee to get rid of all these
-  //              constant integers
-  const auto x_min = std::min(fromPosition.getX(), toPosition.getX());
-  const auto x_max = std::max(fromPosition.getX(), toPosition.getX());
-  const auto y_min = std::min(fromPosition.getY(), toPosition.getY());
-  const auto y_max = std::max(fromPosition.getY(), toPosition.getY());
-  for (auto x = x_min - 9; x <= x_max + 8; x++)
-  {
-    for (auto y = y_min - 7; y <= y_max + 6; y++)
+  // Update the set of creatures that the moving creature can see
+  // The client receives the creatures that comes into view with the new map data, and
+  // forgets the creatures that goes out of view by itself, so no need to tell it
+  auto& visibleCreatureIds = creature_data_.at(creatureId).visible_creature_ids;
+  visibleCreatureIds = getVisibleCreatureIds(toPosition);
+  eraseCreatureId(&visibleCreatureIds, creatureId);
+
+  // Tell the moving creature itself that it moved, directly since it gets the new map data with it
+  WorldEvent event;
+  event.type = WorldEvent::Type::CREATURE_MOVE;
+  event.stackPos = fromStackPos;
+  event.creatureId = creatureId;
+  event.position = fromPosition;
+  event.newPosition = toPosition;
+  queueEvent(creatureId, event);
+  flushEvents(creatureId);
+
+  // Find all creatures that could see the creature before the move, or can see it after the move
+  // and tell them that the creature moved within, entered or left their view
+  auto nearCreatureIds = getCreatureIdsThatCanSeePosition(fromPosition);
+  const auto toNearCreatureIds = getCreatureIdsThatCanSeePosition(toPosition);
+  nearCreatureIds.insert(nearCreatureIds.end(), toNearCreatureIds.cbegin(), toNearCreatureIds.cend());
+  std::sort(nearCreatureIds.begin(), nearCreatureIds.end());
+  nearCreatureIds.erase(std::unique(nearCreatureIds.begin(), nearCreatureIds.end()), nearCreatureIds.end());
+
+  for (const auto nearCreatureId : nearCreatureIds)
+  {
+    if (nearCreatureId == creatureId)
     {
-      const auto position = Position(x, y, 7);
-      const auto* tile = getTile(position);
-      if (!tile)
-      {
-        continue;
-      }
-      const auto& nearCreatureIds = tile->getCreatureIds();
-      for (const auto nearCreatureId : nearCreatureIds)
-      {
-        getCreatureCtrl(nearCreatureId).onCreatureMove(*this, creature, fromPosition, fromStackPos, toPosition);
-      }
+      continue;
+    }
+
+    auto& nearCreatureData = creature_data_.at(nearCreatureId);
+    const auto couldSee = containsCreatureId(nearCreatureData.visible_creature_ids, creatureId);
+    const auto canSee = Viewport::canSee(nearCreatureData.position, toPosition);
+
+    if (couldSee && canSee)
+    {
+      event.type = WorldEvent::Type::CREATURE_MOVE;
+      queueEvent(nearCreatureId, event);
+    }
+    else if (couldSee)
+    {
+      eraseCreatureId(&nearCreatureData.visible_creature_ids, creatureId);
+      event.type = WorldEvent::Type::CREATURE_LEAVE_VIEW;
+      queueEvent(nearCreatureId, event);
+    }
+    else if (canSee)
+    {
+      nearCreatureData.visible_creature_ids.push_back(creatureId);
+      WorldEvent enterViewEvent;
+      enterViewEvent.type = WorldEvent::Type::CREATURE_ENTER_VIEW;
+      enterViewEvent.creatureId = creatureId;
+      enterViewEvent.position = toPosition;
+      queueEvent(nearCreatureId, enterViewEvent);
     }
   }
 
   // The client can only show ground + 9 Items/Creatures, so if the number of things on the fromTile
   // is >= 10 then some items on the tile is unknown to the client, so update the Tile for each nearby Creature
-  if (fromTile->getNumberOfThings() >= 10)
+  if (fromTile->needsFullUpdate())
   {
-    auto nearCreatureIds = getCreatureIdsThatCanSeePosition(fromPosition);
-    for (const auto& nearCreatureId : nearCreatureIds)
-    {
-      getCreatureCtrl(nearCreatureId).onTileUpdate(*this, fromPosition);
-    }
+    queueTileUpdate(fromPosition);
   }
 
   return ReturnCode::OK;
@@ -307,11 +532,15 @@ void World::creatureTurn(CreatureId creatureId, Direction direction)
   // Call onCreatureTurn on all creatures that can see the turn
   // including the turning creature itself
   const auto& position = getCreaturePosition(creatureId);
-  auto stackPos = getTile(position)->getCreatureStackPos(creatureId);
+  WorldEvent event;
+  event.type = WorldEvent::Type::CREATURE_TURN;
+  event.stackPos = getTile(position)->getCreatureStackPos(creatureId);
+  event.creatureId = creatureId;
+  event.position = position;
   auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
   for (const auto& nearCreatureId : nearCreatureIds)
   {
-    getCreatureCtrl(nearCreatureId).onCreatureTurn(*this, creature, position, stackPos);
+    queueEvent(nearCreatureId, event);
   }
 }
 
@@ -323,12 +552,19 @@ void World::creatureSay(CreatureId creatureId, const std::string& message)
     return;
   }
 
-  const auto& creature = getCreature(creatureId);
+  // The message is kept until the events have been delivered
+  event_messages_.push_back(message);
+
   const auto& position = getCreaturePosition(creatureId);
+  WorldEvent event;
+  event.type = WorldEvent::Type::CREATURE_SAY;
+  event.creatureId = creatureId;
+  event.position = position;
+  event.message = &event_messages_.back();
   auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
   for (const auto& nearCreatureId : nearCreatureIds)
   {
-    getCreatureCtrl(nearCreatureId).onCreatureSay(*this, creature, position, message);
+    queueEvent(nearCreatureId, event);
   }
 }
 
@@ -344,15 +580,7 @@ bool World::canAddItem(const Item& item, const Position& position) const
     return false;
   }
 
-  for (const auto* item : tile->getItems())
-  {
-    if (item->getItemType().isBlocking)
-    {
-      return false;
-    }
-  }
-
-  return true;
+  return !tile->isBlocking();
 }
 
 World::ReturnCode World::addItem(Item* item, const Position& position)
@@ -366,13 +594,11 @@ World::ReturnCode World::addItem(Item* item, const Position& position)
 
   // Add Item to toTile
   tile->addItem(item);
+  updateTileBits(position, tile);
+  tile_store_.markModified(position);
 
-  // Call onItemAdded on all creatures that can see position
-  auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
-  for (const auto& nearCreatureId : nearCreatureIds)
-  {
-    getCreatureCtrl(nearCreatureId).onItemAdded(*this, *item, position);
-  }
+  // Tell all creatures that can see position
+  queueItemAdded(*item, position);
 
   return ReturnCode::OK;
 }
@@ -398,23 +624,17 @@ World::ReturnCode World::removeItem(ItemTypeId itemTypeId, int count, const Posi
               position.toString().c_str());
     return ReturnCode::ITEM_NOT_FOUND;
   }
+  updateTileBits(position, tile);
+  tile_store_.markModified(position);
 
-  // Call onItemRemoved on all creatures that can see the position
-  auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
-  for (const auto& nearCreatureId : nearCreatureIds)
-  {
-    getCreatureCtrl(nearCreatureId).onItemRemoved(*this, position, stackPos);
-  }
+  // Tell all creatures that can see the position
+  queueItemRemoved(position, stackPos);
 
   // The client can only show ground + 9 Items/Creatures, so if the number of things on the tile
   // is >= 10 then some items on the tile is unknown to the client, so update the Tile for each nearby Creature
-  if (tile->getNumberOfThings() >= 10)
+  if (tile->needsFullUpdate())
   {
-    auto nearCreatureIds = getCreatureIdsThatCanSeePosition(position);
-    for (const auto& nearCreatureId : nearCreatureIds)
-    {
-      getCreatureCtrl(nearCreatureId).onTileUpdate(*this, position);
-    }
+    queueTileUpdate(position);
   }
 
   return ReturnCode::OK;
@@ -468,13 +688,10 @@ World::ReturnCode World::moveItem(CreatureId creatureId,
   }
 
   // Check if we can add Item to toTile
-  for (const auto* item : toTile->getItems())
+  if (toTile->isBlocking())
   {
-    if (item->getItemType().isBlocking)
-    {
-      LOG_DEBUG("%s: Item on toTile is blocking", __func__);
-      return ReturnCode::THERE_IS_NO_ROOM;
-    }
+    LOG_DEBUG("%s: Item on toTile is blocking", __func__);
+    return ReturnCode::THERE_IS_NO_ROOM;
   }
 
   // Get the Item from fromTile
@@ -494,32 +711,23 @@ World::ReturnCode World::moveItem(CreatureId creatureId,
     return ReturnCode::ITEM_NOT_FOUND;
   }
 
+  updateTileBits(fromPosition, fromTile);
+
   // Add Item to toTile
   toTile->addItem(item);
+  updateTileBits(toPosition, toTile);
+  tile_store_.markModified(fromPosition);
+  tile_store_.markModified(toPosition);
 
-  // Call onItemRemoved on all creatures that can see fromPosition
-  auto nearCreatureIds = getCreatureIdsThatCanSeePosition(fromPosition);
-  for (const auto& nearCreatureId : nearCreatureIds)
-  {
-    getCreatureCtrl(nearCreatureId).onItemRemoved(*this, fromPosition, fromStackPos);
-  }
-
-  // Call onItemAdded on all creatures that can see toPosition
-  nearCreatureIds = getCreatureIdsThatCanSeePosition(toPosition);
-  for (const auto& nearCreatureId : nearCreatureIds)
-  {
-    getCreatureCtrl(nearCreatureId).onItemAdded(*this, *item, toPosition);
-  }
+  // Tell all creatures that can see fromPosition and toPosition
+  queueItemRemoved(fromPosition, fromStackPos);
+  queueItemAdded(*item, toPosition);
 
   // The client can only show ground + 9 Items/Creatures, so if the number of things on the fromTile
   // is >= 10 then some items on the tile is unknown to the client, so update the Tile for each nearby Creature
-  if (fromTile->getNumberOfThings() >= 10)
+  if (fromTile->needsFullUpdate())
   {
-    auto nearCreatureIds = getCreatureIdsThatCanSeePosition(fromPosition);
-    for (const auto& nearCreatureId : nearCreatureIds)
-    {
-      getCreatureCtrl(nearCreatureId).onTileUpdate(*this, fromPosition);
-    }
+    queueTileUpdate(fromPosition);
   }
 
   return ReturnCode::OK;
@@ -533,15 +741,32 @@ Item* World::getItem(const Position& position, int stackPosition)
     LOG_ERROR("%s: could not find tile at position: %s", __func__, position.toString().c_str());
     return nullptr;
   }
+
+  // The caller may change the item
+  tile_store_.markModified(position);
   return tile->getItem(stackPosition);
 }
 
+void World::restoreTile(const Position& position, Tile&& tile)
+{
+  setTile(position, std::move(tile));
+  tile_store_.markModified(position);
+}
+
+void World::forEachModifiedTile(const std::function<void(const Position&, const Tile&)>& f)
+{
+  tile_store_.forEachModifiedTile(f);
+}
+
 bool World::creatureCanThrowTo(CreatureId creatureId, const Position& position) const
 {
-  // TODO(simon): Fix
-  (void)creatureId;
-  (void)position;
-  return true;
+  // Only within the area that the creature can see, and only on the same floor
+  const auto& creaturePosition = getCreaturePosition(creatureId);
+  if (creaturePosition.getZ() != position.getZ() || !Viewport::canSee(creaturePosition, position))
+  {
+    return false;
+  }
+  return line_of_sight_.hasLineOfSight(creaturePosition, position);
 }
 
 bool World::creatureCanReach(CreatureId creatureId, const Position& position) const
@@ -554,90 +779,175 @@ bool World::creatureCanReach(CreatureId creatureId, const Position& position) co
 
 std::vector<CreatureId> World::getCreatureIdsThatCanSeePosition(const Position& position) const
 {
+  // A creature on floor z sees the position's floor with an offset, so the area
+  // to search is shifted diagonally for each floor
   std::vector<CreatureId> creatureIds;
-
-  // TODO(simon): fix these constants (see creatureMove)
-  for (int x = position.getX() - 9; x <= position.getX() + 8; ++x)
+  for (auto z = 0; z < number_of_floors; z++)
   {
-    for (int y = position.getY() - 7; y <= position.getY() + 6; ++y)
+    if (!Viewport::canSeeFloor(z, position.getZ()))
     {
-      Position tempPosition(x, y, position.getZ());
-      const auto* tile = getTile(tempPosition);
-      if (!tile)
-      {
-        continue;
-      }
-
-      if (!tile->getCreatureIds().empty())
-      {
-        creatureIds.insert(creatureIds.cend(),
-                           tile->getCreatureIds().cbegin(),
-                           tile->getCreatureIds().cend());
-      }
+      continue;
     }
+
+    const auto offset = Viewport::getFloorOffset(z, position.getZ());
+    sector_grid_.getCreatureIds(position.getX() - Viewport::east - offset,
+                                position.getY() - Viewport::south - offset,
+                                position.getX() + Viewport::west - offset,
+                                position.getY() + Viewport::north - offset,
+                                z,
+                                &creatureIds);
   }
+  return creatureIds;
+}
 
+std::vector<CreatureId> World::getVisibleCreatureIds(const Position& viewerPosition) const
+{
+  std::vector<CreatureId> creatureIds;
+  const auto highestFloor = Viewport::getHighestVisibleFloor(viewerPosition.getZ());
+  const auto lowestFloor = Viewport::getLowestVisibleFloor(viewerPosition.getZ());
+  for (auto z = highestFloor; z <= lowestFloor; z++)
+  {
+    const auto offset = Viewport::getFloorOffset(viewerPosition.getZ(), z);
+    sector_grid_.getCreatureIds(viewerPosition.getX() - Viewport::west + offset,
+                                viewerPosition.getY() - Viewport::north + offset,
+                                viewerPosition.getX() + Viewport::east + offset,
+                                viewerPosition.getY() + Viewport::south + offset,
+                                z,
+                                &creatureIds);
+  }
   return creatureIds;
 }
 
-Tile* World::internalGetTile(const Position& position)
+void World::pageInSectorsAround(const Position& position)
 {
-  if (position.getX() < position_offset ||
-      position.getX() >= position_offset + worldSizeX_ ||
-      position.getY() < position_offset ||
-      position.getY() >= position_offset + worldSizeY_ ||
-      position.getZ() != 7)
+  forEachPagingArea(position, [this](int x_min, int y_min, int x_max, int y_max, int z)
   {
-    return nullptr;
+    tile_store_.pageIn(x_min, y_min, x_max, y_max, z);
+  });
+}
+
+void World::flushEvents()
+{
+  for (const auto creatureId : creature_ids_with_events_)
+  {
+    flushEvents(creatureId);
   }
+  creature_ids_with_events_.clear();
+  event_messages_.clear();
 
-  const auto index = ((position.getX() - position_offset) * worldSizeY_) +
-                      (position.getY() - position_offset);
-  return &tiles_[index];
+  // Clears all observer_ids
+  event_generation_ += 1;
 }
 
-const Tile* World::getTile(const Position& position) const
+void World::queueEvent(CreatureId creatureId, const WorldEvent& event)
 {
-  if (position.getX() < position_offset ||
-      position.getX() >= position_offset + worldSizeX_ ||
-      position.getY() < position_offset ||
-      position.getY() >= position_offset + worldSizeY_ ||
-      position.getZ() != 7)
+  auto& events = creature_data_.at(creatureId).events;
+  if (events.empty())
   {
-    return nullptr;
+    creature_ids_with_events_.push_back(creatureId);
   }
+  events.push_back(event);
 
-  const auto index = ((position.getX() - position_offset) * worldSizeY_) +
-                      (position.getY() - position_offset);
-  return &tiles_[index];
+  // Remember who has events about the creature in the event, see removeCreature
+  auto it = creature_data_.find(event.creatureId);
+  if (it != creature_data_.end())
+  {
+    auto& subject = it->second;
+    if (subject.observer_generation != event_generation_)
+    {
+      subject.observer_ids.clear();
+      subject.observer_generation = event_generation_;
+    }
+    if (subject.observer_ids.empty() || subject.observer_ids.back() != creatureId)
+    {
+      subject.observer_ids.push_back(creatureId);
+    }
+  }
 }
 
-Creature& World::internalGetCreature(CreatureId creatureId)
+void World::flushEvents(CreatureId creatureId)
 {
-  if (!creatureExists(creatureId))
+  auto it = creature_data_.find(creatureId);
+  if (it == creature_data_.end() || it->second.events.empty())
   {
-    LOG_ERROR("%s: called with non-existent CreatureId: %d", __func__, creatureId);
+    return;
   }
-  return *(creature_data_.at(creatureId).creature);
+
+  // The vector keeps its capacity, so there are no allocations once it has grown to the largest tick
+  it->second.creature_ctrl->onWorldEvents(*this, it->second.events);
+  it->second.events.clear();
 }
 
-const Creature& World::getCreature(CreatureId creatureId) const
+void World::queueItemAdded(const Item& item, const Position& position)
+{
+  WorldEvent event;
+  event.type = WorldEvent::Type::ITEM_ADDED;
+  event.position = position;
+  event.item = item;
+  for (const auto& nearCreatureId : getCreatureIdsThatCanSeePosition(position))
+  {
+    queueEvent(nearCreatureId, event);
+  }
+}
+
+void World::queueItemRemoved(const Position& position, int stackPos)
+{
+  WorldEvent event;
+  event.type = WorldEvent::Type::ITEM_REMOVED;
+  event.stackPos = stackPos;
+  event.position = position;
+  for (const auto& nearCreatureId : getCreatureIdsThatCanSeePosition(position))
+  {
+    queueEvent(nearCreatureId, event);
+  }
+}
+
+void World::queueTileUpdate(const Position& position)
+{
+  // Delivered directly, since the current tile is sent with it
+  WorldEvent event;
+  event.type = WorldEvent::Type::TILE_UPDATE;
+  event.position = position;
+  for (const auto& nearCreatureId : getCreatureIdsThatCanSeePosition(position))
+  {
+    queueEvent(nearCreatureId, event);
+    flushEvents(nearCreatureId);
+  }
+}
+
+void World::updateTileBits(const Position& position, const Tile* tile)
+{
+  walkability_map_.setWalkable(position, tile && tile->isWalkable());
+  line_of_sight_.setPassable(position, tile && !tile->isBlockingProjectiles());
+}
+
+Tile* World::internalGetTile(const Position& position)
+{
+  return tile_store_.getTile(position);
+}
+
+const Tile* World::getTile(const Position& position) const
+{
+  return tile_store_.getTile(position);
+}
+
+Creature& World::internalGetCreature(CreatureId creatureId)
 {
   if (!creatureExists(creatureId))
   {
     LOG_ERROR("%s: called with non-existent CreatureId: %d", __func__, creatureId);
-    return Creature::INVALID;
   }
   return *(creature_data_.at(creatureId).creature);
 }
 
-CreatureCtrl& World::getCreatureCtrl(CreatureId creatureId)
+const Creature& World::getCreature(CreatureId creatureId) const
 {
   if (!creatureExists(creatureId))
   {
-    LOG_ERROR("getCreatureCtrl called with non-existent CreatureId");
+    LOG_ERROR("%s: called with non-existent CreatureId: %d", __func__, creatureId);
+    return Creature::INVALID;
   }
-  return *(creature_data_.at(creatureId).creature_ctrl);
+  return *(creature_data_.at(creatureId).creature);
 }
 
 const Position& World::getCreaturePosition(CreatureId creatureId) const
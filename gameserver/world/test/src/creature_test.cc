@@ -45,6 +45,20 @@ TEST(CreatureTest, CreatureId)
   ASSERT_NE(creatureFoo.getCreatureId(), creatureBar.getCreatureId());
 }
 
+TEST(CreatureTest, RestoredCreatureId)
+{
+  Creature creatureFoo("foo");
+
+  // A restored creature keeps its id, and later creatures get higher ids
+  const auto restoredId = creatureFoo.getCreatureId() + 100;
+  Creature creatureBar(restoredId, "bar");
+  Creature creatureBaz("baz");
+
+  ASSERT_EQ(restoredId, creatureBar.getCreatureId());
+  ASSERT_EQ("bar", creatureBar.getName());
+  ASSERT_GT(creatureBaz.getCreatureId(), restoredId);
+}
+
 TEST(CreatureTest, Equals)
 {
   Creature creatureFoo("foo");
@@ -47,6 +47,15 @@ class MockCreatureCtrl : public CreatureCtrl
                                     int oldStackPos,
                                     const Position& newPosition));
 
+  MOCK_METHOD3(onCreatureEnterView, void(const WorldInterface& world_interface,
+                                         const Creature& creature,
+                                         const Position& position));
+
+  MOCK_METHOD4(onCreatureLeaveView, void(const WorldInterface& world_interface,
+                                         const Creature& creature,
+                                         const Position& oldPosition,
+                                         int oldStackPos));
+
   MOCK_METHOD4(onCreatureTurn, void(const WorldInterface& world_interface,
                                     const Creature& creature,
                                     const Position& position,
@@ -0,0 +1,125 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "line_of_sight.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// Creates a map from rows of '.' (passable) and '#' (blocks projectiles), starting at (100, 100, 7)
+void createMap(const std::vector<std::string>& rows, LineOfSight* lineOfSight)
+{
+  for (auto y = 0u; y < rows.size(); y++)
+  {
+    for (auto x = 0u; x < rows[y].size(); x++)
+    {
+      lineOfSight->setPassable(Position(100 + x, 100 + y, 7), rows[y][x] == '.');
+    }
+  }
+}
+
+}  // namespace
+
+TEST(LineOfSightTest, Passable)
+{
+  LineOfSight lineOfSight;
+  createMap({ ".#" }, &lineOfSight);
+
+  EXPECT_TRUE(lineOfSight.isPassable(Position(100, 100, 7)));
+  EXPECT_FALSE(lineOfSight.isPassable(Position(101, 100, 7)));
+  EXPECT_FALSE(lineOfSight.isPassable(Position(100, 100, 6)));   // No tile
+  EXPECT_FALSE(lineOfSight.isPassable(Position(-1, 100, 7)));    // Invalid position
+}
+
+TEST(LineOfSightTest, OpenArea)
+{
+  LineOfSight lineOfSight;
+  createMap({ ".....",
+              ".....",
+              "....." }, &lineOfSight);
+
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(100, 100, 7)));
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(104, 100, 7)));
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(104, 102, 7)));
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(104, 102, 7), Position(100, 101, 7)));
+
+  // Outside of the map, different floors or too far away
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(105, 100, 7)));
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(100, 100, 6)));
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 100, 7),
+                                              Position(100 + LineOfSight::max_distance + 1, 100, 7)));
+}
+
+TEST(LineOfSightTest, Walls)
+{
+  LineOfSight lineOfSight;
+  createMap({ "..#..",
+              ".....",
+              "....#",
+              "...#." }, &lineOfSight);
+
+  // Wall in between
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(104, 100, 7)));
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(104, 100, 7), Position(100, 100, 7)));
+
+  // Past the wall
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(104, 101, 7)));
+
+  // Onto a wall
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 100, 7), Position(102, 100, 7)));
+
+  // From a wall, the from tile is not checked
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(102, 100, 7), Position(102, 101, 7)));
+
+  // Adjacent tiles have no tiles in between, even diagonally between two walls
+  EXPECT_TRUE(lineOfSight.computeLineOfSight(Position(103, 102, 7), Position(104, 103, 7)));
+  EXPECT_FALSE(lineOfSight.computeLineOfSight(Position(100, 103, 7), Position(104, 103, 7)));
+}
+
+TEST(LineOfSightTest, Cache)
+{
+  LineOfSight lineOfSight;
+  createMap({ "....." }, &lineOfSight);
+
+  const Position from(100, 100, 7);
+  const Position to(104, 100, 7);
+  EXPECT_TRUE(lineOfSight.hasLineOfSight(from, to));
+  EXPECT_TRUE(lineOfSight.hasLineOfSight(from, to));
+
+  // Changing a tile invalidates the cached result
+  lineOfSight.setPassable(Position(102, 100, 7), false);
+  EXPECT_FALSE(lineOfSight.hasLineOfSight(from, to));
+  EXPECT_FALSE(lineOfSight.hasLineOfSight(from, to));
+
+  lineOfSight.setPassable(Position(102, 100, 7), true);
+  EXPECT_TRUE(lineOfSight.hasLineOfSight(from, to));
+
+  // Too far away is never cached
+  EXPECT_FALSE(lineOfSight.hasLineOfSight(from, Position(100 + LineOfSight::max_distance + 1, 100, 7)));
+}
@@ -0,0 +1,202 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "pathfinder.h"
+#include "pathfinding_service.h"
+#include "walkability_map.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace
+{
+
+// Creates a map from rows of '.' (walkable) and '#' (not walkable), starting at (100, 100, 7)
+void createMap(const std::vector<std::string>& rows, WalkabilityMap* walkabilityMap)
+{
+  for (auto y = 0u; y < rows.size(); y++)
+  {
+    for (auto x = 0u; x < rows[y].size(); x++)
+    {
+      walkabilityMap->setWalkable(Position(100 + x, 100 + y, 7), rows[y][x] == '.');
+    }
+  }
+}
+
+// Returns the position reached by walking the path
+Position walk(const Position& from, const std::deque<Direction>& path)
+{
+  auto position = from;
+  for (const auto& direction : path)
+  {
+    position = position.addDirection(direction);
+  }
+  return position;
+}
+
+}  // namespace
+
+TEST(PathfinderTest, WalkabilityMap)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ "..#",
+              "#..", }, &walkabilityMap);
+
+  EXPECT_TRUE(walkabilityMap.isWalkable(Position(100, 100, 7)));
+  EXPECT_FALSE(walkabilityMap.isWalkable(Position(102, 100, 7)));
+  EXPECT_FALSE(walkabilityMap.isWalkable(Position(100, 100, 6)));   // No tile
+  EXPECT_FALSE(walkabilityMap.isWalkable(Position(-1, 100, 7)));    // Invalid position
+
+  // Rectangle starting one tile outside of the map
+  std::vector<std::uint64_t> bits;
+  walkabilityMap.copyRectangle(99, 99, 7, 5, 4, &bits);
+  ASSERT_EQ(1u, bits.size());
+  // Rows (y = 99..102) of x = 99..103
+  //   .....  -> 00000
+  //   ...#.  -> 01100 (x = 100, 101)
+  //   .#..   -> 00110 (x = 101, 102)
+  //   .....  -> 00000
+  EXPECT_EQ((0x6u << 5) | (0xCu << 10), bits[0]);
+}
+
+TEST(PathfinderTest, StraightPath)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ ".....",
+              ".....", }, &walkabilityMap);
+
+  Pathfinder pathfinder;
+  std::deque<Direction> path;
+  ASSERT_EQ(Pathfinder::Result::FOUND,
+            pathfinder.findPath(walkabilityMap, Position(100, 100, 7), Position(104, 100, 7), &path));
+  EXPECT_EQ(std::deque<Direction>(4, Direction::EAST), path);
+}
+
+TEST(PathfinderTest, PathAroundWall)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ ".#...",
+              ".#.#.",
+              "...#.", }, &walkabilityMap);
+
+  Pathfinder pathfinder;
+  std::deque<Direction> path;
+  const Position from(100, 100, 7);
+  const Position to(104, 100, 7);
+  ASSERT_EQ(Pathfinder::Result::FOUND, pathfinder.findPath(walkabilityMap, from, to, &path));
+
+  // Down, right, up and right around the first wall
+  EXPECT_EQ(8u, path.size());
+  EXPECT_EQ(to, walk(from, path));
+
+  // Same pathfinder is reused for the way back
+  ASSERT_EQ(Pathfinder::Result::FOUND, pathfinder.findPath(walkabilityMap, to, from, &path));
+  EXPECT_EQ(8u, path.size());
+  EXPECT_EQ(from, walk(to, path));
+}
+
+TEST(PathfinderTest, NoPath)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ "..#..",
+              "..#..",
+              "..#..", }, &walkabilityMap);
+
+  Pathfinder pathfinder;
+  std::deque<Direction> path;
+  EXPECT_EQ(Pathfinder::Result::NOT_FOUND,
+            pathfinder.findPath(walkabilityMap, Position(100, 100, 7), Position(104, 100, 7), &path));
+  EXPECT_TRUE(path.empty());
+
+  // Goal is not walkable
+  EXPECT_EQ(Pathfinder::Result::NOT_FOUND,
+            pathfinder.findPath(walkabilityMap, Position(100, 100, 7), Position(102, 100, 7), &path));
+
+  // Goal is too far away
+  walkabilityMap.setWalkable(Position(100 + Pathfinder::max_distance + 1, 100, 7), true);
+  EXPECT_EQ(Pathfinder::Result::NOT_FOUND,
+            pathfinder.findPath(walkabilityMap,
+                                Position(100, 100, 7),
+                                Position(100 + Pathfinder::max_distance + 1, 100, 7),
+                                &path));
+}
+
+TEST(PathfinderTest, SearchInSteps)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ "..........", }, &walkabilityMap);
+
+  Pathfinder pathfinder;
+  pathfinder.start(walkabilityMap, Position(100, 100, 7), Position(109, 100, 7));
+  for (auto i = 0; i < 9; i++)
+  {
+    ASSERT_EQ(Pathfinder::Result::SEARCHING, pathfinder.search(1));
+  }
+  ASSERT_EQ(Pathfinder::Result::FOUND, pathfinder.search(1));
+  EXPECT_EQ(10, pathfinder.getNumberOfExpandedNodes());
+
+  std::deque<Direction> path;
+  pathfinder.getPath(&path);
+  EXPECT_EQ(std::deque<Direction>(9, Direction::EAST), path);
+}
+
+TEST(PathfinderTest, PathfindingService)
+{
+  WalkabilityMap walkabilityMap;
+  createMap({ "..........",
+              "#########.", }, &walkabilityMap);
+
+  PathfindingService pathfindingService(&walkabilityMap);
+  std::vector<std::pair<int, std::size_t>> results;
+  const auto callback = [&results](int creatureId)
+  {
+    return [&results, creatureId](bool found, std::deque<Direction>&& path)
+    {
+      EXPECT_TRUE(found);
+      results.emplace_back(creatureId, path.size());
+    };
+  };
+
+  pathfindingService.requestPath(1, Position(100, 100, 7), Position(109, 100, 7), callback(1));
+  pathfindingService.requestPath(2, Position(100, 100, 7), Position(109, 101, 7), callback(2));
+  pathfindingService.requestPath(3, Position(100, 100, 7), Position(101, 100, 7), callback(3));
+  pathfindingService.cancel(3);
+
+  // Not enough budget to finish the first request
+  EXPECT_EQ(5, pathfindingService.process(5));
+  EXPECT_TRUE(results.empty());
+
+  // Finishes the first request and continues with the second one
+  pathfindingService.process(15);
+  ASSERT_EQ(1u, results.size());
+  EXPECT_EQ(std::make_pair(1, std::size_t(9)), results[0]);
+
+  pathfindingService.process(100);
+  ASSERT_EQ(2u, results.size());
+  EXPECT_EQ(std::make_pair(2, std::size_t(10)), results[1]);
+  EXPECT_FALSE(pathfindingService.hasRequests());
+}
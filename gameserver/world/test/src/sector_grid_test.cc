@@ -0,0 +1,128 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "sector_grid.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "gmock/gmock.h"
+
+using ::testing::ElementsAre;
+using ::testing::UnorderedElementsAre;
+using ::testing::IsEmpty;
+
+TEST(SectorGridTest, AddRemoveCreature)
+{
+  SectorGrid sectorGrid;
+
+  sectorGrid.addCreature(1, Position(192, 192, 7));
+  sectorGrid.addCreature(2, Position(193, 193, 7));
+  ASSERT_THAT(sectorGrid.getCreatureIds(192, 192, 193, 193, 7), UnorderedElementsAre(1, 2));
+
+  ASSERT_TRUE(sectorGrid.removeCreature(1, Position(192, 192, 7)));
+  ASSERT_THAT(sectorGrid.getCreatureIds(192, 192, 193, 193, 7), ElementsAre(2));
+
+  // Already removed
+  ASSERT_FALSE(sectorGrid.removeCreature(1, Position(192, 192, 7)));
+
+  // Wrong position
+  ASSERT_FALSE(sectorGrid.removeCreature(2, Position(300, 300, 7)));
+
+  ASSERT_TRUE(sectorGrid.removeCreature(2, Position(193, 193, 7)));
+  ASSERT_THAT(sectorGrid.getCreatureIds(192, 192, 193, 193, 7), IsEmpty());
+}
+
+TEST(SectorGridTest, QueryRectangle)
+{
+  SectorGrid sectorGrid;
+
+  // Creatures in different sectors and on different floors
+  sectorGrid.addCreature(1, Position(100, 100, 7));
+  sectorGrid.addCreature(2, Position(107, 100, 7));  // Same sector as 1
+  sectorGrid.addCreature(3, Position(108, 100, 7));  // Next sector
+  sectorGrid.addCreature(4, Position(100, 100, 6));  // Other floor
+  sectorGrid.addCreature(5, Position(130, 130, 7));  // Far away
+
+  // Rectangle within a single sector, only partially covering it
+  ASSERT_THAT(sectorGrid.getCreatureIds(100, 100, 100, 100, 7), ElementsAre(1));
+
+  // Rectangle spanning two sectors
+  ASSERT_THAT(sectorGrid.getCreatureIds(101, 95, 110, 105, 7), UnorderedElementsAre(2, 3));
+
+  // Other floor
+  ASSERT_THAT(sectorGrid.getCreatureIds(90, 90, 110, 110, 6), ElementsAre(4));
+
+  // Large rectangle
+  ASSERT_THAT(sectorGrid.getCreatureIds(0, 0, 200, 200, 7), UnorderedElementsAre(1, 2, 3, 5));
+
+  // Rectangle partially outside of the map
+  ASSERT_THAT(sectorGrid.getCreatureIds(-9, -7, 8, 6, 7), IsEmpty());
+}
+
+TEST(SectorGridTest, MoveCreature)
+{
+  SectorGrid sectorGrid;
+
+  sectorGrid.addCreature(1, Position(100, 100, 7));
+
+  // Move within the same sector
+  ASSERT_TRUE(sectorGrid.moveCreature(1, Position(100, 100, 7), Position(101, 100, 7)));
+  ASSERT_THAT(sectorGrid.getCreatureIds(100, 100, 100, 100, 7), IsEmpty());
+  ASSERT_THAT(sectorGrid.getCreatureIds(101, 100, 101, 100, 7), ElementsAre(1));
+
+  // Move to another sector
+  ASSERT_TRUE(sectorGrid.moveCreature(1, Position(101, 100, 7), Position(101, 99, 7)));
+  ASSERT_THAT(sectorGrid.getCreatureIds(96, 96, 111, 111, 7), ElementsAre(1));
+  ASSERT_THAT(sectorGrid.getCreatureIds(101, 100, 101, 100, 7), IsEmpty());
+  ASSERT_THAT(sectorGrid.getCreatureIds(101, 99, 101, 99, 7), ElementsAre(1));
+
+  // Move with invalid from position
+  ASSERT_FALSE(sectorGrid.moveCreature(1, Position(50, 50, 7), Position(51, 50, 7)));
+  ASSERT_THAT(sectorGrid.getCreatureIds(101, 99, 101, 99, 7), ElementsAre(1));
+}
+
+TEST(SectorGridTest, EmptySectorsAreRemoved)
+{
+  SectorGrid sectorGrid;
+
+  sectorGrid.addCreature(1, Position(100, 100, 7));
+  sectorGrid.addCreature(2, Position(101, 100, 7));
+  ASSERT_EQ(1u, sectorGrid.getNumberOfSectors());
+
+  // A creature that roams through many sectors only leaves its current sector behind
+  auto position = Position(100, 100, 7);
+  for (auto x = 101; x < 200; x++)
+  {
+    const auto nextPosition = Position(x, 100, 7);
+    ASSERT_TRUE(sectorGrid.moveCreature(1, position, nextPosition));
+    position = nextPosition;
+  }
+  ASSERT_EQ(2u, sectorGrid.getNumberOfSectors());
+
+  ASSERT_TRUE(sectorGrid.removeCreature(1, position));
+  ASSERT_TRUE(sectorGrid.removeCreature(2, Position(101, 100, 7)));
+  ASSERT_EQ(0u, sectorGrid.getNumberOfSectors());
+  ASSERT_THAT(sectorGrid.getCreatureIds(0, 0, 300, 300, 7), IsEmpty());
+}
@@ -0,0 +1,206 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "tile_store.h"
+
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "item.h"
+#include "sector_store.h"
+
+namespace
+{
+
+// Keeps the ground Item of each paged out tile in memory
+class SectorStoreFake : public SectorStore
+{
+ public:
+  bool storeSector(const Position& position, const std::vector<Tile>& tiles) override
+  {
+    auto& groundItems = sectors[std::make_tuple(position.getX(), position.getY(), position.getZ())];
+    for (const auto& tile : tiles)
+    {
+      groundItems.push_back(tile.getItems().empty() ? nullptr : tile.getItems().front());
+    }
+    return true;
+  }
+
+  bool loadSector(const Position& position, std::vector<Tile>* tiles) override
+  {
+    auto it = sectors.find(std::make_tuple(position.getX(), position.getY(), position.getZ()));
+    if (it == sectors.end() || it->second.size() != tiles->size())
+    {
+      return false;
+    }
+
+    for (auto i = 0u; i < tiles->size(); i++)
+    {
+      if (it->second[i])
+      {
+        (*tiles)[i] = Tile(it->second[i]);
+      }
+    }
+    sectors.erase(it);
+    return true;
+  }
+
+  std::map<std::tuple<int, int, int>, std::vector<Item*>> sectors;
+};
+
+}  // namespace
+
+TEST(TileStoreTest, SetGetTile)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  TileStore tileStore;
+
+  // Tiles far apart, sectors are only allocated where there are tiles
+  tileStore.setTile(Position(100, 100, 7), Tile(&groundItem));
+  tileStore.setTile(Position(60000, 100, 7), Tile(&groundItem));
+  tileStore.setTile(Position(100, 100, 0), Tile(&groundItem));
+  EXPECT_EQ(3u, tileStore.getNumberOfSectors());
+
+  EXPECT_NE(nullptr, tileStore.getTile(Position(100, 100, 7)));
+  EXPECT_NE(nullptr, tileStore.getTile(Position(60000, 100, 7)));
+  EXPECT_NE(nullptr, tileStore.getTile(Position(100, 100, 0)));
+
+  // Same sector, but no tile
+  EXPECT_EQ(nullptr, tileStore.getTile(Position(101, 100, 7)));
+
+  // No sector
+  EXPECT_EQ(nullptr, tileStore.getTile(Position(1000, 100, 7)));
+
+  // Invalid positions
+  EXPECT_EQ(nullptr, tileStore.getTile(Position(-1, 100, 7)));
+  EXPECT_EQ(nullptr, tileStore.getTile(Position(100, -1, 7)));
+}
+
+TEST(TileStoreTest, PageOutPageIn)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  SectorStoreFake sectorStore;
+  TileStore tileStore;
+  tileStore.setSectorStore(&sectorStore);
+
+  tileStore.setTile(Position(100, 100, 7), Tile(&groundItem));
+  tileStore.setTile(Position(200, 200, 7), Tile(&groundItem));
+  EXPECT_EQ(2u, tileStore.getNumberOfResidentSectors());
+
+  // Sector with (100, 100, 7) is in use, so only the other one is paged out
+  tileStore.markInUse(95, 95, 105, 105, 7);
+  EXPECT_EQ(1, tileStore.pageOut());
+  EXPECT_EQ(1u, tileStore.getNumberOfResidentSectors());
+  EXPECT_EQ(1u, sectorStore.sectors.size());
+
+  // Accessing the paged out sector pages it in again
+  const auto* tile = tileStore.getTile(Position(200, 200, 7));
+  ASSERT_NE(nullptr, tile);
+  EXPECT_EQ(&groundItem, tile->getItems().front());
+  EXPECT_EQ(2u, tileStore.getNumberOfResidentSectors());
+  EXPECT_TRUE(sectorStore.sectors.empty());
+
+  // Marks are cleared by pageOut, so now both are paged out
+  EXPECT_EQ(2, tileStore.pageOut());
+  EXPECT_EQ(0u, tileStore.getNumberOfResidentSectors());
+
+  // Page in explicitly
+  tileStore.pageIn(0, 0, 150, 150, 7);
+  EXPECT_EQ(1u, tileStore.getNumberOfResidentSectors());
+}
+
+TEST(TileStoreTest, NoPageOutWithCreatures)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  SectorStoreFake sectorStore;
+  TileStore tileStore;
+  tileStore.setSectorStore(&sectorStore);
+
+  tileStore.setTile(Position(100, 100, 7), Tile(&groundItem));
+  tileStore.getTile(Position(100, 100, 7))->addCreature(1);
+
+  EXPECT_EQ(0, tileStore.pageOut());
+  EXPECT_EQ(1u, tileStore.getNumberOfResidentSectors());
+}
+
+TEST(TileStoreTest, AddPagedOutSector)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  SectorStoreFake sectorStore;
+  TileStore tileStore;
+  tileStore.setSectorStore(&sectorStore);
+
+  // The sector is only in the SectorStore until it is accessed
+  std::vector<Item*> groundItems(TileStore::sector_size * TileStore::sector_size, nullptr);
+  groundItems[TileStore::getTileIndex(Position(100, 100, 7))] = &groundItem;
+  sectorStore.sectors[std::make_tuple(96, 96, 7)] = groundItems;
+  tileStore.addPagedOutSector(Position(96, 96, 7));
+  EXPECT_EQ(1u, tileStore.getNumberOfSectors());
+  EXPECT_EQ(0u, tileStore.getNumberOfResidentSectors());
+
+  const auto* tile = tileStore.getTile(Position(100, 100, 7));
+  ASSERT_NE(nullptr, tile);
+  EXPECT_EQ(&groundItem, tile->getItems().front());
+  EXPECT_EQ(nullptr, tileStore.getTile(Position(101, 100, 7)));
+  EXPECT_EQ(1u, tileStore.getNumberOfResidentSectors());
+  EXPECT_TRUE(sectorStore.sectors.empty());
+}
+
+TEST(TileStoreTest, ModifiedTiles)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  SectorStoreFake sectorStore;
+  TileStore tileStore;
+  tileStore.setSectorStore(&sectorStore);
+
+  tileStore.setTile(Position(100, 100, 7), Tile(&groundItem));
+  tileStore.setTile(Position(101, 100, 7), Tile(&groundItem));
+  tileStore.setTile(Position(200, 200, 7), Tile(&groundItem));
+
+  // Only tiles in sectors that are marked as modified, and no positions without a tile
+  tileStore.markModified(Position(100, 100, 7));
+  tileStore.markModified(Position(1000, 1000, 7));
+
+  // Modified sectors are still modified after being paged out and in
+  EXPECT_EQ(2, tileStore.pageOut());
+
+  std::vector<Position> positions;
+  tileStore.forEachModifiedTile([&positions, &groundItem](const Position& position, const Tile& tile)
+  {
+    EXPECT_EQ(&groundItem, tile.getItems().front());
+    positions.push_back(position);
+  });
+  ASSERT_EQ(2u, positions.size());
+  EXPECT_EQ(Position(100, 100, 7), positions[0]);
+  EXPECT_EQ(Position(101, 100, 7), positions[1]);
+  EXPECT_EQ(1u, tileStore.getNumberOfResidentSectors());
+}
@@ -23,13 +23,10 @@
  */
 
 #include "tile.h"
-#include "item_mock.h"
+#include "item.h"
 
 #include "gtest/gtest.h"
 
-using ::testing::Return;
-using ::testing::ReturnRef;
-
 class TileTest : public ::testing::Test
 {
 };
@@ -37,10 +34,10 @@ class TileTest : public ::testing::Test
 TEST_F(TileTest, Constructor)
 {
   ItemType groundItemType;
-  ItemMock groundItem;
+  Item groundItem(0, &groundItemType);
   const auto tile = Tile(&groundItem);
 
-  EXPECT_CALL(groundItem, getItemTypeId()).WillOnce(Return(123));
+  groundItemType.id = 123;
   ASSERT_EQ(123, tile.getItem(0)->getItemTypeId());
   ASSERT_EQ(1u, tile.getNumberOfThings());  // Only ground item
 }
@@ -48,7 +45,7 @@ TEST_F(TileTest, Constructor)
 TEST_F(TileTest, AddRemoveCreatures)
 {
   ItemType groundItemType;
-  ItemMock groundItem;
+  Item groundItem(0, &groundItemType);
   auto tile = Tile(&groundItem);
 
   CreatureId creatureA(1);
@@ -89,23 +86,20 @@ TEST_F(TileTest, AddRemoveCreatures)
 TEST_F(TileTest, AddRemoveItems)
 {
   ItemType groundItemType;
-  ItemMock groundItem;
+  Item groundItem(0, &groundItemType);
   auto tile = Tile(&groundItem);
 
   ItemType itemTypeA;
-  ItemMock itemA;
-  EXPECT_CALL(itemA, getItemTypeId()).WillRepeatedly(Return(1));
-  EXPECT_CALL(itemA, getItemType()).WillRepeatedly(ReturnRef(itemTypeA));
+  itemTypeA.id = 1;
+  Item itemA(0, &itemTypeA);
 
   ItemType itemTypeB;
-  ItemMock itemB;
-  EXPECT_CALL(itemB, getItemTypeId()).WillRepeatedly(Return(2));
-  EXPECT_CALL(itemB, getItemType()).WillRepeatedly(ReturnRef(itemTypeB));
+  itemTypeB.id = 2;
+  Item itemB(0, &itemTypeB);
 
   ItemType itemTypeC;
-  ItemMock itemC;
-  EXPECT_CALL(itemC, getItemTypeId()).WillRepeatedly(Return(3));
-  EXPECT_CALL(itemC, getItemType()).WillRepeatedly(ReturnRef(itemTypeC));
+  itemTypeC.id = 3;
+  Item itemC(0, &itemTypeC);
 
   // Add an item and remove it
   tile.addItem(&itemA);
@@ -137,3 +131,98 @@ TEST_F(TileTest, AddRemoveItems)
   ASSERT_TRUE(result);
   ASSERT_EQ(tile.getNumberOfThings(), 1u + 0u);
 }
+
+TEST_F(TileTest, StackPositions)
+{
+  ItemType groundItemType;
+  Item groundItem(0, &groundItemType);
+  auto tile = Tile(&groundItem);
+
+  ItemType topItemType;
+  topItemType.alwaysOnTop = true;
+  topItemType.id = 1;
+  Item topItem(0, &topItemType);
+
+  ItemType bottomItemType;
+  bottomItemType.id = 2;
+  Item bottomItem(0, &bottomItemType);
+
+  // Stack: ground (0), top item (1), creatures (2, 3), bottom item (4)
+  tile.addItem(&bottomItem);
+  tile.addItem(&topItem);
+  tile.addCreature(1);
+  tile.addCreature(2);
+  ASSERT_EQ(5u, tile.getNumberOfThings());
+
+  ASSERT_EQ(&groundItem, tile.getItem(0));
+  ASSERT_EQ(&topItem, tile.getItem(1));
+  ASSERT_EQ(nullptr, tile.getItem(2));
+  ASSERT_EQ(2, tile.getCreatureId(2));
+  ASSERT_EQ(1, tile.getCreatureId(3));
+  ASSERT_EQ(3, tile.getCreatureStackPos(1));
+  ASSERT_EQ(&bottomItem, tile.getItem(4));
+  ASSERT_EQ(nullptr, tile.getItem(5));
+
+  // Removing the top item moves everything up one step
+  ASSERT_TRUE(tile.removeItem(topItem.getItemTypeId(), 1));
+  ASSERT_EQ(2, tile.getCreatureId(1));
+  ASSERT_EQ(2, tile.getCreatureStackPos(1));
+  ASSERT_EQ(&bottomItem, tile.getItem(3));
+
+  // Cannot remove the ground item
+  ASSERT_FALSE(tile.removeItem(0, 0));
+}
+
+TEST_F(TileTest, Flags)
+{
+  ItemType groundItemType;
+  groundItemType.speed = 150;
+  Item groundItem(0, &groundItemType);
+  auto tile = Tile(&groundItem);
+  ASSERT_EQ(150, tile.getGroundSpeed());
+  ASSERT_FALSE(tile.isBlocking());
+  ASSERT_FALSE(tile.hasCreatures());
+  ASSERT_TRUE(tile.isWalkable());
+  ASSERT_FALSE(tile.needsFullUpdate());
+
+  ItemType blockingItemType;
+  blockingItemType.isBlocking = true;
+  blockingItemType.id = 1;
+  Item blockingItem(0, &blockingItemType);
+
+  // Blocking item makes the tile non-walkable until removed
+  tile.addItem(&blockingItem);
+  ASSERT_TRUE(tile.isBlocking());
+  ASSERT_FALSE(tile.isWalkable());
+  ASSERT_TRUE(tile.removeItem(blockingItem.getItemTypeId(), 1));
+  ASSERT_FALSE(tile.isBlocking());
+
+  // Blocking projectiles is separate from blocking creatures
+  ItemType wallItemType;
+  wallItemType.isBlockingProjectiles = true;
+  wallItemType.id = 2;
+  Item wallItem(0, &wallItemType);
+  ASSERT_FALSE(tile.isBlockingProjectiles());
+  tile.addItem(&wallItem);
+  ASSERT_TRUE(tile.isBlockingProjectiles());
+  ASSERT_TRUE(tile.isWalkable());
+  ASSERT_TRUE(tile.removeItem(wallItem.getItemTypeId(), 1));
+  ASSERT_FALSE(tile.isBlockingProjectiles());
+
+  // Creatures also make the tile non-walkable
+  tile.addCreature(1);
+  ASSERT_TRUE(tile.hasCreatures());
+  ASSERT_FALSE(tile.isWalkable());
+  ASSERT_TRUE(tile.removeCreature(1));
+  ASSERT_FALSE(tile.hasCreatures());
+
+  // A tile with max_visible_things or more things can't be updated with a single stack position
+  for (auto i = 1; i < Tile::max_visible_things; i++)
+  {
+    tile.addCreature(i);
+  }
+  ASSERT_EQ(static_cast<std::size_t>(Tile::max_visible_things), tile.getNumberOfThings());
+  ASSERT_TRUE(tile.needsFullUpdate());
+  ASSERT_TRUE(tile.removeCreature(1));
+  ASSERT_FALSE(tile.needsFullUpdate());
+}
@@ -29,23 +29,48 @@
 #include "gmock/gmock.h"
 
 #include "creaturectrl_mock.h"
-#include "item_mock.h"
+#include "item.h"
 #include "world.h"
 #include "creature.h"
 #include "creature_ctrl.h"
 #include "position.h"
 #include "item.h"
 
-using ::testing::ReturnRef;
 using ::testing::AtLeast;
+using ::testing::InSequence;
 using ::testing::_;
 
+namespace
+{
+
+// Keeps the batches of events that World delivers
+class BatchCreatureCtrl : public MockCreatureCtrl
+{
+ public:
+  void onWorldEvents(const WorldInterface& world_interface, const std::vector<WorldEvent>& events) override
+  {
+    batches.push_back(events);
+    CreatureCtrl::onWorldEvents(world_interface, events);
+  }
+
+  std::vector<std::vector<WorldEvent>> batches;
+};
+
+}  // namespace
+
 class WorldTest : public ::testing::Test
 {
  protected:
   WorldTest()
+    : itemType_(),
+      item_(0, &itemType_)
   {
 
+    // Have all ground items be non-blocking
+    itemType_.ground = true;
+    itemType_.speed = 0;
+    itemType_.isBlocking = false;
+
     // We need to build a small simple map
     // Valid positions are (192, 192, 7) to (207, 207, 7)
     std::vector<Tile> tiles;
@@ -53,21 +78,15 @@ class WorldTest : public ::testing::Test
     {
       for (auto y = 0; y < 16; y++)
       {
-        tiles.emplace_back(&itemMock_);
+        tiles.emplace_back(&item_);
       }
     }
 
-    // Have all ground items be non-blocking
-    itemType_.ground = true;
-    itemType_.speed = 0;
-    itemType_.isBlocking = false;
-    EXPECT_CALL(itemMock_, getItemType()).WillRepeatedly(ReturnRef(itemType_));
-
     world = std::make_unique<World>(16, 16, std::move(tiles));
   }
 
-  ItemMock itemMock_;
   ItemType itemType_;
+  Item item_;
   std::unique_ptr<World> world;
 };
 
@@ -81,6 +100,7 @@ TEST_F(WorldTest, AddCreature)
 
   EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureOne, creaturePositionOne));
   world->addCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne);
+  world->flushEvents();
 
   EXPECT_TRUE(world->creatureExists(creatureOne.getCreatureId()));
   EXPECT_EQ(creatureOne, world->getCreature(creatureOne.getCreatureId()));
@@ -96,6 +116,7 @@ TEST_F(WorldTest, AddCreature)
   EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureTwo, creaturePositionTwo));
   EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, creatureTwo, creaturePositionTwo));
   world->addCreature(&creatureTwo, &creatureCtrlTwo, creaturePositionTwo);
+  world->flushEvents();
 
   EXPECT_TRUE(world->creatureExists(creatureTwo.getCreatureId()));
   EXPECT_EQ(creatureTwo, world->getCreature(creatureTwo.getCreatureId()));
@@ -113,6 +134,7 @@ TEST_F(WorldTest, AddCreature)
   EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, creatureThree, creaturePositionThree));
   EXPECT_CALL(creatureCtrlThree, onCreatureSpawn(_, creatureThree, creaturePositionThree));
   world->addCreature(&creatureThree, &creatureCtrlThree, creaturePositionThree);
+  world->flushEvents();
 
   EXPECT_TRUE(world->creatureExists(creatureThree.getCreatureId()));
   EXPECT_EQ(creatureThree, world->getCreature(creatureThree.getCreatureId()));
@@ -131,6 +153,7 @@ TEST_F(WorldTest, AddCreature)
   EXPECT_CALL(creatureCtrlThree, onCreatureSpawn(_, creatureFour, creaturePositionFour));
   EXPECT_CALL(creatureCtrlFour, onCreatureSpawn(_, creatureFour, creaturePositionFour));
   world->addCreature(&creatureFour, &creatureCtrlFour, creaturePositionFour);
+  world->flushEvents();
 
   EXPECT_TRUE(world->creatureExists(creatureFour.getCreatureId()));
   EXPECT_EQ(creatureFour, world->getCreature(creatureFour.getCreatureId()));
@@ -167,17 +190,23 @@ TEST_F(WorldTest, RemoveCreature)
   EXPECT_CALL(creatureCtrlFour, onCreatureSpawn(_, _, _)).Times(1);   // only himself
 
   world->addCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne);
+  world->flushEvents();
   world->addCreature(&creatureTwo, &creatureCtrlTwo, creaturePositionTwo);
+  world->flushEvents();
   world->addCreature(&creatureThree, &creatureCtrlThree, creaturePositionThree);
+  world->flushEvents();
   world->addCreature(&creatureFour, &creatureCtrlFour, creaturePositionFour);
+  world->flushEvents();
 
   // Remove creatureOne
   EXPECT_CALL(creatureCtrlOne, onCreatureDespawn(_, creatureOne, creaturePositionOne, _));
   EXPECT_CALL(creatureCtrlTwo, onCreatureDespawn(_, creatureOne, creaturePositionOne, _));
   EXPECT_CALL(creatureCtrlThree, onCreatureDespawn(_, _, _, _)).Times(0);
   EXPECT_CALL(creatureCtrlFour, onCreatureDespawn(_, _, _, _)).Times(0);
+  EXPECT_FALSE(world->getWalkabilityMap().isWalkable(creaturePositionOne));
   world->removeCreature(creatureOne.getCreatureId());
   EXPECT_FALSE(world->creatureExists(creatureOne.getCreatureId()));
+  EXPECT_TRUE(world->getWalkabilityMap().isWalkable(creaturePositionOne));
 
   // Remove creatureTwo
   EXPECT_CALL(creatureCtrlTwo, onCreatureDespawn(_, creatureTwo, creaturePositionTwo, _));
@@ -198,6 +227,60 @@ TEST_F(WorldTest, RemoveCreature)
   EXPECT_FALSE(world->creatureExists(creatureFour.getCreatureId()));
 }
 
+TEST_F(WorldTest, RestoreCreature)
+{
+  Creature creatureOne("TestCreatureOne");
+  Creature creatureTwo("TestCreatureTwo");
+  MockCreatureCtrl creatureCtrlOne;
+  MockCreatureCtrl creatureCtrlTwo;
+  Position creaturePositionOne(192, 192, 7);
+  Position creaturePositionTwo(193, 193, 7);
+
+  // No creature is told about restored creatures
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, _, _)).Times(0);
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, _, _)).Times(0);
+  EXPECT_EQ(World::ReturnCode::OK, world->restoreCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne));
+  EXPECT_EQ(World::ReturnCode::OK, world->restoreCreature(&creatureTwo, &creatureCtrlTwo, creaturePositionOne));
+  world->flushEvents();
+
+  // Restored at the exact position, even if there is a creature there already
+  EXPECT_EQ(creaturePositionOne, world->getCreaturePosition(creatureOne.getCreatureId()));
+  EXPECT_EQ(creaturePositionOne, world->getCreaturePosition(creatureTwo.getCreatureId()));
+  EXPECT_FALSE(world->getWalkabilityMap().isWalkable(creaturePositionOne));
+  EXPECT_EQ(World::ReturnCode::OTHER_ERROR,
+            world->restoreCreature(&creatureOne, &creatureCtrlOne, creaturePositionTwo));
+
+  // But they see each other as if they were added
+  EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, creatureTwo, creaturePositionOne, _, creaturePositionTwo));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, creaturePositionOne, _, creaturePositionTwo));
+  world->creatureMove(creatureTwo.getCreatureId(), creaturePositionTwo);
+  world->flushEvents();
+}
+
+TEST_F(WorldTest, ModifiedTiles)
+{
+  auto numberOfTiles = 0;
+  const auto countTiles = [&numberOfTiles](const Position&, const Tile&)
+  {
+    numberOfTiles++;
+  };
+
+  // Nothing is modified after loading
+  world->forEachModifiedTile(countTiles);
+  EXPECT_EQ(0, numberOfTiles);
+
+  // All tiles in the sector of the modified tile
+  ItemType itemType;
+  Item item(1, &itemType);
+  EXPECT_EQ(World::ReturnCode::OK, world->addItem(&item, Position(195, 195, 7)));
+  world->forEachModifiedTile(countTiles);
+  EXPECT_EQ(TileStore::sector_size * TileStore::sector_size, numberOfTiles);
+
+  // A restored tile replaces the old one
+  world->restoreTile(Position(195, 195, 7), Tile(&item_));
+  EXPECT_EQ(1u, world->getTile(Position(195, 195, 7))->getItems().size());
+}
+
 TEST_F(WorldTest, CreatureMoveSingleCreature)
 {
   Creature creatureOne("TestCreatureOne");
@@ -205,16 +288,280 @@ TEST_F(WorldTest, CreatureMoveSingleCreature)
   Position creaturePositionOne(192, 192, 7);
   EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, _, _));
   world->addCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne);
+  world->flushEvents();
 
   // Test with Direction
   EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, _, _, _, _));
   Direction direction(Direction::EAST);
   world->creatureMove(creatureOne.getCreatureId(), direction);
+  world->flushEvents();
   EXPECT_EQ(creaturePositionOne.addDirection(direction), world->getCreaturePosition(creatureOne.getCreatureId()));
 
   // Test with Position, from (193, 192, 7) to (193, 193, 7)
   EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, _, _, _, _));
   Position position(193, 193, 7);
   world->creatureMove(creatureOne.getCreatureId(), position);
+  world->flushEvents();
   EXPECT_EQ(position, world->getCreaturePosition(creatureOne.getCreatureId()));
 }
+
+TEST_F(WorldTest, CreatureMoveEnterLeaveView)
+{
+  // creatureOne at (192, 192, 7) can see from (184, 186, 7) to (201, 199, 7)
+  Creature creatureOne("TestCreatureOne");
+  MockCreatureCtrl creatureCtrlOne;
+  Position creaturePositionOne(192, 192, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureOne, _));
+  world->addCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne);
+  world->flushEvents();
+
+  // creatureTwo at (202, 192, 7) is outside creatureOne's view
+  Creature creatureTwo("TestCreatureTwo");
+  MockCreatureCtrl creatureCtrlTwo;
+  Position creaturePositionTwo(202, 192, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureTwo, _)).Times(0);
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, creatureTwo, _));
+  world->addCreature(&creatureTwo, &creatureCtrlTwo, creaturePositionTwo);
+  world->flushEvents();
+
+  // Move creatureTwo into creatureOne's view
+  Position positionInView(201, 192, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureEnterView(_, creatureTwo, positionInView));
+  EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, _, _, _, _)).Times(0);
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, creaturePositionTwo, _, positionInView));
+  world->creatureMove(creatureTwo.getCreatureId(), positionInView);
+  world->flushEvents();
+
+  // Move creatureTwo within creatureOne's view
+  Position positionStillInView(200, 192, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, creatureTwo, positionInView, _, positionStillInView));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, positionInView, _, positionStillInView));
+  world->creatureMove(creatureTwo.getCreatureId(), positionStillInView);
+  world->flushEvents();
+
+  // Move creatureTwo out of creatureOne's view again
+  EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, creatureTwo, positionStillInView, _, positionInView));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, positionStillInView, _, positionInView));
+  world->creatureMove(creatureTwo.getCreatureId(), positionInView);
+  world->flushEvents();
+
+  EXPECT_CALL(creatureCtrlOne, onCreatureLeaveView(_, creatureTwo, positionInView, _));
+  EXPECT_CALL(creatureCtrlOne, onCreatureEnterView(_, _, _)).Times(0);
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, positionInView, _, creaturePositionTwo));
+  world->creatureMove(creatureTwo.getCreatureId(), creaturePositionTwo);
+  world->flushEvents();
+
+  // creatureTwo is no longer visible to creatureOne, so it should not be told about the despawn
+  EXPECT_CALL(creatureCtrlOne, onCreatureDespawn(_, _, _, _)).Times(0);
+  EXPECT_CALL(creatureCtrlTwo, onCreatureDespawn(_, creatureTwo, creaturePositionTwo, _));
+  world->removeCreature(creatureTwo.getCreatureId());
+}
+
+TEST_F(WorldTest, MultipleFloors)
+{
+  // Ground floor (7) is full, floor 6 only has a tile at (200, 200, 6), other floors are empty
+  World multiFloorWorld;
+  for (auto x = 192; x < 192 + 16; x++)
+  {
+    for (auto y = 192; y < 192 + 16; y++)
+    {
+      multiFloorWorld.setTile(Position(x, y, 7), Tile(&item_));
+    }
+  }
+  multiFloorWorld.setTile(Position(200, 200, 6), Tile(&item_));
+
+  EXPECT_NE(nullptr, multiFloorWorld.getTile(Position(200, 200, 7)));
+  EXPECT_NE(nullptr, multiFloorWorld.getTile(Position(200, 200, 6)));
+  EXPECT_EQ(nullptr, multiFloorWorld.getTile(Position(201, 200, 6)));
+  EXPECT_EQ(nullptr, multiFloorWorld.getTile(Position(200, 200, 5)));
+  EXPECT_EQ(nullptr, multiFloorWorld.getTile(Position(200, 200, 8)));
+  EXPECT_EQ(nullptr, multiFloorWorld.getTile(Position(200, 200, 16)));
+
+  // creatureOne at (200, 200, 6) sees floor 7 with an offset of one tile north-west,
+  // i.e. from (191, 193, 7) to (208, 206, 7)
+  Creature creatureOne("TestCreatureOne");
+  MockCreatureCtrl creatureCtrlOne;
+  Position creaturePositionOne(200, 200, 6);
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureOne, creaturePositionOne));
+  EXPECT_EQ(World::ReturnCode::OK, multiFloorWorld.addCreature(&creatureOne, &creatureCtrlOne, creaturePositionOne));
+  multiFloorWorld.flushEvents();
+
+  // creatureTwo at (195, 195, 7) is visible to creatureOne
+  Creature creatureTwo("TestCreatureTwo");
+  MockCreatureCtrl creatureCtrlTwo;
+  Position creaturePositionTwo(195, 195, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, creatureTwo, creaturePositionTwo));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, creatureTwo, creaturePositionTwo));
+  multiFloorWorld.addCreature(&creatureTwo, &creatureCtrlTwo, creaturePositionTwo);
+  multiFloorWorld.flushEvents();
+
+  // Moving creatureTwo north to (195, 192, 7) makes it leave creatureOne's view
+  Position positionOutOfView(195, 192, 7);
+  EXPECT_CALL(creatureCtrlOne, onCreatureLeaveView(_, creatureTwo, creaturePositionTwo, _));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, creaturePositionTwo, _, positionOutOfView));
+  multiFloorWorld.creatureMove(creatureTwo.getCreatureId(), positionOutOfView);
+  multiFloorWorld.flushEvents();
+}
+
+TEST_F(WorldTest, BatchedEvents)
+{
+  Creature creatureOne("TestCreatureOne");
+  BatchCreatureCtrl creatureCtrlOne;
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, _, _)).Times(2);
+  world->addCreature(&creatureOne, &creatureCtrlOne, Position(192, 192, 7));
+
+  Creature creatureTwo("TestCreatureTwo");
+  BatchCreatureCtrl creatureCtrlTwo;
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, _, _));
+  world->addCreature(&creatureTwo, &creatureCtrlTwo, Position(194, 192, 7));
+  world->flushEvents();
+
+  // The own spawn is delivered directly, other creatures' spawns when the events are flushed
+  ASSERT_EQ(2u, creatureCtrlOne.batches.size());
+  ASSERT_EQ(1u, creatureCtrlTwo.batches.size());
+  creatureCtrlOne.batches.clear();
+  creatureCtrlTwo.batches.clear();
+
+  {
+    InSequence sequence;
+    EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, creatureTwo, _, _, Position(195, 192, 7)));
+    EXPECT_CALL(creatureCtrlOne, onCreatureTurn(_, creatureTwo, Position(195, 192, 7), _));
+    EXPECT_CALL(creatureCtrlOne, onCreatureSay(_, creatureTwo, Position(195, 192, 7), "Hello"));
+  }
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, creatureTwo, _, _, Position(195, 192, 7)));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureTurn(_, _, _, _));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSay(_, _, _, _));
+
+  world->creatureMove(creatureTwo.getCreatureId(), Position(195, 192, 7));
+  world->creatureTurn(creatureTwo.getCreatureId(), Direction::NORTH);
+  world->creatureSay(creatureTwo.getCreatureId(), "Hello");
+
+  // Only the own move has been delivered so far
+  EXPECT_EQ(0u, creatureCtrlOne.batches.size());
+  ASSERT_EQ(1u, creatureCtrlTwo.batches.size());
+
+  // Everything else is delivered in one batch per creature
+  world->flushEvents();
+  ASSERT_EQ(1u, creatureCtrlOne.batches.size());
+  ASSERT_EQ(3u, creatureCtrlOne.batches[0].size());
+  EXPECT_EQ(WorldEvent::Type::CREATURE_MOVE, creatureCtrlOne.batches[0][0].type);
+  EXPECT_EQ(WorldEvent::Type::CREATURE_TURN, creatureCtrlOne.batches[0][1].type);
+  EXPECT_EQ(WorldEvent::Type::CREATURE_SAY, creatureCtrlOne.batches[0][2].type);
+  ASSERT_EQ(2u, creatureCtrlTwo.batches.size());
+  EXPECT_EQ(2u, creatureCtrlTwo.batches[1].size());
+
+  // Nothing left to deliver
+  world->flushEvents();
+  EXPECT_EQ(1u, creatureCtrlOne.batches.size());
+  EXPECT_EQ(2u, creatureCtrlTwo.batches.size());
+}
+
+TEST_F(WorldTest, BatchedEventsOrder)
+{
+  Creature creatureOne("TestCreatureOne");
+  BatchCreatureCtrl creatureCtrlOne;
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, _, _)).Times(2);
+  world->addCreature(&creatureOne, &creatureCtrlOne, Position(192, 192, 7));
+
+  Creature creatureTwo("TestCreatureTwo");
+  BatchCreatureCtrl creatureCtrlTwo;
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, _, _));
+  world->addCreature(&creatureTwo, &creatureCtrlTwo, Position(194, 192, 7));
+  world->flushEvents();
+  creatureCtrlOne.batches.clear();
+  creatureCtrlTwo.batches.clear();
+
+  EXPECT_CALL(creatureCtrlOne, onCreatureMove(_, _, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlOne, onCreatureTurn(_, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlOne, onCreatureSay(_, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlOne, onItemAdded(_, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureMove(_, _, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureTurn(_, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSay(_, _, _, _)).Times(AtLeast(1));
+  EXPECT_CALL(creatureCtrlTwo, onItemAdded(_, _, _)).Times(AtLeast(1));
+
+  // Events from both creatures, interleaved
+  auto item = std::make_unique<Item>(1, &itemType_);
+  item->setCount(5);
+  world->creatureSay(creatureOne.getCreatureId(), "First");
+  world->creatureMove(creatureTwo.getCreatureId(), Position(195, 192, 7));
+  world->creatureTurn(creatureOne.getCreatureId(), Direction::SOUTH);
+  world->addItem(item.get(), Position(193, 193, 7));
+  world->creatureSay(creatureTwo.getCreatureId(), "Second");
+
+  // The Item is gone before the events are delivered, the event keeps a copy of it
+  item.reset();
+  world->flushEvents();
+
+  // creatureOne gets all events in the order they happened
+  ASSERT_EQ(1u, creatureCtrlOne.batches.size());
+  const auto& events = creatureCtrlOne.batches[0];
+  ASSERT_EQ(5u, events.size());
+  EXPECT_EQ(WorldEvent::Type::CREATURE_SAY, events[0].type);
+  EXPECT_EQ(creatureOne.getCreatureId(), events[0].creatureId);
+  EXPECT_EQ("First", *events[0].message);
+  EXPECT_EQ(WorldEvent::Type::CREATURE_MOVE, events[1].type);
+  EXPECT_EQ(creatureTwo.getCreatureId(), events[1].creatureId);
+  EXPECT_EQ(WorldEvent::Type::CREATURE_TURN, events[2].type);
+  EXPECT_EQ(creatureOne.getCreatureId(), events[2].creatureId);
+  EXPECT_EQ(WorldEvent::Type::ITEM_ADDED, events[3].type);
+  EXPECT_EQ(&itemType_, &events[3].item.getItemType());
+  EXPECT_EQ(5, events[3].item.getCount());
+  EXPECT_EQ(WorldEvent::Type::CREATURE_SAY, events[4].type);
+  EXPECT_EQ(creatureTwo.getCreatureId(), events[4].creatureId);
+  EXPECT_EQ("Second", *events[4].message);
+}
+
+TEST_F(WorldTest, DespawnFlushesOnlyObservers)
+{
+  // creatureOne and creatureTwo can see each other, creatureThree can see neither of them
+  Creature creatureOne("TestCreatureOne");
+  BatchCreatureCtrl creatureCtrlOne;
+  EXPECT_CALL(creatureCtrlOne, onCreatureSpawn(_, _, _)).Times(2);
+  world->addCreature(&creatureOne, &creatureCtrlOne, Position(192, 192, 7));
+
+  Creature creatureTwo("TestCreatureTwo");
+  BatchCreatureCtrl creatureCtrlTwo;
+  EXPECT_CALL(creatureCtrlTwo, onCreatureSpawn(_, _, _));
+  world->addCreature(&creatureTwo, &creatureCtrlTwo, Position(194, 192, 7));
+
+  Creature creatureThree("TestCreatureThree");
+  BatchCreatureCtrl creatureCtrlThree;
+  EXPECT_CALL(creatureCtrlThree, onCreatureSpawn(_, _, _));
+  world->addCreature(&creatureThree, &creatureCtrlThree, Position(207, 207, 7));
+  world->flushEvents();
+  creatureCtrlOne.batches.clear();
+  creatureCtrlTwo.batches.clear();
+  creatureCtrlThree.batches.clear();
+
+  {
+    InSequence sequence;
+    EXPECT_CALL(creatureCtrlOne, onCreatureSay(_, creatureTwo, _, "Bye"));
+    EXPECT_CALL(creatureCtrlOne, onCreatureDespawn(_, creatureTwo, _, _));
+  }
+  {
+    InSequence sequence;
+    EXPECT_CALL(creatureCtrlTwo, onCreatureSay(_, creatureTwo, _, "Bye"));
+    EXPECT_CALL(creatureCtrlTwo, onCreatureDespawn(_, creatureTwo, _, _));
+  }
+  EXPECT_CALL(creatureCtrlThree, onCreatureSay(_, creatureThree, _, "Hello"));
+
+  world->creatureSay(creatureThree.getCreatureId(), "Hello");
+  world->creatureSay(creatureTwo.getCreatureId(), "Bye");
+  world->removeCreature(creatureTwo.getCreatureId());
+
+  // The events about creatureTwo are delivered while it still exists, in the order they happened
+  ASSERT_EQ(1u, creatureCtrlOne.batches.size());
+  ASSERT_EQ(2u, creatureCtrlOne.batches[0].size());
+  EXPECT_EQ(WorldEvent::Type::CREATURE_SAY, creatureCtrlOne.batches[0][0].type);
+  EXPECT_EQ(WorldEvent::Type::CREATURE_DESPAWN, creatureCtrlOne.batches[0][1].type);
+  ASSERT_EQ(1u, creatureCtrlTwo.batches.size());
+  EXPECT_EQ(2u, creatureCtrlTwo.batches[0].size());
+
+  // creatureThree is not involved and keeps its batch until the end of the tick
+  EXPECT_EQ(0u, creatureCtrlThree.batches.size());
+  world->flushEvents();
+  ASSERT_EQ(1u, creatureCtrlThree.batches.size());
+  EXPECT_EQ(1u, creatureCtrlThree.batches[0].size());
+  EXPECT_EQ(1u, creatureCtrlOne.batches.size());
+}
@@ -0,0 +1,86 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <cstdio>
+#include <string>
+
+// utils
+#include "logger.h"
+
+// world
+#include "position.h"
+#include "tile.h"
+
+// gameengine
+#include "item_manager.h"
+#include "world_factory.h"
+#include "world_image.h"
+
+// Converts world.xml into a world image, that worldserver loads much faster and can load lazily
+// (see WorldImage). The items are needed to validate the ItemTypeIds and to get the walkability
+// and line of sight of each tile.
+int main(int argc, char* argv[])
+{
+  if (argc != 5)
+  {
+    printf("Usage: %s <data file> <items file> <world file> <world image file>\n", argv[0]);
+    printf("Example: %s data/data.dat data/items.xml data/world.xml data/world.bin\n", argv[0]);
+    return 1;
+  }
+
+  const std::string dataFilename = argv[1];
+  const std::string itemsFilename = argv[2];
+  const std::string worldFilename = argv[3];
+  const std::string imageFilename = argv[4];
+
+  Logger::setLevel(Logger::Module::GAMEENGINE, Logger::Level::INFO);
+  Logger::setLevel(Logger::Module::UTILS, Logger::Level::INFO);
+  Logger::setLevel(Logger::Module::WORLD, Logger::Level::INFO);
+
+  ItemManager itemManager;
+  if (!itemManager.loadItemTypes(dataFilename, itemsFilename))
+  {
+    printf("Could not load %s and %s\n", dataFilename.c_str(), itemsFilename.c_str());
+    return 1;
+  }
+
+  WorldImageWriter writer;
+  const auto addTile = [&writer](const Position& position, Tile&& tile)
+  {
+    writer.addTile(position, tile);
+  };
+  if (!WorldFactory::loadTiles(worldFilename, &itemManager, addTile))
+  {
+    printf("Could not load %s\n", worldFilename.c_str());
+    return 1;
+  }
+
+  if (!writer.save(imageFilename))
+  {
+    printf("Could not write %s\n", imageFilename.c_str());
+    return 1;
+  }
+
+  return 0;
+}
@@ -25,12 +25,32 @@
 #ifndef WORLDSERVER_SRC_PROTOCOL_H_
 #define WORLDSERVER_SRC_PROTOCOL_H_
 
+#include <functional>
+
 #include "player_ctrl.h"
+#include "connection.h"
+#include "byte_buffer.h"
 
 class Protocol : public PlayerCtrl
 {
  public:
   virtual ~Protocol() = default;
+
+  // Sends everything queued on the connection, called once per tick in fixed-rate mode
+  virtual void flush() = 0;
+
+  // Used to hand over the session to another process (see Handoff), returns false if the
+  // connection is already closed. See Connection::detach.
+  virtual bool detach(const std::function<void(Connection::Detached&&)>& onDetached) = 0;
+
+  // Continues the session after detach, when it was not handed over. See Connection::reattach.
+  virtual void reattach(Connection::Detached&& detached) = 0;
+
+  // Saves and restores the state of the session, the player itself is restored by
+  // GameEngine::loadSnapshot which calls setPlayerId. playerId is the player that was logged in,
+  // or Creature::INVALID_ID.
+  virtual void saveState(ByteWriter* writer) const = 0;
+  virtual bool loadState(ByteReader* reader, CreatureId* playerId) = 0;
 };
 
 #endif  // WORLDSERVER_SRC_PROTOCOL_H_
@@ -43,9 +43,11 @@
 // world
 #include "world_interface.h"
 #include "tile.h"
+#include "viewport.h"
 
 // utils
 #include "logger.h"
+#include "tick.h"
 
 // account
 #include "account.h"
@@ -58,7 +60,19 @@ Protocol71::Protocol71(const std::function<void(void)>& closeProtocol,
     connection_(std::move(connection)),
     gameEngineQueue_(gameEngineQueue),
     accountReader_(accountReader),
-    playerId_(Creature::INVALID_ID)
+    playerId_(Creature::INVALID_ID),
+    spawningCharacterName_(),
+    moveInputBucket_(move_input_rate, move_input_burst),
+    actionInputBucket_(action_input_rate, action_input_burst),
+    chatInputBucket_(chat_input_rate, chat_input_burst),
+    queuedMove_([this](GameEngine* gameEngine, const Direction& direction)
+    {
+      gameEngine->move(playerId_, direction);
+    }),
+    queuedTurn_([this](GameEngine* gameEngine, const Direction& direction)
+    {
+      gameEngine->turn(playerId_, direction);
+    })
 {
   knownCreatures_.fill(Creature::INVALID_ID);
 
@@ -81,120 +95,114 @@ Protocol71::Protocol71(const std::function<void(void)>& closeProtocol,
   connection_->init(callbacks);
 }
 
-void Protocol71::onCreatureSpawn(const WorldInterface& world_interface,
-                                 const Creature& creature,
-                                 const Position& position)
+void Protocol71::onWorldEvents(const WorldInterface& world_interface, const std::vector<WorldEvent>& events)
 {
   if (!isConnected())
   {
+    for (const auto& event : events)
+    {
+      if (event.type == WorldEvent::Type::CREATURE_DESPAWN && event.creatureId == playerId_)
+      {
+        // We are no longer in game and the connection has been closed, close the protocol
+        playerId_ = Creature::INVALID_ID;
+        closeProtocol_();  // WARNING: This instance is deleted after this call
+        return;
+      }
+    }
     return;
   }
 
+  // Everything that happened near the player during the tick is sent in as few packets as possible
   OutgoingPacket packet;
-
-  if (creature.getCreatureId() == playerId_)
+  auto despawned = false;
+  for (const auto& event : events)
   {
-    // We are spawning!
-    const auto& player = static_cast<const Player&>(creature);
-
-    packet.addU8(0x0A);  // Login
-    packet.addU32(playerId_);
-
-    packet.addU8(0x32);  // ??
-    packet.addU8(0x00);
-
-    packet.addU8(0x64);  // Full (visible) map
-    addPosition(position, &packet);  // Position
-
-    addMapData(world_interface, Position(position.getX() - 8, position.getY() - 6, position.getZ()), 18, 14, &packet);
-
-    for (auto i = 0; i < 12; i++)
+    // Our own spawn and moves come with map data, so give them a packet of their own
+    const auto hasMapData = event.creatureId == playerId_ &&
+                            (event.type == WorldEvent::Type::CREATURE_SPAWN ||
+                             event.type == WorldEvent::Type::CREATURE_MOVE);
+    if (packet.getLength() > 0 && (hasMapData || packet.getLength() > max_batched_packet_length))
     {
-      packet.addU8(0xFF);
+      connection_->sendPacket(std::move(packet));
+      packet = OutgoingPacket();
     }
 
-    packet.addU8(0xE4);  // Light?
-    packet.addU8(0xFF);
+    switch (event.type)
+    {
+      case WorldEvent::Type::CREATURE_SPAWN:
+      {
+        addCreatureSpawn(world_interface, world_interface.getCreature(event.creatureId), event.position, &packet);
+        break;
+      }
 
-    packet.addU8(0x83);  // Magic effect (login)
-    packet.addU16(position.getX());
-    packet.addU16(position.getY());
-    packet.addU8(position.getZ());
-    packet.addU8(0x0A);
+      case WorldEvent::Type::CREATURE_DESPAWN:
+      {
+        addCreatureDespawn(event.position, event.stackPos, &packet);
+        despawned = event.creatureId == playerId_;
+        break;
+      }
 
-    // Player stats
-    packet.addU8(0xA0);
-    packet.addU16(player.getHealth());
-    packet.addU16(player.getMaxHealth());
-    packet.addU16(player.getCapacity());
-    packet.addU32(player.getExperience());
-    packet.addU8(player.getLevel());
-    packet.addU16(player.getMana());
-    packet.addU16(player.getMaxMana());
-    packet.addU8(player.getMagicLevel());
-
-    packet.addU8(0x82);  // Light?
-    packet.addU8(0x6F);
-    packet.addU8(0xD7);
+      case WorldEvent::Type::CREATURE_MOVE:
+      {
+        addCreatureMove(world_interface,
+                        event.creatureId,
+                        event.position,
+                        event.stackPos,
+                        event.newPosition,
+                        &packet);
+        break;
+      }
 
-    // Player skills
-    packet.addU8(0xA1);
-    for (auto i = 0; i < 7; i++)
-    {
-      packet.addU8(10);
-    }
+      case WorldEvent::Type::CREATURE_ENTER_VIEW:
+      {
+        addCreatureEnterView(world_interface.getCreature(event.creatureId), event.position, &packet);
+        break;
+      }
 
+      case WorldEvent::Type::CREATURE_LEAVE_VIEW:
+      {
+        addCreatureLeaveView(event.position, event.stackPos, &packet);
+        break;
+      }
 
-    for (auto i = 1; i <= 10; i++)
-    {
-      addEquipment(player.getEquipment(), i, &packet);
-    }
-  }
-  else
-  {
-    // Someone else spawned
-    packet.addU8(0x6A);
-    addPosition(position, &packet);
-    addCreature(creature, &packet);
+      case WorldEvent::Type::CREATURE_TURN:
+      {
+        addCreatureTurn(world_interface.getCreature(event.creatureId), event.position, event.stackPos, &packet);
+        break;
+      }
 
-    // Spawn/login bubble
-    packet.addU8(0x83);
-    addPosition(position, &packet);
-    packet.addU8(0x0A);
-  }
+      case WorldEvent::Type::CREATURE_SAY:
+      {
+        addCreatureSay(world_interface.getCreature(event.creatureId), event.position, *event.message, &packet);
+        break;
+      }
 
-  connection_->sendPacket(std::move(packet));
-}
+      case WorldEvent::Type::ITEM_REMOVED:
+      {
+        addItemRemoved(event.position, event.stackPos, &packet);
+        break;
+      }
 
-void Protocol71::onCreatureDespawn(const WorldInterface& world_interface,
-                                   const Creature& creature,
-                                   const Position& position,
-                                   int stackPos)
-{
-  (void)world_interface;
+      case WorldEvent::Type::ITEM_ADDED:
+      {
+        addItemAdded(event.item, event.position, &packet);
+        break;
+      }
 
-  if (!isConnected())
-  {
-    if (creature.getCreatureId() == playerId_)
-    {
-      // We are no longer in game and the connection has been closed, close the protocol
-      playerId_ = Creature::INVALID_ID;
-      closeProtocol_();  // WARNING: This instance is deleted after this call
+      case WorldEvent::Type::TILE_UPDATE:
+      {
+        addTileUpdate(world_interface, event.position, &packet);
+        break;
+      }
     }
-    return;
   }
 
-  OutgoingPacket packet;
-  // Logout poff
-  packet.addU8(0x83);
-  addPosition(position, &packet);
-  packet.addU8(0x02);
-  packet.addU8(0x6C);
-  addPosition(position, &packet);
-  packet.addU8(stackPos);
-  connection_->sendPacket(std::move(packet));
+  if (packet.getLength() > 0)
+  {
+    connection_->sendPacket(std::move(packet));
+  }
 
-  if (creature.getCreatureId() == playerId_)
+  if (despawned)
   {
     // This player despawned, close the connection gracefully
     // The protocol will be deleted as soon as the connection has been closed
@@ -204,186 +212,248 @@ void Protocol71::onCreatureDespawn(const WorldInterface& world_interface,
   }
 }
 
-void Protocol71::onCreatureMove(const WorldInterface& world_interface,
-                                const Creature& creature,
-                                const Position& oldPosition,
-                                int oldStackPos,
-                                const Position& newPosition)
+void Protocol71::addCreatureSpawn(const WorldInterface& world_interface,
+                                  const Creature& creature,
+                                  const Position& position,
+                                  OutgoingPacket* packet)
 {
-  if (!isConnected())
+  if (creature.getCreatureId() == playerId_)
   {
-    return;
-  }
+    // We are spawning!
+    const auto& player = static_cast<const Player&>(creature);
 
-  // Build outgoing packet
-  OutgoingPacket packet;
+    packet->addU8(0x0A);  // Login
+    packet->addU32(playerId_);
 
-  const auto& player_position = world_interface.getCreaturePosition(playerId_);
-  bool canSeeOldPos = canSee(player_position, oldPosition);
-  bool canSeeNewPos = canSee(player_position, newPosition);
+    packet->addU8(0x32);  // ??
+    packet->addU8(0x00);
 
-  if (canSeeOldPos && canSeeNewPos)
-  {
-    packet.addU8(0x6D);
-    addPosition(oldPosition, &packet);
-    packet.addU8(oldStackPos);
-    addPosition(newPosition, &packet);
-  }
-  else if (canSeeOldPos)
-  {
-    packet.addU8(0x6C);
-    addPosition(oldPosition, &packet);
-    packet.addU8(oldStackPos);
-  }
-  else if (canSeeNewPos)
-  {
-    packet.addU8(0x6A);
-    addPosition(newPosition, &packet);
-    addCreature(creature, &packet);
+    packet->addU8(0x64);  // Full (visible) map
+    addPosition(position, packet);  // Position
+
+    addMapData(world_interface,
+               Position(position.getX() - Viewport::west, position.getY() - Viewport::north, position.getZ()),
+               Viewport::width,
+               Viewport::height,
+               packet);
+
+    packet->addU8(0x83);  // Magic effect (login)
+    packet->addU16(position.getX());
+    packet->addU16(position.getY());
+    packet->addU8(position.getZ());
+    packet->addU8(0x0A);
+
+    // Player stats
+    packet->addU8(0xA0);
+    packet->addU16(player.getHealth());
+    packet->addU16(player.getMaxHealth());
+    packet->addU16(player.getCapacity());
+    packet->addU32(player.getExperience());
+    packet->addU8(player.getLevel());
+    packet->addU16(player.getMana());
+    packet->addU16(player.getMaxMana());
+    packet->addU8(player.getMagicLevel());
+
+    packet->addU8(0x82);  // Light?
+    packet->addU8(0x6F);
+    packet->addU8(0xD7);
+
+    // Player skills
+    packet->addU8(0xA1);
+    for (auto i = 0; i < 7; i++)
+    {
+      packet->addU8(10);
+    }
+
+
+    for (auto i = 1; i <= 10; i++)
+    {
+      addEquipment(player.getEquipment(), i, packet);
+    }
   }
   else
   {
-    LOG_ERROR("%s: called, but this player cannot see neither oldPosition nor newPosition: "
-              "player_position: %s, oldPosition: %s, newPosition: %s",
-              __func__,
-              player_position.toString().c_str(),
-              oldPosition.toString().c_str(),
-              newPosition.toString().c_str());
-    return;
+    // Someone else spawned
+    packet->addU8(0x6A);
+    addPosition(position, packet);
+    addCreature(creature, packet);
+
+    // Spawn/login bubble
+    packet->addU8(0x83);
+    addPosition(position, packet);
+    packet->addU8(0x0A);
   }
+}
 
-  if (creature.getCreatureId() == playerId_)
+void Protocol71::addCreatureDespawn(const Position& position, int stackPos, OutgoingPacket* packet) const
+{
+  // Logout poff
+  packet->addU8(0x83);
+  addPosition(position, packet);
+  packet->addU8(0x02);
+  packet->addU8(0x6C);
+  addPosition(position, packet);
+  packet->addU8(stackPos);
+}
+
+void Protocol71::addCreatureMove(const WorldInterface& world_interface,
+                                 CreatureId creatureId,
+                                 const Position& oldPosition,
+                                 int oldStackPos,
+                                 const Position& newPosition,
+                                 OutgoingPacket* packet)
+{
+  // World only sends this event if this player could see the creature both before and
+  // after the move, creatures entering or leaving the view are handled by
+  // addCreatureEnterView and addCreatureLeaveView
+  packet->addU8(0x6D);
+  addPosition(oldPosition, packet);
+  packet->addU8(oldStackPos);
+  addPosition(newPosition, packet);
+
+  if (creatureId == playerId_)
   {
     // This player moved, send new map data
-    if (oldPosition.getY() > newPosition.getY())
+    if (oldPosition.getZ() != newPosition.getZ())
     {
-      // Get north block
-      packet.addU8(0x65);
-      addMapData(world_interface, Position(oldPosition.getX() - 8, newPosition.getY() - 6, 7), 18, 1, &packet);
-      packet.addU8(0x7E);
-      packet.addU8(0xFF);
+      // Changed floor, the visible floors are different so send the full map
+      packet->addU8(0x64);
+      addPosition(newPosition, packet);
+      addMapData(world_interface,
+                 Position(newPosition.getX() - Viewport::west,
+                          newPosition.getY() - Viewport::north,
+                          newPosition.getZ()),
+                 Viewport::width,
+                 Viewport::height,
+                 packet);
     }
-    else if (oldPosition.getY() < newPosition.getY())
+    else
     {
-      // Get south block
-      packet.addU8(0x67);
-      addMapData(world_interface, Position(oldPosition.getX() - 8, newPosition.getY() + 7, 7), 18, 1, &packet);
-      packet.addU8(0x7E);
-      packet.addU8(0xFF);
-    }
+      if (oldPosition.getY() > newPosition.getY())
+      {
+        // Get north block
+        packet->addU8(0x65);
+        addMapData(world_interface,
+                   Position(oldPosition.getX() - Viewport::west,
+                            newPosition.getY() - Viewport::north,
+                            newPosition.getZ()),
+                   Viewport::width,
+                   1,
+                   packet);
+      }
+      else if (oldPosition.getY() < newPosition.getY())
+      {
+        // Get south block
+        packet->addU8(0x67);
+        addMapData(world_interface,
+                   Position(oldPosition.getX() - Viewport::west,
+                            newPosition.getY() + Viewport::south,
+                            newPosition.getZ()),
+                   Viewport::width,
+                   1,
+                   packet);
+      }
 
-    if (oldPosition.getX() > newPosition.getX())
-    {
-      // Get west block
-      packet.addU8(0x68);
-      addMapData(world_interface, Position(newPosition.getX() - 8, newPosition.getY() - 6, 7), 1, 14, &packet);
-      packet.addU8(0x62);
-      packet.addU8(0xFF);
-    }
-    else if (oldPosition.getX() < newPosition.getX())
-    {
-      // Get west block
-      packet.addU8(0x66);
-      addMapData(world_interface, Position(newPosition.getX() + 9, newPosition.getY() - 6, 7), 1, 14, &packet);
-      packet.addU8(0x62);
-      packet.addU8(0xFF);
+      if (oldPosition.getX() > newPosition.getX())
+      {
+        // Get west block
+        packet->addU8(0x68);
+        addMapData(world_interface,
+                   Position(newPosition.getX() - Viewport::west,
+                            newPosition.getY() - Viewport::north,
+                            newPosition.getZ()),
+                   1,
+                   Viewport::height,
+                   packet);
+      }
+      else if (oldPosition.getX() < newPosition.getX())
+      {
+        // Get east block
+        packet->addU8(0x66);
+        addMapData(world_interface,
+                   Position(newPosition.getX() + Viewport::east,
+                            newPosition.getY() - Viewport::north,
+                            newPosition.getZ()),
+                   1,
+                   Viewport::height,
+                   packet);
+      }
     }
   }
-
-  connection_->sendPacket(std::move(packet));
 }
 
-void Protocol71::onCreatureTurn(const WorldInterface& world_interface,
-                                const Creature& creature,
-                                const Position& position,
-                                int stackPos)
+void Protocol71::addCreatureEnterView(const Creature& creature, const Position& position, OutgoingPacket* packet)
 {
-  (void)world_interface;
-
-  if (!isConnected())
-  {
-    return;
-  }
-
-  OutgoingPacket packet;
-  packet.addU8(0x6B);
-  addPosition(position, &packet);
-  packet.addU8(stackPos);
-  packet.addU8(0x63);
-  packet.addU8(0x00);
-  packet.addU32(creature.getCreatureId());
-  packet.addU8(static_cast<std::uint8_t>(creature.getDirection()));
-  connection_->sendPacket(std::move(packet));
+  packet->addU8(0x6A);
+  addPosition(position, packet);
+  addCreature(creature, packet);
 }
 
-void Protocol71::onCreatureSay(const WorldInterface& world_interface,
-                               const Creature& creature,
-                               const Position& position,
-                               const std::string& message)
+void Protocol71::addCreatureLeaveView(const Position& oldPosition, int oldStackPos, OutgoingPacket* packet) const
 {
-  (void)world_interface;
+  packet->addU8(0x6C);
+  addPosition(oldPosition, packet);
+  packet->addU8(oldStackPos);
+}
 
-  if (!isConnected())
-  {
-    return;
-  }
+void Protocol71::addCreatureTurn(const Creature& creature,
+                                 const Position& position,
+                                 int stackPos,
+                                 OutgoingPacket* packet) const
+{
+  packet->addU8(0x6B);
+  addPosition(position, packet);
+  packet->addU8(stackPos);
+  packet->addU8(0x63);
+  packet->addU8(0x00);
+  packet->addU32(creature.getCreatureId());
+  packet->addU8(static_cast<std::uint8_t>(creature.getDirection()));
+}
 
-  OutgoingPacket packet;
-  packet.addU8(0xAA);
-  packet.addString(creature.getName());
-  packet.addU8(0x01);  // Say type
+void Protocol71::addCreatureSay(const Creature& creature,
+                                const Position& position,
+                                const std::string& message,
+                                OutgoingPacket* packet) const
+{
+  packet->addU8(0xAA);
+  packet->addString(creature.getName());
+  packet->addU8(0x01);  // Say type
   // if type <= 3
-  addPosition(position, &packet);
-  packet.addString(message);
-  connection_->sendPacket(std::move(packet));
+  addPosition(position, packet);
+  packet->addString(message);
 }
 
-void Protocol71::onItemRemoved(const WorldInterface& world_interface, const Position& position, int stackPos)
+void Protocol71::addItemRemoved(const Position& position, int stackPos, OutgoingPacket* packet) const
 {
-  (void)world_interface;
-
-  if (!isConnected())
-  {
-    return;
-  }
-
-  OutgoingPacket packet;
-  packet.addU8(0x6C);
-  addPosition(position, &packet);
-  packet.addU8(stackPos);
-  connection_->sendPacket(std::move(packet));
+  packet->addU8(0x6C);
+  addPosition(position, packet);
+  packet->addU8(stackPos);
 }
 
-void Protocol71::onItemAdded(const WorldInterface& world_interface, const Item& item, const Position& position)
+void Protocol71::addItemAdded(const Item& item, const Position& position, OutgoingPacket* packet) const
 {
-  (void)world_interface;
-
-  if (!isConnected())
-  {
-    return;
-  }
-
-  OutgoingPacket packet;
-  packet.addU8(0x6A);
-  addPosition(position, &packet);
-  addItem(item, &packet);
-  connection_->sendPacket(std::move(packet));
+  packet->addU8(0x6A);
+  addPosition(position, packet);
+  addItem(item, packet);
 }
 
-void Protocol71::onTileUpdate(const WorldInterface& world_interface, const Position& position)
+void Protocol71::addTileUpdate(const WorldInterface& world_interface,
+                               const Position& position,
+                               OutgoingPacket* packet)
 {
-  if (!isConnected())
+  packet->addU8(0x69);
+  addPosition(position, packet);
+  const auto* tile = world_interface.getTile(position);
+  if (tile)
   {
-    return;
+    addTileData(world_interface, *tile, packet);
+    packet->addU8(0x00);
   }
-
-  OutgoingPacket packet;
-  packet.addU8(0x69);
-  addPosition(position, &packet);
-  addMapData(world_interface, position, 1, 1, &packet);
-  packet.addU8(0x00);
-  packet.addU8(0xFF);
-  connection_->sendPacket(std::move(packet));
+  else
+  {
+    packet->addU8(0x01);
+  }
+  packet->addU8(0xFF);
 }
 
 void Protocol71::onEquipmentUpdated(const Player& player, int inventoryIndex)
@@ -417,7 +487,7 @@ void Protocol71::onOpenContainer(int clientContainerId, const Container& contain
   packet.addU8(0x6E);
   packet.addU8(clientContainerId);
   addItem(item, &packet);
-  packet.addString(item.getItemType().name);
+  packet.addString(item.getItemType().getDetails().name);
   packet.addU8(item.getItemType().maxitems);
   packet.addU8(container.parentContainerId == Container::INVALID_ID ? 0x00 : 0x01);
   packet.addU8(container.items.size());
@@ -539,6 +609,100 @@ void Protocol71::cancelMove()
   connection_->sendPacket(std::move(packet));
 }
 
+void Protocol71::flush()
+{
+  if (isConnected())
+  {
+    connection_->flush();
+  }
+}
+
+bool Protocol71::detach(const std::function<void(Connection::Detached&&)>& onDetached)
+{
+  return isConnected() && connection_->detach(onDetached);
+}
+
+void Protocol71::reattach(Connection::Detached&& detached)
+{
+  connection_->reattach(std::move(detached));
+}
+
+void Protocol71::saveState(ByteWriter* writer) const
+{
+  writer->addU32(playerId_);
+  writer->addString(spawningCharacterName_);
+  for (const auto creatureId : knownCreatures_)
+  {
+    writer->addU32(creatureId);
+  }
+}
+
+bool Protocol71::loadState(ByteReader* reader, CreatureId* playerId)
+{
+  *playerId = reader->getU32();
+  const auto spawningCharacterName = reader->getString();
+  for (auto& creatureId : knownCreatures_)
+  {
+    creatureId = reader->getU32();
+  }
+  if (reader->failed())
+  {
+    LOG_ERROR("%s: invalid state", __func__);
+    return false;
+  }
+
+  // The spawn task was not run before the session was handed over, queue it again
+  if (!spawningCharacterName.empty())
+  {
+    queueSpawn(spawningCharacterName);
+  }
+  return true;
+}
+
+void Protocol71::setPlayerId(CreatureId playerId)
+{
+  playerId_ = playerId;
+
+  // Any queued move or turn tasks are canceled when the player despawns
+  queuedMove_.reset();
+  queuedTurn_.reset();
+  moveInputBucket_.reset();
+  actionInputBucket_.reset();
+  chatInputBucket_.reset();
+}
+
+TokenBucket* Protocol71::getInputBucket(int packetId)
+{
+  switch (packetId)
+  {
+    case 0x64:  // Move click (path)
+    case 0x65:  // Player move
+    case 0x66:
+    case 0x67:
+    case 0x68:
+    case 0x6F:  // Player turn
+    case 0x70:
+    case 0x71:
+    case 0x72:
+      return &moveInputBucket_;
+
+    case 0x78:  // Move item
+    case 0x82:  // Use item
+    case 0x87:  // Close container
+    case 0x88:  // Open parent container
+    case 0x8C:  // Look at
+      return &actionInputBucket_;
+
+    case 0x96:  // Say
+      return &chatInputBucket_;
+
+    default:  // Logout, cancel move, stop all actions and unknown packets
+      // These are cheap and can't pile up work in the GameEngine, and a player that is over the
+      // move rate must still be able to stop
+      return nullptr;
+  }
+}
+
 void Protocol71::parsePacket(IncomingPacket* packet)
 {
   if (!isConnected())
@@ -567,11 +731,21 @@ void Protocol71::parsePacket(IncomingPacket* packet)
   while (!packet->isEmpty())
   {
     const auto packetId = packet->getU8();
+
+    // The commands in a packet can't be skipped without parsing them, so the rest of the
+    // packet is dropped when the player is over the rate of a command's class
+    auto* inputBucket = getInputBucket(packetId);
+    if (inputBucket && !inputBucket->consume(Tick::now()))
+    {
+      LOG_DEBUG("%s: input rate exceeded, player id: %d, packet id: 0x%X", __func__, playerId_, packetId);
+      return;
+    }
+
     switch (packetId)
     {
       case 0x14:
       {
-        gameEngineQueue_->addTask(playerId_, [this](GameEngine* gameEngine)
+        gameEngineQueue_->addTask(GameEngineQueue::Priority::LOGIN, playerId_, [this](GameEngine* gameEngine)
         {
           gameEngine->despawn(playerId_);
         });
@@ -589,10 +763,7 @@ void Protocol71::parsePacket(IncomingPacket* packet)
       case 0x67:  // South = 2
       case 0x68:  // West  = 3
       {
-        gameEngineQueue_->addTask(playerId_, [this, packetId](GameEngine* gameEngine)
-        {
-          gameEngine->move(playerId_, static_cast<Direction>(packetId - 0x65));
-        });
+        queuedMove_.queue(gameEngineQueue_, playerId_, static_cast<Direction>(packetId - 0x65));
         break;
       }
 
@@ -610,10 +781,7 @@ void Protocol71::parsePacket(IncomingPacket* packet)
       case 0x71:  // South = 2
       case 0x72:  // West  = 3
       {
-        gameEngineQueue_->addTask(playerId_, [this, packetId](GameEngine* gameEngine)
-        {
-          gameEngine->turn(playerId_, static_cast<Direction>(packetId - 0x6F));
-        });
+        queuedTurn_.queue(gameEngineQueue_, playerId_, static_cast<Direction>(packetId - 0x6F));
         break;
       }
 
@@ -686,48 +854,13 @@ void Protocol71::onDisconnected()
   else
   {
     // We need to tell the gameengine to despawn us
-    gameEngineQueue_->addTask(playerId_, [this](GameEngine* gameEngine)
+    gameEngineQueue_->addTask(GameEngineQueue::Priority::LOGIN, playerId_, [this](GameEngine* gameEngine)
     {
       gameEngine->despawn(playerId_);
     });
   }
 }
 
-bool Protocol71::canSee(const Position& player_position, const Position& to_position) const
-{
-  // Note: client displays 15x11 tiles, but it know about 18x14 tiles.
-  //
-  //       Client know about one extra row north, one extra column west
-  //       two extra rows south and two extra rows east.
-  //
-  //       This function returns true if to_position is visible from player_position
-  //       with regards to what the client (player_position) knows about, e.g. 18x14 tiles.
-  //
-  //
-  //     00 01 02 03 04 05 06 07 08 09 10 11 12 13 14 15 16 17 18
-  //     ________________________________________________________
-  // 00 |   _______________________________________________      |
-  // 01 |  |                                               |     |
-  // 02 |  |                                               |     |
-  // 03 |  |                                               |     |
-  // 04 |  |                                               |     |
-  // 05 |  |                                               |     |
-  // 06 |  |                                               |     |
-  // 07 |  |                                               |     |
-  // 08 |  |                                               |     |
-  // 09 |  |                                               |     |
-  // 10 |  |                                               |     |
-  // 11 |  |                                               |     |
-  // 12 |  |_______________________________________________|     |
-  // 13 |                                                        |
-  // 14 |________________________________________________________|
-
-  return to_position.getX() >= player_position.getX() - 8 &&
-         to_position.getX() <= player_position.getX() + 9 &&
-         to_position.getY() >= player_position.getY() - 6 &&
-         to_position.getY() <= player_position.getY() + 7;
-}
-
 void Protocol71::addPosition(const Position& position, OutgoingPacket* packet) const
 {
   packet->addU16(position.getX());
@@ -741,69 +874,123 @@ void Protocol71::addMapData(const WorldInterface& world_interface,
                             int height,
                             OutgoingPacket* packet)
 {
-  for (auto x = position.getX(); x < position.getX() + width; x++)
+  // Above ground the floors are sent from the ground floor and up,
+  // underground from two floors above the player and down
+  const auto z = position.getZ();
+  const auto highestFloor = Viewport::getHighestVisibleFloor(z);
+  const auto lowestFloor = Viewport::getLowestVisibleFloor(z);
+
+  auto skip = -1;
+  if (z <= Viewport::ground_floor)
   {
-    for (auto y = position.getY(); y < position.getY() + height; y++)
+    for (auto floorZ = lowestFloor; floorZ >= highestFloor; floorZ--)
     {
-      const auto* tile = world_interface.getTile(Position(x, y, position.getZ()));
-      if (tile)
-      {
-        const auto& items = tile->getItems();
-        const auto& creatureIds = tile->getCreatureIds();
-        auto itemIt = items.cbegin();
-        auto creatureIt = creatureIds.cbegin();
-
-        // Client can only handle ground + 9 items/creatures at most
-        auto count = 0;
-
-        // Add ground Item
-        addItem(*(*itemIt), packet);
-        count++;
-        ++itemIt;
-
-        // if splash; add; count++
-
-        // Add top Items
-        while (count < 10 && itemIt != items.cend())
-        {
-          if (!(*itemIt)->getItemType().alwaysOnTop)
-          {
-            break;
-          }
-
-          addItem(*(*itemIt), packet);
-          count++;
-          ++itemIt;
-        }
+      addFloorData(world_interface, position, floorZ, width, height, &skip, packet);
+    }
+  }
+  else
+  {
+    for (auto floorZ = highestFloor; floorZ <= lowestFloor; floorZ++)
+    {
+      addFloorData(world_interface, position, floorZ, width, height, &skip, packet);
+    }
+  }
 
-        // Add Creatures
-        while (count < 10 && creatureIt != creatureIds.cend())
-        {
-          const Creature& creature = world_interface.getCreature(*creatureIt);
-          addCreature(creature, packet);
-          count++;
-          ++creatureIt;
-        }
+  if (skip >= 0)
+  {
+    packet->addU8(skip);
+    packet->addU8(0xFF);
+  }
+}
 
-        // Add bottom Item
-        while (count < 10 && itemIt != items.cend())
+void Protocol71::addFloorData(const WorldInterface& world_interface,
+                              const Position& position,
+                              int z,
+                              int width,
+                              int height,
+                              int* skip,
+                              OutgoingPacket* packet)
+{
+  // Tiles that do not exist are not sent, instead the number of tiles to skip is sent
+  // before the next existing tile (or at the end of the map data)
+  const auto offset = Viewport::getFloorOffset(position.getZ(), z);
+  for (auto x = position.getX() + offset; x < position.getX() + offset + width; x++)
+  {
+    for (auto y = position.getY() + offset; y < position.getY() + offset + height; y++)
+    {
+      const auto* tile = world_interface.getTile(Position(x, y, z));
+      if (tile)
+      {
+        if (*skip >= 0)
         {
-          addItem(*(*itemIt), packet);
-          count++;
-          ++itemIt;
+          packet->addU8(*skip);
+          packet->addU8(0xFF);
         }
+        *skip = 0;
+        addTileData(world_interface, *tile, packet);
       }
-
-      if (x != position.getX() + width - 1 ||
-          y != position.getY() + height - 1)
+      else if (*skip == 0xFE)
       {
-        packet->addU8(0x00);
         packet->addU8(0xFF);
+        packet->addU8(0xFF);
+        *skip = -1;
+      }
+      else
+      {
+        *skip += 1;
       }
     }
   }
 }
 
+void Protocol71::addTileData(const WorldInterface& world_interface, const Tile& tile, OutgoingPacket* packet)
+{
+  const auto& items = tile.getItems();
+  const auto& creatureIds = tile.getCreatureIds();
+  auto itemIt = items.cbegin();
+  auto creatureIt = creatureIds.cbegin();
+
+  // Client can only handle ground + 9 items/creatures at most
+  auto count = 0;
+
+  // Add ground Item
+  addItem(*(*itemIt), packet);
+  count++;
+  ++itemIt;
+
+  // if splash; add; count++
+
+  // Add top Items
+  while (count < Tile::max_visible_things && itemIt != items.cend())
+  {
+    if (!(*itemIt)->getItemType().alwaysOnTop)
+    {
+      break;
+    }
+
+    addItem(*(*itemIt), packet);
+    count++;
+    ++itemIt;
+  }
+
+  // Add Creatures
+  while (count < Tile::max_visible_things && creatureIt != creatureIds.cend())
+  {
+    const Creature& creature = world_interface.getCreature(*creatureIt);
+    addCreature(creature, packet);
+    count++;
+    ++creatureIt;
+  }
+
+  // Add bottom Item
+  while (count < Tile::max_visible_things && itemIt != items.cend())
+  {
+    addItem(*(*itemIt), packet);
+    count++;
+    ++itemIt;
+  }
+}
+
 void Protocol71::addCreature(const Creature& creature, OutgoingPacket* packet)
 {
   // First check if we know about this creature or not
@@ -919,9 +1106,17 @@ void Protocol71::parseLogin(IncomingPacket* packet)
   }
 
   // Login OK, spawn player
-  gameEngineQueue_->addTask(playerId_, [this, character_name](GameEngine* gameEngine)
+  queueSpawn(character_name);
+}
+
+void Protocol71::queueSpawn(const std::string& characterName)
+{
+  spawningCharacterName_ = characterName;
+  gameEngineQueue_->addTask(GameEngineQueue::Priority::LOGIN, playerId_, [this](GameEngine* gameEngine)
   {
-    if (!gameEngine->spawn(character_name, this))
+    const auto characterName = std::move(spawningCharacterName_);
+    spawningCharacterName_.clear();
+    if (!gameEngine->spawn(characterName, this))
     {
       OutgoingPacket response;
       response.addU8(0x14);
@@ -948,7 +1143,7 @@ void Protocol71::parseMoveClick(IncomingPacket* packet)
     moves.push_back(static_cast<Direction>(packet->getU8()));
   }
 
-  gameEngineQueue_->addTask(playerId_, [this, moves](GameEngine* gameEngine) mutable
+  gameEngineQueue_->addTask(playerId_, [this, moves = std::move(moves)](GameEngine* gameEngine) mutable
   {
     gameEngine->movePath(playerId_, std::move(moves));
   });
@@ -1015,7 +1210,7 @@ void Protocol71::parseLookAt(IncomingPacket* packet)
 
   LOG_DEBUG("%s: itemPosition: %s", __func__, itemPosition.toString().c_str());
 
-  gameEngineQueue_->addTask(playerId_, [this, itemPosition](GameEngine* gameEngine)
+  gameEngineQueue_->addTask(GameEngineQueue::Priority::LOW, playerId_, [this, itemPosition](GameEngine* gameEngine)
   {
     gameEngine->lookAt(playerId_, itemPosition);
   });
@@ -1042,9 +1237,15 @@ void Protocol71::parseSay(IncomingPacket* packet)
       break;
   }
 
-  const auto message = packet->getString();
+  auto message = packet->getString();
 
-  gameEngineQueue_->addTask(playerId_, [this, type, message, receiver, channelId](GameEngine* gameEngine)
+  gameEngineQueue_->addTask(GameEngineQueue::Priority::CHAT,
+                            playerId_,
+                            [this,
+                             type,
+                             message = std::move(message),
+                             receiver = std::move(receiver),
+                             channelId](GameEngine* gameEngine)
   {
     gameEngine->say(playerId_, type, message, receiver, channelId);
   });
@@ -31,16 +31,22 @@
 #include <functional>
 #include <string>
 #include <memory>
+#include <vector>
 
 // gameengine
 #include "player.h"
 #include "game_position.h"
 #include "container.h"
+#include "coalesced_task.h"
 
 // world
 #include "creature.h"
 #include "position.h"
 #include "item.h"
+#include "world_event.h"
+
+// utils
+#include "token_bucket.h"
 
 class Connection;
 class IncomingPacket;
@@ -48,10 +54,22 @@ class OutgoingPacket;
 class GameEngineQueue;
 class AccountReader;
 class WorldInterface;
+class Tile;
 
 class Protocol71 : public Protocol
 {
  public:
+  // Batched world events are sent in a new packet once a packet is this large, see onWorldEvents
+  static constexpr std::size_t max_batched_packet_length = 4096;
+
+  // Rate of each input class, in commands per second and burst size, see getInputBucket
+  static constexpr int move_input_rate = 20;
+  static constexpr int move_input_burst = 10;
+  static constexpr int action_input_rate = 10;
+  static constexpr int action_input_burst = 10;
+  static constexpr int chat_input_rate = 2;
+  static constexpr int chat_input_burst = 5;
+
   Protocol71(const std::function<void(void)>& closeProtocol,
              std::unique_ptr<Connection>&& connection,
              GameEngineQueue* gameEngineQueue,
@@ -62,35 +80,11 @@ class Protocol71 : public Protocol
   Protocol71& operator=(const Protocol71&) = delete;
 
   // Called by World (from CreatureCtrl)
-  void onCreatureSpawn(const WorldInterface& world_interface,
-                       const Creature& creature,
-                       const Position& position) override;
-  void onCreatureDespawn(const WorldInterface& world_interface,
-                         const Creature& creature,
-                         const Position& position,
-                         int stackPos) override;
-  void onCreatureMove(const WorldInterface& world_interface,
-                      const Creature& creature,
-                      const Position& oldPosition,
-                      int oldStackPos,
-                      const Position& newPosition) override;
-  void onCreatureTurn(const WorldInterface& world_interface,
-                      const Creature& creature,
-                      const Position& position,
-                      int stackPos) override;
-  void onCreatureSay(const WorldInterface& world_interface,
-                     const Creature& creature,
-                     const Position& position,
-                     const std::string& message) override;
-
-  void onItemRemoved(const WorldInterface& world_interface, const Position& position, int stackPos) override;
-  void onItemAdded(const WorldInterface& world_interface, const Item& item, const Position& position) override;
-
-  void onTileUpdate(const WorldInterface& world_interface, const Position& position) override;
+  void onWorldEvents(const WorldInterface& world_interface, const std::vector<WorldEvent>& events) override;
 
   // Called by GameEngine (from PlayerCtrl)
   CreatureId getPlayerId() const override { return playerId_; }
-  void setPlayerId(CreatureId playerId) override { playerId_ = playerId; }
+  void setPlayerId(CreatureId playerId) override;
   void onEquipmentUpdated(const Player& player, int inventoryIndex) override;
   void onOpenContainer(int localContainerId, const Container& container, const Item& item) override;
   void onCloseContainer(int localContainerId) override;
@@ -101,6 +95,15 @@ class Protocol71 : public Protocol
   void sendCancel(const std::string& message) override;
   void cancelMove() override;
 
+  // Called by worldserver at the end of each tick
+  void flush() override;
+
+  // Called by worldserver when the session is handed over to another process
+  bool detach(const std::function<void(Connection::Detached&&)>& onDetached) override;
+  void reattach(Connection::Detached&& detached) override;
+  void saveState(ByteWriter* writer) const override;
+  bool loadState(ByteReader* reader, CreatureId* playerId) override;
+
  private:
   bool isLoggedIn() const { return playerId_ != Creature::INVALID_ID; }
   bool isConnected() const { return static_cast<bool>(connection_); }
@@ -110,13 +113,43 @@ class Protocol71 : public Protocol
   void onDisconnected();
 
   // Helper functions for creating OutgoingPackets
-  bool canSee(const Position& player_position, const Position& to_position) const;
+  void addCreatureSpawn(const WorldInterface& world_interface,
+                        const Creature& creature,
+                        const Position& position,
+                        OutgoingPacket* packet);
+  void addCreatureDespawn(const Position& position, int stackPos, OutgoingPacket* packet) const;
+  void addCreatureMove(const WorldInterface& world_interface,
+                       CreatureId creatureId,
+                       const Position& oldPosition,
+                       int oldStackPos,
+                       const Position& newPosition,
+                       OutgoingPacket* packet);
+  void addCreatureEnterView(const Creature& creature, const Position& position, OutgoingPacket* packet);
+  void addCreatureLeaveView(const Position& oldPosition, int oldStackPos, OutgoingPacket* packet) const;
+  void addCreatureTurn(const Creature& creature, const Position& position, int stackPos, OutgoingPacket* packet) const;
+  void addCreatureSay(const Creature& creature,
+                      const Position& position,
+                      const std::string& message,
+                      OutgoingPacket* packet) const;
+  void addItemRemoved(const Position& position, int stackPos, OutgoingPacket* packet) const;
+  void addItemAdded(const Item& item, const Position& position, OutgoingPacket* packet) const;
+  void addTileUpdate(const WorldInterface& world_interface, const Position& position, OutgoingPacket* packet);
   void addPosition(const Position& position, OutgoingPacket* packet) const;
+  // Adds all floors that are visible from position's floor, position is the
+  // north-west corner of the area on that floor
   void addMapData(const WorldInterface& world_interface,
                   const Position& position,
                   int width,
                   int height,
                   OutgoingPacket* packet);
+  void addFloorData(const WorldInterface& world_interface,
+                    const Position& position,
+                    int z,
+                    int width,
+                    int height,
+                    int* skip,
+                    OutgoingPacket* packet);
+  void addTileData(const WorldInterface& world_interface, const Tile& tile, OutgoingPacket* packet);
   void addCreature(const Creature& creature, OutgoingPacket* packet);
   void addItem(const Item& item, OutgoingPacket* packet) const;
   void addEquipment(const Equipment& equipment, int inventoryIndex, OutgoingPacket* packet) const;
@@ -131,6 +164,12 @@ class Protocol71 : public Protocol
   void parseLookAt(IncomingPacket* packet);
   void parseSay(IncomingPacket* packet);
 
+  // Queues the spawn of a player that has logged in
+  void queueSpawn(const std::string& characterName);
+
+  // Input rate shaping
+  TokenBucket* getInputBucket(int packetId);
+
   // Helper functions for parsing IncomingPackets
   GamePosition getGamePosition(IncomingPacket* packet) const;
   ItemPosition getItemPosition(IncomingPacket* packet) const;
@@ -142,7 +181,20 @@ class Protocol71 : public Protocol
 
   CreatureId playerId_;
 
+  // Logged in, but not yet spawned by the GameEngine, see queueSpawn
+  std::string spawningCharacterName_;
+
   std::array<CreatureId, 64> knownCreatures_;
+
+  // Commands that are dropped when the player sends more than the rate of its class
+  TokenBucket moveInputBucket_;
+  TokenBucket actionInputBucket_;
+  TokenBucket chatInputBucket_;
+
+  // Moves and turns that are queued to the GameEngine but not yet performed, a new
+  // move or turn replaces the queued one instead of adding another task
+  CoalescedTask<Direction> queuedMove_;
+  CoalescedTask<Direction> queuedTurn_;
 };
 
 #endif  // WORLDSERVER_SRC_PROTOCOL_71_H_
@@ -22,15 +22,25 @@
  * SOFTWARE.
  */
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <deque>
 #include <functional>
+#include <future>
 #include <memory>
+#include <thread>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include <boost/asio.hpp>  //NOLINT
 
 // utils
+#include "byte_buffer.h"
 #include "config_parser.h"
 #include "logger.h"
+#include "thread_affinity.h"
+#include "tick.h"
 
 // account
 #include "account.h"
@@ -39,6 +49,8 @@
 #include "server_factory.h"
 #include "server.h"
 #include "connection.h"
+#include "handoff.h"
+#include "network_threads.h"
 
 // gameengine
 #include "game_engine.h"
@@ -54,12 +66,19 @@
 static std::unique_ptr<GameEngineQueue> gameEngineQueue;
 static std::unique_ptr<GameEngine> gameEngine;
 static std::unique_ptr<AccountReader> accountReader;
+static std::unique_ptr<NetworkThreads> networkThreads;  // Only if networking runs on its own threads
 static std::unique_ptr<Server> server;
 
 using ProtocolId = int;
 static std::unordered_map<ProtocolId, std::unique_ptr<Protocol>> protocols;
 
-void onClientConnected(std::unique_ptr<Connection>&& connection)
+// Magic of the data that is handed over to another process, see startHandoff
+static constexpr std::uint32_t handoff_magic = 0x31565357;  // "WSV1"
+
+// How long the processes wait for each other to ack the handoff, see startHandoff
+static constexpr int handoff_ack_timeout_ms = 10000;
+
+Protocol* createProtocol(std::unique_ptr<Connection>&& connection)
 {
   static ProtocolId nextProtocolId = 0;
 
@@ -68,6 +87,12 @@ void onClientConnected(std::unique_ptr<Connection>&& connection)
 
   LOG_DEBUG("%s: protocolId: %d", __func__, protocolId);
 
+  // In fixed-rate mode all packets are queued and sent once per tick, see main
+  if (gameEngineQueue->isFixedRate())
+  {
+    connection->setCorked(true);
+  }
+
   // Create and store Protocol for this Connection
   // Note: we need a different solution if we want to support different protocol versions
   // as the client version is parsed in the login packet
@@ -80,9 +105,264 @@ void onClientConnected(std::unique_ptr<Connection>&& connection)
                                                gameEngineQueue.get(),
                                                accountReader.get());
 
+  auto* result = protocol.get();
   protocols.emplace(std::piecewise_construct,
                     std::forward_as_tuple(protocolId),
                     std::forward_as_tuple(std::move(protocol)));
+  return result;
+}
+
+void onClientConnected(std::unique_ptr<Connection>&& connection)
+{
+  createProtocol(std::move(connection));
+}
+
+// Hands over the listening socket, all sessions and the game state to the process that connected to
+// the handoff socket (see resumeFromHandoff), and then stops the io_service.
+//
+// The GameEngineQueue is stopped first so that nothing changes while the connections are detached,
+// and the connections are kept open in this process until the io_service is stopped. If the other
+// process does not ack that it has taken over, everything is reattached and this process continues,
+// and onFailed is called.
+void startHandoff(boost::asio::io_service* io_service, int handoffSocket, const std::function<void(void)>& onFailed)
+{
+  LOG_INFO("%s: handing over to another process", __func__);
+  const auto start = Tick::now();
+
+  gameEngineQueue->stop();
+
+  struct DetachedSession
+  {
+    ProtocolId protocolId;
+    Connection::Detached detached;
+  };
+  auto sessions = std::make_shared<std::vector<DetachedSession>>();
+  auto pending = std::make_shared<int>(1);  // Released after all connections are asked to detach
+  auto listeningSocket = server->detach();
+
+  const auto onAllDetached = [io_service, handoffSocket, onFailed, start, sessions, listeningSocket]()
+  {
+    // The listening socket first, then one socket per session
+    std::vector<int> sockets = { listeningSocket };
+    std::vector<std::uint8_t> data;
+    ByteWriter writer(&data);
+    writer.addU32(handoff_magic);
+    const auto numberOfSessions = std::count_if(sessions->cbegin(), sessions->cend(), [](const DetachedSession& session)
+    {
+      return session.detached.socket != -1;
+    });
+    writer.addU32(numberOfSessions);
+    for (const auto& session : *sessions)
+    {
+      if (session.detached.socket == -1)
+      {
+        // Closed by the network threads during the handoff, see ConnectionProxy
+        continue;
+      }
+
+      writer.addU32(sockets.size());
+      sockets.push_back(session.detached.socket);
+      writer.addBytes(session.detached.receivedData);
+      writer.addBytes(session.detached.unsentData);
+
+      std::vector<std::uint8_t> state;
+      ByteWriter stateWriter(&state);
+      protocols.at(session.protocolId)->saveState(&stateWriter);
+      writer.addBytes(state);
+    }
+
+    std::vector<std::uint8_t> snapshot;
+    gameEngine->saveSnapshot(&snapshot);
+    writer.addBytes(snapshot);
+
+    // The other process acks when it has loaded everything, and then waits for the ack from this
+    // process, so that only one of them continues
+    if (Handoff::send(handoffSocket, sockets, data) &&
+        Handoff::receiveAck(handoffSocket, handoff_ack_timeout_ms) &&
+        Handoff::sendAck(handoffSocket))
+    {
+      LOG_INFO("startHandoff: handed over %d sessions (%d bytes) in %d ms",
+               static_cast<int>(numberOfSessions),
+               static_cast<int>(data.size()),
+               static_cast<int>(Tick::now() - start));
+      close(handoffSocket);
+      io_service->stop();
+      return;
+    }
+
+    // The other process only closes its copies of the sockets, so continue with them
+    LOG_ERROR("startHandoff: could not hand over, continuing");
+    close(handoffSocket);
+    server->reattach();
+    for (auto& session : *sessions)
+    {
+      if (session.detached.socket != -1)
+      {
+        protocols.at(session.protocolId)->reattach(std::move(session.detached));
+      }
+    }
+    gameEngineQueue->resume();
+    onFailed();
+  };
+
+  for (auto& pair : protocols)
+  {
+    const auto protocolId = pair.first;
+    const auto onDetached = [protocolId, sessions, pending, onAllDetached](Connection::Detached&& detached)
+    {
+      sessions->push_back({ protocolId, std::move(detached) });
+      if (--*pending == 0)
+      {
+        onAllDetached();
+      }
+    };
+    if (pair.second->detach(onDetached))
+    {
+      ++*pending;
+    }
+  }
+
+  if (--*pending == 0)
+  {
+    onAllDetached();
+  }
+}
+
+// Takes over the listening socket, the sessions and the game state from the process that is
+// listening on the handoff socket, see startHandoff
+//
+// Until both processes have acked the handoff the running process keeps its sockets, so on failure
+// the received sockets are only closed, never shut down: either directly, or by deallocate when they
+// have been adopted. The listening socket is adopted last, so that no client is accepted unless
+// this process takes over.
+bool resumeFromHandoff(boost::asio::io_service* io_service, int handoffSocket)
+{
+  const auto start = Tick::now();
+
+  std::vector<int> sockets;
+  std::vector<std::uint8_t> data;
+  if (!Handoff::receive(handoffSocket, &sockets, &data))
+  {
+    LOG_ERROR("%s: could not receive from the running WorldServer", __func__);
+    return false;
+  }
+
+  // Validate everything before any socket is adopted
+  struct Session
+  {
+    std::uint32_t socketIndex;
+    std::vector<std::uint8_t> receivedData;
+    std::vector<std::uint8_t> unsentData;
+    std::vector<std::uint8_t> state;
+  };
+  std::vector<Session> sessions;
+  std::vector<bool> usedSockets(sockets.size(), false);
+  ByteReader reader(data.data(), data.size());
+  const auto magic = reader.getU32();
+  const auto numberOfSessions = reader.getU32();
+  for (auto i = 0u; i < numberOfSessions && !reader.failed(); i++)
+  {
+    Session session;
+    session.socketIndex = reader.getU32();
+    session.receivedData = reader.getBytes();
+    session.unsentData = reader.getBytes();
+    session.state = reader.getBytes();
+    if (reader.failed() || session.socketIndex == 0 || session.socketIndex >= sockets.size() ||
+        usedSockets[session.socketIndex])
+    {
+      break;
+    }
+    usedSockets[session.socketIndex] = true;
+    sessions.push_back(std::move(session));
+  }
+  const auto snapshot = reader.getBytes();
+  if (reader.failed() || magic != handoff_magic || sessions.size() != numberOfSessions ||
+      sockets.size() != numberOfSessions + 1)
+  {
+    LOG_ERROR("%s: invalid data from the running WorldServer", __func__);
+    for (const auto socket : sockets)
+    {
+      close(socket);
+    }
+    return false;
+  }
+
+  // The sessions are resumed before the players are restored, since the players need their PlayerCtrl
+  std::unordered_map<CreatureId, Protocol*> playerProtocols;
+  auto statesLoaded = true;
+  for (auto& session : sessions)
+  {
+    Connection::Detached detached = { sockets[session.socketIndex],
+                                      std::move(session.receivedData),
+                                      std::move(session.unsentData) };
+    auto* protocol = createProtocol(ServerFactory::adoptConnection(io_service,
+                                                                   std::move(detached),
+                                                                   networkThreads.get()));
+
+    ByteReader stateReader(session.state.data(), session.state.size());
+    CreatureId playerId = Creature::INVALID_ID;
+    if (!protocol->loadState(&stateReader, &playerId))
+    {
+      statesLoaded = false;
+    }
+    else if (playerId != Creature::INVALID_ID)
+    {
+      playerProtocols[playerId] = protocol;
+    }
+  }
+
+  if (!statesLoaded || !gameEngine->loadSnapshot(snapshot, [&playerProtocols](CreatureId playerId) -> PlayerCtrl*
+      {
+        const auto it = playerProtocols.find(playerId);
+        return it != playerProtocols.end() ? it->second : nullptr;
+      }))
+  {
+    LOG_ERROR("%s: could not load the game state", __func__);
+    close(sockets.front());
+    return false;
+  }
+
+  if (!Handoff::sendAck(handoffSocket) || !Handoff::receiveAck(handoffSocket, handoff_ack_timeout_ms))
+  {
+    LOG_ERROR("%s: the running WorldServer did not ack the handoff", __func__);
+    close(sockets.front());
+    return false;
+  }
+
+  server = ServerFactory::adoptServer(io_service, sockets.front(), &onClientConnected, networkThreads.get());
+
+  for (const auto& pair : playerProtocols)
+  {
+    if (pair.second->getPlayerId() != pair.first)
+    {
+      // The client is closed as soon as it sends anything, as it is not logged in
+      LOG_ERROR("%s: player with id: %d was not restored", __func__, pair.first);
+    }
+  }
+
+  LOG_INFO("%s: resumed %d sessions (%d bytes) in %d ms",
+           __func__,
+           static_cast<int>(numberOfSessions),
+           static_cast<int>(data.size()),
+           static_cast<int>(Tick::now() - start));
+  return true;
+}
+
+// Deallocates everything, in reverse order of construction
+// The network threads are stopped first, so that the connections can be deleted on this thread
+void deallocate()
+{
+  if (networkThreads)
+  {
+    networkThreads->stop();
+  }
+
+  protocols.clear();
+  server.reset();
+  networkThreads.reset();
+  accountReader.reset();
+  gameEngine.reset();
+  gameEngineQueue.reset();
 }
 
 int main()
@@ -97,13 +377,25 @@ int main()
 
   // Read [server] settings
   const auto serverPort = config.getInteger("server", "port", 7172);
+  const auto handoffSocketPath = config.getString("server", "handoff_socket", "");
+  const auto numberOfNetworkThreads = config.getInteger("server", "network_threads", 0);
+  const auto networkCpuList = config.getString("server", "network_cpus", "");
 
   // Read [world] settings
   const auto loginMessage     = config.getString("world", "login_message", "Welcome to LoginServer!");
   const auto accountsFilename = config.getString("world", "accounts_file", "data/accounts.xml");
   const auto dataFilename     = config.getString("world", "data_file", "data/data.dat");
   const auto itemsFilename    = config.getString("world", "item_file", "data/items.xml");
+  const auto itemsCacheFile   = config.getString("world", "item_cache_file", "data/items.bin");
   const auto worldFilename    = config.getString("world", "world_file", "data/world.xml");
+  const auto lazySectors      = config.getBoolean("world", "lazy_sectors", false);
+  const auto loaderThreads    = config.getInteger("world", "loader_threads",
+                                                  static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+  const auto pageDirectory    = config.getString("world", "page_directory", "");
+  const auto pageOutInterval  = config.getInteger("world", "page_out_interval", 60000);
+  const auto tickInterval     = config.getInteger("world", "tick_interval", 0);
+  const auto tickBudget       = config.getInteger("world", "tick_budget", 20);
+  const auto engineCpuList    = config.getString("world", "engine_cpus", "");
 
   // Read [logger] settings
   const auto logger_account     = config.getString("logger", "account", "ERROR");
@@ -124,12 +416,38 @@ int main()
   printf("WorldServer configuration\n");
   printf("--------------------------------------------------------------------------------\n");
   printf("Server port:               %d\n", serverPort);
+  printf("Handoff socket:            %s\n",
+         handoffSocketPath.empty() ? "(handoff disabled)" : handoffSocketPath.c_str());
+  if (numberOfNetworkThreads > 0)
+  {
+    printf("Network threads:           %d\n", numberOfNetworkThreads);
+  }
+  else
+  {
+    printf("Network threads:           (same thread as GameEngine)\n");
+  }
+  printf("Network CPUs:              %s\n", networkCpuList.empty() ? "(not pinned)" : networkCpuList.c_str());
   printf("\n");
   printf("Login message:             %s\n", loginMessage.c_str());
   printf("Accounts filename:         %s\n", accountsFilename.c_str());
   printf("Data filename:             %s\n", dataFilename.c_str());
   printf("Items filename:            %s\n", itemsFilename.c_str());
+  printf("Items cache filename:      %s\n", itemsCacheFile.empty() ? "(cache disabled)" : itemsCacheFile.c_str());
   printf("World filename:            %s\n", worldFilename.c_str());
+  printf("Lazy sectors:              %s\n", lazySectors ? "yes (world image only)" : "no");
+  printf("Loader threads:            %d (world image only)\n", loaderThreads);
+  printf("Page directory:            %s\n", pageDirectory.empty() ? "(paging disabled)" : pageDirectory.c_str());
+  printf("Page out interval:         %d ms\n", pageOutInterval);
+  if (tickInterval > 0)
+  {
+    printf("Tick interval:             %d ms (fixed-rate)\n", tickInterval);
+  }
+  else
+  {
+    printf("Tick interval:             (event-driven)\n");
+  }
+  printf("Tick budget:               %d ms\n", tickBudget);
+  printf("GameEngine CPUs:           %s\n", engineCpuList.empty() ? "(not pinned)" : engineCpuList.c_str());
   printf("\n");
   printf("Account logging:           %s\n", logger_account.c_str());
   printf("Network logging:           %s\n", logger_network.c_str());
@@ -138,33 +456,135 @@ int main()
   printf("Worldserver logging:       %s\n", logger_worldserver.c_str());
   printf("--------------------------------------------------------------------------------\n");
 
+  std::vector<int> networkCpus;
+  std::vector<int> engineCpus;
+  if (!ThreadAffinity::parseCpuList(networkCpuList, &networkCpus) ||
+      !ThreadAffinity::parseCpuList(engineCpuList, &engineCpus))
+  {
+    LOG_ERROR("Invalid list of CPUs, expected e.g. \"0,2-3\"");
+    return 1;
+  }
+
   LOG_INFO("Starting WorldServer!");
 
   boost::asio::io_service io_service;
 
   // Create GameEngine and GameEngineQueue
   gameEngine = std::make_unique<GameEngine>();
-  gameEngineQueue = std::make_unique<GameEngineQueue>(gameEngine.get(), &io_service);
+  gameEngineQueue = std::make_unique<GameEngineQueue>(gameEngine.get(), &io_service, tickInterval);
+  gameEngineQueue->setTimeBudget(tickBudget);
+  gameEngineQueue->setOnTickEnd([]()
+  {
+    for (auto& pair : protocols)
+    {
+      pair.second->flush();
+    }
+  });
+
+  // Load accounts on another thread while GameEngine loads items and the world, they don't depend on each other
+  accountReader = std::make_unique<AccountReader>();
+  auto accountsLoaded = std::async(std::launch::async, [&accountsFilename]()
+  {
+    const auto start = Tick::now();
+    if (!accountReader->loadFile(accountsFilename))
+    {
+      LOG_ERROR("Could not load accounts file: %s", accountsFilename.c_str());
+      return false;
+    }
+    LOG_INFO("Accounts loaded in %d ms", static_cast<int>(Tick::now() - start));
+    return true;
+  });
 
   // Initialize GameEngine
-  if (!gameEngine->init(gameEngineQueue.get(), loginMessage, dataFilename, itemsFilename, worldFilename))
+  if (!gameEngine->init(gameEngineQueue.get(),
+                        loginMessage,
+                        dataFilename,
+                        itemsFilename,
+                        itemsCacheFile,
+                        worldFilename,
+                        lazySectors,
+                        loaderThreads,
+                        pageDirectory,
+                        pageOutInterval))
   {
     LOG_ERROR("Could not initialize GameEngine");
     return 1;
   }
 
-  // Create and load AccountReader
-  accountReader = std::make_unique<AccountReader>();
-  if (!accountReader->loadFile(accountsFilename))
+  if (!accountsLoaded.get())
   {
-    LOG_ERROR("Could not load accounts file: %s", accountsFilename.c_str());
     return 1;
   }
 
-  // Create Server
-  server = ServerFactory::createServer(&io_service, serverPort, &onClientConnected);
+  // This thread runs GameEngine, and also the networking unless it has its own threads
+  // Threads that were started during the initialization are not affected
+  if (!ThreadAffinity::pinCurrentThread(engineCpus))
+  {
+    LOG_ERROR("Could not pin the GameEngine thread");
+  }
+  if (numberOfNetworkThreads > 0)
+  {
+    networkThreads = std::make_unique<NetworkThreads>(&io_service, numberOfNetworkThreads, networkCpus);
+    networkThreads->start();
+  }
+
+  // Take over from a WorldServer that is running with the same handoff socket, if any, otherwise create Server
+  if (!handoffSocketPath.empty())
+  {
+    const auto handoffSocket = Handoff::connect(handoffSocketPath);
+    if (handoffSocket != -1)
+    {
+      const auto resumed = resumeFromHandoff(&io_service, handoffSocket);
+      close(handoffSocket);
+      if (!resumed)
+      {
+        deallocate();
+        return 1;
+      }
+    }
+  }
+  if (!server)
+  {
+    server = ServerFactory::createServer(&io_service, serverPort, &onClientConnected, networkThreads.get());
+  }
+
+  // Wait for the next WorldServer to take over, see startHandoff
+  using HandoffProtocol = boost::asio::local::stream_protocol;
+  std::unique_ptr<HandoffProtocol::acceptor> handoffAcceptor;
+  HandoffProtocol::socket handoffConnection(io_service);
+  std::function<void(void)> acceptHandoff;
+  if (!handoffSocketPath.empty())
+  {
+    const auto handoffListeningSocket = Handoff::listen(handoffSocketPath);
+    if (handoffListeningSocket == -1)
+    {
+      LOG_ERROR("Could not listen on handoff socket: %s", handoffSocketPath.c_str());
+      return 1;
+    }
+
+    handoffAcceptor = std::make_unique<HandoffProtocol::acceptor>(io_service,
+                                                                   HandoffProtocol(),
+                                                                   handoffListeningSocket);
+    acceptHandoff = [&io_service, &handoffAcceptor, &handoffConnection, &acceptHandoff]()
+    {
+      const auto onAccept = [&io_service, &handoffConnection, &acceptHandoff](const boost::system::error_code& error)
+      {
+        if (error)
+        {
+          LOG_ERROR("Could not accept handoff connection: %s", error.message().c_str());
+          return;
+        }
 
-  LOG_INFO("WorldServer started!");
+        // Wait for the next WorldServer again if this one could not take over
+        startHandoff(&io_service, handoffConnection.release(), acceptHandoff);
+      };
+      handoffAcceptor->async_accept(handoffConnection, onAccept);
+    };
+    acceptHandoff();
+  }
+
+  // Tick::now() is counted from process start, so this is the time until the first connection can be accepted
+  LOG_INFO("WorldServer started in %d ms!", static_cast<int>(Tick::now()));
 
   // run() will continue to run until ^C from user is catched
   boost::asio::signal_set signals(io_service, SIGINT, SIGTERM);
@@ -180,12 +600,9 @@ int main()
 
   LOG_INFO("Stopping WorldServer!");
 
-  // Deallocate things (in reverse order of construction)
-  protocols.clear();
-  server.reset();
-  accountReader.reset();
-  gameEngine.reset();
-  gameEngineQueue.reset();
+  // Note that detached connections are only closed in this process, see startHandoff
+  handoffAcceptor.reset();
+  deallocate();
 
   return 0;
 }
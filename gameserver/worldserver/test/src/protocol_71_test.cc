@@ -0,0 +1,192 @@
+/**
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Simon Sandström
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "protocol_71.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <boost/asio.hpp>  //NOLINT
+
+#include "gtest/gtest.h"
+
+#include "connection.h"
+#include "game_engine.h"
+#include "game_engine_queue.h"
+#include "incoming_packet.h"
+#include "item_manager.h"
+#include "tile.h"
+#include "world_image.h"
+
+#include "item_types_files.h"
+
+namespace
+{
+
+const std::string image_filename = "protocol_71_test.bin";
+
+// Enough to run the tasks that are due, but shorter than it takes a player to walk one step on grass
+constexpr int run_tasks_ms = 100;
+
+// Longer than it takes a player to walk one step on grass
+constexpr int step_ms = 1000;
+
+// Records the first byte (the packet type) of each sent packet
+class ConnectionFake : public Connection
+{
+ public:
+  explicit ConnectionFake(std::vector<int>* sentPacketTypes)
+    : sentPacketTypes_(sentPacketTypes)
+  {
+  }
+
+  void init(const Callbacks& callbacks) override { callbacks_ = callbacks; }
+  void close(bool force) override { (void)force; }
+  void sendPacket(OutgoingPacket&& packet) override { sentPacketTypes_->push_back(packet.getBuffer()[0]); }
+  void setCorked(bool corked) override { (void)corked; }
+  void flush() override {}
+  bool detach(const std::function<void(Detached&&)>& onDetached) override { (void)onDetached; return false; }
+  void reattach(Detached&& detached) override { (void)detached; }
+
+  void receive(const std::vector<std::uint8_t>& data)
+  {
+    IncomingPacket packet(data.data(), data.size());
+    callbacks_.onPacketReceived(&packet);
+  }
+
+ private:
+  Callbacks callbacks_;
+  std::vector<int>* sentPacketTypes_;
+};
+
+class Protocol71Test : public ::testing::Test
+{
+ protected:
+  Protocol71Test()
+    : io_service_(),
+      gameEngine_(),
+      gameEngineQueue_(&gameEngine_, &io_service_),
+      sentPacketTypes_(),
+      connection_(new ConnectionFake(&sentPacketTypes_)),
+      protocol_([]() {}, std::unique_ptr<Connection>(connection_), &gameEngineQueue_, nullptr)
+  {
+  }
+
+  void SetUp() override
+  {
+    // Grass from (200, 200, 7) to (215, 215, 7), players spawn at (208, 208, 7)
+    ItemManager itemManager;
+    ASSERT_TRUE(loadItemTypes("<item id=\"100\" name=\"grass\"/>", &itemManager));
+    Tile grass(itemManager.getItem(itemManager.createMapItem(100)));
+    WorldImageWriter writer;
+    for (auto x = 200; x < 216; x++)
+    {
+      for (auto y = 200; y < 216; y++)
+      {
+        writer.addTile(Position(x, y, 7), grass);
+      }
+    }
+    ASSERT_TRUE(writer.save(image_filename));
+    ASSERT_TRUE(writeSourceFiles("<item id=\"100\" name=\"grass\"/>"));
+    ASSERT_TRUE(gameEngine_.init(&gameEngineQueue_, "", data_filename, items_filename, "", image_filename,
+                                 false, 1, "", 0));
+    ASSERT_TRUE(gameEngine_.spawn("Alice", &protocol_));
+  }
+
+  void TearDown() override
+  {
+    gameEngine_.despawn(protocol_.getPlayerId());
+    std::remove(image_filename.c_str());
+    std::remove(data_filename.c_str());
+    std::remove(items_filename.c_str());
+  }
+
+  // Runs the io_service for the given time
+  void runFor(int ms)
+  {
+    boost::asio::deadline_timer timer(io_service_, boost::posix_time::milliseconds(ms));
+    timer.async_wait([this](const boost::system::error_code& error)
+    {
+      (void)error;
+      io_service_.stop();
+    });
+    io_service_.reset();
+    io_service_.run();
+  }
+
+  int numberOfSentPackets(int packetType) const
+  {
+    return std::count(sentPacketTypes_.cbegin(), sentPacketTypes_.cend(), packetType);
+  }
+
+  boost::asio::io_service io_service_;
+  GameEngine gameEngine_;
+  GameEngineQueue gameEngineQueue_;
+  std::vector<int> sentPacketTypes_;
+  ConnectionFake* connection_;
+  Protocol71 protocol_;
+};
+
+}  // namespace
+
+TEST_F(Protocol71Test, CancelMoveOverMoveRate)
+{
+  // The first step is taken directly
+  connection_->receive({ 0x66 });
+  runFor(run_tasks_ms);
+  ASSERT_EQ(1, numberOfSentPackets(0x6D));
+
+  // Spam arrow keys until the move rate is exceeded, the steps within the rate are coalesced
+  // into one step that is delayed until the player may move again
+  for (auto i = 0; i < 2 * Protocol71::move_input_burst; i++)
+  {
+    connection_->receive({ 0x67 });
+  }
+
+  // Cancel move still reaches the GameEngine, which cancels the delayed step
+  connection_->receive({ 0x69 });
+  runFor(step_ms);
+  EXPECT_EQ(1, numberOfSentPackets(0x6D));
+}
+
+TEST_F(Protocol71Test, StopOverMoveRate)
+{
+  connection_->receive({ 0x66 });
+  runFor(run_tasks_ms);
+  ASSERT_EQ(1, numberOfSentPackets(0x6D));
+
+  for (auto i = 0; i < 2 * Protocol71::move_input_burst; i++)
+  {
+    connection_->receive({ 0x67 });
+  }
+
+  connection_->receive({ 0xBE });
+  runFor(step_ms);
+  EXPECT_EQ(1, numberOfSentPackets(0x6D));
+}